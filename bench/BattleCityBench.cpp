@@ -0,0 +1,265 @@
+#include "../src/Game/Game.h"
+#include "../src/Game/Level.h"
+#include "../src/Game/WorldState.h"
+#include "../src/Game/GameObjects/IGameObject.h"
+#include "../src/Game/GameObjects/Tank.h"
+#include "../src/Physics/PhysicsEngine.h"
+#include "../src/Renderer/SpriteAnimator.h"
+#include "../src/Resources/ResourceManager.h"
+#include "../src/System/Timer.h"
+#include "LevelGenerator.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Hot paths of the engine, measured headless: resources are loaded without a GL context.
+// Prints one JSON document to stdout. Usage: BattleCityBench [--quick]
+// Every result is the median over the repeats of the time per operation.
+
+static int g_repeats = 15;
+
+static double measureNanoseconds(const std::function<void()>& function, const size_t operationsCount)
+{
+	std::vector<double> times;
+	times.reserve(g_repeats);
+	for (int currentRepeat = 0; currentRepeat < g_repeats; ++currentRepeat)
+	{
+		const auto startTime = std::chrono::high_resolution_clock::now();
+		function();
+		times.push_back(std::chrono::duration<double, std::nano>(std::chrono::high_resolution_clock::now() - startTime).count() / operationsCount);
+	}
+	std::nth_element(times.begin(), times.begin() + times.size() / 2, times.end());
+	return times[times.size() / 2];
+}
+
+class JSONResults
+{
+public:
+	void add(const std::string& benchmark, const std::string& parameters, const double nanoseconds)
+	{
+		m_stream << (m_resultsCount++ > 0 ? ",\n" : "") << "\t\t{ \"benchmark\": \"" << benchmark << "\"" << parameters << ", \"nsPerOp\": " << nanoseconds << " }";
+	}
+	void print() const
+	{
+		std::cout << "{\n\t\"benchmark\": \"BattleCity\",\n\t\"repeats\": " << g_repeats << ",\n\t\"results\": [\n" << m_stream.str() << "\n\t]\n}" << std::endl;
+	}
+
+private:
+	std::stringstream m_stream;
+	size_t m_resultsCount = 0;
+};
+
+static std::string parameter(const char* name, const size_t value)
+{
+	return std::string(", \"") + name + "\": " + std::to_string(value);
+}
+
+int main(int args, char** argv)
+{
+	const bool isQuick = args > 1 && std::strcmp(argv[1], "--quick") == 0;
+	g_repeats = isQuick ? 3 : 15;
+	const std::vector<size_t> mapSizes = isQuick ? std::vector<size_t>{ 13, 64 } : std::vector<size_t>{ 13, 32, 64, 128, 256 };
+	const std::vector<size_t> tanksCounts = isQuick ? std::vector<size_t>{ 10, 100 } : std::vector<size_t>{ 10, 100, 1000 };
+
+	ResourceManager::setExecutablePath(argv[0]);
+	ResourceManager::setHeadless(true);
+	JSONResults results;
+	std::mt19937 random(12345);
+
+	results.add("loadJSONResources", "", measureNanoseconds([]()
+		{
+			ResourceManager::unloadAllResources();
+			ResourceManager::loadJSONResources("res/resourses.json");
+		}, 1));
+	if (ResourceManager::getLevels().empty())
+	{
+		std::cerr << "Can't load res/resourses.json" << std::endl;
+		return -1;
+	}
+
+	for (const size_t mapSize : mapSizes)
+	{
+		const std::vector<std::string> description = makeLevelDescription(mapSize, mapSize, random);
+		results.add("LevelConstruction", parameter("mapSize", mapSize), measureNanoseconds([&description]()
+			{
+				const Level level(description);
+			}, 1));
+
+		const Level level(description);
+		constexpr size_t queriesCount = 10000;
+		std::uniform_real_distribution<float> coordinate(0.f, static_cast<float>(mapSize * Level::BLOCK_SIZE));
+		std::vector<glm::vec2> queryPositions(queriesCount);
+		for (glm::vec2& currentPosition : queryPositions)
+		{
+			currentPosition = glm::vec2(coordinate(random), coordinate(random));
+		}
+		size_t objectsFound = 0;
+		results.add("Level::getObjectsInArea", parameter("mapSize", mapSize), measureNanoseconds([&]()
+			{
+				for (const glm::vec2& currentPosition : queryPositions)
+				{
+					objectsFound += level.getObjectsInArea(currentPosition, currentPosition + glm::vec2(Level::BLOCK_SIZE)).size();
+				}
+			}, queriesCount));
+		if (objectsFound == 0)
+		{
+			std::cerr << "getObjectsInArea found nothing" << std::endl;
+		}
+	}
+
+	for (const size_t collidersCount : { 1, 4, 16 })
+	{
+		std::vector<Physics::AABB> colliders1;
+		std::vector<Physics::AABB> colliders2;
+		for (size_t currentCollider = 0; currentCollider < collidersCount; ++currentCollider)
+		{
+			glm::vec2 topRight(4.f * (currentCollider + 1), 4.f);
+			colliders1.emplace_back(glm::vec2(4.f * currentCollider, 0.f), topRight);
+			colliders2.emplace_back(glm::vec2(4.f * currentCollider, 0.f), topRight);
+		}
+		constexpr size_t callsCount = 100000;
+		size_t intersectionsCount = 0;
+		results.add("PhysicsEngine::hasIntersection", parameter("colliders", collidersCount), measureNanoseconds([&]()
+			{
+				for (size_t currentCall = 0; currentCall < callsCount; ++currentCall)
+				{
+					// the second object slides away, so both the early-out and the full scan are measured
+					const glm::vec2 position2(static_cast<float>(currentCall % 128), 0.f);
+					intersectionsCount += Physics::PhysicsEngine::hasIntersection(colliders1, glm::vec2(0.f), colliders2, position2) ? 1 : 0;
+				}
+			}, callsCount));
+		if (intersectionsCount == 0)
+		{
+			std::cerr << "hasIntersection found nothing" << std::endl;
+		}
+	}
+
+	for (const size_t mapSize : mapSizes)
+	{
+		for (const size_t tanksCount : tanksCounts)
+		{
+			Physics::PhysicsEngine::init();
+			auto pLevel = std::make_shared<Level>(makeLevelDescription(mapSize, mapSize, random));
+			Physics::PhysicsEngine::setCurrentLevel(pLevel);
+
+			std::uniform_real_distribution<float> coordinate(static_cast<float>(Level::BLOCK_SIZE), static_cast<float>((mapSize - 1) * Level::BLOCK_SIZE));
+			std::uniform_int_distribution<int> orientation(0, 3);
+			std::vector<std::shared_ptr<Tank>> tanks;
+			tanks.reserve(tanksCount);
+			for (size_t currentTank = 0; currentTank < tanksCount; ++currentTank)
+			{
+				auto pTank = std::make_shared<Tank>(0.05, glm::vec2(coordinate(random), coordinate(random)), glm::vec2(Level::BLOCK_SIZE, Level::BLOCK_SIZE), 0.f);
+				Physics::PhysicsEngine::addDynamicGameObject(pTank);
+				// finish the respawn animation, spawning tanks can't move
+				pTank->update(2000);
+				pTank->setOrientation(static_cast<Tank::EOrientation>(orientation(random)));
+				pTank->setVelocity(pTank->getMaxVelocity());
+				tanks.push_back(std::move(pTank));
+			}
+
+			results.add("PhysicsEngine::update", parameter("mapSize", mapSize) + parameter("tanks", tanksCount), measureNanoseconds([]()
+				{
+					Physics::PhysicsEngine::update(1000.0 / 60.0);
+				}, 1));
+
+			tanks.clear();
+			Physics::PhysicsEngine::terminate();
+		}
+	}
+
+	{
+		Tank tank(0.05, glm::vec2(Level::BLOCK_SIZE), glm::vec2(Level::BLOCK_SIZE, Level::BLOCK_SIZE), 0.f);
+		constexpr size_t updatesCount = 100000;
+		results.add("IGameObject::changeStateField", "", measureNanoseconds([&tank]()
+			{
+				for (size_t currentUpdate = 0; currentUpdate < updatesCount; ++currentUpdate)
+				{
+					// what the physics does for every object that moved
+					const glm::vec2 oldPosition = tank.getCurrentPosition();
+					tank.getCurrentPosition().x += 1.f;
+					tank.changeStateField(IGameObject::POSITION_FIELD, oldPosition, tank.getCurrentPosition());
+				}
+			}, updatesCount));
+		Physics::PhysicsEngine::terminate();
+	}
+
+	{
+		Physics::PhysicsEngine::init();
+		Game game(glm::ivec2(13 * 16, 14 * 16));
+		if (game.init(1))
+		{
+			WorldState state;
+			game.saveState(state);
+			const std::string stateSize = parameter("bytes", state.getSize());
+			constexpr size_t snapshotsCount = 10000;
+			results.add("Game::saveState", stateSize, measureNanoseconds([&game, &state]()
+				{
+					for (size_t currentSnapshot = 0; currentSnapshot < snapshotsCount; ++currentSnapshot)
+					{
+						game.saveState(state);
+					}
+				}, snapshotsCount));
+			bool isRestored = true;
+			results.add("Game::restoreState", stateSize, measureNanoseconds([&game, &state, &isRestored]()
+				{
+					for (size_t currentSnapshot = 0; currentSnapshot < snapshotsCount; ++currentSnapshot)
+					{
+						isRestored &= game.restoreState(state);
+					}
+				}, snapshotsCount));
+			if (!isRestored)
+			{
+				std::cerr << "Game::restoreState failed" << std::endl;
+			}
+		}
+		Physics::PhysicsEngine::terminate();
+	}
+
+	{
+		RenderEngine::SpriteAnimator spriteAnimator(ResourceManager::getSprite("tankSprite_top"_rid));
+		constexpr size_t updatesCount = 100000;
+		results.add("SpriteAnimator::update", "", measureNanoseconds([&spriteAnimator]()
+			{
+				for (size_t currentUpdate = 0; currentUpdate < updatesCount; ++currentUpdate)
+				{
+					spriteAnimator.update(1000.0 / 60.0);
+				}
+			}, updatesCount));
+	}
+
+	{
+		Timer timer;
+		size_t firedCount = 0;
+		timer.setCallback([&timer, &firedCount]()
+			{
+				++firedCount;
+				timer.start(100);
+			}
+		);
+		timer.start(100);
+		constexpr size_t updatesCount = 100000;
+		results.add("Timer::update", "", measureNanoseconds([&timer]()
+			{
+				for (size_t currentUpdate = 0; currentUpdate < updatesCount; ++currentUpdate)
+				{
+					timer.update(1000.0 / 60.0);
+				}
+			}, updatesCount));
+		if (firedCount == 0)
+		{
+			std::cerr << "Timer never fired" << std::endl;
+		}
+	}
+
+	ResourceManager::unloadAllResources();
+	results.print();
+	return 0;
+}
@@ -0,0 +1,87 @@
+#include "../src/System/JobSystem.h"
+
+#include <chrono>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <vector>
+
+// Scheduling overhead and parallelFor scaling of the job system for 1..N worker threads.
+// Prints one JSON document to stdout. Usage: JobSystemBench [maxThreads]
+
+static double measureMilliseconds(const std::function<void()>& function, const int repeats)
+{
+	double bestTime = 1e300;
+	for (int currentRepeat = 0; currentRepeat < repeats; ++currentRepeat)
+	{
+		const auto startTime = std::chrono::high_resolution_clock::now();
+		function();
+		const double duration = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
+		bestTime = duration < bestTime ? duration : bestTime;
+	}
+	return bestTime;
+}
+
+int main(int args, char** argv)
+{
+	unsigned int maxThreadsCount = std::thread::hardware_concurrency() > 0 ? std::thread::hardware_concurrency() : 1;
+	if (args > 1)
+	{
+		maxThreadsCount = static_cast<unsigned int>(std::max(1, std::atoi(argv[1])));
+	}
+	constexpr size_t emptyJobsCount = 4000;
+	constexpr size_t elementsCount = 1 << 22;
+
+	std::vector<float> input(elementsCount);
+	std::vector<float> output(elementsCount);
+	for (size_t currentElement = 0; currentElement < elementsCount; ++currentElement)
+	{
+		input[currentElement] = static_cast<float>(currentElement);
+	}
+
+	double singleThreadParallelForTime = 0;
+	std::cout << "{\n\t\"benchmark\": \"JobSystem\",\n\t\"results\": [\n";
+	for (unsigned int threadsCount = 1; threadsCount <= maxThreadsCount; threadsCount *= 2)
+	{
+		JobSystem::init(threadsCount);
+
+		const double emptyJobsTime = measureMilliseconds([&]()
+			{
+				Job* pRoot = JobSystem::createJob([](Job&) {});
+				for (size_t currentJob = 0; currentJob < emptyJobsCount; ++currentJob)
+				{
+					JobSystem::run(JobSystem::createJob([](Job&) {}, pRoot));
+				}
+				JobSystem::run(pRoot);
+				JobSystem::wait(pRoot);
+			}, 50);
+
+		const double parallelForTime = measureMilliseconds([&]()
+			{
+				JobSystem::parallelFor(elementsCount, 4096, [&](const size_t begin, const size_t end)
+					{
+						for (size_t currentElement = begin; currentElement < end; ++currentElement)
+						{
+							output[currentElement] = std::sqrt(input[currentElement]) * std::sin(input[currentElement]);
+						}
+					}
+				);
+			}, 10);
+		if (threadsCount == 1)
+		{
+			singleThreadParallelForTime = parallelForTime;
+		}
+
+		std::cout << "\t\t{ \"threads\": " << threadsCount
+				  << ", \"emptyJobNs\": " << emptyJobsTime * 1e6 / (emptyJobsCount + 1)
+				  << ", \"parallelForMs\": " << parallelForTime
+				  << ", \"speedup\": " << singleThreadParallelForTime / parallelForTime
+				  << " }" << (threadsCount * 2 <= maxThreadsCount ? "," : "") << "\n";
+
+		JobSystem::terminate();
+	}
+	std::cout << "\t]\n}" << std::endl;
+	return 0;
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <random>
+#include <string>
+#include <vector>
+
+// A map of widthBlocks x heightBlocks with walls, water, trees and ice on about a third of the blocks
+inline std::vector<std::string> makeLevelDescription(const size_t widthBlocks, const size_t heightBlocks, std::mt19937& random)
+{
+	static const char blocks[] = "0123456789ABC4";
+	std::uniform_int_distribution<int> isBlock(0, 2);
+	std::uniform_int_distribution<size_t> blockType(0, sizeof(blocks) - 2);
+	std::vector<std::string> description(heightBlocks, std::string(widthBlocks, 'D'));
+	for (std::string& currentRow : description)
+	{
+		for (char& currentBlock : currentRow)
+		{
+			if (isBlock(random) == 0)
+			{
+				currentBlock = blocks[blockType(random)];
+			}
+		}
+	}
+	description[heightBlocks - 1][widthBlocks / 2] = 'E';
+	return description;
+}
@@ -0,0 +1,412 @@
+#include "../src/Game/Game.h"
+#include "../src/Resources/ResourceManager.h"
+#include "../src/Server/BotClient.h"
+#include "../src/Server/GameServer.h"
+
+#include <sys/epoll.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Game server load generator: runs a BattleCityServer in this process and ramps up the number of bot
+// clients playing it over loopback UDP, from --bots-start to --bots-max by --bots-step every --step-seconds.
+// The bots speak the real protocol and play random inputs, or the --script file in a loop. They are
+// spread over --client-threads threads that wait on all their sockets with epoll, so thousands of them
+// fit in one process. A bot takes a snapshot as soon as it arrives: the snapshot latency is the time from
+// the start of the server tick the snapshot is of to its arrival. Every step reports the server tick time,
+// the snapshot latency percentiles and the bandwidth; the last line is the most bots the server kept up with.
+// Usage: LoadGenerator [--bots-start N] [--bots-max N] [--bots-step N] [--step-seconds S] [--rooms N] [--script FILE]
+//                      [--client-threads N] [--threads N] [--io-threads N] [--network epoll|io_uring] [--snapshot-interval TICKS]
+//                      [--view BLOCKS] [--level N] [--port P]
+
+static constexpr const char* USAGE = "Usage: LoadGenerator [--bots-start N] [--bots-max N] [--bots-step N] [--step-seconds S] [--rooms N] [--script FILE]"
+									 " [--client-threads N] [--threads N] [--io-threads N] [--network epoll|io_uring] [--snapshot-interval TICKS]"
+									 " [--view BLOCKS] [--level N] [--port P]";
+
+// the snapshot latency histogram: buckets of LATENCY_BUCKET_WIDTH microseconds, the last one takes the rest
+static constexpr size_t LATENCY_BUCKETS_COUNT = 4096;
+static constexpr uint64_t LATENCY_BUCKET_WIDTH = 10;
+static constexpr int MAX_EVENTS = 256;
+
+struct Options
+{
+	GameServerSettings server;
+	size_t botsStart = 100;
+	size_t botsMax = 1000;
+	size_t botsStep = 100;
+	double stepSeconds = 5.0;
+	unsigned int clientThreadsCount = 1;
+	std::string scriptPath;
+};
+
+// what the bots of one client thread got so far, read by the main thread between the steps
+struct ClientThreadStats
+{
+	std::atomic<uint64_t> snapshotsCount{ 0 };
+	std::atomic<uint64_t> snapshotBytes{ 0 };
+	std::atomic<uint64_t> corruptSnapshotsCount{ 0 };
+	std::atomic<uint64_t> missingBaselinesCount{ 0 };
+	std::atomic<size_t> joinedBotsCount{ 0 };
+	std::array<std::atomic<uint64_t>, LATENCY_BUCKETS_COUNT> latencyHistogram;
+
+	ClientThreadStats()
+	{
+		for (auto& currentBucket : latencyHistogram)
+		{
+			currentBucket.store(0, std::memory_order_relaxed);
+		}
+	}
+};
+
+static bool parseOptions(const int args, char** argv, Options& options)
+{
+	options.server.port = 0;
+	options.server.roomsCount = 0;
+	for (int currentArgument = 1; currentArgument < args; ++currentArgument)
+	{
+		const std::string argument = argv[currentArgument];
+		if (currentArgument + 1 >= args)
+		{
+			return false;
+		}
+		const char* value = argv[++currentArgument];
+		if (argument == "--bots-start")
+		{
+			options.botsStart = static_cast<size_t>(std::max(1, std::atoi(value)));
+		}
+		else if (argument == "--bots-max")
+		{
+			options.botsMax = static_cast<size_t>(std::max(1, std::atoi(value)));
+		}
+		else if (argument == "--bots-step")
+		{
+			options.botsStep = static_cast<size_t>(std::max(1, std::atoi(value)));
+		}
+		else if (argument == "--step-seconds")
+		{
+			options.stepSeconds = std::max(0.5, std::atof(value));
+		}
+		else if (argument == "--rooms")
+		{
+			options.server.roomsCount = static_cast<uint32_t>(std::max(1, std::atoi(value)));
+		}
+		else if (argument == "--script")
+		{
+			options.scriptPath = value;
+		}
+		else if (argument == "--client-threads")
+		{
+			options.clientThreadsCount = static_cast<unsigned int>(std::max(1, std::atoi(value)));
+		}
+		else if (argument == "--threads")
+		{
+			options.server.threadsCount = static_cast<unsigned int>(std::max(0, std::atoi(value)));
+		}
+		else if (argument == "--io-threads")
+		{
+			options.server.ioThreadsCount = static_cast<unsigned int>(std::max(1, std::atoi(value)));
+		}
+		else if (argument == "--network")
+		{
+			options.server.useIoUring = std::string(value) == "io_uring";
+		}
+		else if (argument == "--snapshot-interval")
+		{
+			options.server.snapshotInterval = static_cast<uint32_t>(std::max(1, std::atoi(value)));
+		}
+		else if (argument == "--view")
+		{
+			options.server.viewSize = std::max(0, std::atoi(value));
+		}
+		else if (argument == "--level")
+		{
+			options.server.levelIndex = static_cast<size_t>(std::max(0, std::atoi(value)));
+		}
+		else if (argument == "--port")
+		{
+			options.server.port = static_cast<uint16_t>(std::atoi(value));
+		}
+		else
+		{
+			return false;
+		}
+	}
+	options.botsStart = std::min(options.botsStart, options.botsMax);
+	// every bot gets a slot unless the rooms are given
+	if (options.server.roomsCount == 0)
+	{
+		options.server.roomsCount = static_cast<uint32_t>((options.botsMax + Game::MAX_PLAYERS - 1) / Game::MAX_PLAYERS);
+	}
+	return true;
+}
+
+// Owns the bots whose index is clientThread modulo the client threads count, creates them as the target
+// count grows and plays them until isRunning turns false.
+static void runClientThread(const size_t clientThread, const Options& options, const GameServer& server, const NetAddress& serverAddress,
+							const std::shared_ptr<const std::vector<BotClient::ScriptStep>>& pScript, const std::atomic<size_t>& targetBotsCount,
+							const std::atomic<bool>& isRunning, ClientThreadStats& threadStats)
+{
+	const int epollHandle = epoll_create1(0);
+	std::vector<std::unique_ptr<BotClient>> bots;
+	std::vector<uint32_t> lastSnapshotTicks;
+	std::array<epoll_event, MAX_EVENTS> events;
+
+	using Clock = std::chrono::steady_clock;
+	const auto tickDuration = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::milli>(Game::TICK_DURATION));
+	auto nextTickTime = Clock::now();
+	while (isRunning.load(std::memory_order_relaxed))
+	{
+		// rounded up, the thread doesn't spin through the last millisecond before the tick
+		const auto waitTime = std::chrono::duration_cast<std::chrono::microseconds>(nextTickTime - Clock::now()).count();
+		const int timeout = static_cast<int>((waitTime + 999) / 1000);
+		const int eventsCount = epoll_wait(epollHandle, events.data(), MAX_EVENTS, std::max(timeout, 0));
+		for (int currentEvent = 0; currentEvent < eventsCount; ++currentEvent)
+		{
+			const size_t bot = static_cast<size_t>(events[currentEvent].data.u64);
+			bots[bot]->receivePackets();
+			const uint32_t tick = bots[bot]->getLastSnapshotTick();
+			if (tick == lastSnapshotTicks[bot])
+			{
+				continue;
+			}
+			lastSnapshotTicks[bot] = tick;
+			const uint64_t tickStartTime = server.getTickStartTime(tick);
+			if (tickStartTime > 0)
+			{
+				const uint64_t latency = (NetworkEngine::now() - tickStartTime) / 1000;
+				threadStats.latencyHistogram[std::min(static_cast<size_t>(latency / LATENCY_BUCKET_WIDTH), LATENCY_BUCKETS_COUNT - 1)].fetch_add(1, std::memory_order_relaxed);
+			}
+		}
+
+		const auto currentTime = Clock::now();
+		if (currentTime < nextTickTime)
+		{
+			continue;
+		}
+		nextTickTime = std::max(nextTickTime + tickDuration, currentTime);
+
+		const size_t botsCount = targetBotsCount.load(std::memory_order_relaxed);
+		for (size_t currentBot = bots.size() * options.clientThreadsCount + clientThread; currentBot < botsCount; currentBot += options.clientThreadsCount)
+		{
+			auto pBot = std::make_unique<BotClient>(serverAddress, static_cast<uint32_t>(currentBot + 1));
+			pBot->setScript(pScript);
+			if (!pBot->open())
+			{
+				std::cerr << "Can't open the socket of bot " << currentBot << std::endl;
+				break;
+			}
+			epoll_event event = {};
+			event.events = EPOLLIN;
+			event.data.u64 = bots.size();
+			epoll_ctl(epollHandle, EPOLL_CTL_ADD, static_cast<int>(pBot->getNativeHandle()), &event);
+			bots.push_back(std::move(pBot));
+			lastSnapshotTicks.push_back(0);
+		}
+
+		BotClient::Stats totalStats;
+		size_t joinedBotsCount = 0;
+		for (const auto& currentBot : bots)
+		{
+			currentBot->sendPackets();
+			const BotClient::Stats& stats = currentBot->getStats();
+			totalStats.snapshotsCount += stats.snapshotsCount;
+			totalStats.snapshotBytes += stats.snapshotBytes;
+			totalStats.corruptSnapshotsCount += stats.corruptSnapshotsCount;
+			totalStats.missingBaselinesCount += stats.missingBaselinesCount;
+			joinedBotsCount += currentBot->isJoined() ? 1 : 0;
+		}
+		threadStats.snapshotsCount.store(totalStats.snapshotsCount, std::memory_order_relaxed);
+		threadStats.snapshotBytes.store(totalStats.snapshotBytes, std::memory_order_relaxed);
+		threadStats.corruptSnapshotsCount.store(totalStats.corruptSnapshotsCount, std::memory_order_relaxed);
+		threadStats.missingBaselinesCount.store(totalStats.missingBaselinesCount, std::memory_order_relaxed);
+		threadStats.joinedBotsCount.store(joinedBotsCount, std::memory_order_relaxed);
+	}
+	for (const auto& currentBot : bots)
+	{
+		currentBot->leave();
+	}
+	close(epollHandle);
+}
+
+// the upper bound of the bucket the fraction of the samples is under, in the unit of the bucket width
+template<size_t BucketsCount>
+static double getPercentile(const std::array<uint64_t, BucketsCount>& histogram, const uint64_t bucketWidth, const double fraction)
+{
+	uint64_t samplesCount = 0;
+	for (const uint64_t currentCount : histogram)
+	{
+		samplesCount += currentCount;
+	}
+	const uint64_t rank = static_cast<uint64_t>(fraction * static_cast<double>(samplesCount));
+	uint64_t count = 0;
+	for (size_t currentBucket = 0; currentBucket < BucketsCount; ++currentBucket)
+	{
+		count += histogram[currentBucket];
+		if (count > rank)
+		{
+			return static_cast<double>((currentBucket + 1) * bucketWidth);
+		}
+	}
+	return 0.0;
+}
+
+template<size_t BucketsCount>
+static double getMean(const std::array<uint64_t, BucketsCount>& histogram, const uint64_t bucketWidth)
+{
+	uint64_t samplesCount = 0;
+	double sum = 0.0;
+	for (size_t currentBucket = 0; currentBucket < BucketsCount; ++currentBucket)
+	{
+		samplesCount += histogram[currentBucket];
+		sum += histogram[currentBucket] * (currentBucket + 0.5) * bucketWidth;
+	}
+	return samplesCount > 0 ? sum / samplesCount : 0.0;
+}
+
+int main(int args, char** argv)
+{
+	Options options;
+	if (!parseOptions(args, argv, options))
+	{
+		std::cerr << USAGE << std::endl;
+		return 2;
+	}
+	ResourceManager::setExecutablePath(argv[0]);
+	ResourceManager::setHeadless(true);
+	ResourceManager::loadJSONResources("res/resourses.json");
+
+	std::shared_ptr<std::vector<BotClient::ScriptStep>> pScript;
+	if (!options.scriptPath.empty())
+	{
+		pScript = std::make_shared<std::vector<BotClient::ScriptStep>>();
+		if (!BotClient::loadScript(options.scriptPath, *pScript))
+		{
+			std::cerr << "Can't load the script " << options.scriptPath << std::endl;
+			ResourceManager::unloadAllResources();
+			return 2;
+		}
+	}
+
+	int result = 0;
+	{
+		GameServer server(options.server);
+		if (!server.init())
+		{
+			std::cerr << "Can't start the server" << std::endl;
+			ResourceManager::unloadAllResources();
+			return 2;
+		}
+		std::atomic<bool> isServerRunning{ true };
+		std::thread serverThread([&server, &isServerRunning]() { server.run(isServerRunning); });
+
+		NetAddress serverAddress;
+		NetAddress::parse("127.0.0.1:" + std::to_string(server.getPort()), serverAddress);
+		std::atomic<size_t> targetBotsCount{ 0 };
+		std::atomic<bool> areClientsRunning{ true };
+		std::vector<std::unique_ptr<ClientThreadStats>> threadStats;
+		std::vector<std::thread> clientThreads;
+		for (size_t currentThread = 0; currentThread < options.clientThreadsCount; ++currentThread)
+		{
+			threadStats.emplace_back(std::make_unique<ClientThreadStats>());
+			clientThreads.emplace_back(runClientThread, currentThread, std::cref(options), std::cref(server), std::cref(serverAddress),
+									   std::shared_ptr<const std::vector<BotClient::ScriptStep>>(pScript), std::cref(targetBotsCount),
+									   std::cref(areClientsRunning), std::ref(*threadStats.back()));
+		}
+
+		std::printf("%u rooms, %u client threads, %s bots, %s, snapshot every %u ticks\n", options.server.roomsCount, options.clientThreadsCount,
+					pScript ? "scripted" : "random", server.getNetworkBackendName(), options.server.snapshotInterval);
+		std::printf("%6s %6s | %-33s | %-26s | %-28s | %s\n", "bots", "joined", "server tick ms: mean p99 max over",
+					"snapshot latency ms: p50 p99 max", "out KB/s, B/client/s, in pk/s", "dropped, corrupt");
+
+		std::array<uint64_t, GameServer::TICK_TIME_BUCKETS_COUNT> lastTickTimes = {};
+		std::array<uint64_t, LATENCY_BUCKETS_COUNT> lastLatencies = {};
+		NetworkEngine::Stats lastNetwork;
+		uint64_t lastCorruptCount = 0;
+		size_t mostBotsKeptUpWith = 0;
+		for (size_t botsCount = options.botsStart; botsCount <= options.botsMax; botsCount += options.botsStep)
+		{
+			targetBotsCount.store(botsCount, std::memory_order_relaxed);
+			const auto stepStartTime = std::chrono::steady_clock::now();
+			std::this_thread::sleep_for(std::chrono::duration<double>(options.stepSeconds));
+			const double stepTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - stepStartTime).count();
+
+			std::array<uint64_t, GameServer::TICK_TIME_BUCKETS_COUNT> tickTimes;
+			server.getTickTimeHistogram(tickTimes);
+			std::array<uint64_t, GameServer::TICK_TIME_BUCKETS_COUNT> stepTickTimes;
+			uint64_t ticksCount = 0;
+			uint64_t overrunTicksCount = 0;
+			size_t maxTickBucket = 0;
+			for (size_t currentBucket = 0; currentBucket < tickTimes.size(); ++currentBucket)
+			{
+				stepTickTimes[currentBucket] = tickTimes[currentBucket] - lastTickTimes[currentBucket];
+				ticksCount += stepTickTimes[currentBucket];
+				overrunTicksCount += currentBucket * GameServer::TICK_TIME_BUCKET_WIDTH >= Game::TICK_DURATION * 1000.0 ? stepTickTimes[currentBucket] : 0;
+				maxTickBucket = stepTickTimes[currentBucket] > 0 ? currentBucket : maxTickBucket;
+			}
+			lastTickTimes = tickTimes;
+
+			std::array<uint64_t, LATENCY_BUCKETS_COUNT> stepLatencies = {};
+			size_t joinedBotsCount = 0;
+			uint64_t corruptCount = 0;
+			for (const auto& currentStats : threadStats)
+			{
+				for (size_t currentBucket = 0; currentBucket < LATENCY_BUCKETS_COUNT; ++currentBucket)
+				{
+					stepLatencies[currentBucket] += currentStats->latencyHistogram[currentBucket].load(std::memory_order_relaxed);
+				}
+				joinedBotsCount += currentStats->joinedBotsCount.load(std::memory_order_relaxed);
+				corruptCount += currentStats->corruptSnapshotsCount.load(std::memory_order_relaxed);
+			}
+			size_t maxLatencyBucket = 0;
+			for (size_t currentBucket = 0; currentBucket < LATENCY_BUCKETS_COUNT; ++currentBucket)
+			{
+				const uint64_t latencies = stepLatencies[currentBucket];
+				stepLatencies[currentBucket] -= lastLatencies[currentBucket];
+				lastLatencies[currentBucket] = latencies;
+				maxLatencyBucket = stepLatencies[currentBucket] > 0 ? currentBucket : maxLatencyBucket;
+			}
+
+			const NetworkEngine::Stats network = server.getNetworkStats();
+			const uint64_t sentBytes = network.sentBytes - lastNetwork.sentBytes;
+			const uint64_t droppedCount = network.droppedReceivesCount + network.droppedSendsCount - lastNetwork.droppedReceivesCount - lastNetwork.droppedSendsCount;
+			const size_t clientsCount = server.getClientsCount();
+			std::printf("%6zu %6zu | %9.3f %7.3f %7.3f %6llu | %8.2f %7.2f %7.2f | %9.1f %7.0f %9.0f | %llu, %llu\n", botsCount, joinedBotsCount,
+						getMean(stepTickTimes, GameServer::TICK_TIME_BUCKET_WIDTH) / 1000.0,
+						getPercentile(stepTickTimes, GameServer::TICK_TIME_BUCKET_WIDTH, 0.99) / 1000.0,
+						(maxTickBucket + 1) * GameServer::TICK_TIME_BUCKET_WIDTH / 1000.0, static_cast<unsigned long long>(overrunTicksCount),
+						getPercentile(stepLatencies, LATENCY_BUCKET_WIDTH, 0.5) / 1000.0, getPercentile(stepLatencies, LATENCY_BUCKET_WIDTH, 0.99) / 1000.0,
+						(maxLatencyBucket + 1) * LATENCY_BUCKET_WIDTH / 1000.0, sentBytes / stepTime / 1024.0,
+						clientsCount > 0 ? sentBytes / (clientsCount * stepTime) : 0.0, (network.receivedPacketsCount - lastNetwork.receivedPacketsCount) / stepTime,
+						static_cast<unsigned long long>(droppedCount), static_cast<unsigned long long>(corruptCount - lastCorruptCount));
+			std::fflush(stdout);
+			lastNetwork = network;
+			lastCorruptCount = corruptCount;
+			// kept up: every tick in time, on the 60 Hz budget, and nothing lost
+			if (ticksCount > 0 && overrunTicksCount * 100 <= ticksCount && droppedCount == 0)
+			{
+				mostBotsKeptUpWith = botsCount;
+			}
+			result = corruptCount > 0 ? 1 : result;
+		}
+		areClientsRunning = false;
+		for (std::thread& currentThread : clientThreads)
+		{
+			currentThread.join();
+		}
+		isServerRunning = false;
+		serverThread.join();
+		std::printf("kept up with %zu bots: at most 1%% of the ticks over %.1f ms and no packets dropped\n", mostBotsKeptUpWith, Game::TICK_DURATION);
+	}
+	ResourceManager::unloadAllResources();
+	return result;
+}
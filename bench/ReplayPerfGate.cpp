@@ -0,0 +1,295 @@
+#include "../src/Game/Game.h"
+#include "../src/Game/Replay.h"
+#include "../src/Physics/PhysicsEngine.h"
+#include "../src/Renderer/RenderSnapshot.h"
+#include "../src/Resources/ResourceManager.h"
+#include "../src/System/JobSystem.h"
+
+#include <rapidjson/document.h>
+#include <rapidjson/istreamwrapper.h>
+#include <rapidjson/prettywriter.h>
+#include <rapidjson/stringbuffer.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <tuple>
+#include <vector>
+
+// Performance regression gate: plays a recorded replay headless at its fixed tick rate and times
+// every subsystem of the simulation tick. The p50/p99 tick times are compared against a checked-in
+// baseline; a subsystem slower than baseline * (1 + tolerance) + slack fails the run. The times are
+// absolute, a baseline only holds for the machine that wrote it: see BATTLECITY_PERF_GATE in CMakeLists.txt.
+// Usage: ReplayPerfGate --replay <file> --baseline <file> [--runs N] [--write-baseline]
+
+enum ESubsystem : size_t
+{
+	GameUpdate,
+	PhysicsUpdate,
+	SnapshotBuild,
+	WholeTick,
+	SubsystemsCount
+};
+
+static const char* g_subsystemNames[SubsystemsCount] = { "game", "physics", "snapshot", "tick" };
+
+// the first ticks load lazily and warm the caches up, they are not measured
+static constexpr uint32_t WARMUP_TICKS = 60;
+
+struct Percentiles
+{
+	double p50 = 0;
+	double p99 = 0;
+};
+
+static double percentile(std::vector<double>& samples, const double p)
+{
+	if (samples.empty())
+	{
+		return 0;
+	}
+	const size_t index = std::min(samples.size() - 1, static_cast<size_t>(p * (samples.size() - 1) + 0.5));
+	std::nth_element(samples.begin(), samples.begin() + index, samples.end());
+	return samples[index];
+}
+
+static double microsecondsSince(const std::chrono::steady_clock::time_point& time)
+{
+	return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - time).count();
+}
+
+// one pass over the replay, per-tick times in microseconds
+static bool playReplay(const Replay& replay, std::array<std::vector<double>, SubsystemsCount>& samples)
+{
+	Physics::PhysicsEngine::init();
+	bool isPlayed = false;
+	{
+		Game game(glm::ivec2(13 * 16, 14 * 16));
+		if (game.init(replay.getLevelIndex()))
+		{
+			RenderEngine::RenderSnapshot snapshot;
+			const double delta = replay.getTickDuration();
+			ReplayPlayer player(replay);
+			while (!player.isFinished())
+			{
+				const uint32_t currentTick = player.getCurrentTick();
+				player.feedTick(game);
+
+				const auto tickStart = std::chrono::steady_clock::now();
+				game.update(delta);
+				const double gameTime = microsecondsSince(tickStart);
+
+				const auto physicsStart = std::chrono::steady_clock::now();
+				Physics::PhysicsEngine::update(delta);
+				const double physicsTime = microsecondsSince(physicsStart);
+
+				const auto snapshotStart = std::chrono::steady_clock::now();
+				snapshot.clear();
+				game.render(snapshot);
+				const double snapshotTime = microsecondsSince(snapshotStart);
+				const double tickTime = microsecondsSince(tickStart);
+
+				if (currentTick >= WARMUP_TICKS)
+				{
+					samples[GameUpdate].push_back(gameTime);
+					samples[PhysicsUpdate].push_back(physicsTime);
+					samples[SnapshotBuild].push_back(snapshotTime);
+					samples[WholeTick].push_back(tickTime);
+				}
+			}
+			isPlayed = true;
+		}
+	}
+	Physics::PhysicsEngine::terminate();
+	return isPlayed;
+}
+
+struct Baseline
+{
+	double tolerance = 0.5;
+	double slackMicroseconds = 2;
+	std::array<Percentiles, SubsystemsCount> subsystems;
+};
+
+static bool loadBaseline(const std::string& path, Baseline& baseline)
+{
+	std::ifstream file(path);
+	if (!file.is_open())
+	{
+		std::cerr << "Can't open baseline: " << path << std::endl;
+		return false;
+	}
+	rapidjson::IStreamWrapper stream(file);
+	rapidjson::Document document;
+	document.ParseStream(stream);
+	if (document.HasParseError() || !document.IsObject() || !document.HasMember("subsystems"))
+	{
+		std::cerr << "Bad baseline: " << path << std::endl;
+		return false;
+	}
+	if (document.HasMember("tolerance"))
+	{
+		baseline.tolerance = document["tolerance"].GetDouble();
+	}
+	if (document.HasMember("slackMicroseconds"))
+	{
+		baseline.slackMicroseconds = document["slackMicroseconds"].GetDouble();
+	}
+	const rapidjson::Value& subsystems = document["subsystems"];
+	for (size_t currentSubsystem = 0; currentSubsystem < SubsystemsCount; ++currentSubsystem)
+	{
+		const auto it = subsystems.FindMember(g_subsystemNames[currentSubsystem]);
+		if (it == subsystems.MemberEnd())
+		{
+			std::cerr << "Baseline has no subsystem: " << g_subsystemNames[currentSubsystem] << std::endl;
+			return false;
+		}
+		baseline.subsystems[currentSubsystem].p50 = it->value["p50"].GetDouble();
+		baseline.subsystems[currentSubsystem].p99 = it->value["p99"].GetDouble();
+	}
+	return true;
+}
+
+static bool writeBaseline(const std::string& path, const Baseline& baseline)
+{
+	rapidjson::StringBuffer buffer;
+	rapidjson::PrettyWriter<rapidjson::StringBuffer> writer(buffer);
+	writer.SetIndent('\t', 1);
+	writer.StartObject();
+	writer.Key("units"); writer.String("microseconds per tick");
+	writer.Key("tolerance"); writer.Double(baseline.tolerance);
+	writer.Key("slackMicroseconds"); writer.Double(baseline.slackMicroseconds);
+	writer.Key("subsystems");
+	writer.StartObject();
+	for (size_t currentSubsystem = 0; currentSubsystem < SubsystemsCount; ++currentSubsystem)
+	{
+		writer.Key(g_subsystemNames[currentSubsystem]);
+		writer.StartObject();
+		writer.Key("p50"); writer.Double(static_cast<int>(baseline.subsystems[currentSubsystem].p50 * 100) / 100.0);
+		writer.Key("p99"); writer.Double(static_cast<int>(baseline.subsystems[currentSubsystem].p99 * 100) / 100.0);
+		writer.EndObject();
+	}
+	writer.EndObject();
+	writer.EndObject();
+
+	std::ofstream file(path, std::ios::out | std::ios::trunc);
+	if (!file.is_open())
+	{
+		std::cerr << "Can't write baseline: " << path << std::endl;
+		return false;
+	}
+	file << buffer.GetString() << "\n";
+	std::cout << "Baseline written to " << path << std::endl;
+	return true;
+}
+
+int main(int args, char** argv)
+{
+	std::string replayPath;
+	std::string baselinePath;
+	int runsCount = 7;
+	bool isWritingBaseline = false;
+	for (int currentArgument = 1; currentArgument < args; ++currentArgument)
+	{
+		const std::string argument = argv[currentArgument];
+		if (argument == "--replay" && currentArgument + 1 < args)
+		{
+			replayPath = argv[++currentArgument];
+		}
+		else if (argument == "--baseline" && currentArgument + 1 < args)
+		{
+			baselinePath = argv[++currentArgument];
+		}
+		else if (argument == "--runs" && currentArgument + 1 < args)
+		{
+			runsCount = std::max(1, std::atoi(argv[++currentArgument]));
+		}
+		else if (argument == "--write-baseline")
+		{
+			isWritingBaseline = true;
+		}
+		else
+		{
+			std::cerr << "Usage: ReplayPerfGate --replay <file> --baseline <file> [--runs N] [--write-baseline]" << std::endl;
+			return 2;
+		}
+	}
+	if (replayPath.empty() || baselinePath.empty())
+	{
+		std::cerr << "Usage: ReplayPerfGate --replay <file> --baseline <file> [--runs N] [--write-baseline]" << std::endl;
+		return 2;
+	}
+
+	Replay replay;
+	if (!replay.load(replayPath))
+	{
+		return 2;
+	}
+
+	ResourceManager::setExecutablePath(argv[0]);
+	ResourceManager::setHeadless(true);
+	// the same threading as the game: the level update runs on the job system
+	JobSystem::init();
+
+	// every percentile is the median over the runs, a single noisy run doesn't fail the gate
+	std::array<std::vector<double>, SubsystemsCount> p50Runs;
+	std::array<std::vector<double>, SubsystemsCount> p99Runs;
+	for (int currentRun = 0; currentRun < runsCount; ++currentRun)
+	{
+		std::array<std::vector<double>, SubsystemsCount> samples;
+		if (!playReplay(replay, samples))
+		{
+			JobSystem::terminate();
+			return 2;
+		}
+		for (size_t currentSubsystem = 0; currentSubsystem < SubsystemsCount; ++currentSubsystem)
+		{
+			p50Runs[currentSubsystem].push_back(percentile(samples[currentSubsystem], 0.5));
+			p99Runs[currentSubsystem].push_back(percentile(samples[currentSubsystem], 0.99));
+		}
+	}
+	JobSystem::terminate();
+	ResourceManager::unloadAllResources();
+
+	Baseline measured;
+	for (size_t currentSubsystem = 0; currentSubsystem < SubsystemsCount; ++currentSubsystem)
+	{
+		measured.subsystems[currentSubsystem].p50 = percentile(p50Runs[currentSubsystem], 0.5);
+		measured.subsystems[currentSubsystem].p99 = percentile(p99Runs[currentSubsystem], 0.5);
+	}
+
+	if (isWritingBaseline)
+	{
+		return writeBaseline(baselinePath, measured) ? 0 : 2;
+	}
+
+	Baseline baseline;
+	if (!loadBaseline(baselinePath, baseline))
+	{
+		return 2;
+	}
+
+	std::printf("%u ticks at %.0f Hz, %d runs, tolerance %.0f%% + %.1f us\n",
+				replay.getTicksCount(), replay.getTickRate(), runsCount, baseline.tolerance * 100, baseline.slackMicroseconds);
+	std::printf("%-10s %5s %12s %12s %9s  %s\n", "subsystem", "", "baseline us", "measured us", "diff", "");
+	bool hasRegression = false;
+	for (size_t currentSubsystem = 0; currentSubsystem < SubsystemsCount; ++currentSubsystem)
+	{
+		const Percentiles& expected = baseline.subsystems[currentSubsystem];
+		const Percentiles& actual = measured.subsystems[currentSubsystem];
+		for (const auto& [name, expectedTime, actualTime] : { std::make_tuple("p50", expected.p50, actual.p50), std::make_tuple("p99", expected.p99, actual.p99) })
+		{
+			const bool isRegression = actualTime > expectedTime * (1 + baseline.tolerance) + baseline.slackMicroseconds;
+			hasRegression |= isRegression;
+			const double diff = expectedTime > 0 ? (actualTime / expectedTime - 1) * 100 : 0;
+			std::printf("%-10s %5s %12.2f %12.2f %+8.1f%%  %s\n", g_subsystemNames[currentSubsystem], name, expectedTime, actualTime, diff, isRegression ? "REGRESSION" : "ok");
+		}
+	}
+	std::cout << (hasRegression ? "FAILED: tick time regressed" : "PASSED") << std::endl;
+	return hasRegression ? 1 : 0;
+}
@@ -0,0 +1,224 @@
+#include "../src/Game/Game.h"
+#include "../src/Resources/ResourceManager.h"
+#include "../src/Server/BotClient.h"
+#include "../src/Server/GameServer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Game server capacity: runs a BattleCityServer in this process and --bots bot clients against it over
+// loopback UDP for --seconds, then reports how many rooms one core can tick in real time and how many
+// snapshot bytes each client gets per second, with the packet rate of the network engine, the packets it
+// moves per system call and how long a snapshot waits from the start of its tick to leaving the process.
+// The bots decode every snapshot, a snapshot that doesn't decode to the server's checksum fails the run.
+// --spectators adds spectator bots spread over the rooms: the report shows how many spectator packets
+// went out per encoded spectator snapshot, run it with and without them to see what a spectator costs.
+// Usage: ServerBench [--rooms N] [--bots N] [--spectators N] [--seconds S] [--threads N] [--io-threads N] [--network epoll|io_uring] [--snapshot-interval TICKS] [--view BLOCKS] [--view-margin BLOCKS] [--level N] [--port P]
+
+struct Options
+{
+	GameServerSettings server;
+	size_t botsCount = 0;
+	size_t spectatorsCount = 0;
+	double seconds = 10.0;
+};
+
+static bool parseOptions(const int args, char** argv, Options& options)
+{
+	options.server.port = 0;
+	options.server.roomsCount = 32;
+	for (int currentArgument = 1; currentArgument < args; ++currentArgument)
+	{
+		const std::string argument = argv[currentArgument];
+		if (currentArgument + 1 >= args)
+		{
+			return false;
+		}
+		const char* value = argv[++currentArgument];
+		if (argument == "--rooms")
+		{
+			options.server.roomsCount = static_cast<uint32_t>(std::max(1, std::atoi(value)));
+		}
+		else if (argument == "--bots")
+		{
+			options.botsCount = static_cast<size_t>(std::max(0, std::atoi(value)));
+		}
+		else if (argument == "--spectators")
+		{
+			options.spectatorsCount = static_cast<size_t>(std::max(0, std::atoi(value)));
+		}
+		else if (argument == "--seconds")
+		{
+			options.seconds = std::max(0.1, std::atof(value));
+		}
+		else if (argument == "--threads")
+		{
+			options.server.threadsCount = static_cast<unsigned int>(std::max(0, std::atoi(value)));
+		}
+		else if (argument == "--io-threads")
+		{
+			options.server.ioThreadsCount = static_cast<unsigned int>(std::max(1, std::atoi(value)));
+		}
+		else if (argument == "--network")
+		{
+			options.server.useIoUring = std::string(value) == "io_uring";
+		}
+		else if (argument == "--snapshot-interval")
+		{
+			options.server.snapshotInterval = static_cast<uint32_t>(std::max(1, std::atoi(value)));
+		}
+		else if (argument == "--view")
+		{
+			options.server.viewSize = std::max(0, std::atoi(value));
+		}
+		else if (argument == "--view-margin")
+		{
+			options.server.viewMargin = std::max(0, std::atoi(value));
+		}
+		else if (argument == "--level")
+		{
+			options.server.levelIndex = static_cast<size_t>(std::max(0, std::atoi(value)));
+		}
+		else if (argument == "--port")
+		{
+			options.server.port = static_cast<uint16_t>(std::atoi(value));
+		}
+		else
+		{
+			return false;
+		}
+	}
+	if (options.botsCount == 0)
+	{
+		options.botsCount = options.server.roomsCount * Game::MAX_PLAYERS;
+	}
+	return true;
+}
+
+int main(int args, char** argv)
+{
+	Options options;
+	if (!parseOptions(args, argv, options))
+	{
+		std::cerr << "Usage: ServerBench [--rooms N] [--bots N] [--spectators N] [--seconds S] [--threads N] [--io-threads N] [--network epoll|io_uring] [--snapshot-interval TICKS] [--view BLOCKS] [--view-margin BLOCKS] [--level N] [--port P]" << std::endl;
+		return 2;
+	}
+	ResourceManager::setExecutablePath(argv[0]);
+	ResourceManager::setHeadless(true);
+	ResourceManager::loadJSONResources("res/resourses.json");
+
+	int result = 0;
+	{
+		GameServer server(options.server);
+		if (!server.init())
+		{
+			std::cerr << "Can't start the server" << std::endl;
+			ResourceManager::unloadAllResources();
+			return 2;
+		}
+		std::atomic<bool> isServerRunning{ true };
+		std::thread serverThread([&server, &isServerRunning]() { server.run(isServerRunning); });
+
+		NetAddress serverAddress;
+		NetAddress::parse("127.0.0.1:" + std::to_string(server.getPort()), serverAddress);
+		std::vector<std::unique_ptr<BotClient>> bots;
+		for (size_t currentBot = 0; currentBot < options.botsCount + options.spectatorsCount; ++currentBot)
+		{
+			bots.emplace_back(std::make_unique<BotClient>(serverAddress, static_cast<uint32_t>(currentBot + 1)));
+			if (currentBot >= options.botsCount)
+			{
+				bots.back()->spectate(static_cast<uint32_t>((currentBot - options.botsCount) % options.server.roomsCount));
+			}
+			if (!bots.back()->open())
+			{
+				std::cerr << "Can't open the socket of bot " << currentBot << std::endl;
+				bots.pop_back();
+				break;
+			}
+		}
+
+		// the bots tick at the game's rate on this thread
+		using Clock = std::chrono::steady_clock;
+		const auto tickDuration = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::milli>(Game::TICK_DURATION));
+		const auto endTime = Clock::now() + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(options.seconds));
+		for (auto nextTickTime = Clock::now(); Clock::now() < endTime; nextTickTime += tickDuration)
+		{
+			std::this_thread::sleep_until(nextTickTime);
+			for (const auto& currentBot : bots)
+			{
+				currentBot->update();
+			}
+		}
+		size_t joinedBotsCount = 0;
+		size_t playerBotsCount = 0;
+		size_t watchingSpectatorsCount = 0;
+		BotClient::Stats botStats;
+		BotClient::Stats spectatorStats;
+		for (const auto& currentBot : bots)
+		{
+			const BotClient::Stats& stats = currentBot->getStats();
+			BotClient::Stats& totalStats = currentBot->isSpectator() ? spectatorStats : botStats;
+			(currentBot->isSpectator() ? watchingSpectatorsCount : joinedBotsCount) += currentBot->isJoined() ? 1 : 0;
+			playerBotsCount += currentBot->isSpectator() ? 0 : 1;
+			totalStats.snapshotsCount += stats.snapshotsCount;
+			totalStats.snapshotBytes += stats.snapshotBytes;
+			totalStats.missingBaselinesCount += stats.missingBaselinesCount;
+			totalStats.corruptSnapshotsCount += stats.corruptSnapshotsCount;
+			currentBot->leave();
+		}
+		isServerRunning = false;
+		serverThread.join();
+
+		const GameServer::Stats stats = server.getStats();
+		const double roomTime = stats.roomTicksCount > 0 ? stats.totalRoomTime / stats.roomTicksCount : 0.0;
+		const double clientSeconds = joinedBotsCount * stats.runTime;
+		std::printf("%u rooms, %zu of %zu bots joined, %u threads, %u I/O threads with %s, %.1f s, snapshot every %u ticks\n", options.server.roomsCount,
+					joinedBotsCount, playerBotsCount, server.getThreadsCount(), options.server.ioThreadsCount, server.getNetworkBackendName(), stats.runTime,
+					options.server.snapshotInterval);
+		std::printf("room tick: %.4f ms, %.0f rooms per core at %.0f Hz\n", roomTime, roomTime > 0.0 ? Game::TICK_DURATION / roomTime : 0.0, Game::TICK_RATE);
+		std::printf("server tick: %.3f ms mean, %.3f ms max, %llu of %llu ticks over budget\n",
+					stats.ticksCount > 0 ? stats.totalTickTime / stats.ticksCount : 0.0, stats.maxTickTime,
+					static_cast<unsigned long long>(stats.overrunTicksCount), static_cast<unsigned long long>(stats.ticksCount));
+		std::printf("snapshots: %llu sent, %.0f bytes per client per second sent, %.0f received, %.1f bytes per snapshot\n",
+					static_cast<unsigned long long>(stats.snapshotsSentCount), clientSeconds > 0.0 ? stats.snapshotBytesSent / clientSeconds : 0.0,
+					clientSeconds > 0.0 ? botStats.snapshotBytes / clientSeconds : 0.0,
+					stats.snapshotsSentCount > 0 ? static_cast<double>(stats.snapshotBytesSent) / stats.snapshotsSentCount : 0.0);
+		if (options.server.viewSize > 0)
+		{
+			std::printf("  view of %d blocks with a margin of %d, %llu entered or left a view\n", options.server.viewSize, options.server.viewMargin,
+						static_cast<unsigned long long>(stats.interestChangesCount));
+		}
+		std::printf("  %llu whole, %llu did not fit into a packet, %llu received by the bots, %llu missed the baseline, %llu corrupt\n",
+					static_cast<unsigned long long>(stats.fullSnapshotsCount), static_cast<unsigned long long>(stats.incompleteSnapshotsCount),
+					static_cast<unsigned long long>(botStats.snapshotsCount), static_cast<unsigned long long>(botStats.missingBaselinesCount),
+					static_cast<unsigned long long>(botStats.corruptSnapshotsCount));
+		if (options.spectatorsCount > 0)
+		{
+			std::printf("spectators: %zu of %zu watching, %llu snapshots encoded (%llu keyframes) for %llu packets, %.1f packets per encoding\n",
+						watchingSpectatorsCount, bots.size() - playerBotsCount, static_cast<unsigned long long>(stats.spectatorSnapshotsCount),
+						static_cast<unsigned long long>(stats.spectatorKeyframesCount), static_cast<unsigned long long>(stats.spectatorPacketsSentCount),
+						stats.spectatorSnapshotsCount > 0 ? static_cast<double>(stats.spectatorPacketsSentCount) / stats.spectatorSnapshotsCount : 0.0);
+			std::printf("  %.0f bytes per spectator per second, %llu received, %llu waited for a keyframe, %llu corrupt\n",
+						watchingSpectatorsCount > 0 && stats.runTime > 0.0 ? stats.spectatorBytesSent / (watchingSpectatorsCount * stats.runTime) : 0.0,
+						static_cast<unsigned long long>(spectatorStats.snapshotsCount), static_cast<unsigned long long>(spectatorStats.missingBaselinesCount),
+						static_cast<unsigned long long>(spectatorStats.corruptSnapshotsCount));
+		}
+		const NetworkEngine::Stats& network = stats.network;
+		std::printf("network: %.0f packets received and %.0f sent per second, %.1f packets per system call, %llu wakeups, %llu dropped\n",
+					stats.runTime > 0.0 ? network.receivedPacketsCount / stats.runTime : 0.0, stats.runTime > 0.0 ? network.sentPacketsCount / stats.runTime : 0.0,
+					network.systemCallsCount > 0 ? static_cast<double>(network.receivedPacketsCount + network.sentPacketsCount) / network.systemCallsCount : 0.0,
+					static_cast<unsigned long long>(network.wakeupsCount), static_cast<unsigned long long>(network.droppedReceivesCount + network.droppedSendsCount));
+		std::printf("tick to send: %.0f us median, %.0f us p99, %.0f us max\n", network.tickToSendMedian, network.tickToSendP99, network.tickToSendMax);
+		result = botStats.corruptSnapshotsCount == 0 && spectatorStats.corruptSnapshotsCount == 0 && joinedBotsCount > 0 ? 0 : 1;
+	}
+	ResourceManager::unloadAllResources();
+	return result;
+}
@@ -0,0 +1,355 @@
+#include "../src/Game/Level.h"
+#include "../src/Game/WorldHash.h"
+#include "../src/Game/GameObjects/Tank.h"
+#include "../src/Physics/PhysicsEngine.h"
+#include "../src/Renderer/RenderSnapshot.h"
+#include "../src/Resources/ResourceManager.h"
+#include "../src/System/JobSystem.h"
+#include "../src/System/Metrics.h"
+#include "LevelGenerator.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Scalability sweep: fills a map with N tanks that drive around and fire continuously, for every N
+// of the sweep, and measures how each subsystem of the tick scales. The tanks are the game's own
+// Tank objects with their bullets, simulated by the PhysicsEngine against a real Level.
+// Prints a CSV row per tank count and subsystem to stdout, progress goes to stderr.
+// Usage: StressSweep [--counts 10,100,...] [--map WxH | --level N] [--mode ai|random]
+//                    [--ticks N] [--seed N] [--csv <file>]
+//
+// Draw calls are the render items of the tick's snapshot: the GL thread issues one draw per item.
+// Allocations are counted by the operator new of AllocationCounter.cpp, the job system workers' included;
+// without BATTLECITY_COUNT_ALLOCATIONS the allocation columns stay 0.
+
+enum ESubsystem : size_t
+{
+	TanksAI,
+	TanksUpdate,
+	LevelUpdate,
+	PhysicsUpdate,
+	SnapshotBuild,
+	WholeTick,
+	SubsystemsCount
+};
+
+static const char* g_subsystemNames[SubsystemsCount] = { "ai", "tanks", "level", "physics", "snapshot", "tick" };
+
+enum class EDriveMode : uint8_t
+{
+	// turns when blocked, otherwise keeps its course for a while
+	AI,
+	// picks a random direction now and then regardless of the surroundings
+	RandomWalk
+};
+
+// spawning takes 1.5 s of game time, the sweep measures tanks that already drive
+static constexpr uint32_t WARMUP_TICKS = 100;
+static constexpr double TICK_DURATION = 1000.0 / 60.0;
+
+struct SubsystemStats
+{
+	std::vector<double> times;
+	uint64_t allocationsCount = 0;
+	uint64_t allocatedBytes = 0;
+};
+
+struct SweepSettings
+{
+	std::vector<size_t> tanksCounts{ 10, 100, 1000, 10000, 100000 };
+	size_t mapWidth = 64;
+	size_t mapHeight = 64;
+	int levelIndex = -1;
+	EDriveMode driveMode = EDriveMode::AI;
+	uint32_t ticksCount = 300;
+	unsigned int seed = 12345;
+	std::string csvPath;
+};
+
+// resident set size in megabytes, 0 where /proc is not available
+static double getResidentMegabytes(const char* field)
+{
+	std::ifstream status("/proc/self/status");
+	std::string line;
+	while (std::getline(status, line))
+	{
+		if (line.compare(0, std::strlen(field), field) == 0)
+		{
+			return std::strtod(line.c_str() + std::strlen(field), nullptr) / 1024.0;
+		}
+	}
+	return 0;
+}
+
+static double percentile(std::vector<double>& samples, const double p)
+{
+	if (samples.empty())
+	{
+		return 0;
+	}
+	const size_t index = std::min(samples.size() - 1, static_cast<size_t>(p * (samples.size() - 1) + 0.5));
+	std::nth_element(samples.begin(), samples.begin() + index, samples.end());
+	return samples[index];
+}
+
+class ScopedMeasure
+{
+public:
+	ScopedMeasure(SubsystemStats& stats, const bool isMeasured)
+		: m_stats(stats)
+		, m_isMeasured(isMeasured)
+		, m_allocationsCount(Metrics::getAllocationsCount())
+		, m_allocatedBytes(Metrics::getAllocatedBytes())
+		, m_start(std::chrono::steady_clock::now())
+	{
+	}
+	~ScopedMeasure()
+	{
+		if (m_isMeasured)
+		{
+			m_stats.times.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - m_start).count());
+			m_stats.allocationsCount += Metrics::getAllocationsCount() - m_allocationsCount;
+			m_stats.allocatedBytes += Metrics::getAllocatedBytes() - m_allocatedBytes;
+		}
+	}
+
+private:
+	SubsystemStats& m_stats;
+	bool m_isMeasured;
+	uint64_t m_allocationsCount;
+	uint64_t m_allocatedBytes;
+	std::chrono::steady_clock::time_point m_start;
+};
+
+static void runSweepPoint(const SweepSettings& settings, const size_t tanksCount, std::ostream& csv)
+{
+	std::mt19937 random(settings.seed);
+	const std::vector<std::string> description = settings.levelIndex >= 0
+		? ResourceManager::getLevels()[settings.levelIndex]
+		: makeLevelDescription(settings.mapWidth, settings.mapHeight, random);
+	const size_t widthBlocks = description.front().size();
+	const size_t heightBlocks = description.size();
+
+	const double residentBefore = getResidentMegabytes("VmRSS:");
+	WorldHash::reset();
+	Physics::PhysicsEngine::init();
+	auto pLevel = std::make_shared<Level>(description);
+	Physics::PhysicsEngine::setCurrentLevel(pLevel);
+
+	std::uniform_real_distribution<float> coordinateX(static_cast<float>(Level::BLOCK_SIZE), static_cast<float>((widthBlocks - 1) * Level::BLOCK_SIZE));
+	std::uniform_real_distribution<float> coordinateY(static_cast<float>(Level::BLOCK_SIZE), static_cast<float>((heightBlocks - 1) * Level::BLOCK_SIZE));
+	std::uniform_int_distribution<int> orientation(0, 3);
+	std::uniform_int_distribution<int> courseTicks(30, 180);
+	std::vector<std::shared_ptr<Tank>> tanks;
+	std::vector<int> ticksToTurn(tanksCount);
+	std::vector<glm::vec2> lastPositions(tanksCount);
+	tanks.reserve(tanksCount);
+	for (size_t currentTank = 0; currentTank < tanksCount; ++currentTank)
+	{
+		auto pTank = std::make_shared<Tank>(0.05, glm::vec2(coordinateX(random), coordinateY(random)), glm::vec2(Level::BLOCK_SIZE, Level::BLOCK_SIZE), 0.f);
+		Physics::PhysicsEngine::addDynamicGameObject(pTank);
+		pTank->setOrientation(static_cast<Tank::EOrientation>(orientation(random)));
+		ticksToTurn[currentTank] = courseTicks(random);
+		tanks.push_back(std::move(pTank));
+	}
+	const double residentAfterSetup = getResidentMegabytes("VmRSS:");
+
+	std::array<SubsystemStats, SubsystemsCount> stats;
+	for (SubsystemStats& subsystem : stats)
+	{
+		// the measurement itself must not allocate inside the measured ticks
+		subsystem.times.reserve(settings.ticksCount);
+	}
+	RenderEngine::RenderSnapshot snapshot;
+	uint64_t drawCalls = 0;
+	const auto sweepStart = std::chrono::steady_clock::now();
+	for (uint32_t currentTick = 0; currentTick < WARMUP_TICKS + settings.ticksCount; ++currentTick)
+	{
+		const bool isMeasured = currentTick >= WARMUP_TICKS;
+		ScopedMeasure tickMeasure(stats[WholeTick], isMeasured);
+		{
+			ScopedMeasure measure(stats[TanksAI], isMeasured);
+			for (size_t currentTank = 0; currentTank < tanksCount; ++currentTank)
+			{
+				Tank& tank = *tanks[currentTank];
+				const bool isBlocked = settings.driveMode == EDriveMode::AI && tank.getCurrentPosition() == lastPositions[currentTank];
+				if (--ticksToTurn[currentTank] <= 0 || isBlocked)
+				{
+					tank.setOrientation(static_cast<Tank::EOrientation>(orientation(random)));
+					ticksToTurn[currentTank] = courseTicks(random);
+				}
+				lastPositions[currentTank] = tank.getCurrentPosition();
+				tank.setVelocity(tank.getMaxVelocity());
+				tank.fire();
+			}
+		}
+		{
+			ScopedMeasure measure(stats[TanksUpdate], isMeasured);
+			for (const auto& pTank : tanks)
+			{
+				pTank->update(TICK_DURATION);
+			}
+		}
+		{
+			ScopedMeasure measure(stats[LevelUpdate], isMeasured);
+			pLevel->update(TICK_DURATION);
+		}
+		{
+			ScopedMeasure measure(stats[PhysicsUpdate], isMeasured);
+			Physics::PhysicsEngine::update(TICK_DURATION);
+		}
+		{
+			ScopedMeasure measure(stats[SnapshotBuild], isMeasured);
+			snapshot.clear();
+			for (const auto& pTank : tanks)
+			{
+				pTank->render(snapshot);
+			}
+			pLevel->render(snapshot);
+		}
+		if (isMeasured)
+		{
+			drawCalls += snapshot.getItems().size();
+		}
+	}
+	const double sweepSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - sweepStart).count();
+	const double residentAfterRun = getResidentMegabytes("VmRSS:");
+
+	tanks.clear();
+	Physics::PhysicsEngine::terminate();
+	pLevel.reset();
+
+	for (size_t currentSubsystem = 0; currentSubsystem < SubsystemsCount; ++currentSubsystem)
+	{
+		SubsystemStats& subsystem = stats[currentSubsystem];
+		double totalTime = 0;
+		for (const double time : subsystem.times)
+		{
+			totalTime += time;
+		}
+		const double meanTime = subsystem.times.empty() ? 0 : totalTime / subsystem.times.size();
+		csv << tanksCount << ',' << widthBlocks << 'x' << heightBlocks << ',' << g_subsystemNames[currentSubsystem] << ','
+			<< meanTime << ',' << percentile(subsystem.times, 0.5) << ',' << percentile(subsystem.times, 0.99) << ','
+			<< static_cast<double>(subsystem.allocationsCount) / settings.ticksCount << ','
+			<< static_cast<double>(subsystem.allocatedBytes) / settings.ticksCount << ','
+			<< (currentSubsystem == SnapshotBuild ? static_cast<double>(drawCalls) / settings.ticksCount : 0.0) << ','
+			<< residentAfterSetup - residentBefore << ',' << residentAfterRun << '\n';
+	}
+	csv.flush();
+	std::cerr << tanksCount << " tanks: " << sweepSeconds << " s, tick p50 " << percentile(stats[WholeTick].times, 0.5) << " us" << std::endl;
+}
+
+static bool parseArguments(const int args, char** argv, SweepSettings& settings)
+{
+	for (int currentArgument = 1; currentArgument < args; ++currentArgument)
+	{
+		const std::string argument = argv[currentArgument];
+		const bool hasValue = currentArgument + 1 < args;
+		if (argument == "--counts" && hasValue)
+		{
+			settings.tanksCounts.clear();
+			std::stringstream counts(argv[++currentArgument]);
+			for (std::string count; std::getline(counts, count, ',');)
+			{
+				settings.tanksCounts.push_back(std::strtoull(count.c_str(), nullptr, 10));
+			}
+		}
+		else if (argument == "--map" && hasValue)
+		{
+			if (std::sscanf(argv[++currentArgument], "%zux%zu", &settings.mapWidth, &settings.mapHeight) != 2 || settings.mapWidth < 3 || settings.mapHeight < 3)
+			{
+				return false;
+			}
+		}
+		else if (argument == "--level" && hasValue)
+		{
+			settings.levelIndex = std::atoi(argv[++currentArgument]);
+		}
+		else if (argument == "--mode" && hasValue)
+		{
+			const std::string mode = argv[++currentArgument];
+			if (mode != "ai" && mode != "random")
+			{
+				return false;
+			}
+			settings.driveMode = mode == "ai" ? EDriveMode::AI : EDriveMode::RandomWalk;
+		}
+		else if (argument == "--ticks" && hasValue)
+		{
+			settings.ticksCount = static_cast<uint32_t>(std::max(1, std::atoi(argv[++currentArgument])));
+		}
+		else if (argument == "--seed" && hasValue)
+		{
+			settings.seed = static_cast<unsigned int>(std::strtoul(argv[++currentArgument], nullptr, 10));
+		}
+		else if (argument == "--csv" && hasValue)
+		{
+			settings.csvPath = argv[++currentArgument];
+		}
+		else
+		{
+			return false;
+		}
+	}
+	return !settings.tanksCounts.empty();
+}
+
+int main(int args, char** argv)
+{
+	SweepSettings settings;
+	if (!parseArguments(args, argv, settings))
+	{
+		std::cerr << "Usage: StressSweep [--counts 10,100,...] [--map WxH | --level N] [--mode ai|random] [--ticks N] [--seed N] [--csv <file>]" << std::endl;
+		return 2;
+	}
+
+	ResourceManager::setExecutablePath(argv[0]);
+	ResourceManager::setHeadless(true);
+	ResourceManager::loadJSONResources("res/resourses.json");
+	if (ResourceManager::getLevels().empty())
+	{
+		std::cerr << "Can't load res/resourses.json" << std::endl;
+		return 2;
+	}
+	if (settings.levelIndex >= static_cast<int>(ResourceManager::getLevels().size()))
+	{
+		std::cerr << "Can't find level: " << settings.levelIndex << std::endl;
+		return 2;
+	}
+
+	std::ofstream csvFile;
+	if (!settings.csvPath.empty())
+	{
+		csvFile.open(settings.csvPath, std::ios::out | std::ios::trunc);
+		if (!csvFile.is_open())
+		{
+			std::cerr << "Can't write " << settings.csvPath << std::endl;
+			return 2;
+		}
+	}
+	std::ostream& csv = csvFile.is_open() ? csvFile : std::cout;
+	csv << "tanks,map,subsystem,mean_us,p50_us,p99_us,allocations_per_tick,allocated_bytes_per_tick,draw_calls_per_tick,setup_rss_mb,rss_mb\n";
+
+	// the same threading as the game: the level update runs on the job system
+	JobSystem::init();
+	for (const size_t tanksCount : settings.tanksCounts)
+	{
+		runSweepPoint(settings, tanksCount, csv);
+	}
+	JobSystem::terminate();
+
+	ResourceManager::unloadAllResources();
+	return 0;
+}
@@ -1,6 +1,7 @@
 #include "Game.h"
 #include "../Resources/ResourceManager.h"
 #include <iostream>
+#include <algorithm>
 #include "../Renderer/ShaderProgram.h"
 #include "../Renderer/Texture2D.h"
 #include "../Renderer/Sprite.h"
@@ -11,12 +12,24 @@
 #include <GLFW/glfw3.h>
 #include "Level.h"
 #include "../Physics/PhysicsEngine.h"
+#include "../System/Profiler.h"
+#include "Replay.h"
+#include "WorldHash.h"
 
 Game::Game(const glm::ivec2& windowSize)
-    :m_windowSize(windowSize)
+    :m_tickInputTimestamp(0)
+    ,m_hasExternalInput(false)
+    ,m_ticksCount(0)
+    ,m_pReplayRecorder(nullptr)
+    ,m_windowSize(windowSize)
     ,m_eCurrentGameState(EGameState::Active)
+    ,m_levelIndex(0)
+    ,m_playersCount(0)
+    ,m_stateSize(0)
 {
     m_keys.fill(false);
+    m_keysPressedInTick.fill(false);
+    m_playerInputs.fill(0);
 }
 
 Game::~Game()
@@ -24,92 +37,306 @@ Game::~Game()
 
 }
 
-void Game::render()
+void Game::render(RenderEngine::RenderSnapshot& snapshot) const
 {
-    if (m_pTank)
+    PROFILE_ZONE("Game::render");
+    snapshot.beginPass("units");
+    for (size_t currentPlayer = 0; currentPlayer < m_playersCount; ++currentPlayer)
     {
-        m_pTank->render();
+        m_pTanks[currentPlayer]->render(snapshot);
     }
+    snapshot.beginPass("terrain");
     if (m_pLevel)
     {
-        m_pLevel->render();
+        m_pLevel->render(snapshot);
     }
+    snapshot.setInputTimestamp(m_tickInputTimestamp);
 }
 
 void Game::update(const double delta)
 {
+    PROFILE_ZONE("Game::update");
+    // several ticks may run before the next snapshot, it keeps the input of the last tick that had any
+    const uint64_t inputTimestamp = m_inputQueue.drain(InputQueue::now(), [this](const InputEvent& event) { applyInputEvent(event); });
+    m_tickInputTimestamp = inputTimestamp != 0 ? inputTimestamp : m_tickInputTimestamp;
+    if (m_eCurrentGameState == EGameState::Pause)
+    {
+        // the keys pressed while paused are kept for the next simulated tick, the replay records them at it
+        return;
+    }
+
+    if (m_pReplayRecorder)
+    {
+        m_pReplayRecorder->setChecksum(m_ticksCount, WorldHash::getChecksum());
+    }
+
     if (m_pLevel)
     {
         m_pLevel->update(delta);
     }
 
-    if (m_pTank)
+    if (!m_hasExternalInput)
     {
-        if (m_keys[GLFW_KEY_W])
-        {
-            m_pTank->setOrientation(Tank::EOrientation::Top);
-            m_pTank->setVelocity(m_pTank->getMaxVelocity());
-        }
-        else if (m_keys[GLFW_KEY_A])
-        {
-            m_pTank->setOrientation(Tank::EOrientation::Left);
-            m_pTank->setVelocity(m_pTank->getMaxVelocity());
-        }
-        else if (m_keys[GLFW_KEY_D])
-        {
-            m_pTank->setOrientation(Tank::EOrientation::Right);
-            m_pTank->setVelocity(m_pTank->getMaxVelocity());
-        }
-        else if (m_keys[GLFW_KEY_S])
-        {
-            m_pTank->setOrientation(Tank::EOrientation::Bottom);
-            m_pTank->setVelocity(m_pTank->getMaxVelocity());
-        }
-        else
-        {
-            m_pTank->setVelocity(0);
-        }
+        m_playerInputs[0] = getKeyboardInput();
+    }
+    for (size_t currentPlayer = 0; currentPlayer < m_playersCount; ++currentPlayer)
+    {
+        applyPlayerInput(*m_pTanks[currentPlayer], m_playerInputs[currentPlayer]);
+        m_pTanks[currentPlayer]->update(delta);
+    }
+    m_keysPressedInTick.fill(false);
+    ++m_ticksCount;
+    if (m_pReplayRecorder)
+    {
+        m_pReplayRecorder->setTicksCount(m_ticksCount);
+    }
+}
 
-        if (m_pTank && m_keys[GLFW_KEY_SPACE])
-        {
-            m_pTank->fire();
-        }
+uint8_t Game::getKeyboardInput() const
+{
+    // one direction at a time, in the order the keys were always checked
+    uint8_t input = 0;
+    if (isKeyActive(GLFW_KEY_W))
+    {
+        input = INPUT_UP;
+    }
+    else if (isKeyActive(GLFW_KEY_A))
+    {
+        input = INPUT_LEFT;
+    }
+    else if (isKeyActive(GLFW_KEY_D))
+    {
+        input = INPUT_RIGHT;
+    }
+    else if (isKeyActive(GLFW_KEY_S))
+    {
+        input = INPUT_DOWN;
+    }
+    if (isKeyActive(GLFW_KEY_SPACE))
+    {
+        input |= INPUT_FIRE;
+    }
+    return input;
+}
 
-        m_pTank->update(delta);
+void Game::applyPlayerInput(Tank& tank, const uint8_t input)
+{
+    if (input & INPUT_UP)
+    {
+        tank.setOrientation(Tank::EOrientation::Top);
+        tank.setVelocity(tank.getMaxVelocity());
+    }
+    else if (input & INPUT_LEFT)
+    {
+        tank.setOrientation(Tank::EOrientation::Left);
+        tank.setVelocity(tank.getMaxVelocity());
+    }
+    else if (input & INPUT_RIGHT)
+    {
+        tank.setOrientation(Tank::EOrientation::Right);
+        tank.setVelocity(tank.getMaxVelocity());
+    }
+    else if (input & INPUT_DOWN)
+    {
+        tank.setOrientation(Tank::EOrientation::Bottom);
+        tank.setVelocity(tank.getMaxVelocity());
+    }
+    else
+    {
+        tank.setVelocity(0);
+    }
+
+    if (input & INPUT_FIRE)
+    {
+        tank.fire();
     }
 }
 
+uint8_t Game::pollLocalInput()
+{
+    const uint64_t inputTimestamp = m_inputQueue.drain(InputQueue::now(), [this](const InputEvent& event) { applyInputEvent(event); });
+    m_tickInputTimestamp = inputTimestamp != 0 ? inputTimestamp : m_tickInputTimestamp;
+    const uint8_t input = getKeyboardInput();
+    m_keysPressedInTick.fill(false);
+    return input;
+}
+
+void Game::setPlayerInput(const size_t player, const uint8_t input)
+{
+    if (player < MAX_PLAYERS)
+    {
+        m_playerInputs[player] = input;
+        m_hasExternalInput = true;
+    }
+}
+
+glm::vec2 Game::getPlayerPosition(const size_t player) const
+{
+    if (player >= MAX_PLAYERS || !m_pTanks[player])
+    {
+        return glm::vec2(0.f);
+    }
+    return m_pTanks[player]->getCurrentPosition() + m_pTanks[player]->getSize() / 2.f;
+}
+
 void Game::setKey(const int key, const int action)
 {
-    m_keys[key] = action;
+    m_inputQueue.push(key, action);
 }
 
-bool Game::init()
+void Game::applyInputEvent(const InputEvent& event)
 {
-    ResourceManager::loadJSONResources("res/resourses.json");
+    if (event.key < 0 || event.key >= static_cast<int>(m_keys.size()))
+    {
+        return;
+    }
+    if (m_pReplayRecorder)
+    {
+        // events applied while paused act on the next simulated tick
+        m_pReplayRecorder->addEvent(m_ticksCount, event.key, event.action);
+    }
+    m_keys[event.key] = event.action != GLFW_RELEASE;
+    if (event.action == GLFW_PRESS)
+    {
+        m_keysPressedInTick[event.key] = true;
+    }
+}
 
-    auto pSpriteShaderProgram = ResourceManager::getShaderProgram("spriteShader");
-    if (!pSpriteShaderProgram)
+bool Game::init(const size_t levelIndex, const size_t playersCount)
+{
+    // the resources are loaded once per process, a server initializes a game per room
+    if (ResourceManager::getLevels().empty())
+    {
+        ResourceManager::loadJSONResources("res/resourses.json");
+    }
+
+    // a headless game has no shaders, it simulates and fills render snapshots only
+    std::shared_ptr<RenderEngine::ShaderProgram> pSpriteShaderProgram;
+    if (!ResourceManager::isHeadless())
+    {
+        pSpriteShaderProgram = ResourceManager::getShaderProgram("spriteShader"_rid);
+    }
+    if (!pSpriteShaderProgram && !ResourceManager::isHeadless())
     {
         std::cerr << "Can't find shader program: " << "spriteShader" << std::endl;
         return false;
     }
+    if (levelIndex >= ResourceManager::getLevels().size())
+    {
+        std::cerr << "Can't find level: " << levelIndex << std::endl;
+        return false;
+    }
 
-    m_pLevel = std::make_shared<Level>(ResourceManager::getLevels()[1]);
+    m_levelIndex = levelIndex;
+    m_playersCount = std::clamp<size_t>(playersCount, 1, MAX_PLAYERS);
+    m_ticksCount = 0;
+    WorldHash::reset();
+    m_pLevel = std::make_shared<Level>(ResourceManager::getLevels()[levelIndex]);
     m_windowSize.x = static_cast<int>(m_pLevel->getLewelWidth());
     m_windowSize.y = static_cast<int>(m_pLevel->getLewelHeight());
     Physics::PhysicsEngine::setCurrentLevel(m_pLevel);
 
     glm::mat4 projectionMatrix = glm::ortho(0.f, static_cast<float>(m_windowSize.x), 0.f, static_cast<float>(m_windowSize.y), -100.f, 100.f);
 
-    pSpriteShaderProgram->use();  
-    pSpriteShaderProgram->setInt("tex", 0);
-    pSpriteShaderProgram->setMatrix4("projectionMat", projectionMatrix); 
+    if (pSpriteShaderProgram)
+    {
+        pSpriteShaderProgram->use();
+        pSpriteShaderProgram->setInt("tex", 0);
+        pSpriteShaderProgram->setMatrix4("projectionMat", projectionMatrix);
+    }
       
-    m_pTank = std::make_shared<Tank>(0.05, m_pLevel->getPlayerRespawn_1(), glm::vec2(Level::BLOCK_SIZE, Level::BLOCK_SIZE), 0.f);
-    Physics::PhysicsEngine::addDynamicGameObject(m_pTank);
+    const glm::ivec2 playerRespawns[MAX_PLAYERS] = { m_pLevel->getPlayerRespawn_1(), m_pLevel->getPlayerRespawn_2() };
+    for (size_t currentPlayer = 0; currentPlayer < MAX_PLAYERS; ++currentPlayer)
+    {
+        m_pTanks[currentPlayer] = nullptr;
+        if (currentPlayer < m_playersCount)
+        {
+            m_pTanks[currentPlayer] = std::make_shared<Tank>(0.05, playerRespawns[currentPlayer], glm::vec2(Level::BLOCK_SIZE, Level::BLOCK_SIZE), 0.f);
+            Physics::PhysicsEngine::addDynamicGameObject(m_pTanks[currentPlayer]);
+        }
+    }
+
+    // every object's layout is fixed from here on, so is the size of the world state
+    WorldState layoutState;
+    saveState(layoutState);
+    m_stateSize = layoutState.getSize();
     return true;  
 } 
+void Game::saveState(WorldState& state) const
+{
+    PROFILE_ZONE("Game::saveState");
+    state.clear();
+    state.write(WORLD_STATE_MAGIC);
+    state.write(static_cast<uint32_t>(m_levelIndex));
+    state.write(static_cast<uint32_t>(m_playersCount));
+    state.write(m_ticksCount);
+    state.write(m_keys);
+    state.write(m_keysPressedInTick);
+    state.write(m_playerInputs);
+    state.write(WorldHash::getHash());
+    if (m_pLevel)
+    {
+        m_pLevel->saveState(state);
+    }
+    for (size_t currentPlayer = 0; currentPlayer < m_playersCount; ++currentPlayer)
+    {
+        m_pTanks[currentPlayer]->saveState(state);
+    }
+}
+
+bool Game::restoreState(const WorldState& state)
+{
+    PROFILE_ZONE("Game::restoreState");
+    WorldState::Reader reader(state);
+    uint32_t magic = 0;
+    uint32_t levelIndex = 0;
+    uint32_t playersCount = 0;
+    reader.read(magic);
+    reader.read(levelIndex);
+    reader.read(playersCount);
+    if (reader.hasFailed() || magic != WORLD_STATE_MAGIC || levelIndex != m_levelIndex || playersCount != m_playersCount || !m_pLevel)
+    {
+        std::cerr << "Can't restore a world state of another level" << std::endl;
+        return false;
+    }
+    // the objects overwrite themselves one by one, a truncated state must be rejected before the first
+    if (state.getSize() != m_stateSize)
+    {
+        std::cerr << "World state is " << state.getSize() << " bytes, the level's is " << m_stateSize << std::endl;
+        return false;
+    }
+    uint32_t ticksCount = 0;
+    std::array<bool, 349> keys;
+    std::array<bool, 349> keysPressedInTick;
+    std::array<uint8_t, MAX_PLAYERS> playerInputs;
+    uint64_t worldHash = 0;
+    reader.read(ticksCount);
+    reader.read(keys);
+    reader.read(keysPressedInTick);
+    reader.read(playerInputs);
+    reader.read(worldHash);
+    // the level checks its objects count before it restores anything, the size check makes a mismatch
+    // past this point impossible for a state the game could have saved
+    if (reader.hasFailed() || !m_pLevel->restoreState(reader))
+    {
+        std::cerr << "World state doesn't match the level" << std::endl;
+        return false;
+    }
+    for (size_t currentPlayer = 0; currentPlayer < m_playersCount; ++currentPlayer)
+    {
+        m_pTanks[currentPlayer]->restoreState(reader);
+    }
+    m_ticksCount = ticksCount;
+    m_playerInputs = playerInputs;
+    if (!m_hasExternalInput)
+    {
+        m_keys = keys;
+        m_keysPressedInTick = keysPressedInTick;
+    }
+    WorldHash::setHash(worldHash);
+    return !reader.hasFailed() && reader.isAtEnd();
+}
+
 size_t Game::getCurrentLewelWidth() const
 {
     return m_pLevel->getLewelWidth();
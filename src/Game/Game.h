@@ -2,25 +2,78 @@
 
 #include <glm/vec2.hpp>
 #include <array>
+#include <atomic>
+#include <memory>
+#include "../System/InputQueue.h"
+#include "WorldState.h"
 
 class Tank;
 class Level;
+class Replay;
+
+namespace RenderEngine
+{
+	class RenderSnapshot;
+}
 
 class Game
 {
 public:
+	// the simulation advances in fixed ticks only, the same inputs give the same game on every run
+	static constexpr double TICK_RATE = 60.0;
+	// milliseconds
+	static constexpr double TICK_DURATION = 1000.0 / TICK_RATE;
+	static constexpr size_t MAX_PLAYERS = 2;
+	// the input of a player in one tick, a bit per control
+	static constexpr uint8_t INPUT_UP = 1 << 0;
+	static constexpr uint8_t INPUT_DOWN = 1 << 1;
+	static constexpr uint8_t INPUT_LEFT = 1 << 2;
+	static constexpr uint8_t INPUT_RIGHT = 1 << 3;
+	static constexpr uint8_t INPUT_FIRE = 1 << 4;
+
 	Game(const glm::ivec2& windowSize);
 	~Game();
 
-	void render();
+	void render(RenderEngine::RenderSnapshot& snapshot) const;
 	void update(const double delta);
 	void setKey(const int key, const int action);
-	bool init();
+	InputQueue& getInputQueue() { return m_inputQueue; }
+	// the window thread pauses the game, a paused game doesn't simulate
+	void setPause(const bool pause) { m_eCurrentGameState = pause ? EGameState::Pause : EGameState::Active; }
+	bool isPaused() const { return m_eCurrentGameState == EGameState::Pause; }
+	// the second player's tank starts at the level's second player respawn
+	bool init(const size_t levelIndex = 1, const size_t playersCount = 1);
+	size_t getLevelIndex() const { return m_levelIndex; }
+	size_t getPlayersCount() const { return m_playersCount; }
+	// the keyboard as a player input: applies the queued key events and reads the keys held or pressed since the last poll
+	uint8_t pollLocalInput();
+	// A networked game sets the input of every player before each tick and the tick doesn't read the
+	// keyboard any more. The keys are then local device state and a restored world state leaves them alone.
+	void setPlayerInput(const size_t player, const uint8_t input);
+	// the center of the player's tank in level pixels
+	glm::vec2 getPlayerPosition(const size_t player) const;
+	// ticks simulated since init, paused ticks are not counted
+	uint32_t getTicksCount() const { return m_ticksCount; }
+	// every input event applied from now on is recorded with its tick, nullptr stops recording
+	void setReplayRecorder(Replay* pReplay) { m_pReplayRecorder = pReplay; }
+	// The whole simulation state between two ticks: the tick counter, the keys held and pressed in
+	// the tick, every object and the world hash. Events still waiting in the input queue and the input
+	// latency timestamp are not part of it. A state restores only into a game of the same level,
+	// restoreState() returns false and leaves the game as it is for a state of another level or
+	// of another size than the level's states, e.g. a truncated one.
+	void saveState(WorldState& state) const;
+	bool restoreState(const WorldState& state);
 	size_t getCurrentLewelWidth() const;
 	size_t getCurrentLewelHeight() const;
 
 private:
-	std::array<bool, 349> m_keys;
+	void applyInputEvent(const InputEvent& event);
+	bool isKeyActive(const int key) const { return m_keys[key] || m_keysPressedInTick[key]; }
+	uint8_t getKeyboardInput() const;
+	static void applyPlayerInput(Tank& tank, const uint8_t input);
+
+	// "BCWS", the first bytes of every saved world state
+	static constexpr uint32_t WORLD_STATE_MAGIC = 0x53574342;
 
 	enum class EGameState
 	{
@@ -28,8 +81,22 @@ private:
 		Pause
 	};
 
+	InputQueue m_inputQueue;
+	// a key pressed and released between two ticks still acts for one tick
+	std::array<bool, 349> m_keys;
+	std::array<bool, 349> m_keysPressedInTick;
+	uint64_t m_tickInputTimestamp;
+	std::array<uint8_t, MAX_PLAYERS> m_playerInputs;
+	bool m_hasExternalInput;
+	uint32_t m_ticksCount;
+	Replay* m_pReplayRecorder;
+
 	glm::ivec2 m_windowSize;
-	EGameState m_eCurrentGameState;
-	std::shared_ptr<Tank> m_pTank;
+	std::atomic<EGameState> m_eCurrentGameState;
+	std::array<std::shared_ptr<Tank>, MAX_PLAYERS> m_pTanks;
 	std::shared_ptr<Level> m_pLevel;
+	size_t m_levelIndex;
+	size_t m_playersCount;
+	// the size of every state saveState() writes for the current level
+	size_t m_stateSize;
 };
\ No newline at end of file
@@ -8,7 +8,7 @@ BetonWall::BetonWall(const EBetonWallType eBetonWallType, const glm::vec2& posit
 							EBlockState::Destroyed,
 							EBlockState::Destroyed,
 							EBlockState::Destroyed }
-	, m_sprite(ResourceManager::getSprite("betonWall"))
+	, m_sprite(ResourceManager::getSprite("betonWall"_rid))
 	, m_blockOffsets { glm::vec2(0, m_size.y / 2.f),
 					   glm::vec2(m_size.x / 2.f, m_size.y / 2.f),
 					   glm::vec2(0, 0),
@@ -58,20 +58,20 @@ BetonWall::BetonWall(const EBetonWallType eBetonWallType, const glm::vec2& posit
 		break;
 	}
 }
-void BetonWall::renderBlock(const EBlockLocation eBlockLocation) const
+void BetonWall::renderBlock(RenderEngine::RenderSnapshot& snapshot, const EBlockLocation eBlockLocation) const
 {
 	const EBlockState state = m_eCurrentBlockState[static_cast<size_t>(eBlockLocation)];
 	if (state != EBlockState::Destroyed)
 	{
-		m_sprite->render(m_position + m_blockOffsets[static_cast<size_t>(eBlockLocation)], m_size / 2.f, m_rotation, m_layer);
+		snapshot.submit(m_sprite.get(), m_position + m_blockOffsets[static_cast<size_t>(eBlockLocation)], m_size / 2.f, m_rotation, m_layer);
 	}
 }
-void BetonWall::render() const
+void BetonWall::render(RenderEngine::RenderSnapshot& snapshot) const
 {
-	renderBlock(EBlockLocation::TopLeft);
-	renderBlock(EBlockLocation::TopRight);
-	renderBlock(EBlockLocation::BottomLeft);
-	renderBlock(EBlockLocation::BottomRight);
+	renderBlock(snapshot, EBlockLocation::TopLeft);
+	renderBlock(snapshot, EBlockLocation::TopRight);
+	renderBlock(snapshot, EBlockLocation::BottomLeft);
+	renderBlock(snapshot, EBlockLocation::BottomRight);
 }
 void BetonWall::update(const double delta)
 {
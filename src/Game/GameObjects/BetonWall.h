@@ -38,10 +38,10 @@ public:
 	};
 
 	BetonWall(const EBetonWallType eBetonWallType, const glm::vec2& position, const glm::vec2& size, const float rotation, const float layer);
-	virtual void render() const override;
+	virtual void render(RenderEngine::RenderSnapshot& snapshot) const override;
 	virtual void update(const double delta) override;
 private:
-	void renderBlock(const EBlockLocation eBlockLocation) const;
+	void renderBlock(RenderEngine::RenderSnapshot& snapshot, const EBlockLocation eBlockLocation) const;
 	std::array<EBlockState, 4> m_eCurrentBlockState;
 	std::shared_ptr<RenderEngine::Sprite> m_sprite;
 	std::array<glm::vec2, 4> m_blockOffsets;
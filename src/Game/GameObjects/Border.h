@@ -14,7 +14,7 @@ class Border : public IGameObject
 public:
 
 	Border(const glm::vec2& position, const glm::vec2& size, const float rotation, const float layer);
-	virtual void render() const override;
+	virtual void render(RenderEngine::RenderSnapshot& snapshot) const override;
 
 private:
 	std::shared_ptr<RenderEngine::Sprite> m_sprite;
@@ -13,21 +13,21 @@ BrickWall::BrickWall(const EBrickWallType eBrickWallType, const glm::vec2& posit
 					   glm::vec2(0, 0),
 					   glm::vec2(m_size.x / 2.f, 0) }
 {
-	m_sprites[static_cast<size_t>(EBrickState::All)]					= ResourceManager::getSprite("brickWall_All");
-	m_sprites[static_cast<size_t>(EBrickState::TopLeft)]				= ResourceManager::getSprite("brickWall_TopLeft");
-	m_sprites[static_cast<size_t>(EBrickState::TopRight)]				= ResourceManager::getSprite("brickWall_TopRight");
-	m_sprites[static_cast<size_t>(EBrickState::Top)]					= ResourceManager::getSprite("brickWall_Top");
-	m_sprites[static_cast<size_t>(EBrickState::BottomLeft)]				= ResourceManager::getSprite("brickWall_BottomLeft");
-	m_sprites[static_cast<size_t>(EBrickState::Left)]					= ResourceManager::getSprite("brickWall_Left");
-	m_sprites[static_cast<size_t>(EBrickState::TopRight_BottomLeft)]	= ResourceManager::getSprite("brickWall_TopRight_BottomLeft");
-	m_sprites[static_cast<size_t>(EBrickState::Top_BottomLeft)]			= ResourceManager::getSprite("brickWall_Top_BottomLeft");
-	m_sprites[static_cast<size_t>(EBrickState::BottomRight)]			= ResourceManager::getSprite("brickWall_BottomRight");
-	m_sprites[static_cast<size_t>(EBrickState::TopLeft_BottomRight)]	= ResourceManager::getSprite("brickWall_TopLeft_BottomRight");
-	m_sprites[static_cast<size_t>(EBrickState::Right)]					= ResourceManager::getSprite("brickWall_Right");
-	m_sprites[static_cast<size_t>(EBrickState::Top_BottomRight)]		= ResourceManager::getSprite("brickWall_Top_BottomRight");
-	m_sprites[static_cast<size_t>(EBrickState::Bottom)]					= ResourceManager::getSprite("brickWall_Bottom");
-	m_sprites[static_cast<size_t>(EBrickState::TopLeft_Bottom)]			= ResourceManager::getSprite("brickWall_TopLeft_Bottom");
-	m_sprites[static_cast<size_t>(EBrickState::TopRight_Bottom)]		= ResourceManager::getSprite("brickWall_TopRight_Bottom");
+	m_sprites[static_cast<size_t>(EBrickState::All)]					= ResourceManager::getSprite("brickWall_All"_rid);
+	m_sprites[static_cast<size_t>(EBrickState::TopLeft)]				= ResourceManager::getSprite("brickWall_TopLeft"_rid);
+	m_sprites[static_cast<size_t>(EBrickState::TopRight)]				= ResourceManager::getSprite("brickWall_TopRight"_rid);
+	m_sprites[static_cast<size_t>(EBrickState::Top)]					= ResourceManager::getSprite("brickWall_Top"_rid);
+	m_sprites[static_cast<size_t>(EBrickState::BottomLeft)]				= ResourceManager::getSprite("brickWall_BottomLeft"_rid);
+	m_sprites[static_cast<size_t>(EBrickState::Left)]					= ResourceManager::getSprite("brickWall_Left"_rid);
+	m_sprites[static_cast<size_t>(EBrickState::TopRight_BottomLeft)]	= ResourceManager::getSprite("brickWall_TopRight_BottomLeft"_rid);
+	m_sprites[static_cast<size_t>(EBrickState::Top_BottomLeft)]			= ResourceManager::getSprite("brickWall_Top_BottomLeft"_rid);
+	m_sprites[static_cast<size_t>(EBrickState::BottomRight)]			= ResourceManager::getSprite("brickWall_BottomRight"_rid);
+	m_sprites[static_cast<size_t>(EBrickState::TopLeft_BottomRight)]	= ResourceManager::getSprite("brickWall_TopLeft_BottomRight"_rid);
+	m_sprites[static_cast<size_t>(EBrickState::Right)]					= ResourceManager::getSprite("brickWall_Right"_rid);
+	m_sprites[static_cast<size_t>(EBrickState::Top_BottomRight)]		= ResourceManager::getSprite("brickWall_Top_BottomRight"_rid);
+	m_sprites[static_cast<size_t>(EBrickState::Bottom)]					= ResourceManager::getSprite("brickWall_Bottom"_rid);
+	m_sprites[static_cast<size_t>(EBrickState::TopLeft_Bottom)]			= ResourceManager::getSprite("brickWall_TopLeft_Bottom"_rid);
+	m_sprites[static_cast<size_t>(EBrickState::TopRight_Bottom)]		= ResourceManager::getSprite("brickWall_TopRight_Bottom"_rid);
 
 	switch (eBrickWallType)
 	{
@@ -72,22 +72,39 @@ BrickWall::BrickWall(const EBrickWallType eBrickWallType, const glm::vec2& posit
 		m_colliders.emplace_back(glm::vec2(m_size.x / 2, 0), glm::vec2(m_size.x, m_size.y / 2));
 		break;
 	}
+	initStateHash();
 }
-void BrickWall::renderBrick(const EBrickLocation eBrickLocation) const
+void BrickWall::renderBrick(RenderEngine::RenderSnapshot& snapshot, const EBrickLocation eBrickLocation) const
 {
 	const EBrickState state = m_eCurrentBrickState[static_cast<size_t>(eBrickLocation)];
 	if (state != EBrickState::Destroyed)
 	{
-		m_sprites[static_cast<size_t>(state)]->render(m_position + m_blockOffsets[static_cast<size_t>(eBrickLocation)], m_size / 2.f, m_rotation, m_layer);
+		snapshot.submit(m_sprites[static_cast<size_t>(state)].get(), m_position + m_blockOffsets[static_cast<size_t>(eBrickLocation)], m_size / 2.f, m_rotation, m_layer);
 	}
 }
-void BrickWall::render() const 
+void BrickWall::render(RenderEngine::RenderSnapshot& snapshot) const 
 {
-	renderBrick(EBrickLocation::TopLeft);
-	renderBrick(EBrickLocation::TopRight);
-	renderBrick(EBrickLocation::BottomLeft);
-	renderBrick(EBrickLocation::BottomRight);
+	renderBrick(snapshot, EBrickLocation::TopLeft);
+	renderBrick(snapshot, EBrickLocation::TopRight);
+	renderBrick(snapshot, EBrickLocation::BottomLeft);
+	renderBrick(snapshot, EBrickLocation::BottomRight);
 }
 void BrickWall::update(const double delta)
 {
-}
\ No newline at end of file
+}
+void BrickWall::hashState(WorldHash::StateHasher& hasher) const
+{
+	// a brick wall doesn't move, only its quarters change
+	hasher.add(FIRST_CUSTOM_FIELD, "topLeft", static_cast<uint32_t>(m_eCurrentBrickState[static_cast<size_t>(EBrickLocation::TopLeft)]));
+	hasher.add(FIRST_CUSTOM_FIELD + 1, "topRight", static_cast<uint32_t>(m_eCurrentBrickState[static_cast<size_t>(EBrickLocation::TopRight)]));
+	hasher.add(FIRST_CUSTOM_FIELD + 2, "bottomLeft", static_cast<uint32_t>(m_eCurrentBrickState[static_cast<size_t>(EBrickLocation::BottomLeft)]));
+	hasher.add(FIRST_CUSTOM_FIELD + 3, "bottomRight", static_cast<uint32_t>(m_eCurrentBrickState[static_cast<size_t>(EBrickLocation::BottomRight)]));
+}
+void BrickWall::writeState(WorldState& state) const
+{
+	state.write(m_eCurrentBrickState);
+}
+void BrickWall::readState(WorldState::Reader& reader)
+{
+	reader.read(m_eCurrentBrickState);
+}
@@ -52,10 +52,14 @@ public:
 	};
 
 	BrickWall(const EBrickWallType eBrickWallType, const glm::vec2& position, const glm::vec2& size, const float rotation, const float layer);
-	virtual void render() const override;
+	virtual void render(RenderEngine::RenderSnapshot& snapshot) const override;
 	virtual void update(const double delta) override;
+	void hashState(WorldHash::StateHasher& hasher) const override;
+protected:
+	void writeState(WorldState& state) const override;
+	void readState(WorldState::Reader& reader) override;
 private:
-	void renderBrick(const EBrickLocation eBrickLocation) const;
+	void renderBrick(RenderEngine::RenderSnapshot& snapshot, const EBrickLocation eBrickLocation) const;
 	std::array<EBrickState, 4> m_eCurrentBrickState;
 	std::array<std::shared_ptr<RenderEngine::Sprite>, 15> m_sprites;
 	std::array<glm::vec2, 4> m_blockOffsets;
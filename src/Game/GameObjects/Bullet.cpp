@@ -11,11 +11,11 @@ Bullet::Bullet(const double velocity,
 	: IGameObject(IGameObject::EObjectType::Bullet, position, size, 0.f, layer)
 	, m_explosionSize(explosionSize)
 	, m_explosionOffset((m_explosionSize - m_size) / 2.f)
-	, m_pSprite_top(ResourceManager::getSprite("bullet_Top"))
-	, m_pSprite_bottom(ResourceManager::getSprite("bullet_Bottom"))
-	, m_pSprite_left(ResourceManager::getSprite("bullet_Left"))
-	, m_pSprite_right(ResourceManager::getSprite("bullet_Right"))
-	, m_pSprite_explosion(ResourceManager::getSprite("explosion"))
+	, m_pSprite_top(ResourceManager::getSprite("bullet_Top"_rid))
+	, m_pSprite_bottom(ResourceManager::getSprite("bullet_Bottom"_rid))
+	, m_pSprite_left(ResourceManager::getSprite("bullet_Left"_rid))
+	, m_pSprite_right(ResourceManager::getSprite("bullet_Right"_rid))
+	, m_pSprite_explosion(ResourceManager::getSprite("explosion"_rid))
 	, m_spriteAnimator_explosion(m_pSprite_explosion)
 	, m_eOrientation(EOrientation::Top)
 	, m_maxVelocity(velocity)
@@ -30,9 +30,10 @@ Bullet::Bullet(const double velocity,
 			m_isActive = false;
 		}
 	);
+	initStateHash();
 }
 
-void Bullet::render() const
+void Bullet::render(RenderEngine::RenderSnapshot& snapshot) const
 {
 	if (m_isActive)
 	{
@@ -41,16 +42,16 @@ void Bullet::render() const
 			switch (m_eOrientation)
 			{
 			case EOrientation::Top:
-				m_pSprite_explosion->render(m_position - m_explosionOffset + glm::vec2(0, m_size.y / 2.f), m_explosionSize, m_rotation, m_layer + 0.1f, m_spriteAnimator_explosion.getCurrentFrame());
+				snapshot.submit(m_pSprite_explosion.get(), m_position - m_explosionOffset + glm::vec2(0, m_size.y / 2.f), m_explosionSize, m_rotation, m_layer + 0.1f, m_spriteAnimator_explosion.getCurrentFrame());
 				break;
 			case EOrientation::Bottom:
-				m_pSprite_explosion->render(m_position - m_explosionOffset - glm::vec2(0, m_size.y / 2.f), m_explosionSize, m_rotation, m_layer + 0.1f, m_spriteAnimator_explosion.getCurrentFrame());
+				snapshot.submit(m_pSprite_explosion.get(), m_position - m_explosionOffset - glm::vec2(0, m_size.y / 2.f), m_explosionSize, m_rotation, m_layer + 0.1f, m_spriteAnimator_explosion.getCurrentFrame());
 				break;
 			case EOrientation::Left:
-				m_pSprite_explosion->render(m_position - m_explosionOffset - glm::vec2(m_size.x / 2.f, 0), m_explosionSize, m_rotation, m_layer + 0.1f, m_spriteAnimator_explosion.getCurrentFrame());
+				snapshot.submit(m_pSprite_explosion.get(), m_position - m_explosionOffset - glm::vec2(m_size.x / 2.f, 0), m_explosionSize, m_rotation, m_layer + 0.1f, m_spriteAnimator_explosion.getCurrentFrame());
 				break;
 			case EOrientation::Right:
-				m_pSprite_explosion->render(m_position - m_explosionOffset + glm::vec2(m_size.x / 2.f, 0), m_explosionSize, m_rotation, m_layer + 0.1f, m_spriteAnimator_explosion.getCurrentFrame());
+				snapshot.submit(m_pSprite_explosion.get(), m_position - m_explosionOffset + glm::vec2(m_size.x / 2.f, 0), m_explosionSize, m_rotation, m_layer + 0.1f, m_spriteAnimator_explosion.getCurrentFrame());
 				break;
 			}
 		}
@@ -59,16 +60,16 @@ void Bullet::render() const
 			switch (m_eOrientation)
 			{
 			case EOrientation::Top:
-				m_pSprite_top->render(m_position, m_size, m_rotation, m_layer);
+				snapshot.submit(m_pSprite_top.get(), m_position, m_size, m_rotation, m_layer);
 				break;
 			case EOrientation::Bottom:
-				m_pSprite_bottom->render(m_position, m_size, m_rotation, m_layer);
+				snapshot.submit(m_pSprite_bottom.get(), m_position, m_size, m_rotation, m_layer);
 				break;
 			case EOrientation::Left:
-				m_pSprite_left->render(m_position, m_size, m_rotation, m_layer);
+				snapshot.submit(m_pSprite_left.get(), m_position, m_size, m_rotation, m_layer);
 				break;
 			case EOrientation::Right:
-				m_pSprite_right->render(m_position, m_size, m_rotation, m_layer);
+				snapshot.submit(m_pSprite_right.get(), m_position, m_size, m_rotation, m_layer);
 				break;
 			}
 		}
@@ -79,13 +80,24 @@ void Bullet::update(const double delta)
 {
 	if (m_isExplosion)
 	{
+		const double explosionTimeLeft = m_explosionTimer.getTimeLeft();
 		m_spriteAnimator_explosion.update(delta);
 		m_explosionTimer.update(delta);
+		changeStateField(EXPLOSION_TIMER_FIELD, explosionTimeLeft, m_explosionTimer.getTimeLeft());
+		if (!m_isExplosion)
+		{
+			changeStateField(EXPLOSION_FIELD, true, false);
+			changeStateField(ACTIVE_FIELD, true, m_isActive);
+		}
 	}
 }
 
 void Bullet::fire(const glm::vec2& position, const glm::vec2& direction)
 {
+	const uint32_t oldOrientation = static_cast<uint32_t>(m_eOrientation);
+	changeStateField(POSITION_FIELD, m_position, position);
+	changeStateField(DIRECTION_FIELD, m_direction, direction);
+	changeStateField(ACTIVE_FIELD, m_isActive, true);
 	m_position = position;
 	m_direction = direction;
 	if (m_direction.x == 0.f)
@@ -97,13 +109,46 @@ void Bullet::fire(const glm::vec2& position, const glm::vec2& direction)
 		m_eOrientation = (m_direction.x < 0) ? EOrientation::Left : EOrientation::Right;
 	}
 	m_isActive = true;
+	changeStateField(ORIENTATION_FIELD, oldOrientation, static_cast<uint32_t>(m_eOrientation));
 	setVelocity(m_maxVelocity);
 }
 
 void Bullet::onCollision()
 {
 	setVelocity(0);
+	changeStateField(EXPLOSION_FIELD, m_isExplosion, true);
 	m_isExplosion = true;
 	m_spriteAnimator_explosion.reset();
+	const double explosionTimeLeft = m_explosionTimer.getTimeLeft();
 	m_explosionTimer.start(m_spriteAnimator_explosion.getTotalDuration());
-}
\ No newline at end of file
+	changeStateField(EXPLOSION_TIMER_FIELD, explosionTimeLeft, m_explosionTimer.getTimeLeft());
+}
+
+void Bullet::hashState(WorldHash::StateHasher& hasher) const
+{
+	IGameObject::hashState(hasher);
+	hasher.add(ORIENTATION_FIELD, "orientation", static_cast<uint32_t>(m_eOrientation));
+	hasher.add(ACTIVE_FIELD, "active", m_isActive);
+	hasher.add(EXPLOSION_FIELD, "explosion", m_isExplosion);
+	hasher.add(EXPLOSION_TIMER_FIELD, "explosionTimer", m_explosionTimer.getTimeLeft());
+}
+
+void Bullet::writeState(WorldState& state) const
+{
+	writeTransform(state);
+	state.write(m_eOrientation);
+	state.write(m_isActive);
+	state.write(m_isExplosion);
+	writeTimer(state, m_explosionTimer);
+	writeAnimator(state, m_spriteAnimator_explosion);
+}
+
+void Bullet::readState(WorldState::Reader& reader)
+{
+	readTransform(reader);
+	reader.read(m_eOrientation);
+	reader.read(m_isActive);
+	reader.read(m_isExplosion);
+	readTimer(reader, m_explosionTimer);
+	readAnimator(reader, m_spriteAnimator_explosion);
+}
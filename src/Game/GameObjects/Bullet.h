@@ -25,13 +25,23 @@ public:
 		   const glm::vec2& size, 
 		   const glm::vec2& explosionSize, 
 		   const float layer);
-	virtual void render() const override;
+	virtual void render(RenderEngine::RenderSnapshot& snapshot) const override;
 	void update(const double delta) override;
 	bool isActive() const { return m_isActive; }
 	void fire(const glm::vec2& position, const glm::vec2& direction);
 	virtual void onCollision() override;
+	void hashState(WorldHash::StateHasher& hasher) const override;
+
+protected:
+	void writeState(WorldState& state) const override;
+	void readState(WorldState::Reader& reader) override;
 
 private:
+	static constexpr uint8_t ORIENTATION_FIELD = FIRST_CUSTOM_FIELD;
+	static constexpr uint8_t ACTIVE_FIELD = FIRST_CUSTOM_FIELD + 1;
+	static constexpr uint8_t EXPLOSION_FIELD = FIRST_CUSTOM_FIELD + 2;
+	static constexpr uint8_t EXPLOSION_TIMER_FIELD = FIRST_CUSTOM_FIELD + 3;
+
 	glm::vec2 m_explosionSize;
 	glm::vec2 m_explosionOffset;
 	std::shared_ptr<RenderEngine::Sprite> m_pSprite_top;
@@ -4,17 +4,30 @@
 
 Eagle::Eagle(const glm::vec2& position, const glm::vec2& size, const float rotation, const float layer)
 	: IGameObject(IGameObject::EObjectType::Eagle, position, size, rotation, layer)
-	, m_sprite{ ResourceManager::getSprite("eagle"),
-			   ResourceManager::getSprite("eagle_dead") }
+	, m_sprite{ ResourceManager::getSprite("eagle"_rid),
+			   ResourceManager::getSprite("eagle_dead"_rid) }
 	, m_eCurrentState(EEagleState::Alive)
 {
 	m_colliders.emplace_back(glm::vec2(0), m_size);
+	initStateHash();
 }
-void Eagle::render() const
+void Eagle::render(RenderEngine::RenderSnapshot& snapshot) const
 {
-	m_sprite[static_cast<size_t>(m_eCurrentState)]->render(m_position, m_size, m_rotation, m_layer);
+	snapshot.submit(m_sprite[static_cast<size_t>(m_eCurrentState)].get(), m_position, m_size, m_rotation, m_layer);
 }
 void Eagle::update(const double delta)
 {
 
-}
\ No newline at end of file
+}
+void Eagle::hashState(WorldHash::StateHasher& hasher) const
+{
+	hasher.add(FIRST_CUSTOM_FIELD, "state", static_cast<uint32_t>(m_eCurrentState));
+}
+void Eagle::writeState(WorldState& state) const
+{
+	state.write(m_eCurrentState);
+}
+void Eagle::readState(WorldState::Reader& reader)
+{
+	reader.read(m_eCurrentState);
+}
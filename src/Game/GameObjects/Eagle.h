@@ -18,8 +18,12 @@ public:
 		Dead
 	};
 	Eagle(const glm::vec2& position, const glm::vec2& size, const float rotation, const float layer);
-	virtual void render() const override;
+	virtual void render(RenderEngine::RenderSnapshot& snapshot) const override;
 	void update(const double delta) override;
+	void hashState(WorldHash::StateHasher& hasher) const override;
+protected:
+	void writeState(WorldState& state) const override;
+	void readState(WorldState::Reader& reader) override;
 private:
 	std::array<std::shared_ptr<RenderEngine::Sprite>, 2> m_sprite;
 	EEagleState m_eCurrentState;
@@ -1,4 +1,6 @@
 #include "IGameObject.h"
+#include "../../Renderer/SpriteAnimator.h"
+#include "../../System/Timer.h"
 
 IGameObject::IGameObject(const EObjectType objectType,const glm::vec2& position, const glm::vec2& size, const float rotation, const float layer)
 	: m_position(position)
@@ -8,14 +10,101 @@ IGameObject::IGameObject(const EObjectType objectType,const glm::vec2& position,
 	, m_objectType(objectType)
 	, m_direction(0, 1.f)
 	, m_velocity(0)
+	, m_entityID(WorldHash::registerObject(this))
+	, m_stateHash(0)
 {
 }
 
 IGameObject::~IGameObject()
 {
+	WorldHash::unregisterObject(m_entityID, this, m_stateHash);
 }
 
 void IGameObject::setVelocity(const double velocity)
 {
+	changeStateField(VELOCITY_FIELD, m_velocity, velocity);
 	m_velocity = velocity;
-}
\ No newline at end of file
+}
+
+void IGameObject::hashState(WorldHash::StateHasher& hasher) const
+{
+	hasher.add(POSITION_FIELD, "position", m_position);
+	hasher.add(DIRECTION_FIELD, "direction", m_direction);
+	hasher.add(VELOCITY_FIELD, "velocity", m_velocity);
+}
+
+void IGameObject::initStateHash()
+{
+	if (!WorldHash::isRegistered(m_entityID, this))
+	{
+		return;
+	}
+	WorldHash::StateHasher hasher(m_entityID);
+	hashState(hasher);
+	WorldHash::apply(m_stateHash ^ hasher.getHash());
+	m_stateHash = hasher.getHash();
+}
+
+void IGameObject::saveState(WorldState& state) const
+{
+	state.write(m_stateHash);
+	writeState(state);
+}
+
+void IGameObject::restoreState(WorldState::Reader& reader)
+{
+	// the saved state hash matches the restored fields, the world hash is restored as a whole by the game
+	reader.read(m_stateHash);
+	readState(reader);
+}
+
+void IGameObject::writeTransform(WorldState& state) const
+{
+	state.write(m_position);
+	state.write(m_direction);
+	state.write(m_velocity);
+}
+
+void IGameObject::readTransform(WorldState::Reader& reader)
+{
+	reader.read(m_position);
+	reader.read(m_direction);
+	reader.read(m_velocity);
+}
+
+void IGameObject::writeTimer(WorldState& state, const Timer& timer)
+{
+	state.write(timer.getTimeLeft());
+	state.write(timer.isRunning());
+}
+
+void IGameObject::readTimer(WorldState::Reader& reader, Timer& timer)
+{
+	double timeLeft = 0;
+	bool isRunning = false;
+	reader.read(timeLeft);
+	reader.read(isRunning);
+	if (isRunning)
+	{
+		timer.start(timeLeft);
+	}
+	else
+	{
+		timer.stop();
+	}
+}
+
+void IGameObject::writeAnimator(WorldState& state, const RenderEngine::SpriteAnimator& spriteAnimator)
+{
+	state.write(static_cast<uint32_t>(spriteAnimator.getCurrentFrame()));
+	state.write(spriteAnimator.getCurrentFrameTime());
+}
+
+void IGameObject::readAnimator(WorldState::Reader& reader, RenderEngine::SpriteAnimator& spriteAnimator)
+{
+	uint32_t frame = 0;
+	double frameTime = 0;
+	reader.read(frame);
+	reader.read(frameTime);
+	spriteAnimator.setPhase(frame, frameTime);
+}
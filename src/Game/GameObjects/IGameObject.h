@@ -3,6 +3,16 @@
 #include <glm/vec2.hpp>
 
 #include "../../Physics/PhysicsEngine.h"
+#include "../../Renderer/RenderSnapshot.h"
+#include "../WorldHash.h"
+#include "../WorldState.h"
+
+class Timer;
+
+namespace RenderEngine
+{
+	class SpriteAnimator;
+}
 
 class IGameObject
 {
@@ -23,7 +33,7 @@ public:
 	};
 
 	IGameObject(const EObjectType objectType, const glm::vec2& position, const glm::vec2& size, const float rotation, const float layer);
-	virtual void render() const = 0;
+	virtual void render(RenderEngine::RenderSnapshot& snapshot) const = 0;
 	virtual void update(const double delta) {};
 	virtual ~IGameObject();
 	virtual glm::vec2& getCurrentPosition() { return m_position; }
@@ -37,6 +47,40 @@ public:
 	virtual bool collides(const EObjectType objectType) { return true; }
 	virtual void onCollision() {}
 
+	// fields of the state hashed into the WorldHash, derived classes number their own from FIRST_CUSTOM_FIELD
+	static constexpr uint8_t POSITION_FIELD = 0;
+	static constexpr uint8_t DIRECTION_FIELD = 1;
+	static constexpr uint8_t VELOCITY_FIELD = 2;
+	static constexpr uint8_t FIRST_CUSTOM_FIELD = 3;
+
+	uint32_t getEntityID() const { return m_entityID; }
+	// 0 - the object has no simulation state in the world hash
+	uint64_t getStateHash() const { return m_stateHash; }
+	// hashes every field of the simulation state, the base hashes the transform
+	virtual void hashState(WorldHash::StateHasher& hasher) const;
+	// every change of a hashed field is reported here, the world hash is updated by the difference
+	template<class TValue>
+	void changeStateField(const uint8_t field, const TValue& oldValue, const TValue& newValue)
+	{
+		const uint64_t oldBits = WorldHash::pack(oldValue);
+		const uint64_t newBits = WorldHash::pack(newValue);
+		if (oldBits == newBits || m_stateHash == 0)
+		{
+			return;
+		}
+		WorldHash::Context& context = *WorldHash::getCurrentContext();
+		if (m_entityID < context.objects.size() && context.objects[m_entityID] == this)
+		{
+			const uint64_t difference = WorldHash::hashField(m_entityID, field, oldBits) ^ WorldHash::hashField(m_entityID, field, newBits);
+			m_stateHash ^= difference;
+			context.hash ^= difference;
+		}
+	}
+
+	// the simulation state with its state hash, restored into an object of the same world
+	void saveState(WorldState& state) const;
+	void restoreState(WorldState::Reader& reader);
+
 protected:	
 	glm::vec2 m_position;
 	glm::vec2 m_size;
@@ -47,4 +91,21 @@ protected:
 	glm::vec2 m_direction;
 	double m_velocity;
 	std::vector<Physics::AABB> m_colliders;
+
+	// objects with simulation state call it at the end of their constructor
+	void initStateHash();
+
+	// objects with simulation state write and read their own fields, the base has none
+	virtual void writeState(WorldState& state) const {}
+	virtual void readState(WorldState::Reader& reader) {}
+	void writeTransform(WorldState& state) const;
+	void readTransform(WorldState::Reader& reader);
+	static void writeTimer(WorldState& state, const Timer& timer);
+	static void readTimer(WorldState::Reader& reader, Timer& timer);
+	static void writeAnimator(WorldState& state, const RenderEngine::SpriteAnimator& spriteAnimator);
+	static void readAnimator(WorldState::Reader& reader, RenderEngine::SpriteAnimator& spriteAnimator);
+
+private:
+	uint32_t m_entityID;
+	uint64_t m_stateHash;
 };
\ No newline at end of file
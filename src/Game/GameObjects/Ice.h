@@ -21,9 +21,9 @@ public:
 	};
 
 	Ice(const glm::vec2& position, const glm::vec2& size, const float rotation, const float layer);
-	virtual void render() const override;
+	virtual void render(RenderEngine::RenderSnapshot& snapshot) const override;
 private:
-	void renderBlock(const EBlockLocation eBlockLocation) const;
+	void renderBlock(RenderEngine::RenderSnapshot& snapshot, const EBlockLocation eBlockLocation) const;
 	std::shared_ptr<RenderEngine::Sprite> m_sprite;
 	std::array<glm::vec2, 4> m_blockOffsets;
 };
\ No newline at end of file
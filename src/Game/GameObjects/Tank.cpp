@@ -11,17 +11,17 @@ Tank::Tank(const double maxVelocity,
 		: IGameObject(IGameObject::EObjectType::Tank, position, size, 0.f, layer)
 		, m_eOrientation(EOrientation::Top)
 		, m_pCurrentBullet(std::make_shared<Bullet>(0.1, m_position + m_size / 4.f, m_size / 2.f, m_size, layer))
-		, m_pSprite_top(ResourceManager::getSprite("tankSprite_top"))
-		, m_pSprite_bottom(ResourceManager::getSprite("tankSprite_bottom"))
-		, m_pSprite_left(ResourceManager::getSprite("tankSprite_left"))
-		, m_pSprite_right(ResourceManager::getSprite("tankSprite_right"))
+		, m_pSprite_top(ResourceManager::getSprite("tankSprite_top"_rid))
+		, m_pSprite_bottom(ResourceManager::getSprite("tankSprite_bottom"_rid))
+		, m_pSprite_left(ResourceManager::getSprite("tankSprite_left"_rid))
+		, m_pSprite_right(ResourceManager::getSprite("tankSprite_right"_rid))
 		, m_spriteAnimator_top(m_pSprite_top)
 		, m_spriteAnimator_bottom(m_pSprite_bottom)
 		, m_spriteAnimator_left(m_pSprite_left)
 		, m_spriteAnimator_right(m_pSprite_right)
-		, m_pSprite_respawn(ResourceManager::getSprite("respawn"))
+		, m_pSprite_respawn(ResourceManager::getSprite("respawn"_rid))
 		, m_spriteAnimator_respawn(m_pSprite_respawn)
-		, m_pSprite_shield(ResourceManager::getSprite("shield"))
+		, m_pSprite_shield(ResourceManager::getSprite("shield"_rid))
 		, m_spriteAnimator_shield(m_pSprite_shield)
 		, m_maxVelocity(maxVelocity)
 		, m_isSpawning(true)
@@ -45,48 +45,50 @@ Tank::Tank(const double maxVelocity,
 	m_colliders.emplace_back(glm::vec2(0), m_size);
 
 	Physics::PhysicsEngine::addDynamicGameObject(m_pCurrentBullet);
+	initStateHash();
 }  
 
 void Tank::setVelocity(const double velocity) 
 {
 	if (!m_isSpawning)
 	{
+		changeStateField(VELOCITY_FIELD, m_velocity, velocity);
 		m_velocity = velocity;
 	}
 }
 
-void Tank::render() const
+void Tank::render(RenderEngine::RenderSnapshot& snapshot) const
 {
 	if (m_isSpawning)
 	{
-		m_pSprite_respawn->render(m_position, m_size, m_rotation, m_layer, m_spriteAnimator_respawn.getCurrentFrame());
+		snapshot.submit(m_pSprite_respawn.get(), m_position, m_size, m_rotation, m_layer, m_spriteAnimator_respawn.getCurrentFrame());
 	}
 	else
 	{
 		switch (m_eOrientation)
 			{
 			case Tank::EOrientation::Top:
-				m_pSprite_top->render(m_position, m_size, m_rotation, m_layer, m_spriteAnimator_top.getCurrentFrame());
+				snapshot.submit(m_pSprite_top.get(), m_position, m_size, m_rotation, m_layer, m_spriteAnimator_top.getCurrentFrame());
 				break;
 			case Tank::EOrientation::Bottom:
-				m_pSprite_bottom->render(m_position, m_size, m_rotation, m_layer, m_spriteAnimator_bottom.getCurrentFrame());
+				snapshot.submit(m_pSprite_bottom.get(), m_position, m_size, m_rotation, m_layer, m_spriteAnimator_bottom.getCurrentFrame());
 				break;
 			case Tank::EOrientation::Left:
-				m_pSprite_left->render(m_position, m_size, m_rotation, m_layer, m_spriteAnimator_left.getCurrentFrame());
+				snapshot.submit(m_pSprite_left.get(), m_position, m_size, m_rotation, m_layer, m_spriteAnimator_left.getCurrentFrame());
 				break;
 			case Tank::EOrientation::Right:
-				m_pSprite_right->render(m_position, m_size, m_rotation, m_layer, m_spriteAnimator_right.getCurrentFrame());
+				snapshot.submit(m_pSprite_right.get(), m_position, m_size, m_rotation, m_layer, m_spriteAnimator_right.getCurrentFrame());
 				break;
 			}
 		if (m_hasShield)
 		{
-			m_pSprite_shield->render(m_position, m_size, m_rotation, m_layer + 0.1f, m_spriteAnimator_shield.getCurrentFrame());
+			snapshot.submit(m_pSprite_shield.get(), m_position, m_size, m_rotation, m_layer + 0.1f, m_spriteAnimator_shield.getCurrentFrame());
 		}
 	}
 	
 	if (m_pCurrentBullet->isActive())
 	{
-		m_pCurrentBullet->render();
+		m_pCurrentBullet->render(snapshot);
 	}
 }
 
@@ -96,6 +98,8 @@ void Tank::setOrientation(const EOrientation eOrientation)
 	{
 		return;
 	}
+	const glm::vec2 oldDirection = m_direction;
+	changeStateField(ORIENTATION_FIELD, static_cast<uint32_t>(m_eOrientation), static_cast<uint32_t>(eOrientation));
 	m_eOrientation = eOrientation;
 	switch (m_eOrientation)
 	{
@@ -116,6 +120,7 @@ void Tank::setOrientation(const EOrientation eOrientation)
 		m_direction.y = 0.f;
 		break;	
 	}
+	changeStateField(DIRECTION_FIELD, oldDirection, m_direction);
 }
 
 void Tank::update(const double delta)
@@ -127,15 +132,28 @@ void Tank::update(const double delta)
 
 	if (m_isSpawning)
 	{
+		const double respawnTimeLeft = m_respawnTimer.getTimeLeft();
+		const double shieldTimeLeft = m_shieldTimer.getTimeLeft();
 		m_spriteAnimator_respawn.update(delta);
 		m_respawnTimer.update(delta);
+		changeStateField(RESPAWN_TIMER_FIELD, respawnTimeLeft, m_respawnTimer.getTimeLeft());
+		if (!m_isSpawning)
+		{
+			// the respawn timer went off and raised the shield
+			changeStateField(SPAWNING_FIELD, true, false);
+			changeStateField(SHIELD_FIELD, false, m_hasShield);
+			changeStateField(SHIELD_TIMER_FIELD, shieldTimeLeft, m_shieldTimer.getTimeLeft());
+		}
 	}
 	else
 	{
 		if (m_hasShield)
 		{
+			const double shieldTimeLeft = m_shieldTimer.getTimeLeft();
 			m_spriteAnimator_shield.update(delta);
 			m_shieldTimer.update(delta);
+			changeStateField(SHIELD_TIMER_FIELD, shieldTimeLeft, m_shieldTimer.getTimeLeft());
+			changeStateField(SHIELD_FIELD, true, m_hasShield);
 		}
 
 		if (m_velocity > 0)
@@ -165,4 +183,49 @@ void Tank::fire()
 	{
 		m_pCurrentBullet->fire(m_position + m_size / 4.f + m_size * m_direction / 4.f, m_direction);
 	}
-}
\ No newline at end of file
+}
+
+void Tank::hashState(WorldHash::StateHasher& hasher) const
+{
+	IGameObject::hashState(hasher);
+	hasher.add(ORIENTATION_FIELD, "orientation", static_cast<uint32_t>(m_eOrientation));
+	hasher.add(SPAWNING_FIELD, "spawning", m_isSpawning);
+	hasher.add(SHIELD_FIELD, "shield", m_hasShield);
+	hasher.add(RESPAWN_TIMER_FIELD, "respawnTimer", m_respawnTimer.getTimeLeft());
+	hasher.add(SHIELD_TIMER_FIELD, "shieldTimer", m_shieldTimer.getTimeLeft());
+}
+
+void Tank::writeState(WorldState& state) const
+{
+	writeTransform(state);
+	state.write(m_eOrientation);
+	state.write(m_isSpawning);
+	state.write(m_hasShield);
+	writeTimer(state, m_respawnTimer);
+	writeTimer(state, m_shieldTimer);
+	writeAnimator(state, m_spriteAnimator_top);
+	writeAnimator(state, m_spriteAnimator_bottom);
+	writeAnimator(state, m_spriteAnimator_left);
+	writeAnimator(state, m_spriteAnimator_right);
+	writeAnimator(state, m_spriteAnimator_respawn);
+	writeAnimator(state, m_spriteAnimator_shield);
+	// the bullet belongs to the tank, it isn't stored anywhere else
+	m_pCurrentBullet->saveState(state);
+}
+
+void Tank::readState(WorldState::Reader& reader)
+{
+	readTransform(reader);
+	reader.read(m_eOrientation);
+	reader.read(m_isSpawning);
+	reader.read(m_hasShield);
+	readTimer(reader, m_respawnTimer);
+	readTimer(reader, m_shieldTimer);
+	readAnimator(reader, m_spriteAnimator_top);
+	readAnimator(reader, m_spriteAnimator_bottom);
+	readAnimator(reader, m_spriteAnimator_left);
+	readAnimator(reader, m_spriteAnimator_right);
+	readAnimator(reader, m_spriteAnimator_respawn);
+	readAnimator(reader, m_spriteAnimator_shield);
+	m_pCurrentBullet->restoreState(reader);
+}
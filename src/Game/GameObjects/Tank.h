@@ -31,14 +31,25 @@ public:
 		 const glm::vec2& size,
 		 const float layer);
 
-	void render() const override;
+	void render(RenderEngine::RenderSnapshot& snapshot) const override;
 	void setOrientation(const EOrientation eOrientation);
 	void update(const double delta) override;
 	double getMaxVelocity() const {return m_maxVelocity;}
 	void setVelocity(const double velocity) override;
 	void fire();
+	void hashState(WorldHash::StateHasher& hasher) const override;
+
+protected:
+	void writeState(WorldState& state) const override;
+	void readState(WorldState::Reader& reader) override;
 
 private:
+	static constexpr uint8_t ORIENTATION_FIELD = FIRST_CUSTOM_FIELD;
+	static constexpr uint8_t SPAWNING_FIELD = FIRST_CUSTOM_FIELD + 1;
+	static constexpr uint8_t SHIELD_FIELD = FIRST_CUSTOM_FIELD + 2;
+	static constexpr uint8_t RESPAWN_TIMER_FIELD = FIRST_CUSTOM_FIELD + 3;
+	static constexpr uint8_t SHIELD_TIMER_FIELD = FIRST_CUSTOM_FIELD + 4;
+
 	EOrientation m_eOrientation;
 	std::shared_ptr<Bullet> m_pCurrentBullet;
 	std::shared_ptr<RenderEngine::Sprite> m_pSprite_top;
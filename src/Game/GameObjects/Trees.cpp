@@ -4,21 +4,21 @@
 
 Trees::Trees(const glm::vec2& position, const glm::vec2& size, const float rotation, const float layer)
 	: IGameObject(IGameObject::EObjectType::Trees, position, size, rotation, layer)
-	, m_sprite(ResourceManager::getSprite("trees"))
+	, m_sprite(ResourceManager::getSprite("trees"_rid))
 	, m_blockOffsets { glm::vec2(0, m_size.y / 2.f),
 					   glm::vec2(m_size.x / 2.f, m_size.y / 2.f),
 					   glm::vec2(0, 0),
 					   glm::vec2(m_size.x / 2.f, 0) }
 {
 }
-void Trees::renderBlock(const EBlockLocation eBlockLocation) const
+void Trees::renderBlock(RenderEngine::RenderSnapshot& snapshot, const EBlockLocation eBlockLocation) const
 {
-	m_sprite->render(m_position + m_blockOffsets[static_cast<size_t>(eBlockLocation)], m_size / 2.f, m_rotation, m_layer);
+	snapshot.submit(m_sprite.get(), m_position + m_blockOffsets[static_cast<size_t>(eBlockLocation)], m_size / 2.f, m_rotation, m_layer);
 }
-void Trees::render() const
+void Trees::render(RenderEngine::RenderSnapshot& snapshot) const
 {
-	renderBlock(EBlockLocation::TopLeft);
-	renderBlock(EBlockLocation::TopRight);
-	renderBlock(EBlockLocation::BottomLeft);
-	renderBlock(EBlockLocation::BottomRight);
+	renderBlock(snapshot, EBlockLocation::TopLeft);
+	renderBlock(snapshot, EBlockLocation::TopRight);
+	renderBlock(snapshot, EBlockLocation::BottomLeft);
+	renderBlock(snapshot, EBlockLocation::BottomRight);
 }
\ No newline at end of file
@@ -4,7 +4,7 @@
 
 Water::Water(const glm::vec2& position, const glm::vec2& size, const float rotation, const float layer)
 	: IGameObject(IGameObject::EObjectType::Water, position, size, rotation, layer)
-	, m_sprite(ResourceManager::getSprite("water"))
+	, m_sprite(ResourceManager::getSprite("water"_rid))
 	, m_spriteAnimator(m_sprite)
 	, m_blockOffsets { glm::vec2(0, m_size.y / 2.f),
 					   glm::vec2(m_size.x / 2.f, m_size.y / 2.f),
@@ -13,22 +13,31 @@ Water::Water(const glm::vec2& position, const glm::vec2& size, const float rotat
 {
 	m_colliders.emplace_back(glm::vec2(0), m_size);
 }
-void Water::renderBlock(const EBlockLocation eBlockLocation) const
+void Water::renderBlock(RenderEngine::RenderSnapshot& snapshot, const EBlockLocation eBlockLocation) const
 {
-	m_sprite->render(m_position + m_blockOffsets[static_cast<size_t>(eBlockLocation)], m_size / 2.f, m_rotation, m_layer, m_spriteAnimator.getCurrentFrame());
+	snapshot.submit(m_sprite.get(), m_position + m_blockOffsets[static_cast<size_t>(eBlockLocation)], m_size / 2.f, m_rotation, m_layer, m_spriteAnimator.getCurrentFrame());
 }
-void Water::render() const
+void Water::render(RenderEngine::RenderSnapshot& snapshot) const
 {
-	renderBlock(EBlockLocation::TopLeft);
-	renderBlock(EBlockLocation::TopRight);
-	renderBlock(EBlockLocation::BottomLeft);
-	renderBlock(EBlockLocation::BottomRight);
+	renderBlock(snapshot, EBlockLocation::TopLeft);
+	renderBlock(snapshot, EBlockLocation::TopRight);
+	renderBlock(snapshot, EBlockLocation::BottomLeft);
+	renderBlock(snapshot, EBlockLocation::BottomRight);
 }
 void Water::update(const double delta)
 {
 	m_spriteAnimator.update(delta);
 }
 
+void Water::writeState(WorldState& state) const
+{
+	writeAnimator(state, m_spriteAnimator);
+}
+void Water::readState(WorldState::Reader& reader)
+{
+	readAnimator(reader, m_spriteAnimator);
+}
+
 bool Water::collides(const EObjectType objectType)
 {
 	return objectType != IGameObject::EObjectType::Bullet;
@@ -22,12 +22,16 @@ public:
 	};
 
 	Water(const glm::vec2& position, const glm::vec2& size, const float rotation, const float layer);
-	virtual void render() const override;
+	virtual void render(RenderEngine::RenderSnapshot& snapshot) const override;
 	void update(const double delta) override;
 	virtual bool collides(const EObjectType objectType) override;
 
+protected:
+	void writeState(WorldState& state) const override;
+	void readState(WorldState::Reader& reader) override;
+
 private:
-	void renderBlock(const EBlockLocation eBlockLocation) const;
+	void renderBlock(RenderEngine::RenderSnapshot& snapshot, const EBlockLocation eBlockLocation) const;
 	std::shared_ptr<RenderEngine::Sprite> m_sprite;
 	RenderEngine::SpriteAnimator m_spriteAnimator;
 	std::array<glm::vec2, 4> m_blockOffsets;
@@ -7,6 +7,8 @@
 #include "GameObjects/Water.h"
 #include "GameObjects/Eagle.h"
 #include "GameObjects/Border.h"
+#include "../System/JobSystem.h"
+#include "../System/Profiler.h"
 #include <algorithm>
 #include <cmath>
 
@@ -124,25 +126,61 @@ Level::Level(const std::vector<std::string>& levelDescription)
 	//right border
 	m_levelObjects.emplace_back(std::make_shared<Border>(glm::vec2((m_widthBlocks + 1) * BLOCK_SIZE, 0.f), glm::vec2(BLOCK_SIZE * 2.f, (m_heightBlocks + 1) * BLOCK_SIZE), 0.f, 0.f));
 }
-void Level::render() const
+void Level::render(RenderEngine::RenderSnapshot& snapshot) const
 {
+	PROFILE_ZONE("Level::render");
 	for (const auto& currentMapObject : m_levelObjects)
 	{
 		if (currentMapObject)
 		{
-			currentMapObject->render();
+			currentMapObject->render(snapshot);
 		}
 	}
 }
 void Level::update(const double delta)
 {
+	PROFILE_ZONE("Level::update");
+	// map objects only animate themselves, so they can be updated in parallel
+	JobSystem::parallelFor(m_levelObjects.size(), 512, [this, delta](const size_t begin, const size_t end)
+		{
+			PROFILE_ZONE("Level::update objects");
+			for (size_t currentObject = begin; currentObject < end; ++currentObject)
+			{
+				if (m_levelObjects[currentObject])
+				{
+					m_levelObjects[currentObject]->update(delta);
+				}
+			}
+		}
+	);
+}
+void Level::saveState(WorldState& state) const
+{
+	state.write(static_cast<uint32_t>(m_levelObjects.size()));
+	for (const auto& currentMapObject : m_levelObjects)
+	{
+		if (currentMapObject)
+		{
+			currentMapObject->saveState(state);
+		}
+	}
+}
+bool Level::restoreState(WorldState::Reader& reader)
+{
+	uint32_t objectsCount = 0;
+	reader.read(objectsCount);
+	if (reader.hasFailed() || objectsCount != m_levelObjects.size())
+	{
+		return false;
+	}
 	for (const auto& currentMapObject : m_levelObjects)
 	{
 		if (currentMapObject)
 		{
-			currentMapObject->update(delta);
+			currentMapObject->restoreState(reader);
 		}
 	}
+	return !reader.hasFailed();
 }
 size_t Level::getLewelWidth() const
 {  
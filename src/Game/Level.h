@@ -4,17 +4,26 @@
 #include <string>
 #include <memory>
 #include <glm/vec2.hpp>
+#include "WorldState.h"
 
 class IGameObject;
 
+namespace RenderEngine
+{
+	class RenderSnapshot;
+}
+
 class Level
 {
 public:
 	static constexpr unsigned int BLOCK_SIZE = 16;
 
 	Level(const std::vector<std::string>& levelDescription);
-	void render() const;
+	void render(RenderEngine::RenderSnapshot& snapshot) const;
 	void update(const double delta);
+	// the state of every map object in the map order
+	void saveState(WorldState& state) const;
+	bool restoreState(WorldState::Reader& reader);
 	size_t getLewelWidth() const;
 	size_t getLewelHeight() const;
 
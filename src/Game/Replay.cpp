@@ -0,0 +1,237 @@
+#include "Replay.h"
+#include "Game.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+
+static const char* REPLAY_TEXT_HEADER = "BattleCityReplay";
+static constexpr int REPLAY_TEXT_VERSION = 1;
+static const uint8_t REPLAY_MAGIC[4] = { 'B', 'C', 'R', 'P' };
+static constexpr uint8_t REPLAY_BINARY_VERSION = 3;
+// version 2 had no checksums
+static constexpr uint8_t REPLAY_BINARY_VERSION_NO_CHECKSUMS = 2;
+
+static void writeVarint(std::vector<uint8_t>& data, uint64_t value)
+{
+	while (value >= 0x80)
+	{
+		data.push_back(static_cast<uint8_t>(value) | 0x80);
+		value >>= 7;
+	}
+	data.push_back(static_cast<uint8_t>(value));
+}
+
+static bool readVarint(const std::vector<uint8_t>& data, size_t& offset, uint64_t& value)
+{
+	value = 0;
+	for (unsigned int shift = 0; shift < 64 && offset < data.size(); shift += 7)
+	{
+		const uint8_t currentByte = data[offset++];
+		value |= static_cast<uint64_t>(currentByte & 0x7f) << shift;
+		if ((currentByte & 0x80) == 0)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+Replay::Replay(const size_t levelIndex, const double tickRate)
+	: m_levelIndex(levelIndex)
+	, m_tickRate(tickRate)
+	, m_ticksCount(0)
+{
+}
+
+void Replay::addEvent(const uint32_t tick, const int key, const int action)
+{
+	m_events.push_back({ tick, key, action });
+	m_ticksCount = tick + 1 > m_ticksCount ? tick + 1 : m_ticksCount;
+}
+
+void Replay::setChecksum(const uint32_t tick, const uint32_t checksum)
+{
+	if (tick >= m_checksums.size())
+	{
+		m_checksums.resize(tick + 1, 0);
+	}
+	m_checksums[tick] = checksum;
+}
+
+bool Replay::load(const std::string& path)
+{
+	std::ifstream file(path, std::ios::in | std::ios::binary);
+	if (!file.is_open())
+	{
+		std::cerr << "Can't open replay: " << path << std::endl;
+		return false;
+	}
+	const std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+	m_events.clear();
+	m_checksums.clear();
+	m_ticksCount = 0;
+	bool isLoaded = false;
+	if (data.size() >= sizeof(REPLAY_MAGIC) && std::equal(std::begin(REPLAY_MAGIC), std::end(REPLAY_MAGIC), data.begin()))
+	{
+		isLoaded = loadBinary(data);
+	}
+	else
+	{
+		std::istringstream stream(std::string(data.begin(), data.end()));
+		isLoaded = loadText(stream);
+	}
+	if (!isLoaded || m_tickRate <= 0)
+	{
+		std::cerr << "Bad replay: " << path << std::endl;
+		return false;
+	}
+	return true;
+}
+
+bool Replay::loadBinary(const std::vector<uint8_t>& data)
+{
+	size_t offset = sizeof(REPLAY_MAGIC);
+	const uint8_t version = offset < data.size() ? data[offset++] : 0;
+	if (version != REPLAY_BINARY_VERSION && version != REPLAY_BINARY_VERSION_NO_CHECKSUMS)
+	{
+		return false;
+	}
+	uint64_t levelIndex = 0;
+	uint64_t tickRate = 0;
+	uint64_t ticksCount = 0;
+	uint64_t eventsCount = 0;
+	if (!readVarint(data, offset, levelIndex) || !readVarint(data, offset, tickRate) ||
+		!readVarint(data, offset, ticksCount) || !readVarint(data, offset, eventsCount) || eventsCount > data.size())
+	{
+		return false;
+	}
+	m_levelIndex = static_cast<size_t>(levelIndex);
+	// stored in millihertz
+	m_tickRate = tickRate / 1000.0;
+	m_events.reserve(static_cast<size_t>(eventsCount));
+
+	uint64_t tick = 0;
+	for (uint64_t currentEvent = 0; currentEvent < eventsCount; ++currentEvent)
+	{
+		uint64_t tickDelta = 0;
+		uint64_t keyAction = 0;
+		if (!readVarint(data, offset, tickDelta) || !readVarint(data, offset, keyAction))
+		{
+			return false;
+		}
+		tick += tickDelta;
+		addEvent(static_cast<uint32_t>(tick), static_cast<int>(keyAction >> 2), static_cast<int>(keyAction & 3));
+	}
+
+	uint64_t checksumsCount = 0;
+	if (version == REPLAY_BINARY_VERSION && (!readVarint(data, offset, checksumsCount) || checksumsCount * 4 > data.size() - offset))
+	{
+		return false;
+	}
+	m_checksums.resize(static_cast<size_t>(checksumsCount));
+	for (uint32_t& currentChecksum : m_checksums)
+	{
+		// little endian, checksums don't compress
+		currentChecksum = data[offset] | (data[offset + 1] << 8) | (data[offset + 2] << 16) | (static_cast<uint32_t>(data[offset + 3]) << 24);
+		offset += 4;
+	}
+	m_ticksCount = static_cast<uint32_t>(ticksCount) > m_ticksCount ? static_cast<uint32_t>(ticksCount) : m_ticksCount;
+	return true;
+}
+
+bool Replay::loadText(std::istream& stream)
+{
+	std::string header;
+	int version = 0;
+	stream >> header >> version;
+	if (header != REPLAY_TEXT_HEADER || version != REPLAY_TEXT_VERSION)
+	{
+		return false;
+	}
+
+	uint32_t ticksCount = 0;
+	std::string line;
+	while (std::getline(stream, line))
+	{
+		std::istringstream lineStream(line);
+		std::string tag;
+		if (!(lineStream >> tag))
+		{
+			continue;
+		}
+		if (tag == "level")
+		{
+			lineStream >> m_levelIndex;
+		}
+		else if (tag == "tickRate")
+		{
+			lineStream >> m_tickRate;
+		}
+		else if (tag == "ticks")
+		{
+			lineStream >> ticksCount;
+		}
+		else if (tag == "e")
+		{
+			ReplayEvent event{};
+			if (!(lineStream >> event.tick >> event.key >> event.action) || (!m_events.empty() && event.tick < m_events.back().tick))
+			{
+				std::cerr << "Bad replay event: " << line << std::endl;
+				return false;
+			}
+			addEvent(event.tick, event.key, event.action);
+		}
+	}
+	m_ticksCount = ticksCount > m_ticksCount ? ticksCount : m_ticksCount;
+	return true;
+}
+
+bool Replay::save(const std::string& path) const
+{
+	std::vector<uint8_t> data(std::begin(REPLAY_MAGIC), std::end(REPLAY_MAGIC));
+	data.reserve(32 + m_events.size() * 2 + m_checksums.size() * 4);
+	data.push_back(REPLAY_BINARY_VERSION);
+	writeVarint(data, m_levelIndex);
+	writeVarint(data, static_cast<uint64_t>(std::llround(m_tickRate * 1000.0)));
+	writeVarint(data, m_ticksCount);
+	writeVarint(data, m_events.size());
+	uint32_t lastTick = 0;
+	for (const ReplayEvent& currentEvent : m_events)
+	{
+		// keys are GLFW key codes, actions are release, press and repeat: both fit into one varint
+		writeVarint(data, currentEvent.tick - lastTick);
+		writeVarint(data, (static_cast<uint64_t>(currentEvent.key) << 2) | (static_cast<uint64_t>(currentEvent.action) & 3));
+		lastTick = currentEvent.tick;
+	}
+	writeVarint(data, m_checksums.size());
+	for (const uint32_t currentChecksum : m_checksums)
+	{
+		for (unsigned int shift = 0; shift < 32; shift += 8)
+		{
+			data.push_back(static_cast<uint8_t>(currentChecksum >> shift));
+		}
+	}
+
+	std::ofstream file(path, std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!file.is_open())
+	{
+		std::cerr << "Can't write replay: " << path << std::endl;
+		return false;
+	}
+	file.write(reinterpret_cast<const char*>(data.data()), data.size());
+	return static_cast<bool>(file);
+}
+
+void ReplayPlayer::feedTick(Game& game)
+{
+	const std::vector<ReplayEvent>& events = m_replay.getEvents();
+	for (; m_nextEvent < events.size() && events[m_nextEvent].tick == m_currentTick; ++m_nextEvent)
+	{
+		game.setKey(events[m_nextEvent].key, events[m_nextEvent].action);
+	}
+	++m_currentTick;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class Game;
+
+struct ReplayEvent
+{
+	uint32_t tick;
+	int key;
+	int action;
+};
+
+// Key events of a play session with the tick they were applied on, replayed at a fixed tick rate.
+// Saved in a compact binary format: the events are delta-encoded by tick and written as varints,
+// a typical event takes two bytes. The text format ("BattleCityReplay 1" header, "level",
+// "tickRate" and "ticks" lines, then one "e <tick> <key> <action>" line per event) is still read,
+// it is handy for hand-written replays. A recorded replay also carries the world checksum at the
+// start of every tick, so a playback can prove it reproduced the recorded game.
+class Replay
+{
+public:
+	Replay(const size_t levelIndex = 1, const double tickRate = 60.0);
+
+	bool load(const std::string& path);
+	bool save(const std::string& path) const;
+
+	void addEvent(const uint32_t tick, const int key, const int action);
+	void setTicksCount(const uint32_t ticksCount) { m_ticksCount = ticksCount; }
+	void setChecksum(const uint32_t tick, const uint32_t checksum);
+
+	const std::vector<ReplayEvent>& getEvents() const { return m_events; }
+	size_t getLevelIndex() const { return m_levelIndex; }
+	double getTickRate() const { return m_tickRate; }
+	// milliseconds
+	double getTickDuration() const { return 1000.0 / m_tickRate; }
+	uint32_t getTicksCount() const { return m_ticksCount; }
+	// WorldHash::getChecksum() at the start of each tick, empty if the replay was not recorded from a game
+	const std::vector<uint32_t>& getChecksums() const { return m_checksums; }
+
+private:
+	bool loadText(std::istream& stream);
+	bool loadBinary(const std::vector<uint8_t>& data);
+
+	std::vector<ReplayEvent> m_events;
+	std::vector<uint32_t> m_checksums;
+	size_t m_levelIndex;
+	double m_tickRate;
+	uint32_t m_ticksCount;
+};
+
+// Feeds the events of a replay into a game tick by tick, the caller runs the tick itself
+class ReplayPlayer
+{
+public:
+	ReplayPlayer(const Replay& replay) : m_replay(replay), m_nextEvent(0), m_currentTick(0) {}
+
+	bool isFinished() const { return m_currentTick >= m_replay.getTicksCount(); }
+	uint32_t getCurrentTick() const { return m_currentTick; }
+	// queues the current tick's events into the game and moves to the next tick
+	void feedTick(Game& game);
+
+private:
+	const Replay& m_replay;
+	size_t m_nextEvent;
+	uint32_t m_currentTick;
+};
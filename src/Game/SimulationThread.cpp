@@ -0,0 +1,165 @@
+#include "SimulationThread.h"
+#include "Game.h"
+#include "../Physics/PhysicsEngine.h"
+#include "WorldHash.h"
+#include "../System/JobSystem.h"
+#include "../System/Metrics.h"
+#include "../System/Profiler.h"
+#include "../Renderer/RenderStats.h"
+#include <algorithm>
+#include <chrono>
+
+static constexpr uint32_t MAX_TICKS_PER_WAKEUP = 8;
+
+SimulationThread::SimulationThread(Game& game)
+	: m_game(game)
+	, m_ticksRequested(0)
+	, m_ticksPublished(0)
+	, m_isRunning(false)
+	, m_skipElapsedTime(false)
+{
+}
+
+SimulationThread::~SimulationThread()
+{
+	stop();
+}
+
+void SimulationThread::start()
+{
+	m_isRunning = true;
+	m_ticksRequested = 1;
+	m_thread = std::thread(&SimulationThread::run, this);
+}
+
+void SimulationThread::stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_tickMutex);
+		m_isRunning = false;
+	}
+	m_tickCondition.notify_one();
+	m_publishCondition.notify_all();
+	if (m_thread.joinable())
+	{
+		m_thread.join();
+	}
+}
+
+const RenderEngine::RenderSnapshot& SimulationThread::acquireLatestSnapshot()
+{
+	m_snapshots.update();
+	{
+		std::lock_guard<std::mutex> lock(m_tickMutex);
+		++m_ticksRequested;
+	}
+	m_tickCondition.notify_one();
+	return m_snapshots.getReadBuffer();
+}
+
+const RenderEngine::RenderSnapshot& SimulationThread::acquireFreshSnapshot()
+{
+	{
+		std::unique_lock<std::mutex> lock(m_tickMutex);
+		const uint64_t tick = ++m_ticksRequested;
+		m_tickCondition.notify_one();
+		m_publishCondition.wait(lock, [this, tick]() { return !m_isRunning || m_ticksPublished >= tick; });
+	}
+	m_snapshots.update();
+	return m_snapshots.getReadBuffer();
+}
+
+void SimulationThread::skipElapsedTime()
+{
+	std::lock_guard<std::mutex> lock(m_tickMutex);
+	m_skipElapsedTime = true;
+}
+
+void SimulationThread::run()
+{
+	PROFILE_THREAD("Simulation");
+	Metrics::Histogram& updateTimeHistogram = Metrics::histogram("battlecity_game_update_seconds", "Game update of one simulation tick", Metrics::TICK_TIME_BOUNDS);
+	Metrics::Histogram& physicsTimeHistogram = Metrics::histogram("battlecity_physics_update_seconds", "Physics update of one simulation tick", Metrics::TICK_TIME_BOUNDS);
+	Metrics::Counter& ticksCounter = Metrics::counter("battlecity_game_ticks_total", "Simulation ticks");
+	Metrics::Gauge& entitiesGauge = Metrics::gauge("battlecity_game_entities", "Objects in the simulated world");
+	// parallel game code runs on the job system owned by this thread
+	JobSystem::init();
+
+	uint64_t ticksDone = 0;
+	double unprocessedTime = 0.0;
+	auto lastTime = std::chrono::high_resolution_clock::now();
+	while (true)
+	{
+		bool skipElapsedTime = false;
+		{
+			std::unique_lock<std::mutex> lock(m_tickMutex);
+			m_tickCondition.wait(lock, [this, ticksDone]() { return !m_isRunning || m_ticksRequested > ticksDone; });
+			if (!m_isRunning)
+			{
+				break;
+			}
+			// a slow wakeup covers all frames requested meanwhile, the due ticks account for the time
+			ticksDone = m_ticksRequested;
+			skipElapsedTime = m_skipElapsedTime;
+			m_skipElapsedTime = false;
+		}
+
+		PROFILE_ZONE("Tick");
+		// the wall clock only decides how many fixed ticks are due, the game never sees its delta
+		const auto currentTime = std::chrono::high_resolution_clock::now();
+		unprocessedTime = skipElapsedTime ? 0.0 : unprocessedTime + std::chrono::duration<double, std::milli>(currentTime - lastTime).count();
+		lastTime = currentTime;
+		uint32_t ticksDue = static_cast<uint32_t>(unprocessedTime / Game::TICK_DURATION);
+		unprocessedTime -= ticksDue * Game::TICK_DURATION;
+		if (ticksDue > MAX_TICKS_PER_WAKEUP)
+		{
+			// after a stall the game slows down instead of spiralling further behind
+			ticksDue = MAX_TICKS_PER_WAKEUP;
+			unprocessedTime = 0.0;
+		}
+		double updateTime = 0.0;
+		double physicsTime = 0.0;
+		for (uint32_t currentTick = 0; currentTick < ticksDue; ++currentTick)
+		{
+			if (m_tickFunction)
+			{
+				const auto tickStartTime = std::chrono::high_resolution_clock::now();
+				m_tickFunction();
+				const double tickTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - tickStartTime).count();
+				updateTime += tickTime;
+				updateTimeHistogram.observe(tickTime / 1000.0);
+				ticksCounter.add();
+				continue;
+			}
+			const auto updateStartTime = std::chrono::high_resolution_clock::now();
+			m_game.update(Game::TICK_DURATION);
+			const auto updateEndTime = std::chrono::high_resolution_clock::now();
+			Physics::PhysicsEngine::update(Game::TICK_DURATION);
+			const double tickUpdateTime = std::chrono::duration<double, std::milli>(updateEndTime - updateStartTime).count();
+			const double tickPhysicsTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - updateEndTime).count();
+			updateTime += tickUpdateTime;
+			physicsTime += tickPhysicsTime;
+			updateTimeHistogram.observe(tickUpdateTime / 1000.0);
+			physicsTimeHistogram.observe(tickPhysicsTime / 1000.0);
+			ticksCounter.add();
+		}
+		RenderEngine::RenderStats::setSimulationTimes(updateTime, physicsTime);
+		if (ticksDue > 0)
+		{
+			const std::vector<IGameObject*>& objects = WorldHash::getObjects();
+			entitiesGauge.set(static_cast<double>(objects.size() - static_cast<size_t>(std::count(objects.begin(), objects.end(), nullptr))));
+		}
+
+		RenderEngine::RenderSnapshot& snapshot = m_snapshots.getWriteBuffer();
+		snapshot.clear();
+		m_game.render(snapshot);
+		m_snapshots.publish();
+		{
+			std::lock_guard<std::mutex> lock(m_tickMutex);
+			m_ticksPublished = ticksDone;
+		}
+		m_publishCondition.notify_all();
+	}
+
+	JobSystem::terminate();
+}
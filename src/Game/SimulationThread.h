@@ -0,0 +1,50 @@
+#pragma once
+
+#include "../Renderer/RenderSnapshot.h"
+#include "../System/TripleBuffer.h"
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+class Game;
+
+// Runs Game::update and physics on its own thread, so the next ticks are simulated while the main
+// thread draws the previous ones. Every frame request runs the fixed ticks that are due by then
+// (possibly none) and publishes a RenderSnapshot.
+class SimulationThread
+{
+public:
+	SimulationThread(Game& game);
+	~SimulationThread();
+
+	SimulationThread(const SimulationThread&) = delete;
+	SimulationThread& operator = (const SimulationThread&) = delete;
+
+	// replaces the local tick (Game::update and the physics) before start(), e.g. with a network session
+	void setTickFunction(std::function<void()> tickFunction) { m_tickFunction = std::move(tickFunction); }
+	void start();
+	void stop();
+	// Main thread: returns the newest published snapshot and asks for the next tick
+	const RenderEngine::RenderSnapshot& acquireLatestSnapshot();
+	// Main thread: runs a tick on the input received so far and waits for its snapshot
+	const RenderEngine::RenderSnapshot& acquireFreshSnapshot();
+	// Main thread: the time since the last tick is not simulated, e.g. after a pause
+	void skipElapsedTime();
+
+private:
+	void run();
+
+	Game& m_game;
+	std::function<void()> m_tickFunction;
+	TripleBuffer<RenderEngine::RenderSnapshot> m_snapshots;
+	std::thread m_thread;
+	std::mutex m_tickMutex;
+	std::condition_variable m_tickCondition;
+	std::condition_variable m_publishCondition;
+	uint64_t m_ticksRequested;
+	uint64_t m_ticksPublished;
+	bool m_isRunning;
+	bool m_skipElapsedTime;
+};
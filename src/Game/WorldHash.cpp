@@ -0,0 +1,82 @@
+#include "WorldHash.h"
+#include "GameObjects/IGameObject.h"
+#include <iomanip>
+
+WorldHash::Context WorldHash::m_processContext;
+thread_local WorldHash::Context* WorldHash::m_pContext = &WorldHash::m_processContext;
+
+static const char* getObjectTypeName(const IGameObject::EObjectType objectType)
+{
+	switch (objectType)
+	{
+	case IGameObject::EObjectType::BetonWall:
+		return "BetonWall";
+	case IGameObject::EObjectType::Border:
+		return "Border";
+	case IGameObject::EObjectType::BrickWall:
+		return "BrickWall";
+	case IGameObject::EObjectType::Bullet:
+		return "Bullet";
+	case IGameObject::EObjectType::Eagle:
+		return "Eagle";
+	case IGameObject::EObjectType::Ice:
+		return "Ice";
+	case IGameObject::EObjectType::Tank:
+		return "Tank";
+	case IGameObject::EObjectType::Trees:
+		return "Trees";
+	case IGameObject::EObjectType::Water:
+		return "Water";
+	default:
+		return "Unknown";
+	}
+}
+
+void WorldHash::reset()
+{
+	m_pContext->objects.clear();
+	m_pContext->hash = 0;
+}
+
+uint32_t WorldHash::registerObject(IGameObject* pObject)
+{
+	m_pContext->objects.push_back(pObject);
+	return static_cast<uint32_t>(m_pContext->objects.size() - 1);
+}
+
+void WorldHash::unregisterObject(const uint32_t entityID, const IGameObject* pObject, const uint64_t stateHash)
+{
+	if (isRegistered(entityID, pObject))
+	{
+		m_pContext->objects[entityID] = nullptr;
+		apply(stateHash);
+	}
+}
+
+void WorldHash::dump(std::ostream& stream)
+{
+	std::vector<Field> fields;
+	const std::streamsize precision = stream.precision(9);
+	for (const IGameObject* pObject : m_pContext->objects)
+	{
+		if (!pObject || pObject->getStateHash() == 0)
+		{
+			continue;
+		}
+		fields.clear();
+		StateHasher hasher(pObject->getEntityID(), &fields);
+		pObject->hashState(hasher);
+		stream << "entity " << pObject->getEntityID() << " " << getObjectTypeName(pObject->getObjectType())
+			   << " hash " << std::hex << std::setw(16) << std::setfill('0') << pObject->getStateHash() << std::dec << std::setfill(' ');
+		for (const Field& currentField : fields)
+		{
+			stream << " " << currentField.name << "=" << currentField.x;
+			if (currentField.isVector)
+			{
+				stream << "," << currentField.y;
+			}
+		}
+		stream << "\n";
+	}
+	stream.precision(precision);
+}
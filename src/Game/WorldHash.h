@@ -0,0 +1,126 @@
+#pragma once
+
+#include <glm/vec2.hpp>
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <vector>
+
+class IGameObject;
+
+// Incremental checksum of the simulated world. The state of every object is a set of fields, each
+// field contributes a hash of (entity ID, field, value), and the world hash is the XOR of all
+// contributions. When a field changes only the difference of its old and new contribution is applied,
+// so the world hash follows the simulation at the cost of two small hashes per changed field and is
+// independent of the order of the changes. Objects change on the simulation thread only.
+// Every thread hashes into the context made current on it, by default the one context of the process;
+// a process simulating several worlds gives each its own context.
+class WorldHash
+{
+public:
+	struct Field
+	{
+		const char* name;
+		double x;
+		double y;
+		bool isVector;
+	};
+
+	static uint64_t pack(const uint32_t value) { return value; }
+	static uint64_t pack(const bool value) { return value ? 1 : 0; }
+	static uint64_t pack(const double value)
+	{
+		uint64_t bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+		return bits;
+	}
+	static uint64_t pack(const glm::vec2& value)
+	{
+		uint32_t bits[2];
+		std::memcpy(bits, &value.x, sizeof(bits[0]));
+		std::memcpy(bits + 1, &value.y, sizeof(bits[1]));
+		return (static_cast<uint64_t>(bits[1]) << 32) | bits[0];
+	}
+
+	static uint64_t hashField(const uint32_t entityID, const uint8_t field, const uint64_t value)
+	{
+		uint64_t hash = value ^ ((static_cast<uint64_t>(entityID) << 8 | field) * 0x9e3779b97f4a7c15ull);
+		hash ^= hash >> 32;
+		hash *= 0xd6e8feb86659fd93ull;
+		hash ^= hash >> 32;
+		hash *= 0xd6e8feb86659fd93ull;
+		hash ^= hash >> 32;
+		return hash;
+	}
+
+	// Hashes the whole state of one object field by field. With a fields list it also collects the values by name for dumps.
+	class StateHasher
+	{
+	public:
+		StateHasher(const uint32_t entityID, std::vector<Field>* pFields = nullptr)
+			: m_entityID(entityID)
+			, m_hash(0)
+			, m_pFields(pFields)
+		{
+		}
+
+		template<class TValue>
+		void add(const uint8_t field, const char* name, const TValue& value)
+		{
+			m_hash ^= hashField(m_entityID, field, pack(value));
+			if (m_pFields)
+			{
+				m_pFields->push_back(makeField(name, value));
+			}
+		}
+
+		uint64_t getHash() const { return m_hash; }
+
+	private:
+		template<class TValue>
+		static Field makeField(const char* name, const TValue& value) { return { name, static_cast<double>(value), 0.0, false }; }
+		static Field makeField(const char* name, const glm::vec2& value) { return { name, value.x, value.y, true }; }
+
+		uint32_t m_entityID;
+		uint64_t m_hash;
+		std::vector<Field>* m_pFields;
+	};
+
+	struct Context
+	{
+		// indexed by entity ID, nullptr for destroyed objects
+		std::vector<IGameObject*> objects;
+		uint64_t hash = 0;
+	};
+
+	WorldHash() = delete;
+
+	// nullptr makes the process context current again
+	static void setCurrentContext(Context* pContext) { m_pContext = pContext ? pContext : &m_processContext; }
+	static Context* getCurrentContext() { return m_pContext; }
+
+	// a new world starts: entity IDs are given out from 0 again, objects of the old world stop counting
+	static void reset();
+	static uint32_t registerObject(IGameObject* pObject);
+	static void unregisterObject(const uint32_t entityID, const IGameObject* pObject, const uint64_t stateHash);
+	static bool isRegistered(const uint32_t entityID, const IGameObject* pObject)
+	{
+		const std::vector<IGameObject*>& objects = m_pContext->objects;
+		return entityID < objects.size() && objects[entityID] == pObject;
+	}
+	static void apply(const uint64_t stateHashDifference) { m_pContext->hash ^= stateHashDifference; }
+	// a restored world state brings its own hash along
+	static void setHash(const uint64_t hash) { m_pContext->hash = hash; }
+
+	static uint64_t getHash() { return m_pContext->hash; }
+	// the hash folded to the 32 bits stored per tick in replays
+	static uint32_t getChecksum() { return static_cast<uint32_t>(getHash() ^ (getHash() >> 32)); }
+	// indexed by entity ID, objects without state are registered too
+	static const std::vector<IGameObject*>& getObjects() { return m_pContext->objects; }
+	// one line per object with state: entity ID, type, state hash and the named state fields
+	static void dump(std::ostream& stream);
+
+private:
+	static Context m_processContext;
+	static thread_local Context* m_pContext;
+};
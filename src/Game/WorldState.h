@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+// The whole simulation state of a world in one flat buffer. Values are copied in as plain bytes in a
+// fixed order, the buffer holds no pointers, so it can be copied, moved or kept in a ring of states
+// for rewind as is. It only restores into a world built from the same level: objects write their
+// state in the order they are stored in, and every object knows its own layout.
+// A buffer that is reused keeps its capacity, taking a snapshot then doesn't allocate.
+class WorldState
+{
+public:
+	void clear() { m_buffer.clear(); }
+	size_t getSize() const { return m_buffer.size(); }
+	const uint8_t* getData() const { return m_buffer.data(); }
+	void assign(const uint8_t* pData, const size_t size) { m_buffer.assign(pData, pData + size); }
+
+	template<class TValue>
+	void write(const TValue& value)
+	{
+		static_assert(std::is_trivially_copyable<TValue>::value, "only plain values go into a world state");
+		const size_t offset = m_buffer.size();
+		m_buffer.resize(offset + sizeof(TValue));
+		std::memcpy(m_buffer.data() + offset, &value, sizeof(TValue));
+	}
+
+	// Reads the values back in the order they were written. Reading past the end fails the reader
+	// and leaves the value untouched.
+	class Reader
+	{
+	public:
+		Reader(const WorldState& state) : m_pData(state.getData()), m_size(state.getSize()), m_offset(0), m_hasFailed(false) {}
+
+		template<class TValue>
+		void read(TValue& value)
+		{
+			static_assert(std::is_trivially_copyable<TValue>::value, "only plain values go into a world state");
+			if (m_hasFailed || m_size - m_offset < sizeof(TValue))
+			{
+				m_hasFailed = true;
+				return;
+			}
+			std::memcpy(&value, m_pData + m_offset, sizeof(TValue));
+			m_offset += sizeof(TValue);
+		}
+
+		bool hasFailed() const { return m_hasFailed; }
+		bool isAtEnd() const { return m_offset == m_size; }
+
+	private:
+		const uint8_t* m_pData;
+		size_t m_size;
+		size_t m_offset;
+		bool m_hasFailed;
+	};
+
+private:
+	std::vector<uint8_t> m_buffer;
+};
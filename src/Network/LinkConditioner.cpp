@@ -0,0 +1,37 @@
+#include "LinkConditioner.h"
+
+LinkConditioner::LinkConditioner(UDPSocket& socket, const Settings& settings)
+	: m_socket(socket)
+	, m_settings(settings)
+	, m_random(settings.seed)
+	, m_droppedPacketsCount(0)
+{
+}
+
+void LinkConditioner::send(const NetAddress& address, const uint8_t* pData, const size_t size)
+{
+	if (m_settings.loss > 0.0 && std::uniform_real_distribution<double>(0.0, 1.0)(m_random) < m_settings.loss)
+	{
+		++m_droppedPacketsCount;
+		return;
+	}
+	const double delay = m_settings.latency + (m_settings.jitter > 0.0 ? std::uniform_real_distribution<double>(0.0, m_settings.jitter)(m_random) : 0.0);
+	if (delay <= 0.0)
+	{
+		m_socket.send(address, pData, size);
+		return;
+	}
+	const auto dueTime = Clock::now() + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::milli>(delay));
+	m_delayedPackets.push({ dueTime, address, std::vector<uint8_t>(pData, pData + size) });
+}
+
+void LinkConditioner::flush()
+{
+	const auto currentTime = Clock::now();
+	while (!m_delayedPackets.empty() && m_delayedPackets.top().dueTime <= currentTime)
+	{
+		const DelayedPacket& packet = m_delayedPackets.top();
+		m_socket.send(packet.address, packet.data.data(), packet.data.size());
+		m_delayedPackets.pop();
+	}
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "UDPSocket.h"
+#include <chrono>
+#include <cstdint>
+#include <queue>
+#include <random>
+#include <vector>
+
+// Sends through a socket as if the network in between were bad: every packet is held back for the
+// latency plus a random jitter (so packets can overtake each other) and dropped with the loss
+// probability. With the default settings packets go out at once. Used to test netcode on loopback.
+class LinkConditioner
+{
+public:
+	struct Settings
+	{
+		// milliseconds, one way
+		double latency = 0.0;
+		double jitter = 0.0;
+		// 0..1
+		double loss = 0.0;
+		uint32_t seed = 1;
+	};
+
+	LinkConditioner(UDPSocket& socket, const Settings& settings);
+
+	void send(const NetAddress& address, const uint8_t* pData, const size_t size);
+	// sends the held back packets that are due, call it at least once per tick
+	void flush();
+
+	UDPSocket& getSocket() { return m_socket; }
+	uint64_t getDroppedPacketsCount() const { return m_droppedPacketsCount; }
+
+private:
+	using Clock = std::chrono::steady_clock;
+
+	struct DelayedPacket
+	{
+		Clock::time_point dueTime;
+		NetAddress address;
+		std::vector<uint8_t> data;
+
+		bool operator > (const DelayedPacket& packet) const { return dueTime > packet.dueTime; }
+	};
+
+	UDPSocket& m_socket;
+	Settings m_settings;
+	std::mt19937 m_random;
+	std::priority_queue<DelayedPacket, std::vector<DelayedPacket>, std::greater<DelayedPacket>> m_delayedPackets;
+	uint64_t m_droppedPacketsCount;
+};
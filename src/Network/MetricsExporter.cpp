@@ -0,0 +1,235 @@
+#include "MetricsExporter.h"
+#include "../System/Metrics.h"
+#include "../System/Profiler.h"
+
+#include <chrono>
+#include <iostream>
+
+#ifdef _WIN32
+	#define WIN32_LEAN_AND_MEAN
+	#define NOMINMAX
+	#include <winsock2.h>
+	#include <ws2tcpip.h>
+	#pragma comment(lib, "ws2_32.lib")
+	using SocketHandle = SOCKET;
+	#define poll WSAPoll
+#else
+	#include <arpa/inet.h>
+	#include <netinet/in.h>
+	#include <poll.h>
+	#include <sys/socket.h>
+	#include <unistd.h>
+	using SocketHandle = int;
+#endif
+
+// a request is a line and a few headers, more isn't read
+static constexpr size_t MAX_REQUEST_SIZE = 4096;
+// a scraper that hung up must not kill the process with SIGPIPE
+#ifdef MSG_NOSIGNAL
+static constexpr int SEND_FLAGS = MSG_NOSIGNAL;
+#else
+static constexpr int SEND_FLAGS = 0;
+#endif
+
+MetricsExporter::~MetricsExporter()
+{
+	stop();
+}
+
+bool MetricsExporter::start(const MetricsExporterSettings& settings)
+{
+	stop();
+	m_settings = settings;
+	if (m_settings.port != 0 && !openEndpoint())
+	{
+		return false;
+	}
+	if (!m_settings.jsonPath.empty())
+	{
+		m_jsonFile.open(m_settings.jsonPath, std::ios::app);
+		if (!m_jsonFile)
+		{
+			std::cerr << "Can't open the metrics file " << m_settings.jsonPath << std::endl;
+			closeSocket(m_listenSocket);
+			return false;
+		}
+	}
+	m_isRunning = true;
+	m_thread = std::thread(&MetricsExporter::run, this);
+	return true;
+}
+
+void MetricsExporter::stop()
+{
+	if (!m_thread.joinable())
+	{
+		return;
+	}
+	m_isRunning = false;
+	m_thread.join();
+	if (m_jsonFile.is_open())
+	{
+		writeJSONLine();
+		m_jsonFile.close();
+	}
+	closeSocket(m_listenSocket);
+	m_port = 0;
+}
+
+bool MetricsExporter::openEndpoint()
+{
+#ifdef _WIN32
+	static const bool isInitialized = []()
+	{
+		WSADATA data;
+		return WSAStartup(MAKEWORD(2, 2), &data) == 0;
+	}();
+	if (!isInitialized)
+	{
+		std::cerr << "Can't initialize Winsock" << std::endl;
+		return false;
+	}
+#endif
+	sockaddr_in socketAddress = {};
+	socketAddress.sin_family = AF_INET;
+	socketAddress.sin_port = htons(m_settings.port);
+	if (inet_pton(AF_INET, m_settings.bindAddress == "localhost" ? "127.0.0.1" : m_settings.bindAddress.c_str(), &socketAddress.sin_addr) != 1)
+	{
+		std::cerr << "Bad metrics bind address: " << m_settings.bindAddress << std::endl;
+		return false;
+	}
+	const SocketHandle socketHandle = ::socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+#ifdef _WIN32
+	if (socketHandle == INVALID_SOCKET)
+#else
+	if (socketHandle < 0)
+#endif
+	{
+		std::cerr << "Can't create the metrics socket" << std::endl;
+		return false;
+	}
+	m_listenSocket = static_cast<intptr_t>(socketHandle);
+	// a restarted server gets its port back while the old connections time out
+	const int isReused = 1;
+	setsockopt(socketHandle, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&isReused), sizeof(isReused));
+	if (::bind(socketHandle, reinterpret_cast<const sockaddr*>(&socketAddress), sizeof(socketAddress)) != 0 || ::listen(socketHandle, 4) != 0)
+	{
+		std::cerr << "Can't serve the metrics on " << m_settings.bindAddress << ":" << m_settings.port << std::endl;
+		closeSocket(m_listenSocket);
+		return false;
+	}
+	sockaddr_in boundAddress = {};
+	socklen_t boundAddressSize = sizeof(boundAddress);
+	getsockname(socketHandle, reinterpret_cast<sockaddr*>(&boundAddress), &boundAddressSize);
+	m_port = ntohs(boundAddress.sin_port);
+	return true;
+}
+
+void MetricsExporter::closeSocket(intptr_t& socketHandle)
+{
+	if (socketHandle == INVALID_SOCKET_HANDLE)
+	{
+		return;
+	}
+#ifdef _WIN32
+	closesocket(static_cast<SocketHandle>(socketHandle));
+#else
+	::close(static_cast<SocketHandle>(socketHandle));
+#endif
+	socketHandle = INVALID_SOCKET_HANDLE;
+}
+
+void MetricsExporter::run()
+{
+	PROFILE_THREAD("Metrics");
+	using Clock = std::chrono::steady_clock;
+	const auto jsonInterval = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(m_settings.jsonInterval));
+	auto nextJSONTime = Clock::now() + jsonInterval;
+	while (m_isRunning.load(std::memory_order_relaxed))
+	{
+		if (m_listenSocket != INVALID_SOCKET_HANDLE)
+		{
+			pollfd listenPoll = {};
+			listenPoll.fd = static_cast<SocketHandle>(m_listenSocket);
+			listenPoll.events = POLLIN;
+			if (poll(&listenPoll, 1, POLL_TIMEOUT_MILLISECONDS) > 0)
+			{
+				intptr_t connection = static_cast<intptr_t>(::accept(static_cast<SocketHandle>(m_listenSocket), nullptr, nullptr));
+#ifdef _WIN32
+				if (connection != static_cast<intptr_t>(INVALID_SOCKET))
+#else
+				if (connection >= 0)
+#endif
+				{
+					serveConnection(connection);
+					closeSocket(connection);
+				}
+			}
+		}
+		else
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(POLL_TIMEOUT_MILLISECONDS));
+		}
+		if (m_jsonFile.is_open() && Clock::now() >= nextJSONTime)
+		{
+			nextJSONTime += jsonInterval;
+			writeJSONLine();
+		}
+	}
+}
+
+void MetricsExporter::serveConnection(const intptr_t connection)
+{
+	PROFILE_ZONE("MetricsExporter::serveConnection");
+	const SocketHandle socketHandle = static_cast<SocketHandle>(connection);
+	std::string request;
+	char buffer[1024];
+	// the whole header, or what came within the timeout
+	while (request.find("\r\n\r\n") == std::string::npos && request.size() < MAX_REQUEST_SIZE)
+	{
+		pollfd connectionPoll = {};
+		connectionPoll.fd = socketHandle;
+		connectionPoll.events = POLLIN;
+		if (poll(&connectionPoll, 1, POLL_TIMEOUT_MILLISECONDS) <= 0)
+		{
+			break;
+		}
+		const auto receivedSize = ::recv(socketHandle, buffer, sizeof(buffer), 0);
+		if (receivedSize <= 0)
+		{
+			break;
+		}
+		request.append(buffer, static_cast<size_t>(receivedSize));
+	}
+
+	std::string body;
+	std::string status = "200 OK";
+	if (request.compare(0, 13, "GET /metrics ") == 0 || request.compare(0, 6, "GET / ") == 0)
+	{
+		Metrics::writePrometheus(body);
+	}
+	else
+	{
+		status = "404 Not Found";
+		body = "Metrics are at /metrics\n";
+	}
+	std::string response = "HTTP/1.0 " + status + "\r\nContent-Type: text/plain; version=0.0.4; charset=utf-8\r\nContent-Length: " +
+						   std::to_string(body.size()) + "\r\nConnection: close\r\n\r\n" + body;
+	for (size_t sentSize = 0; sentSize < response.size();)
+	{
+		const auto size = ::send(socketHandle, response.data() + sentSize, static_cast<int>(response.size() - sentSize), SEND_FLAGS);
+		if (size <= 0)
+		{
+			break;
+		}
+		sentSize += static_cast<size_t>(size);
+	}
+}
+
+void MetricsExporter::writeJSONLine()
+{
+	std::string line;
+	Metrics::writeJSONLine(line);
+	m_jsonFile << line;
+	m_jsonFile.flush();
+}
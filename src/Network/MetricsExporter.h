@@ -0,0 +1,54 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <thread>
+
+struct MetricsExporterSettings
+{
+	// the port of the Prometheus endpoint, 0 - no endpoint
+	uint16_t port = 0;
+	std::string bindAddress = "127.0.0.1";
+	// a file the metrics are appended to as a JSON line every jsonInterval seconds, empty - no file
+	std::string jsonPath;
+	double jsonInterval = 10.0;
+};
+
+// Exports the Metrics registry from a thread of its own, so nothing that updates the metrics ever waits
+// for it: serves GET /metrics in the Prometheus text format over HTTP on a local TCP port and appends
+// periodic JSON lines to a file. One connection is served at a time, a scraper is the only client.
+class MetricsExporter
+{
+public:
+	MetricsExporter() = default;
+	~MetricsExporter();
+
+	MetricsExporter(const MetricsExporter&) = delete;
+	MetricsExporter& operator = (const MetricsExporter&) = delete;
+
+	bool start(const MetricsExporterSettings& settings);
+	// writes a last JSON line
+	void stop();
+	// the bound port, 0 without an endpoint
+	uint16_t getPort() const { return m_port; }
+
+private:
+	static constexpr intptr_t INVALID_SOCKET_HANDLE = -1;
+	// how long the thread sleeps at most, it notices stop() that late
+	static constexpr int POLL_TIMEOUT_MILLISECONDS = 100;
+
+	bool openEndpoint();
+	void closeSocket(intptr_t& socketHandle);
+	void run();
+	void serveConnection(const intptr_t connection);
+	void writeJSONLine();
+
+	MetricsExporterSettings m_settings;
+	intptr_t m_listenSocket = INVALID_SOCKET_HANDLE;
+	uint16_t m_port = 0;
+	std::ofstream m_jsonFile;
+	std::atomic<bool> m_isRunning{ false };
+	std::thread m_thread;
+};
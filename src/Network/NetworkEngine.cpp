@@ -0,0 +1,897 @@
+#include "NetworkEngine.h"
+#include "../System/JobSystem.h"
+#include "../System/Metrics.h"
+#include "../System/Profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+#ifdef __linux__
+	#include <arpa/inet.h>
+	#include <cerrno>
+	#include <netinet/in.h>
+	#include <sys/epoll.h>
+	#include <sys/eventfd.h>
+	#include <sys/mman.h>
+	#include <sys/socket.h>
+	#include <sys/syscall.h>
+	#include <unistd.h>
+	#define BATTLECITY_HAS_EPOLL 1
+	#if __has_include(<linux/io_uring.h>) && defined(__NR_io_uring_setup)
+		#include <linux/io_uring.h>
+		#define BATTLECITY_HAS_IO_URING 1
+	#endif
+#endif
+
+// a socket is given that much kernel buffer, a burst of inputs from every client arrives between two ticks
+static constexpr int SOCKET_BUFFER_SIZE = 4 * 1024 * 1024;
+// an idle I/O thread wakes up that often anyway
+static constexpr int IDLE_TIMEOUT_MILLISECONDS = 100;
+// a burst larger than a send queue waits that long for the I/O thread before packets are dropped,
+// once per producer: the sends after a timeout are dropped at once until the queue is empty again
+static constexpr uint64_t FULL_QUEUE_WAIT_NANOSECONDS = 2000000;
+
+#ifdef BATTLECITY_HAS_EPOLL
+static void toSocketAddress(const NetAddress& address, sockaddr_in& socketAddress)
+{
+	socketAddress = {};
+	socketAddress.sin_family = AF_INET;
+	socketAddress.sin_addr.s_addr = htonl(address.ip);
+	socketAddress.sin_port = htons(address.port);
+}
+
+static void toNetAddress(const sockaddr_in& socketAddress, NetAddress& address)
+{
+	address.ip = ntohl(socketAddress.sin_addr.s_addr);
+	address.port = ntohs(socketAddress.sin_port);
+}
+#endif
+
+#ifdef BATTLECITY_HAS_IO_URING
+// A ring set up through the raw system calls, the headers of the kernel are all it needs. It also owns
+// the buffers of the operations in flight, the kernel may write into them until the ring is closed.
+class NetworkEngine::IoUring
+{
+public:
+	static constexpr unsigned int ENTRIES = 256;
+
+	struct Message
+	{
+		msghdr header;
+		iovec vector;
+		sockaddr_in address;
+	};
+
+	// the receives kept in flight, each into its own packet
+	std::array<Message, BATCH_SIZE> receiveMessages;
+	std::array<NetPacket, BATCH_SIZE> receivePackets;
+	// one batch of sends in flight, straight from the send queues
+	std::array<Message, BATCH_SIZE> sendMessages;
+	std::array<const NetPacket*, BATCH_SIZE> sendPackets;
+	uint64_t wakeupValue = 0;
+
+	~IoUring()
+	{
+		if (m_pSqes)
+		{
+			munmap(m_pSqes, m_sqesSize);
+		}
+		if (m_pCqRing && m_pCqRing != m_pSqRing)
+		{
+			munmap(m_pCqRing, m_cqRingSize);
+		}
+		if (m_pSqRing)
+		{
+			munmap(m_pSqRing, m_sqRingSize);
+		}
+		if (m_handle >= 0)
+		{
+			::close(m_handle);
+		}
+	}
+
+	bool init()
+	{
+		io_uring_params params = {};
+		m_handle = static_cast<int>(syscall(__NR_io_uring_setup, ENTRIES, &params));
+		if (m_handle < 0)
+		{
+			return false;
+		}
+		m_sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+		m_cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+		const bool isSingleMap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+		if (isSingleMap)
+		{
+			m_sqRingSize = m_cqRingSize = std::max(m_sqRingSize, m_cqRingSize);
+		}
+		m_pSqRing = map(m_sqRingSize, IORING_OFF_SQ_RING);
+		m_pCqRing = isSingleMap ? m_pSqRing : map(m_cqRingSize, IORING_OFF_CQ_RING);
+		m_sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+		m_pSqes = static_cast<io_uring_sqe*>(map(m_sqesSize, IORING_OFF_SQES));
+		if (!m_pSqRing || !m_pCqRing || !m_pSqes)
+		{
+			return false;
+		}
+		uint8_t* pSqRing = static_cast<uint8_t*>(m_pSqRing);
+		m_pSqHead = reinterpret_cast<unsigned int*>(pSqRing + params.sq_off.head);
+		m_pSqTail = reinterpret_cast<unsigned int*>(pSqRing + params.sq_off.tail);
+		m_sqMask = *reinterpret_cast<unsigned int*>(pSqRing + params.sq_off.ring_mask);
+		m_sqEntries = params.sq_entries;
+		m_pSqArray = reinterpret_cast<unsigned int*>(pSqRing + params.sq_off.array);
+		uint8_t* pCqRing = static_cast<uint8_t*>(m_pCqRing);
+		m_pCqHead = reinterpret_cast<unsigned int*>(pCqRing + params.cq_off.head);
+		m_pCqTail = reinterpret_cast<unsigned int*>(pCqRing + params.cq_off.tail);
+		m_cqMask = *reinterpret_cast<unsigned int*>(pCqRing + params.cq_off.ring_mask);
+		m_pCqes = reinterpret_cast<io_uring_cqe*>(pCqRing + params.cq_off.cqes);
+		m_sqTail = *m_pSqTail;
+		return true;
+	}
+
+	// a cleared submission entry, nullptr when the ring is full
+	io_uring_sqe* getSqe()
+	{
+		if (m_sqTail - __atomic_load_n(m_pSqHead, __ATOMIC_ACQUIRE) >= m_sqEntries)
+		{
+			return nullptr;
+		}
+		const unsigned int index = m_sqTail & m_sqMask;
+		io_uring_sqe* pSqe = &m_pSqes[index];
+		std::memset(pSqe, 0, sizeof(io_uring_sqe));
+		m_pSqArray[index] = index;
+		++m_sqTail;
+		++m_pendingCount;
+		return pSqe;
+	}
+
+	// submits what was prepared and waits for waitCount completions, one system call
+	bool submit(const unsigned int waitCount)
+	{
+		__atomic_store_n(m_pSqTail, m_sqTail, __ATOMIC_RELEASE);
+		const int result = static_cast<int>(syscall(__NR_io_uring_enter, m_handle, m_pendingCount, waitCount,
+													waitCount > 0 ? IORING_ENTER_GETEVENTS : 0, nullptr, 0));
+		if (result < 0)
+		{
+			return errno == EINTR || errno == EAGAIN || errno == EBUSY;
+		}
+		m_pendingCount -= std::min(m_pendingCount, static_cast<unsigned int>(result));
+		return true;
+	}
+
+	// calls function(const io_uring_cqe&) for every completion so far
+	template<class TFunction>
+	void forEachCompletion(const TFunction& function)
+	{
+		unsigned int head = *m_pCqHead;
+		const unsigned int tail = __atomic_load_n(m_pCqTail, __ATOMIC_ACQUIRE);
+		for (; head != tail; ++head)
+		{
+			function(m_pCqes[head & m_cqMask]);
+		}
+		__atomic_store_n(m_pCqHead, head, __ATOMIC_RELEASE);
+	}
+
+private:
+	void* map(const size_t size, const off_t offset)
+	{
+		void* pMemory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_handle, offset);
+		return pMemory == MAP_FAILED ? nullptr : pMemory;
+	}
+
+	int m_handle = -1;
+	void* m_pSqRing = nullptr;
+	void* m_pCqRing = nullptr;
+	io_uring_sqe* m_pSqes = nullptr;
+	size_t m_sqRingSize = 0;
+	size_t m_cqRingSize = 0;
+	size_t m_sqesSize = 0;
+	unsigned int* m_pSqHead = nullptr;
+	unsigned int* m_pSqTail = nullptr;
+	unsigned int* m_pSqArray = nullptr;
+	unsigned int m_sqMask = 0;
+	unsigned int m_sqEntries = 0;
+	unsigned int m_sqTail = 0;
+	unsigned int m_pendingCount = 0;
+	unsigned int* m_pCqHead = nullptr;
+	unsigned int* m_pCqTail = nullptr;
+	unsigned int m_cqMask = 0;
+	io_uring_cqe* m_pCqes = nullptr;
+};
+#else
+class NetworkEngine::IoUring
+{
+};
+#endif
+
+NetworkEngine::IOThread::IOThread()
+	: pReceiveQueue(std::make_unique<ReceiveQueue>())
+{
+}
+
+NetworkEngine::IOThread::~IOThread()
+{
+#ifdef BATTLECITY_HAS_EPOLL
+	if (wakeupHandle >= 0)
+	{
+		::close(static_cast<int>(wakeupHandle));
+	}
+#endif
+}
+
+NetworkEngine::NetworkEngine()
+	: m_port(0)
+	, m_isIoUringUsed(false)
+	, m_isRunning(false)
+	, m_tickTimestamp(0)
+{
+}
+
+NetworkEngine::~NetworkEngine()
+{
+	stop();
+}
+
+bool NetworkEngine::open(const NetworkEngineSettings& settings)
+{
+	m_settings = settings;
+	m_ioThreads.clear();
+	const unsigned int ioThreadsCount = std::max(1u, settings.ioThreadsCount);
+	for (unsigned int currentIOThread = 0; currentIOThread < ioThreadsCount; ++currentIOThread)
+	{
+		auto pIOThread = std::make_unique<IOThread>();
+		// the first socket may take any free port, the others join it
+		if (!pIOThread->socket.open(currentIOThread == 0 ? settings.port : m_port, settings.bindAddress, ioThreadsCount > 1))
+		{
+			m_ioThreads.clear();
+			return false;
+		}
+		m_port = pIOThread->socket.getPort();
+		pIOThread->socket.setBufferSize(SOCKET_BUFFER_SIZE);
+#ifdef BATTLECITY_HAS_EPOLL
+		pIOThread->wakeupHandle = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+		if (pIOThread->wakeupHandle < 0)
+		{
+			m_ioThreads.clear();
+			return false;
+		}
+#endif
+		m_ioThreads.emplace_back(std::move(pIOThread));
+	}
+
+	m_isIoUringUsed = false;
+#ifdef BATTLECITY_HAS_IO_URING
+	if (settings.useIoUring)
+	{
+		m_isIoUringUsed = true;
+		for (const auto& currentIOThread : m_ioThreads)
+		{
+			currentIOThread->pIoUring = std::make_unique<IoUring>();
+			m_isIoUringUsed = m_isIoUringUsed && currentIOThread->pIoUring->init();
+		}
+		if (!m_isIoUringUsed)
+		{
+			for (const auto& currentIOThread : m_ioThreads)
+			{
+				currentIOThread->pIoUring.reset();
+			}
+		}
+	}
+#endif
+	if (settings.useIoUring && !m_isIoUringUsed)
+	{
+		std::cerr << "io_uring is not available, the network uses " << getBackendName() << std::endl;
+	}
+	return true;
+}
+
+bool NetworkEngine::start()
+{
+	if (m_ioThreads.empty() || m_isRunning)
+	{
+		return false;
+	}
+	// a queue per job system thread, none of them is shared between two producers
+	const unsigned int producersCount = std::max(1u, JobSystem::getThreadsCount());
+	m_producers.clear();
+	for (const auto& currentIOThread : m_ioThreads)
+	{
+		currentIOThread->sendQueues.clear();
+	}
+	for (unsigned int currentProducer = 0; currentProducer < producersCount; ++currentProducer)
+	{
+		m_producers.emplace_back(std::make_unique<Producer>());
+		m_ioThreads[currentProducer % m_ioThreads.size()]->sendQueues.push_back(&m_producers.back()->sendQueue);
+	}
+
+	m_isRunning = true;
+	for (const auto& currentIOThread : m_ioThreads)
+	{
+		IOThread& ioThread = *currentIOThread;
+		ioThread.thread = std::thread([this, &ioThread]()
+			{
+				PROFILE_THREAD("Network");
+				if (m_isIoUringUsed)
+				{
+					runIoUring(ioThread);
+				}
+				else
+				{
+#ifdef BATTLECITY_HAS_EPOLL
+					runEpoll(ioThread);
+#else
+					runPolling(ioThread);
+#endif
+				}
+			}
+		);
+	}
+	return true;
+}
+
+void NetworkEngine::stop()
+{
+	if (!m_isRunning)
+	{
+		return;
+	}
+	m_isRunning = false;
+	for (const auto& currentIOThread : m_ioThreads)
+	{
+		currentIOThread->isSleeping = true;
+		wake(*currentIOThread);
+		currentIOThread->thread.join();
+	}
+}
+
+const char* NetworkEngine::getBackendName() const
+{
+#ifdef BATTLECITY_HAS_EPOLL
+	return m_isIoUringUsed ? "io_uring" : "epoll";
+#else
+	return "polling";
+#endif
+}
+
+uint64_t NetworkEngine::now()
+{
+	return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+bool NetworkEngine::send(const NetAddress& address, const uint8_t* pData, const size_t size)
+{
+	NetPacket* pPacket = beginSend(address, size);
+	if (!pPacket)
+	{
+		return false;
+	}
+	std::memcpy(pPacket->data, pData, size);
+	commitSend();
+	return true;
+}
+
+bool NetworkEngine::send(const NetAddress& address, const std::shared_ptr<const PacketWriter>& pPacket)
+{
+	NetPacket* pQueuedPacket = beginSend(address, pPacket->getSize());
+	if (!pQueuedPacket)
+	{
+		return false;
+	}
+	pQueuedPacket->pShared = pPacket;
+	commitSend();
+	return true;
+}
+
+NetPacket* NetworkEngine::beginSend(const NetAddress& address, const size_t size)
+{
+	const int producer = JobSystem::getCurrentWorkerIndex();
+	if (producer < 0 || static_cast<size_t>(producer) >= m_producers.size() || size > UDPSocket::MAX_PACKET_SIZE)
+	{
+		return nullptr;
+	}
+	Producer& sender = *m_producers[static_cast<size_t>(producer)];
+	SendQueue& queue = sender.sendQueue;
+	IOThread& ioThread = *m_ioThreads[static_cast<size_t>(producer) % m_ioThreads.size()];
+	if (sender.isStalled)
+	{
+		if (!queue.isEmpty())
+		{
+			recordDropped(ioThread.droppedSendsCount, 1);
+			return nullptr;
+		}
+		sender.isStalled = false;
+	}
+	NetPacket* pPacket = queue.beginPush();
+	if (!pPacket)
+	{
+		for (const uint64_t waitEndTime = now() + FULL_QUEUE_WAIT_NANOSECONDS; !pPacket && now() < waitEndTime; pPacket = queue.beginPush())
+		{
+			std::this_thread::yield();
+		}
+		if (!pPacket)
+		{
+			sender.isStalled = true;
+			recordDropped(ioThread.droppedSendsCount, 1);
+			return nullptr;
+		}
+	}
+	pPacket->address = address;
+	pPacket->size = static_cast<uint16_t>(size);
+	pPacket->timestamp = m_tickTimestamp.load(std::memory_order_relaxed);
+	return pPacket;
+}
+
+void NetworkEngine::commitSend()
+{
+	const size_t producer = static_cast<size_t>(JobSystem::getCurrentWorkerIndex());
+	IOThread& ioThread = *m_ioThreads[producer % m_ioThreads.size()];
+	m_producers[producer]->sendQueue.commitPush();
+	// pairs with the fence in prepareSleep(): either the I/O thread sees the packet or this thread sees it sleeping
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (ioThread.isSleeping.load(std::memory_order_relaxed))
+	{
+		wake(ioThread);
+	}
+}
+
+void NetworkEngine::popSent(SendQueue& queue, const size_t count)
+{
+	for (size_t currentPacket = 0; currentPacket < count; ++currentPacket)
+	{
+		queue.peek(currentPacket)->pShared.reset();
+	}
+	queue.pop(count);
+}
+
+NetworkEngine::Stats NetworkEngine::getStats() const
+{
+	Stats stats;
+	std::vector<uint64_t> histogram(LATENCY_BUCKETS_COUNT);
+	for (const auto& currentIOThread : m_ioThreads)
+	{
+		const IOThread& ioThread = *currentIOThread;
+		stats.receivedPacketsCount += ioThread.receivedPacketsCount.load(std::memory_order_relaxed);
+		stats.receivedBytes += ioThread.receivedBytes.load(std::memory_order_relaxed);
+		stats.sentPacketsCount += ioThread.sentPacketsCount.load(std::memory_order_relaxed);
+		stats.sentBytes += ioThread.sentBytes.load(std::memory_order_relaxed);
+		stats.systemCallsCount += ioThread.systemCallsCount.load(std::memory_order_relaxed);
+		stats.droppedReceivesCount += ioThread.droppedReceivesCount.load(std::memory_order_relaxed);
+		stats.droppedSendsCount += ioThread.droppedSendsCount.load(std::memory_order_relaxed);
+		stats.wakeupsCount += ioThread.wakeupsCount.load(std::memory_order_relaxed);
+		if (!m_isRunning)
+		{
+			for (size_t currentBucket = 0; currentBucket < LATENCY_BUCKETS_COUNT; ++currentBucket)
+			{
+				histogram[currentBucket] += ioThread.tickToSendHistogram[currentBucket];
+			}
+		}
+	}
+
+	uint64_t samplesCount = 0;
+	for (const uint64_t currentCount : histogram)
+	{
+		samplesCount += currentCount;
+	}
+	// the upper edge of the bucket a sample falls into
+	uint64_t countBelow = 0;
+	for (size_t currentBucket = 0; currentBucket < LATENCY_BUCKETS_COUNT && samplesCount > 0; ++currentBucket)
+	{
+		if (histogram[currentBucket] == 0)
+		{
+			continue;
+		}
+		const double bucketEnd = static_cast<double>((currentBucket + 1) * LATENCY_BUCKET_WIDTH);
+		if (countBelow < (samplesCount + 1) / 2 && countBelow + histogram[currentBucket] >= (samplesCount + 1) / 2)
+		{
+			stats.tickToSendMedian = bucketEnd;
+		}
+		const uint64_t p99Count = samplesCount - samplesCount / 100;
+		if (countBelow < p99Count && countBelow + histogram[currentBucket] >= p99Count)
+		{
+			stats.tickToSendP99 = bucketEnd;
+		}
+		stats.tickToSendMax = bucketEnd;
+		countBelow += histogram[currentBucket];
+	}
+	return stats;
+}
+
+bool NetworkEngine::prepareSleep(IOThread& ioThread)
+{
+	ioThread.isSleeping.store(true, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	for (const SendQueue* pQueue : ioThread.sendQueues)
+	{
+		if (!pQueue->isEmpty())
+		{
+			ioThread.isSleeping.store(false, std::memory_order_relaxed);
+			return false;
+		}
+	}
+	return m_isRunning.load(std::memory_order_relaxed);
+}
+
+void NetworkEngine::wake(IOThread& ioThread)
+{
+	// only the first producer to see the thread asleep pays for the system call
+	if (!ioThread.isSleeping.exchange(false))
+	{
+		return;
+	}
+#ifdef BATTLECITY_HAS_EPOLL
+	const uint64_t value = 1;
+	const ssize_t result = ::write(static_cast<int>(ioThread.wakeupHandle), &value, sizeof(value));
+	(void)result;
+#endif
+}
+
+void NetworkEngine::recordReceived(IOThread& ioThread, const uint64_t packetsCount, const uint64_t bytes)
+{
+	static Metrics::Counter& receivedPacketsCounter = Metrics::counter("battlecity_network_received_packets_total", "Packets received by the network engine");
+	static Metrics::Counter& receivedBytesCounter = Metrics::counter("battlecity_network_received_bytes_total", "Bytes received by the network engine");
+	ioThread.receivedPacketsCount.fetch_add(packetsCount, std::memory_order_relaxed);
+	ioThread.receivedBytes.fetch_add(bytes, std::memory_order_relaxed);
+	receivedPacketsCounter.add(packetsCount);
+	receivedBytesCounter.add(bytes);
+}
+
+void NetworkEngine::recordDropped(std::atomic<uint64_t>& droppedCount, const uint64_t packetsCount)
+{
+	static Metrics::Counter& droppedPacketsCounter = Metrics::counter("battlecity_network_dropped_packets_total", "Packets the network engine dropped, a queue was full or the system refused them");
+	droppedCount.fetch_add(packetsCount, std::memory_order_relaxed);
+	droppedPacketsCounter.add(packetsCount);
+}
+
+void NetworkEngine::recordSent(IOThread& ioThread, const NetPacket& packet, const uint64_t sendTime)
+{
+	static Metrics::Counter& sentPacketsCounter = Metrics::counter("battlecity_network_sent_packets_total", "Packets sent by the network engine");
+	static Metrics::Counter& sentBytesCounter = Metrics::counter("battlecity_network_sent_bytes_total", "Bytes sent by the network engine");
+	ioThread.sentPacketsCount.fetch_add(1, std::memory_order_relaxed);
+	ioThread.sentBytes.fetch_add(packet.size, std::memory_order_relaxed);
+	sentPacketsCounter.add();
+	sentBytesCounter.add(packet.size);
+	if (packet.timestamp != 0 && sendTime >= packet.timestamp)
+	{
+		const uint64_t latency = (sendTime - packet.timestamp) / 1000;
+		++ioThread.tickToSendHistogram[std::min<uint64_t>(latency / LATENCY_BUCKET_WIDTH, LATENCY_BUCKETS_COUNT - 1)];
+	}
+}
+
+void NetworkEngine::runEpoll(IOThread& ioThread)
+{
+#ifdef BATTLECITY_HAS_EPOLL
+	const int socketHandle = static_cast<int>(ioThread.socket.getNativeHandle());
+	const int wakeupHandle = static_cast<int>(ioThread.wakeupHandle);
+	const int epollHandle = epoll_create1(EPOLL_CLOEXEC);
+	epoll_event event = {};
+	event.events = EPOLLIN;
+	event.data.fd = socketHandle;
+	epoll_ctl(epollHandle, EPOLL_CTL_ADD, socketHandle, &event);
+	event.data.fd = wakeupHandle;
+	epoll_ctl(epollHandle, EPOLL_CTL_ADD, wakeupHandle, &event);
+
+	std::array<mmsghdr, BATCH_SIZE> messages;
+	std::array<iovec, BATCH_SIZE> vectors;
+	std::array<sockaddr_in, BATCH_SIZE> addresses;
+	std::array<NetPacket*, BATCH_SIZE> packets;
+	// with the receive queue full the packets are read and dropped here, the loop doesn't spin on them
+	auto pDroppedPackets = std::make_unique<std::array<NetPacket, BATCH_SIZE>>();
+	const auto prepareMessage = [&messages, &vectors, &addresses](const size_t index, void* pData, const size_t size)
+		{
+			vectors[index].iov_base = pData;
+			vectors[index].iov_len = size;
+			messages[index] = {};
+			messages[index].msg_hdr.msg_name = &addresses[index];
+			messages[index].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+			messages[index].msg_hdr.msg_iov = &vectors[index];
+			messages[index].msg_hdr.msg_iovlen = 1;
+		};
+
+	while (m_isRunning.load(std::memory_order_relaxed))
+	{
+		bool isBusy = false;
+
+		// received packets are written straight into the free slots of the queue
+		ReceiveQueue& receiveQueue = *ioThread.pReceiveQueue;
+		size_t slotsCount = 0;
+		for (; slotsCount < BATCH_SIZE; ++slotsCount)
+		{
+			packets[slotsCount] = receiveQueue.beginPush(slotsCount);
+			if (!packets[slotsCount])
+			{
+				break;
+			}
+		}
+		const bool isQueueFull = slotsCount == 0;
+		if (isQueueFull)
+		{
+			for (; slotsCount < BATCH_SIZE; ++slotsCount)
+			{
+				packets[slotsCount] = &(*pDroppedPackets)[slotsCount];
+			}
+		}
+		for (size_t currentSlot = 0; currentSlot < slotsCount; ++currentSlot)
+		{
+			prepareMessage(currentSlot, packets[currentSlot]->data, UDPSocket::MAX_PACKET_SIZE);
+		}
+		const int receivedCount = recvmmsg(socketHandle, messages.data(), static_cast<unsigned int>(slotsCount), MSG_DONTWAIT, nullptr);
+		ioThread.systemCallsCount.fetch_add(1, std::memory_order_relaxed);
+		if (receivedCount > 0)
+		{
+			isBusy = true;
+			if (isQueueFull)
+			{
+				recordDropped(ioThread.droppedReceivesCount, static_cast<uint64_t>(receivedCount));
+			}
+			else
+			{
+				const uint64_t receiveTime = now();
+				uint64_t bytes = 0;
+				for (int currentMessage = 0; currentMessage < receivedCount; ++currentMessage)
+				{
+					NetPacket& packet = *packets[currentMessage];
+					toNetAddress(addresses[currentMessage], packet.address);
+					packet.size = static_cast<uint16_t>(messages[currentMessage].msg_len);
+					packet.timestamp = receiveTime;
+					bytes += packet.size;
+				}
+				receiveQueue.commitPush(static_cast<size_t>(receivedCount));
+				recordReceived(ioThread, static_cast<uint64_t>(receivedCount), bytes);
+			}
+		}
+
+		// the send queues are sent from in place too, a batch at a time
+		for (SendQueue* pQueue : ioThread.sendQueues)
+		{
+			for (bool isBufferFull = false; !isBufferFull;)
+			{
+				size_t packetsCount = 0;
+				for (const NetPacket* pPacket = pQueue->peek(0); pPacket && packetsCount < BATCH_SIZE; pPacket = pQueue->peek(++packetsCount))
+				{
+					prepareMessage(packetsCount, const_cast<uint8_t*>(pPacket->getData()), pPacket->size);
+					toSocketAddress(pPacket->address, addresses[packetsCount]);
+				}
+				if (packetsCount == 0)
+				{
+					break;
+				}
+				const int sentCount = sendmmsg(socketHandle, messages.data(), static_cast<unsigned int>(packetsCount), MSG_DONTWAIT);
+				ioThread.systemCallsCount.fetch_add(1, std::memory_order_relaxed);
+				if (sentCount < 0)
+				{
+					isBufferFull = errno == EAGAIN || errno == EWOULDBLOCK || errno == ENOBUFS;
+					if (!isBufferFull)
+					{
+						// the first packet can't be sent at all, the rest goes with the next batch
+						popSent(*pQueue, 1);
+						recordDropped(ioThread.droppedSendsCount, 1);
+					}
+					continue;
+				}
+				const uint64_t sendTime = now();
+				for (int currentMessage = 0; currentMessage < sentCount; ++currentMessage)
+				{
+					recordSent(ioThread, *pQueue->peek(static_cast<size_t>(currentMessage)), sendTime);
+				}
+				popSent(*pQueue, static_cast<size_t>(sentCount));
+				isBusy = true;
+				isBufferFull = static_cast<size_t>(sentCount) < packetsCount;
+			}
+		}
+
+		if (!isBusy && prepareSleep(ioThread))
+		{
+			std::array<epoll_event, 2> events;
+			epoll_wait(epollHandle, events.data(), static_cast<int>(events.size()), IDLE_TIMEOUT_MILLISECONDS);
+			ioThread.isSleeping.store(false, std::memory_order_relaxed);
+			uint64_t value = 0;
+			const ssize_t result = ::read(wakeupHandle, &value, sizeof(value));
+			(void)result;
+			ioThread.systemCallsCount.fetch_add(2, std::memory_order_relaxed);
+			ioThread.wakeupsCount.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+	::close(epollHandle);
+#else
+	runPolling(ioThread);
+#endif
+}
+
+void NetworkEngine::runIoUring(IOThread& ioThread)
+{
+#ifdef BATTLECITY_HAS_IO_URING
+	IoUring& ring = *ioThread.pIoUring;
+	const int socketHandle = static_cast<int>(ioThread.socket.getNativeHandle());
+	const int wakeupHandle = static_cast<int>(ioThread.wakeupHandle);
+	// what a completion belongs to: the top bits tell the operation, the rest is the slot
+	static constexpr uint64_t RECEIVE_TAG = 1ull << 32;
+	static constexpr uint64_t SEND_TAG = 2ull << 32;
+	static constexpr uint64_t WAKEUP_TAG = 3ull << 32;
+	static constexpr uint64_t SLOT_MASK = (1ull << 32) - 1;
+
+	const auto prepareMessage = [](IoUring::Message& message, void* pData, const size_t size)
+		{
+			message.vector.iov_base = pData;
+			message.vector.iov_len = size;
+			message.header = {};
+			message.header.msg_name = &message.address;
+			message.header.msg_namelen = sizeof(sockaddr_in);
+			message.header.msg_iov = &message.vector;
+			message.header.msg_iovlen = 1;
+		};
+	const auto postReceive = [&ring, &prepareMessage, socketHandle](const size_t slot)
+		{
+			IoUring::Message& message = ring.receiveMessages[slot];
+			prepareMessage(message, ring.receivePackets[slot].data, UDPSocket::MAX_PACKET_SIZE);
+			io_uring_sqe* pSqe = ring.getSqe();
+			pSqe->opcode = IORING_OP_RECVMSG;
+			pSqe->fd = socketHandle;
+			pSqe->addr = reinterpret_cast<uint64_t>(&message.header);
+			pSqe->len = 1;
+			pSqe->user_data = RECEIVE_TAG | slot;
+		};
+	const auto postWakeupRead = [&ring, wakeupHandle]()
+		{
+			io_uring_sqe* pSqe = ring.getSqe();
+			pSqe->opcode = IORING_OP_READ;
+			pSqe->fd = wakeupHandle;
+			pSqe->addr = reinterpret_cast<uint64_t>(&ring.wakeupValue);
+			pSqe->len = sizeof(ring.wakeupValue);
+			pSqe->user_data = WAKEUP_TAG;
+		};
+	for (size_t currentSlot = 0; currentSlot < BATCH_SIZE; ++currentSlot)
+	{
+		postReceive(currentSlot);
+	}
+	postWakeupRead();
+
+	// packets of the batch in flight taken from each send queue, popped once the whole batch completed
+	std::vector<size_t> queuedSendsCounts(ioThread.sendQueues.size());
+	size_t sendsInFlightCount = 0;
+	while (m_isRunning.load(std::memory_order_relaxed))
+	{
+		if (sendsInFlightCount == 0)
+		{
+			for (size_t currentQueue = 0; currentQueue < ioThread.sendQueues.size(); ++currentQueue)
+			{
+				const SendQueue& queue = *ioThread.sendQueues[currentQueue];
+				size_t packetsCount = 0;
+				for (const NetPacket* pPacket = queue.peek(0); pPacket && sendsInFlightCount < BATCH_SIZE; pPacket = queue.peek(++packetsCount))
+				{
+					IoUring::Message& message = ring.sendMessages[sendsInFlightCount];
+					prepareMessage(message, const_cast<uint8_t*>(pPacket->getData()), pPacket->size);
+					toSocketAddress(pPacket->address, message.address);
+					io_uring_sqe* pSqe = ring.getSqe();
+					pSqe->opcode = IORING_OP_SENDMSG;
+					pSqe->fd = socketHandle;
+					pSqe->addr = reinterpret_cast<uint64_t>(&message.header);
+					pSqe->len = 1;
+					pSqe->user_data = SEND_TAG | sendsInFlightCount;
+					ring.sendPackets[sendsInFlightCount++] = pPacket;
+				}
+				queuedSendsCounts[currentQueue] = packetsCount;
+			}
+		}
+
+		bool isSleeping = false;
+		if (sendsInFlightCount == 0)
+		{
+			if (!prepareSleep(ioThread))
+			{
+				continue;
+			}
+			isSleeping = true;
+		}
+		if (!ring.submit(1))
+		{
+			std::cerr << "io_uring_enter failed, the network stops" << std::endl;
+			break;
+		}
+		ioThread.systemCallsCount.fetch_add(1, std::memory_order_relaxed);
+		if (isSleeping)
+		{
+			ioThread.isSleeping.store(false, std::memory_order_relaxed);
+			ioThread.wakeupsCount.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		const uint64_t completionTime = now();
+		ring.forEachCompletion([&](const io_uring_cqe& completion)
+			{
+				const size_t slot = static_cast<size_t>(completion.user_data & SLOT_MASK);
+				switch (completion.user_data & ~SLOT_MASK)
+				{
+				case RECEIVE_TAG:
+					if (completion.res > 0)
+					{
+						NetPacket* pPacket = ioThread.pReceiveQueue->beginPush();
+						if (pPacket)
+						{
+							toNetAddress(ring.receiveMessages[slot].address, pPacket->address);
+							pPacket->size = static_cast<uint16_t>(completion.res);
+							pPacket->timestamp = completionTime;
+							std::memcpy(pPacket->data, ring.receivePackets[slot].data, pPacket->size);
+							ioThread.pReceiveQueue->commitPush();
+							recordReceived(ioThread, 1, pPacket->size);
+						}
+						else
+						{
+							recordDropped(ioThread.droppedReceivesCount, 1);
+						}
+					}
+					postReceive(slot);
+					break;
+				case SEND_TAG:
+					if (completion.res >= 0)
+					{
+						recordSent(ioThread, *ring.sendPackets[slot], completionTime);
+					}
+					else
+					{
+						recordDropped(ioThread.droppedSendsCount, 1);
+					}
+					if (--sendsInFlightCount == 0)
+					{
+						for (size_t currentQueue = 0; currentQueue < ioThread.sendQueues.size(); ++currentQueue)
+						{
+							popSent(*ioThread.sendQueues[currentQueue], queuedSendsCounts[currentQueue]);
+							queuedSendsCounts[currentQueue] = 0;
+						}
+					}
+					break;
+				case WAKEUP_TAG:
+					postWakeupRead();
+					break;
+				default:
+					break;
+				}
+			}
+		);
+	}
+#else
+	runEpoll(ioThread);
+#endif
+}
+
+void NetworkEngine::runPolling(IOThread& ioThread)
+{
+	while (m_isRunning.load(std::memory_order_relaxed))
+	{
+		bool isBusy = false;
+		for (NetPacket* pPacket = ioThread.pReceiveQueue->beginPush(); pPacket; pPacket = ioThread.pReceiveQueue->beginPush())
+		{
+			const size_t size = ioThread.socket.receive(pPacket->address, pPacket->data, UDPSocket::MAX_PACKET_SIZE);
+			if (size == 0)
+			{
+				break;
+			}
+			pPacket->size = static_cast<uint16_t>(size);
+			pPacket->timestamp = now();
+			ioThread.pReceiveQueue->commitPush();
+			recordReceived(ioThread, 1, size);
+			isBusy = true;
+		}
+		for (SendQueue* pQueue : ioThread.sendQueues)
+		{
+			for (const NetPacket* pPacket = pQueue->front(); pPacket; pPacket = pQueue->front())
+			{
+				if (ioThread.socket.send(pPacket->address, pPacket->getData(), pPacket->size))
+				{
+					recordSent(ioThread, *pPacket, now());
+				}
+				else
+				{
+					recordDropped(ioThread.droppedSendsCount, 1);
+				}
+				popSent(*pQueue, 1);
+				isBusy = true;
+			}
+		}
+		// without a wakeup handle a producer can't interrupt the wait, it stays short
+		if (!isBusy)
+		{
+			ioThread.socket.wait(1.0);
+			ioThread.wakeupsCount.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+}
@@ -0,0 +1,182 @@
+#pragma once
+
+#include "Packet.h"
+#include "UDPSocket.h"
+#include "../System/SPSCQueue.h"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+// A datagram with its sender or receiver, preallocated in the queues between the threads
+struct NetPacket
+{
+	NetAddress address;
+	uint16_t size;
+	// NetworkEngine::now() of the receive, the tick timestamp of a packet to send
+	uint64_t timestamp;
+	uint8_t data[UDPSocket::MAX_PACKET_SIZE];
+	// a packet sent to many receivers is referenced instead of copied into data, released once sent
+	std::shared_ptr<const PacketWriter> pShared;
+
+	const uint8_t* getData() const { return pShared ? pShared->getData() : data; }
+};
+
+struct NetworkEngineSettings
+{
+	uint16_t port = 0;
+	std::string bindAddress = "127.0.0.1";
+	// an event loop thread per core given to the network
+	unsigned int ioThreadsCount = 1;
+	// io_uring instead of epoll where the system has it
+	bool useIoUring = false;
+};
+
+// Event-driven UDP for the server. Every I/O thread owns a socket bound to the shared port and runs one
+// event loop: epoll with recvmmsg and sendmmsg batches, or io_uring with receives kept in flight. Received
+// packets go into a lock-free queue per I/O thread that the simulation thread drains; the job system
+// threads queue the packets to send into a lock-free queue of their own, each served by one I/O thread.
+// Every queue is a preallocated ring the packets are written into in place, nothing allocates per packet.
+// An idle I/O thread sleeps in the kernel and is woken through an eventfd, only when it actually sleeps.
+// Without epoll (not Linux) the I/O threads fall back to polling the socket.
+class NetworkEngine
+{
+public:
+	static constexpr size_t RECEIVE_QUEUE_CAPACITY = 4096;
+	static constexpr size_t SEND_QUEUE_CAPACITY = 1024;
+	// packets per recvmmsg and sendmmsg call
+	static constexpr size_t BATCH_SIZE = 64;
+	// the tick to send latency histogram: buckets of LATENCY_BUCKET_WIDTH microseconds, the last one takes the rest
+	static constexpr size_t LATENCY_BUCKETS_COUNT = 4096;
+	static constexpr uint64_t LATENCY_BUCKET_WIDTH = 5;
+
+	struct Stats
+	{
+		uint64_t receivedPacketsCount = 0;
+		uint64_t receivedBytes = 0;
+		uint64_t sentPacketsCount = 0;
+		uint64_t sentBytes = 0;
+		// every system call of the I/O threads, waiting included
+		uint64_t systemCallsCount = 0;
+		// a queue was full or the system refused the packet
+		uint64_t droppedReceivesCount = 0;
+		uint64_t droppedSendsCount = 0;
+		uint64_t wakeupsCount = 0;
+		// microseconds from the start of the tick to the send call, complete after stop()
+		double tickToSendMedian = 0.0;
+		double tickToSendP99 = 0.0;
+		double tickToSendMax = 0.0;
+	};
+
+	NetworkEngine();
+	~NetworkEngine();
+
+	NetworkEngine(const NetworkEngine&) = delete;
+	NetworkEngine& operator = (const NetworkEngine&) = delete;
+
+	// binds a socket per I/O thread to the port
+	bool open(const NetworkEngineSettings& settings);
+	// Starts the I/O threads. The job system must be running: every one of its threads may send.
+	bool start();
+	void stop();
+	uint16_t getPort() const { return m_port; }
+	const char* getBackendName() const;
+
+	// nanoseconds of a monotonic clock
+	static uint64_t now();
+
+	// Calls function(const NetPacket&) for every packet received so far, on the one thread that drains.
+	template<class TFunction>
+	size_t receive(const TFunction& function)
+	{
+		size_t packetsCount = 0;
+		for (const auto& currentIOThread : m_ioThreads)
+		{
+			auto& queue = *currentIOThread->pReceiveQueue;
+			for (const NetPacket* pPacket = queue.front(); pPacket; pPacket = queue.front())
+			{
+				function(*pPacket);
+				queue.pop();
+				++packetsCount;
+			}
+		}
+		return packetsCount;
+	}
+
+	// Queues a packet to send, from a job system thread. False when the queue of the thread is full.
+	bool send(const NetAddress& address, const uint8_t* pData, const size_t size);
+	// Queues a packet encoded once for many receivers: every receiver takes a reference to it, not a copy.
+	bool send(const NetAddress& address, const std::shared_ptr<const PacketWriter>& pPacket);
+	// packets queued from now on belong to the tick that started at the timestamp
+	void setTickTimestamp(const uint64_t timestamp) { m_tickTimestamp.store(timestamp, std::memory_order_relaxed); }
+
+	Stats getStats() const;
+
+private:
+	using ReceiveQueue = SPSCQueue<NetPacket, RECEIVE_QUEUE_CAPACITY>;
+	using SendQueue = SPSCQueue<NetPacket, SEND_QUEUE_CAPACITY>;
+	class IoUring;
+
+	// a job system thread's end of the sends, only that thread touches it
+	struct Producer
+	{
+		SendQueue sendQueue;
+		// a send timed out on the full queue: the next ones fail at once until the I/O thread empties it
+		bool isStalled = false;
+	};
+
+	struct IOThread
+	{
+		UDPSocket socket;
+		intptr_t wakeupHandle = -1;
+		std::thread thread;
+		std::atomic<bool> isSleeping{ false };
+		std::unique_ptr<ReceiveQueue> pReceiveQueue;
+		// the send queues of the job system threads this I/O thread serves
+		std::vector<SendQueue*> sendQueues;
+		std::unique_ptr<IoUring> pIoUring;
+
+		std::atomic<uint64_t> receivedPacketsCount{ 0 };
+		std::atomic<uint64_t> receivedBytes{ 0 };
+		std::atomic<uint64_t> sentPacketsCount{ 0 };
+		std::atomic<uint64_t> sentBytes{ 0 };
+		std::atomic<uint64_t> systemCallsCount{ 0 };
+		std::atomic<uint64_t> droppedReceivesCount{ 0 };
+		std::atomic<uint64_t> droppedSendsCount{ 0 };
+		std::atomic<uint64_t> wakeupsCount{ 0 };
+		std::vector<uint32_t> tickToSendHistogram = std::vector<uint32_t>(LATENCY_BUCKETS_COUNT);
+
+		IOThread();
+		~IOThread();
+	};
+
+	// the free slot of the calling thread's send queue, nullptr when the packet can't be queued
+	NetPacket* beginSend(const NetAddress& address, const size_t size);
+	void commitSend();
+	// releases the shared packets of the first count packets and pops them
+	static void popSent(SendQueue& queue, const size_t count);
+
+	void runEpoll(IOThread& ioThread);
+	void runIoUring(IOThread& ioThread);
+	void runPolling(IOThread& ioThread);
+	// true when the I/O thread may sleep: it is marked sleeping and nothing is queued to send
+	bool prepareSleep(IOThread& ioThread);
+	static void wake(IOThread& ioThread);
+	// count into the I/O thread's stats and the metrics registry
+	static void recordReceived(IOThread& ioThread, const uint64_t packetsCount, const uint64_t bytes);
+	static void recordDropped(std::atomic<uint64_t>& droppedCount, const uint64_t packetsCount);
+	static void recordSent(IOThread& ioThread, const NetPacket& packet, const uint64_t sendTime);
+
+	NetworkEngineSettings m_settings;
+	uint16_t m_port;
+	bool m_isIoUringUsed;
+	std::atomic<bool> m_isRunning;
+	std::atomic<uint64_t> m_tickTimestamp;
+	// one per job system thread, they outlive the I/O threads' sends in flight
+	std::vector<std::unique_ptr<Producer>> m_producers;
+	std::vector<std::unique_ptr<IOThread>> m_ioThreads;
+};
@@ -0,0 +1,140 @@
+#pragma once
+
+#include "UDPSocket.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+// Builds a packet in a fixed buffer of UDPSocket::MAX_PACKET_SIZE bytes. Integers are little-endian,
+// writing past the end sets the overflow flag and drops the value instead of allocating.
+class PacketWriter
+{
+public:
+	void clear() { m_size = 0; m_hasOverflowed = false; }
+	const uint8_t* getData() const { return m_data.data(); }
+	size_t getSize() const { return m_size; }
+	bool hasOverflowed() const { return m_hasOverflowed; }
+	// drops everything written after the first size bytes, e.g. a record that didn't fit
+	void rewind(const size_t size) { m_size = size < m_size ? size : m_size; m_hasOverflowed = false; }
+
+	template<class TInteger>
+	void write(const TInteger value)
+	{
+		static_assert(std::is_integral<TInteger>::value, "packets carry integers");
+		if (m_size + sizeof(TInteger) > m_data.size())
+		{
+			m_hasOverflowed = true;
+			return;
+		}
+		using TUnsigned = typename std::make_unsigned<TInteger>::type;
+		const TUnsigned bits = static_cast<TUnsigned>(value);
+		for (size_t currentByte = 0; currentByte < sizeof(TInteger); ++currentByte)
+		{
+			m_data[m_size++] = static_cast<uint8_t>(bits >> (8 * currentByte));
+		}
+	}
+
+	// 7 bits per byte, small numbers take one byte
+	void writeVarint(uint32_t value)
+	{
+		while (value >= 0x80)
+		{
+			write(static_cast<uint8_t>(value | 0x80));
+			value >>= 7;
+		}
+		write(static_cast<uint8_t>(value));
+	}
+
+	// zigzag: small numbers of either sign take one byte
+	void writeSignedVarint(const int32_t value)
+	{
+		writeVarint((static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31));
+	}
+
+	void writeBytes(const uint8_t* pData, const size_t size)
+	{
+		if (m_size + size > m_data.size())
+		{
+			m_hasOverflowed = true;
+			return;
+		}
+		std::memcpy(m_data.data() + m_size, pData, size);
+		m_size += size;
+	}
+
+private:
+	std::array<uint8_t, UDPSocket::MAX_PACKET_SIZE> m_data;
+	size_t m_size = 0;
+	bool m_hasOverflowed = false;
+};
+
+// Reads a received packet back. Reading past the end fails the reader and returns zeroes.
+class PacketReader
+{
+public:
+	PacketReader(const uint8_t* pData, const size_t size) : m_pData(pData), m_size(size), m_offset(0), m_hasFailed(false) {}
+
+	template<class TInteger>
+	TInteger read()
+	{
+		static_assert(std::is_integral<TInteger>::value, "packets carry integers");
+		if (m_hasFailed || m_size - m_offset < sizeof(TInteger))
+		{
+			m_hasFailed = true;
+			return 0;
+		}
+		using TUnsigned = typename std::make_unsigned<TInteger>::type;
+		TUnsigned bits = 0;
+		for (size_t currentByte = 0; currentByte < sizeof(TInteger); ++currentByte)
+		{
+			bits |= static_cast<TUnsigned>(static_cast<TUnsigned>(m_pData[m_offset++]) << (8 * currentByte));
+		}
+		return static_cast<TInteger>(bits);
+	}
+
+	uint32_t readVarint()
+	{
+		uint32_t value = 0;
+		for (uint32_t shift = 0; shift < 35; shift += 7)
+		{
+			const uint8_t currentByte = read<uint8_t>();
+			value |= static_cast<uint32_t>(currentByte & 0x7f) << shift;
+			if ((currentByte & 0x80) == 0)
+			{
+				return value;
+			}
+		}
+		m_hasFailed = true;
+		return 0;
+	}
+
+	int32_t readSignedVarint()
+	{
+		const uint32_t value = readVarint();
+		return static_cast<int32_t>((value >> 1) ^ (0u - (value & 1)));
+	}
+
+	// the bytes stay in the packet buffer, nullptr if the packet is too short
+	const uint8_t* readBytes(const size_t size)
+	{
+		if (m_hasFailed || m_size - m_offset < size)
+		{
+			m_hasFailed = true;
+			return nullptr;
+		}
+		const uint8_t* pBytes = m_pData + m_offset;
+		m_offset += size;
+		return pBytes;
+	}
+
+	bool hasFailed() const { return m_hasFailed; }
+	bool isAtEnd() const { return m_offset == m_size; }
+
+private:
+	const uint8_t* m_pData;
+	size_t m_size;
+	size_t m_offset;
+	bool m_hasFailed;
+};
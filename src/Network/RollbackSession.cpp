@@ -0,0 +1,286 @@
+#include "RollbackSession.h"
+#include "LinkConditioner.h"
+#include "Packet.h"
+#include "../Game/Game.h"
+#include "../Game/WorldHash.h"
+#include "../Physics/PhysicsEngine.h"
+#include "../System/Profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+// "BCRB"
+static constexpr uint32_t PACKET_MAGIC = 0x42524342;
+static constexpr uint8_t INPUTS_PACKET = 1;
+static constexpr uint32_t NO_TICK = UINT32_MAX;
+// a peer that runs ahead of the other waits at most one tick per interval, so the game doesn't visibly stutter
+static constexpr uint32_t TIME_SYNC_INTERVAL = 16;
+
+RollbackSession::RollbackSession(Game& game, const size_t localPlayer, LinkConditioner& link, const NetAddress& remoteAddress, const RollbackSettings& settings)
+	: m_game(game)
+	, m_localPlayer(localPlayer)
+	, m_link(link)
+	, m_remoteAddress(remoteAddress)
+	, m_settings(settings)
+	, m_localInputsEnd(0)
+	, m_stalledInput(0)
+	, m_remoteConfirmedTick(0)
+	, m_remoteAckedTick(0)
+	, m_rollbackTick(NO_TICK)
+	, m_remoteTick(0)
+	, m_remoteAdvantage(0)
+	, m_remoteChecksumTick(NO_TICK)
+	, m_remoteChecksum(0)
+	, m_lastComparedTick(NO_TICK)
+	, m_lastTimeSyncTick(NO_TICK)
+{
+	m_settings.inputDelay = std::min(m_settings.inputDelay, MAX_INPUT_DELAY);
+	m_settings.rollbackWindow = std::clamp<uint32_t>(m_settings.rollbackWindow, 1, MAX_ROLLBACK_WINDOW);
+	m_localInputs.fill(0);
+	m_remoteInputs.fill(0);
+	m_remoteInputTicks.fill(NO_TICK);
+	m_usedRemoteInputs.fill(0);
+	m_checksums.fill(0);
+	m_states.resize(m_settings.rollbackWindow + 1);
+	// nothing was sampled for the first ticks of the delay, they have no input
+	m_localInputsEnd = m_settings.inputDelay;
+}
+
+bool RollbackSession::advanceTick(const uint8_t localInput)
+{
+	PROFILE_ZONE("RollbackSession::advanceTick");
+	receive();
+	rollback();
+	compareChecksums();
+
+	const uint32_t tick = m_game.getTicksCount();
+	if (tick >= m_remoteConfirmedTick + m_settings.rollbackWindow)
+	{
+		// predicting further would need a rollback longer than the window
+		++m_stats.stalledTicksCount;
+		m_stalledInput |= localInput;
+		sendInputs();
+		m_link.flush();
+		return false;
+	}
+	// both peers see each other a latency late, half the difference of what they see is the real lead
+	const int32_t localAdvantage = static_cast<int32_t>(tick) - static_cast<int32_t>(m_remoteTick);
+	if (tick % TIME_SYNC_INTERVAL == 0 && tick != m_lastTimeSyncTick && (localAdvantage - m_remoteAdvantage) / 2 >= 1)
+	{
+		m_lastTimeSyncTick = tick;
+		++m_stats.timeSyncWaitsCount;
+		++m_stats.stalledTicksCount;
+		m_stalledInput |= localInput;
+		sendInputs();
+		m_link.flush();
+		return false;
+	}
+
+	// the fire tapped while waiting is kept, the direction only when none is held now
+	static constexpr uint8_t DIRECTIONS = Game::INPUT_UP | Game::INPUT_DOWN | Game::INPUT_LEFT | Game::INPUT_RIGHT;
+	uint8_t input = localInput | (m_stalledInput & Game::INPUT_FIRE);
+	if ((input & DIRECTIONS) == 0)
+	{
+		input |= m_stalledInput & DIRECTIONS;
+	}
+	m_stalledInput = 0;
+	m_localInputs[(tick + m_settings.inputDelay) % INPUT_HISTORY] = input;
+	m_localInputsEnd = tick + m_settings.inputDelay + 1;
+	simulateTick(tick);
+	sendInputs();
+	m_link.flush();
+	return true;
+}
+
+void RollbackSession::idle()
+{
+	receive();
+	rollback();
+	compareChecksums();
+	sendInputs();
+	m_link.flush();
+}
+
+void RollbackSession::receive()
+{
+	std::array<uint8_t, UDPSocket::MAX_PACKET_SIZE> buffer;
+	NetAddress address;
+	for (size_t size = m_link.getSocket().receive(address, buffer.data(), buffer.size()); size > 0;
+		 size = m_link.getSocket().receive(address, buffer.data(), buffer.size()))
+	{
+		if (address == m_remoteAddress)
+		{
+			PacketReader reader(buffer.data(), size);
+			handlePacket(reader);
+		}
+	}
+}
+
+void RollbackSession::handlePacket(PacketReader& reader)
+{
+	const uint32_t magic = reader.read<uint32_t>();
+	const uint8_t type = reader.read<uint8_t>();
+	const uint32_t remoteTick = reader.read<uint32_t>();
+	const int32_t remoteAdvantage = reader.read<int32_t>();
+	const uint32_t ackedTick = reader.read<uint32_t>();
+	const uint32_t firstInputTick = reader.read<uint32_t>();
+	const uint8_t inputsCount = reader.read<uint8_t>();
+	const uint8_t* pInputs = reader.readBytes(inputsCount);
+	const uint32_t checksumTick = reader.read<uint32_t>();
+	const uint32_t checksum = reader.read<uint32_t>();
+	if (reader.hasFailed() || magic != PACKET_MAGIC || type != INPUTS_PACKET)
+	{
+		return;
+	}
+
+	// packets may come out of order, only the newest one tells where the remote is
+	if (remoteTick >= m_remoteTick)
+	{
+		m_remoteTick = remoteTick;
+		m_remoteAdvantage = remoteAdvantage;
+	}
+	m_remoteAckedTick = std::max(m_remoteAckedTick, ackedTick);
+
+	const uint32_t currentTick = m_game.getTicksCount();
+	for (uint32_t currentInput = 0; currentInput < inputsCount; ++currentInput)
+	{
+		const uint32_t inputTick = firstInputTick + currentInput;
+		const size_t slot = inputTick % INPUT_HISTORY;
+		if (inputTick < m_remoteConfirmedTick || inputTick >= m_remoteConfirmedTick + INPUT_HISTORY / 2 || m_remoteInputTicks[slot] == inputTick)
+		{
+			continue;
+		}
+		m_remoteInputs[slot] = pInputs[currentInput];
+		m_remoteInputTicks[slot] = inputTick;
+		if (inputTick < currentTick && pInputs[currentInput] != m_usedRemoteInputs[slot])
+		{
+			m_rollbackTick = std::min(m_rollbackTick, inputTick);
+		}
+	}
+	while (m_remoteInputTicks[m_remoteConfirmedTick % INPUT_HISTORY] == m_remoteConfirmedTick)
+	{
+		++m_remoteConfirmedTick;
+	}
+
+	if (checksumTick != NO_TICK && (m_remoteChecksumTick == NO_TICK || checksumTick > m_remoteChecksumTick))
+	{
+		m_remoteChecksumTick = checksumTick;
+		m_remoteChecksum = checksum;
+	}
+}
+
+void RollbackSession::rollback()
+{
+	const uint32_t currentTick = m_game.getTicksCount();
+	if (m_rollbackTick >= currentTick)
+	{
+		m_rollbackTick = NO_TICK;
+		return;
+	}
+	PROFILE_ZONE("RollbackSession::rollback");
+	const auto startTime = std::chrono::steady_clock::now();
+	const uint32_t rollbackTicks = currentTick - m_rollbackTick;
+	// the window keeps the remote confirmed at most rollbackWindow ticks back, the state is still there
+	if (rollbackTicks > m_settings.rollbackWindow || !m_game.restoreState(m_states[m_rollbackTick % m_states.size()]))
+	{
+		std::cerr << "Can't roll back " << rollbackTicks << " ticks to tick " << m_rollbackTick << std::endl;
+		++m_stats.desyncsCount;
+		m_rollbackTick = NO_TICK;
+		return;
+	}
+	for (uint32_t currentResimulatedTick = m_rollbackTick; currentResimulatedTick < currentTick; ++currentResimulatedTick)
+	{
+		simulateTick(currentResimulatedTick);
+	}
+	m_rollbackTick = NO_TICK;
+
+	const double rollbackTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+	++m_stats.rollbacksCount;
+	m_stats.resimulatedTicksCount += rollbackTicks;
+	m_stats.maxRollbackTicks = std::max(m_stats.maxRollbackTicks, rollbackTicks);
+	m_stats.maxRollbackTime = std::max(m_stats.maxRollbackTime, rollbackTime);
+	m_stats.totalRollbackTime += rollbackTime;
+}
+
+void RollbackSession::simulateTick(const uint32_t tick)
+{
+	const size_t slot = tick % INPUT_HISTORY;
+	m_game.saveState(m_states[tick % m_states.size()]);
+	m_checksums[slot] = WorldHash::getChecksum();
+
+	const uint8_t remoteInput = getRemoteInput(tick);
+	m_usedRemoteInputs[slot] = remoteInput;
+	m_game.setPlayerInput(m_localPlayer, m_localInputs[slot]);
+	m_game.setPlayerInput(1 - m_localPlayer, remoteInput);
+	m_game.update(Game::TICK_DURATION);
+	Physics::PhysicsEngine::update(Game::TICK_DURATION);
+}
+
+uint8_t RollbackSession::getRemoteInput(const uint32_t tick) const
+{
+	if (m_remoteInputTicks[tick % INPUT_HISTORY] == tick)
+	{
+		return m_remoteInputs[tick % INPUT_HISTORY];
+	}
+	// the remote most likely still holds what it held last
+	return m_remoteConfirmedTick > 0 ? m_remoteInputs[(m_remoteConfirmedTick - 1) % INPUT_HISTORY] : 0;
+}
+
+uint32_t RollbackSession::getFinalTick() const
+{
+	const uint32_t currentTick = m_game.getTicksCount();
+	if (currentTick == 0)
+	{
+		return NO_TICK;
+	}
+	// the hash at the start of a tick depends on the inputs of the ticks before it only
+	return std::min({ m_remoteConfirmedTick, currentTick - 1, m_rollbackTick });
+}
+
+void RollbackSession::sendInputs()
+{
+	PacketWriter writer;
+	const uint32_t currentTick = m_game.getTicksCount();
+	writer.write(PACKET_MAGIC);
+	writer.write(INPUTS_PACKET);
+	writer.write(currentTick);
+	writer.write(static_cast<int32_t>(currentTick) - static_cast<int32_t>(m_remoteTick));
+	writer.write(m_remoteConfirmedTick);
+
+	// everything the remote hasn't acknowledged, as far as the history goes back
+	const uint32_t oldestKeptTick = m_localInputsEnd > INPUT_HISTORY - 1 ? m_localInputsEnd - (INPUT_HISTORY - 1) : 0;
+	const uint32_t firstInputTick = std::max(m_remoteAckedTick, oldestKeptTick);
+	const uint32_t inputsCount = std::min<uint32_t>(m_localInputsEnd > firstInputTick ? m_localInputsEnd - firstInputTick : 0, UINT8_MAX);
+	writer.write(firstInputTick);
+	writer.write(static_cast<uint8_t>(inputsCount));
+	for (uint32_t currentInput = 0; currentInput < inputsCount; ++currentInput)
+	{
+		writer.write(m_localInputs[(firstInputTick + currentInput) % INPUT_HISTORY]);
+	}
+
+	const uint32_t finalTick = getFinalTick();
+	writer.write(finalTick);
+	writer.write(finalTick != NO_TICK ? m_checksums[finalTick % INPUT_HISTORY] : 0u);
+	m_link.send(m_remoteAddress, writer.getData(), writer.getSize());
+}
+
+void RollbackSession::compareChecksums()
+{
+	const uint32_t finalTick = getFinalTick();
+	const uint32_t currentTick = m_game.getTicksCount();
+	if (m_remoteChecksumTick == NO_TICK || m_remoteChecksumTick == m_lastComparedTick || finalTick == NO_TICK ||
+		m_remoteChecksumTick > finalTick || m_remoteChecksumTick + INPUT_HISTORY <= currentTick)
+	{
+		return;
+	}
+	m_lastComparedTick = m_remoteChecksumTick;
+	++m_stats.checksumsComparedCount;
+	if (m_checksums[m_remoteChecksumTick % INPUT_HISTORY] != m_remoteChecksum)
+	{
+		if (m_stats.desyncsCount++ == 0)
+		{
+			std::cerr << "DESYNC: the peers' worlds differ at tick " << m_remoteChecksumTick << std::endl;
+		}
+	}
+}
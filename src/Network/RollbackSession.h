@@ -0,0 +1,109 @@
+#pragma once
+
+#include "../Game/WorldState.h"
+#include "UDPSocket.h"
+#include <array>
+#include <cstdint>
+#include <vector>
+
+class Game;
+class LinkConditioner;
+class PacketReader;
+
+struct RollbackSettings
+{
+	// ticks between sampling the local input and simulating it, hides that much latency without rollbacks
+	uint32_t inputDelay = 2;
+	// how many ticks the remote input may be predicted, the session waits for the remote beyond that
+	uint32_t rollbackWindow = 8;
+};
+
+// Two-player peer-to-peer play with rollback. The local input is simulated after the input delay, the
+// remote input is predicted to stay what it was last. When the real remote input arrives and differs
+// from the prediction, the world is restored to the mispredicted tick and the ticks since are simulated
+// again. Both peers run the same deterministic simulation, so the world hashes they exchange for fully
+// confirmed ticks must match; a mismatch is counted as a desync. Every packet repeats all the local
+// inputs the remote hasn't acknowledged yet, a lost packet costs nothing but a later correction.
+class RollbackSession
+{
+public:
+	static constexpr uint32_t MAX_ROLLBACK_WINDOW = 32;
+	static constexpr uint32_t MAX_INPUT_DELAY = 16;
+
+	struct Stats
+	{
+		uint64_t rollbacksCount = 0;
+		uint64_t resimulatedTicksCount = 0;
+		uint32_t maxRollbackTicks = 0;
+		// milliseconds of restore and resimulation
+		double maxRollbackTime = 0.0;
+		double totalRollbackTime = 0.0;
+		// ticks that waited for the remote: the rollback window was full or the peer was ahead
+		uint64_t stalledTicksCount = 0;
+		uint64_t timeSyncWaitsCount = 0;
+		uint64_t checksumsComparedCount = 0;
+		uint64_t desyncsCount = 0;
+	};
+
+	// the game is initialized for two players, both peers start from tick 0 of the same level
+	RollbackSession(Game& game, const size_t localPlayer, LinkConditioner& link, const NetAddress& remoteAddress, const RollbackSettings& settings);
+
+	// One tick of the frame loop: receives the remote input, corrects mispredicted ticks and simulates the
+	// next tick with the local input. Returns false when the tick has to wait for the remote, the input then
+	// carries over to the next simulated tick so a key tapped meanwhile isn't lost.
+	bool advanceTick(const uint8_t localInput);
+	// receives, corrects and resends without simulating, e.g. after the last tick until the remote confirmed it
+	void idle();
+
+	// the remote input is known for every tick before it
+	uint32_t getConfirmedTick() const { return m_remoteConfirmedTick; }
+	// the remote has received the local input of every tick before it
+	uint32_t getRemoteAckedTick() const { return m_remoteAckedTick; }
+	const Stats& getStats() const { return m_stats; }
+
+private:
+	// holds the inputs the remote may still miss: up to two rollback windows and two input delays
+	static constexpr uint32_t INPUT_HISTORY = 128;
+
+	void receive();
+	void handlePacket(PacketReader& reader);
+	void rollback();
+	void simulateTick(const uint32_t tick);
+	void sendInputs();
+	void compareChecksums();
+	uint8_t getRemoteInput(const uint32_t tick) const;
+	// the world hash at the start of every tick up to it won't change any more
+	uint32_t getFinalTick() const;
+
+	Game& m_game;
+	size_t m_localPlayer;
+	LinkConditioner& m_link;
+	NetAddress m_remoteAddress;
+	RollbackSettings m_settings;
+
+	// ring buffers indexed by tick % INPUT_HISTORY
+	std::array<uint8_t, INPUT_HISTORY> m_localInputs;
+	std::array<uint8_t, INPUT_HISTORY> m_remoteInputs;
+	std::array<uint32_t, INPUT_HISTORY> m_remoteInputTicks;
+	std::array<uint8_t, INPUT_HISTORY> m_usedRemoteInputs;
+	std::array<uint32_t, INPUT_HISTORY> m_checksums;
+	// the state at the start of each of the last rollbackWindow + 1 ticks
+	std::vector<WorldState> m_states;
+
+	uint32_t m_localInputsEnd;
+	// the local inputs of the ticks that waited for the remote since the last simulated one
+	uint8_t m_stalledInput;
+	uint32_t m_remoteConfirmedTick;
+	uint32_t m_remoteAckedTick;
+	// the earliest tick simulated with a wrong prediction, UINT32_MAX if none
+	uint32_t m_rollbackTick;
+
+	uint32_t m_remoteTick;
+	int32_t m_remoteAdvantage;
+	uint32_t m_remoteChecksumTick;
+	uint32_t m_remoteChecksum;
+	uint32_t m_lastComparedTick;
+	uint32_t m_lastTimeSyncTick;
+
+	Stats m_stats;
+};
@@ -0,0 +1,211 @@
+#include "UDPSocket.h"
+#include <cstdlib>
+#include <iostream>
+#include <type_traits>
+
+#ifdef _WIN32
+	#define WIN32_LEAN_AND_MEAN
+	#define NOMINMAX
+	#include <winsock2.h>
+	#include <ws2tcpip.h>
+	#pragma comment(lib, "ws2_32.lib")
+	using SocketHandle = SOCKET;
+#else
+	#include <arpa/inet.h>
+	#include <netinet/in.h>
+	#include <poll.h>
+	#include <sys/socket.h>
+	#include <fcntl.h>
+	#include <unistd.h>
+	using SocketHandle = int;
+#endif
+
+static bool parseIP(const std::string& host, uint32_t& ip)
+{
+	in_addr address;
+	if (inet_pton(AF_INET, host == "localhost" ? "127.0.0.1" : host.c_str(), &address) != 1)
+	{
+		return false;
+	}
+	ip = ntohl(address.s_addr);
+	return true;
+}
+
+static sockaddr_in makeSocketAddress(const NetAddress& address)
+{
+	sockaddr_in socketAddress = {};
+	socketAddress.sin_family = AF_INET;
+	socketAddress.sin_addr.s_addr = htonl(address.ip);
+	socketAddress.sin_port = htons(address.port);
+	return socketAddress;
+}
+
+bool NetAddress::parse(const std::string& hostAndPort, NetAddress& address)
+{
+	const size_t colon = hostAndPort.rfind(':');
+	if (colon == std::string::npos)
+	{
+		return false;
+	}
+	const int port = std::atoi(hostAndPort.c_str() + colon + 1);
+	if (port <= 0 || port > 65535 || !parseIP(hostAndPort.substr(0, colon), address.ip))
+	{
+		return false;
+	}
+	address.port = static_cast<uint16_t>(port);
+	return true;
+}
+
+std::string NetAddress::toString() const
+{
+	return std::to_string(ip >> 24) + "." + std::to_string((ip >> 16) & 0xff) + "." + std::to_string((ip >> 8) & 0xff) + "." +
+		   std::to_string(ip & 0xff) + ":" + std::to_string(port);
+}
+
+UDPSocket::~UDPSocket()
+{
+	close();
+}
+
+bool UDPSocket::open(const uint16_t port, const std::string& bindAddress, const bool isPortShared)
+{
+	close();
+#ifdef _WIN32
+	static const bool isInitialized = []()
+	{
+		WSADATA data;
+		return WSAStartup(MAKEWORD(2, 2), &data) == 0;
+	}();
+	if (!isInitialized)
+	{
+		std::cerr << "Can't initialize Winsock" << std::endl;
+		return false;
+	}
+#endif
+	NetAddress address;
+	if (!parseIP(bindAddress, address.ip))
+	{
+		std::cerr << "Bad bind address: " << bindAddress << std::endl;
+		return false;
+	}
+	address.port = port;
+
+	const SocketHandle socketHandle = ::socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+#ifdef _WIN32
+	if (socketHandle == INVALID_SOCKET)
+#else
+	if (socketHandle < 0)
+#endif
+	{
+		std::cerr << "Can't create a UDP socket" << std::endl;
+		return false;
+	}
+	m_socket = static_cast<intptr_t>(socketHandle);
+#ifdef SO_REUSEPORT
+	if (isPortShared)
+	{
+		const int isReused = 1;
+		setsockopt(socketHandle, SOL_SOCKET, SO_REUSEPORT, reinterpret_cast<const char*>(&isReused), sizeof(isReused));
+	}
+#endif
+
+	const sockaddr_in socketAddress = makeSocketAddress(address);
+	if (::bind(socketHandle, reinterpret_cast<const sockaddr*>(&socketAddress), sizeof(socketAddress)) != 0)
+	{
+		std::cerr << "Can't bind a UDP socket to " << address.toString() << std::endl;
+		close();
+		return false;
+	}
+#ifdef _WIN32
+	u_long isNonBlocking = 1;
+	ioctlsocket(socketHandle, FIONBIO, &isNonBlocking);
+#else
+	fcntl(socketHandle, F_SETFL, fcntl(socketHandle, F_GETFL, 0) | O_NONBLOCK);
+#endif
+
+	sockaddr_in boundAddress = {};
+	socklen_t boundAddressSize = sizeof(boundAddress);
+	getsockname(socketHandle, reinterpret_cast<sockaddr*>(&boundAddress), &boundAddressSize);
+	m_port = ntohs(boundAddress.sin_port);
+	return true;
+}
+
+void UDPSocket::close()
+{
+	if (!isOpen())
+	{
+		return;
+	}
+#ifdef _WIN32
+	closesocket(static_cast<SocketHandle>(m_socket));
+#else
+	::close(static_cast<SocketHandle>(m_socket));
+#endif
+	m_socket = INVALID_SOCKET_HANDLE;
+	m_port = 0;
+}
+
+bool UDPSocket::setBufferSize(const int bytes)
+{
+	if (!isOpen())
+	{
+		return false;
+	}
+	const SocketHandle socketHandle = static_cast<SocketHandle>(m_socket);
+	return setsockopt(socketHandle, SOL_SOCKET, SO_RCVBUF, reinterpret_cast<const char*>(&bytes), sizeof(bytes)) == 0 &&
+		   setsockopt(socketHandle, SOL_SOCKET, SO_SNDBUF, reinterpret_cast<const char*>(&bytes), sizeof(bytes)) == 0;
+}
+
+bool UDPSocket::send(const NetAddress& address, const uint8_t* pData, const size_t size)
+{
+	if (!isOpen() || size > MAX_PACKET_SIZE)
+	{
+		return false;
+	}
+	const sockaddr_in socketAddress = makeSocketAddress(address);
+	const auto sentSize = ::sendto(static_cast<SocketHandle>(m_socket), reinterpret_cast<const char*>(pData), static_cast<int>(size), 0,
+								   reinterpret_cast<const sockaddr*>(&socketAddress), sizeof(socketAddress));
+	if (sentSize != static_cast<std::remove_const_t<decltype(sentSize)>>(size))
+	{
+		return false;
+	}
+	m_sentPacketsCount.fetch_add(1, std::memory_order_relaxed);
+	m_sentBytesCount.fetch_add(size, std::memory_order_relaxed);
+	return true;
+}
+
+size_t UDPSocket::receive(NetAddress& address, uint8_t* pBuffer, const size_t bufferSize)
+{
+	if (!isOpen())
+	{
+		return 0;
+	}
+	sockaddr_in socketAddress = {};
+	socklen_t socketAddressSize = sizeof(socketAddress);
+	const auto receivedSize = ::recvfrom(static_cast<SocketHandle>(m_socket), reinterpret_cast<char*>(pBuffer), static_cast<int>(bufferSize), 0,
+										 reinterpret_cast<sockaddr*>(&socketAddress), &socketAddressSize);
+	if (receivedSize <= 0)
+	{
+		return 0;
+	}
+	address.ip = ntohl(socketAddress.sin_addr.s_addr);
+	address.port = ntohs(socketAddress.sin_port);
+	m_receivedPacketsCount.fetch_add(1, std::memory_order_relaxed);
+	m_receivedBytesCount.fetch_add(static_cast<uint64_t>(receivedSize), std::memory_order_relaxed);
+	return static_cast<size_t>(receivedSize);
+}
+
+bool UDPSocket::wait(const double timeoutMilliseconds)
+{
+	if (!isOpen())
+	{
+		return false;
+	}
+#ifdef _WIN32
+	WSAPOLLFD pollDescriptor = { static_cast<SocketHandle>(m_socket), POLLRDNORM, 0 };
+	return WSAPoll(&pollDescriptor, 1, static_cast<int>(timeoutMilliseconds)) > 0;
+#else
+	pollfd pollDescriptor = { static_cast<SocketHandle>(m_socket), POLLIN, 0 };
+	return ::poll(&pollDescriptor, 1, static_cast<int>(timeoutMilliseconds)) > 0;
+#endif
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// IPv4 address and port in host byte order
+struct NetAddress
+{
+	uint32_t ip = 0;
+	uint16_t port = 0;
+
+	// "host:port", the host is a dotted address or "localhost"
+	static bool parse(const std::string& hostAndPort, NetAddress& address);
+	std::string toString() const;
+	bool operator == (const NetAddress& address) const { return ip == address.ip && port == address.port; }
+	bool operator != (const NetAddress& address) const { return !(*this == address); }
+};
+
+// Non-blocking UDP socket. Nothing waits except wait(), a full send buffer drops the packet like the network would.
+// Several threads may send through one socket at once.
+class UDPSocket
+{
+public:
+	// larger packets are never sent, they would be fragmented on the way
+	static constexpr size_t MAX_PACKET_SIZE = 1200;
+
+	UDPSocket() = default;
+	~UDPSocket();
+
+	UDPSocket(const UDPSocket&) = delete;
+	UDPSocket& operator = (const UDPSocket&) = delete;
+
+	// port 0 binds any free port; with isPortShared several sockets bind the same port and the
+	// system spreads the senders over them (SO_REUSEPORT where it exists)
+	bool open(const uint16_t port, const std::string& bindAddress = "127.0.0.1", const bool isPortShared = false);
+	void close();
+	bool isOpen() const { return m_socket != INVALID_SOCKET_HANDLE; }
+	// the kernel receive and send buffers, a server with many clients needs more than the default
+	bool setBufferSize(const int bytes);
+	uint16_t getPort() const { return m_port; }
+	// the system's socket handle for batched and asynchronous I/O
+	intptr_t getNativeHandle() const { return m_socket; }
+
+	bool send(const NetAddress& address, const uint8_t* pData, const size_t size);
+	// the size of the received packet, 0 if none is waiting
+	size_t receive(NetAddress& address, uint8_t* pBuffer, const size_t bufferSize);
+	// true when a packet arrived within the timeout
+	bool wait(const double timeoutMilliseconds);
+
+	uint64_t getSentPacketsCount() const { return m_sentPacketsCount.load(std::memory_order_relaxed); }
+	uint64_t getSentBytesCount() const { return m_sentBytesCount.load(std::memory_order_relaxed); }
+	uint64_t getReceivedPacketsCount() const { return m_receivedPacketsCount.load(std::memory_order_relaxed); }
+	uint64_t getReceivedBytesCount() const { return m_receivedBytesCount.load(std::memory_order_relaxed); }
+
+private:
+	static constexpr intptr_t INVALID_SOCKET_HANDLE = -1;
+
+	intptr_t m_socket = INVALID_SOCKET_HANDLE;
+	uint16_t m_port = 0;
+	std::atomic<uint64_t> m_sentPacketsCount{ 0 };
+	std::atomic<uint64_t> m_sentBytesCount{ 0 };
+	std::atomic<uint64_t> m_receivedPacketsCount{ 0 };
+	std::atomic<uint64_t> m_receivedBytesCount{ 0 };
+};
@@ -1,11 +1,13 @@
 #include "PhysicsEngine.h"
 #include "../Game/GameObjects/IGameObject.h"
 #include "../Game/Level.h"
+#include "../System/Metrics.h"
+#include "../System/Profiler.h"
 
 namespace Physics {
 
-	std::unordered_set<std::shared_ptr<IGameObject>> PhysicsEngine::m_dynamicObjects;
-	std::shared_ptr<Level> PhysicsEngine::m_pCurrentLevel;
+	PhysicsEngine::World PhysicsEngine::m_processWorld;
+	thread_local PhysicsEngine::World* PhysicsEngine::m_pCurrentWorld = &PhysicsEngine::m_processWorld;
 
 	void PhysicsEngine::init()
 	{
@@ -14,21 +16,28 @@ namespace Physics {
 
 	void PhysicsEngine::terminate()
 	{
-		m_dynamicObjects.clear();
-		m_pCurrentLevel.reset();
+		m_pCurrentWorld->dynamicObjects.clear();
+		m_pCurrentWorld->pCurrentLevel.reset();
 	}
 
 	void PhysicsEngine::setCurrentLevel(std::shared_ptr<Level> pLevel)
 	{
-		m_pCurrentLevel.swap(pLevel);
+		m_pCurrentWorld->pCurrentLevel.swap(pLevel);
 	}
 
 	void PhysicsEngine::update(const double delta)
 	{
-		for (auto& currentObject : m_dynamicObjects)
+		PROFILE_ZONE("PhysicsEngine::update");
+		static Metrics::Counter& movesCounter = Metrics::counter("battlecity_physics_moves_total", "Moves of dynamic objects checked for collisions");
+		static Metrics::Counter& collisionsCounter = Metrics::counter("battlecity_physics_collisions_total", "Moves stopped by a collision");
+		uint64_t movesCount = 0;
+		uint64_t collisionsCount = 0;
+		World& world = *m_pCurrentWorld;
+		for (auto& currentObject : world.dynamicObjects)
 		{
 			if (currentObject->getCurrentVelocity() > 0)
 			{
+				const glm::vec2 oldPosition = currentObject->getCurrentPosition();
 				if (currentObject->getCurrentDirection().x != 0.f)
 				{
 					currentObject->getCurrentPosition() = glm::vec2(currentObject->getCurrentPosition().x, static_cast<unsigned int>(currentObject->getCurrentPosition().y / 4.f + 0.5f)*4.f);
@@ -37,9 +46,10 @@ namespace Physics {
 				{
 					currentObject->getCurrentPosition() = glm::vec2(static_cast<unsigned int>(currentObject->getCurrentPosition().x / 4.f + 0.5f) * 4.f, currentObject->getCurrentPosition().y);
 				}
+				++movesCount;
 				const auto newPosition =  currentObject->getCurrentPosition() + currentObject->getCurrentDirection() * static_cast<float>(currentObject->getCurrentVelocity() * delta);
 				const auto& colliders = currentObject->getColliders();
-				std::vector<std::shared_ptr<IGameObject>> objectToCheck = m_pCurrentLevel->getObjectsInArea(newPosition, newPosition + currentObject->getSize());
+				std::vector<std::shared_ptr<IGameObject>> objectToCheck = world.pCurrentLevel->getObjectsInArea(newPosition, newPosition + currentObject->getSize());
 
 				bool hasCollision = false;
 
@@ -72,14 +82,18 @@ namespace Physics {
 						currentObject->getCurrentPosition() = glm::vec2(currentObject->getCurrentPosition().x, static_cast<unsigned int>(currentObject->getCurrentPosition().y / 8.f + 0.5f) * 8.f);
 					}
 					currentObject->onCollision();
+					++collisionsCount;
 				}
+				currentObject->changeStateField(IGameObject::POSITION_FIELD, oldPosition, currentObject->getCurrentPosition());
 			}
 		}
+		movesCounter.add(movesCount);
+		collisionsCounter.add(collisionsCount);
 	}
 
 	void PhysicsEngine::addDynamicGameObject(std::shared_ptr<IGameObject> pGameObject)
 	{
-		m_dynamicObjects.insert(std::move(pGameObject));
+		m_pCurrentWorld->dynamicObjects.push_back(std::move(pGameObject));
 	}
 
 	bool PhysicsEngine::hasIntersection(const std::vector<AABB>& colliders1, const glm::vec2& position1,
@@ -1,5 +1,4 @@
 #pragma once
-#include <unordered_set>
 #include <memory>
 #include <vector>
 
@@ -10,7 +9,7 @@ class Level;
 
 namespace Physics {
 	struct AABB {
-		AABB(const glm::vec2& _bottomLeft, glm::vec2& _topRight)
+		AABB(const glm::vec2& _bottomLeft, const glm::vec2& _topRight)
 			: bottomLeft(_bottomLeft)
 			, topRight(_topRight)
 		{}
@@ -21,6 +20,15 @@ namespace Physics {
 	class PhysicsEngine
 	{
 	public:
+		// The dynamic objects and the level of one simulated world. The engine works on the world made
+		// current on the calling thread, by default all threads share one world of the process.
+		struct World
+		{
+			// in the order of addition: the update order must not depend on heap addresses to be deterministic
+			std::vector<std::shared_ptr<IGameObject>> dynamicObjects;
+			std::shared_ptr<Level> pCurrentLevel;
+		};
+
 		~PhysicsEngine() = delete;
 		PhysicsEngine() = delete;
 		PhysicsEngine(const PhysicsEngine&) = delete;
@@ -33,13 +41,15 @@ namespace Physics {
 		static void update(const double delta);
 		static void addDynamicGameObject(std::shared_ptr<IGameObject> pGameObject);
 		static void setCurrentLevel(std::shared_ptr<Level> pLevel);
-
-	private:
-		static std::unordered_set<std::shared_ptr<IGameObject>> m_dynamicObjects;
-		static std::shared_ptr<Level> m_pCurrentLevel;
-
+		// nullptr makes the process world current again
+		static void setCurrentWorld(World* pWorld) { m_pCurrentWorld = pWorld ? pWorld : &m_processWorld; }
+		static World* getCurrentWorld() { return m_pCurrentWorld; }
 		static bool hasIntersection(const std::vector<AABB>& colliders1, const glm::vec2& position1,
 									const std::vector<AABB>& colliders2, const glm::vec2& position2);
+
+	private:
+		static World m_processWorld;
+		static thread_local World* m_pCurrentWorld;
 	};
 }
 
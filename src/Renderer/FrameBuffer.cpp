@@ -0,0 +1,116 @@
+#include "FrameBuffer.h"
+#include <iostream>
+
+namespace RenderEngine
+{
+	FrameBuffer::FrameBuffer()
+		: m_id(0)
+		, m_colorTexture(0)
+		, m_depthRenderBuffer(0)
+		, m_width(0)
+		, m_height(0)
+	{
+	}
+
+	FrameBuffer::~FrameBuffer()
+	{
+		release();
+	}
+
+	FrameBuffer& FrameBuffer::operator=(FrameBuffer&& frameBuffer) noexcept
+	{
+		release();
+		m_id = frameBuffer.m_id;
+		m_colorTexture = frameBuffer.m_colorTexture;
+		m_depthRenderBuffer = frameBuffer.m_depthRenderBuffer;
+		m_width = frameBuffer.m_width;
+		m_height = frameBuffer.m_height;
+		frameBuffer.m_id = 0;
+		frameBuffer.m_colorTexture = 0;
+		frameBuffer.m_depthRenderBuffer = 0;
+		return *this;
+	}
+
+	FrameBuffer::FrameBuffer(FrameBuffer&& frameBuffer) noexcept
+		: m_id(frameBuffer.m_id)
+		, m_colorTexture(frameBuffer.m_colorTexture)
+		, m_depthRenderBuffer(frameBuffer.m_depthRenderBuffer)
+		, m_width(frameBuffer.m_width)
+		, m_height(frameBuffer.m_height)
+	{
+		frameBuffer.m_id = 0;
+		frameBuffer.m_colorTexture = 0;
+		frameBuffer.m_depthRenderBuffer = 0;
+	}
+
+	bool FrameBuffer::resize(const unsigned int width, const unsigned int height)
+	{
+		if (width == m_width && height == m_height && m_id != 0)
+		{
+			return true;
+		}
+		release();
+		if (width == 0 || height == 0)
+		{
+			return false;
+		}
+		m_width = width;
+		m_height = height;
+
+		glGenTextures(1, &m_colorTexture);
+		glBindTexture(GL_TEXTURE_2D, m_colorTexture);
+		glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, width, height);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glBindTexture(GL_TEXTURE_2D, 0);
+
+		glGenRenderbuffers(1, &m_depthRenderBuffer);
+		glBindRenderbuffer(GL_RENDERBUFFER, m_depthRenderBuffer);
+		glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+		glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+		glGenFramebuffers(1, &m_id);
+		glBindFramebuffer(GL_FRAMEBUFFER, m_id);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_colorTexture, 0);
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, m_depthRenderBuffer);
+		const GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		if (status != GL_FRAMEBUFFER_COMPLETE)
+		{
+			std::cerr << "ERROR::FRAMEBUFFER: Framebuffer is incomplete: 0x" << std::hex << status << std::dec << std::endl;
+			release();
+			return false;
+		}
+		return true;
+	}
+
+	void FrameBuffer::bind() const
+	{
+		glBindFramebuffer(GL_FRAMEBUFFER, m_id);
+	}
+
+	void FrameBuffer::unbind() const
+	{
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	}
+
+	void FrameBuffer::blitToScreen() const
+	{
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, m_id);
+		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+		glBlitFramebuffer(0, 0, m_width, m_height, 0, 0, m_width, m_height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	}
+
+	void FrameBuffer::release()
+	{
+		glDeleteFramebuffers(1, &m_id);
+		glDeleteRenderbuffers(1, &m_depthRenderBuffer);
+		glDeleteTextures(1, &m_colorTexture);
+		m_id = 0;
+		m_colorTexture = 0;
+		m_depthRenderBuffer = 0;
+		m_width = 0;
+		m_height = 0;
+	}
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <glad/glad.h>
+
+namespace RenderEngine
+{
+	// Offscreen color + depth target the frame is rendered into. It keeps the last frame,
+	// so it can be presented again without re-rendering the scene.
+	class FrameBuffer
+	{
+	public:
+		FrameBuffer();
+		~FrameBuffer();
+
+		FrameBuffer(const FrameBuffer&) = delete;
+		FrameBuffer& operator = (const FrameBuffer&) = delete;
+		FrameBuffer& operator=(FrameBuffer&& frameBuffer) noexcept;
+		FrameBuffer(FrameBuffer&& frameBuffer) noexcept;
+
+		bool resize(const unsigned int width, const unsigned int height);
+		void bind() const;
+		void unbind() const;
+		// copies the color attachment to the window framebuffer
+		void blitToScreen() const;
+
+		unsigned int getWidth() const { return m_width; }
+		unsigned int getHeight() const { return m_height; }
+
+	private:
+		void release();
+
+		GLuint m_id;
+		GLuint m_colorTexture;
+		GLuint m_depthRenderBuffer;
+		unsigned int m_width;
+		unsigned int m_height;
+	};
+}
@@ -0,0 +1,151 @@
+#include "GPUProfiler.h"
+
+namespace RenderEngine
+{
+	std::array<GPUProfiler::FrameQueries, GPUProfiler::FRAMES_IN_FLIGHT> GPUProfiler::m_frames;
+	std::vector<size_t> GPUProfiler::m_openZones;
+	std::vector<GPUProfiler::PassTime> GPUProfiler::m_lastPassTimes;
+	Profiler::Track* GPUProfiler::m_pTrack = nullptr;
+	uint64_t GPUProfiler::m_frameIndex = 0;
+	uint64_t GPUProfiler::m_droppedFramesCount = 0;
+	bool GPUProfiler::m_isInitialized = false;
+
+	void GPUProfiler::init()
+	{
+		if (m_isInitialized)
+		{
+			return;
+		}
+		for (FrameQueries& currentFrame : m_frames)
+		{
+			glGenQueries(static_cast<GLsizei>(currentFrame.queries.size()), currentFrame.queries.data());
+			currentFrame.zones.reserve(MAX_ZONES_PER_FRAME);
+			currentFrame.zones.clear();
+			currentFrame.usedQueries = 0;
+		}
+		m_openZones.reserve(MAX_ZONES_PER_FRAME);
+		m_lastPassTimes.reserve(MAX_ZONES_PER_FRAME);
+		if (!m_pTrack)
+		{
+			m_pTrack = Profiler::createTrack("GPU");
+		}
+		m_isInitialized = true;
+	}
+
+	void GPUProfiler::terminate()
+	{
+		if (!m_isInitialized)
+		{
+			return;
+		}
+		for (FrameQueries& currentFrame : m_frames)
+		{
+			glDeleteQueries(static_cast<GLsizei>(currentFrame.queries.size()), currentFrame.queries.data());
+			currentFrame.zones.clear();
+			currentFrame.usedQueries = 0;
+		}
+		m_openZones.clear();
+		m_isInitialized = false;
+	}
+
+	void GPUProfiler::beginFrame()
+	{
+		if (!m_isInitialized)
+		{
+			return;
+		}
+		FrameQueries& frame = m_frames[m_frameIndex % FRAMES_IN_FLIGHT];
+		readBack(frame);
+
+		frame.zones.clear();
+		frame.usedQueries = 0;
+		m_openZones.clear();
+		// GL time of the commands issued so far, paired with the CPU clock to place zones on the trace timeline
+		glGetInteger64v(GL_TIMESTAMP, &frame.gpuCalibrationTime);
+		frame.cpuCalibrationTicks = Profiler::now();
+	}
+
+	void GPUProfiler::endFrame()
+	{
+		if (!m_isInitialized)
+		{
+			return;
+		}
+		while (!m_openZones.empty())
+		{
+			endZone();
+		}
+		++m_frameIndex;
+	}
+
+	void GPUProfiler::beginZone(const char* name)
+	{
+		if (!m_isInitialized)
+		{
+			return;
+		}
+		FrameQueries& frame = m_frames[m_frameIndex % FRAMES_IN_FLIGHT];
+		if (frame.usedQueries + 2 > frame.queries.size())
+		{
+			m_openZones.push_back(SIZE_MAX);
+			return;
+		}
+		frame.zones.push_back({ name, frame.usedQueries, frame.usedQueries + 1 });
+		frame.usedQueries += 2;
+		frame.lastIssuedQuery = frame.zones.back().beginQuery;
+		glQueryCounter(frame.queries[frame.lastIssuedQuery], GL_TIMESTAMP);
+		m_openZones.push_back(frame.zones.size() - 1);
+	}
+
+	void GPUProfiler::endZone()
+	{
+		if (!m_isInitialized || m_openZones.empty())
+		{
+			return;
+		}
+		const size_t zone = m_openZones.back();
+		m_openZones.pop_back();
+		if (zone == SIZE_MAX)
+		{
+			return;
+		}
+		FrameQueries& frame = m_frames[m_frameIndex % FRAMES_IN_FLIGHT];
+		frame.lastIssuedQuery = frame.zones[zone].endQuery;
+		glQueryCounter(frame.queries[frame.lastIssuedQuery], GL_TIMESTAMP);
+	}
+
+	void GPUProfiler::readBack(FrameQueries& frame)
+	{
+		if (frame.zones.empty())
+		{
+			return;
+		}
+
+		// queries complete in order, the last one issued tells whether the whole frame is ready
+		GLint isAvailable = GL_FALSE;
+		glGetQueryObjectiv(frame.queries[frame.lastIssuedQuery], GL_QUERY_RESULT_AVAILABLE, &isAvailable);
+		if (isAvailable != GL_TRUE)
+		{
+			++m_droppedFramesCount;
+			return;
+		}
+
+		m_lastPassTimes.clear();
+		for (const ZoneQueries& currentZone : frame.zones)
+		{
+			GLuint64 beginTime = 0;
+			GLuint64 endTime = 0;
+			glGetQueryObjectui64v(frame.queries[currentZone.beginQuery], GL_QUERY_RESULT, &beginTime);
+			glGetQueryObjectui64v(frame.queries[currentZone.endQuery], GL_QUERY_RESULT, &endTime);
+			if (endTime < beginTime)
+			{
+				continue;
+			}
+			m_lastPassTimes.push_back({ currentZone.name, static_cast<double>(endTime - beginTime) / 1e6 });
+
+			const double beginOffset = static_cast<double>(static_cast<GLint64>(beginTime) - frame.gpuCalibrationTime);
+			const uint64_t beginTicks = frame.cpuCalibrationTicks + Profiler::nanosecondsToTicks(beginOffset > 0 ? beginOffset : 0);
+			Profiler::recordZone(*m_pTrack, currentZone.name, beginTicks, beginTicks + Profiler::nanosecondsToTicks(static_cast<double>(endTime - beginTime)));
+		}
+	}
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "../System/Profiler.h"
+
+namespace RenderEngine
+{
+	// GL_TIMESTAMP queries around named render passes. Every frame uses its own set of query objects
+	// and reads it back FRAMES_IN_FLIGHT frames later, so the CPU never waits for the GPU; results that
+	// are still not available are dropped. Finished zones go to the "GPU" track of the CPU profiler.
+	class GPUProfiler
+	{
+	public:
+		static constexpr size_t FRAMES_IN_FLIGHT = 4;
+		static constexpr size_t MAX_ZONES_PER_FRAME = 32;
+
+		struct PassTime
+		{
+			const char* name;
+			double milliseconds;
+		};
+
+		class Zone
+		{
+		public:
+			Zone(const char* name) { beginZone(name); }
+			~Zone() { endZone(); }
+
+			Zone(const Zone&) = delete;
+			Zone& operator = (const Zone&) = delete;
+		};
+
+		static void init();
+		static void terminate();
+
+		static void beginFrame();
+		static void endFrame();
+		// name must outlive the profiler, string literals are expected
+		static void beginZone(const char* name);
+		static void endZone();
+
+		// results of the newest frame read back, FRAMES_IN_FLIGHT frames old
+		static const std::vector<PassTime>& getLastPassTimes() { return m_lastPassTimes; }
+		static uint64_t getDroppedFramesCount() { return m_droppedFramesCount; }
+
+	private:
+		struct ZoneQueries
+		{
+			const char* name;
+			size_t beginQuery;
+			size_t endQuery;
+		};
+
+		struct FrameQueries
+		{
+			std::array<GLuint, MAX_ZONES_PER_FRAME * 2> queries;
+			std::vector<ZoneQueries> zones;
+			size_t usedQueries = 0;
+			size_t lastIssuedQuery = 0;
+			GLint64 gpuCalibrationTime = 0;
+			uint64_t cpuCalibrationTicks = 0;
+		};
+
+		static void readBack(FrameQueries& frame);
+
+		static std::array<FrameQueries, FRAMES_IN_FLIGHT> m_frames;
+		static std::vector<size_t> m_openZones;
+		static std::vector<PassTime> m_lastPassTimes;
+		static Profiler::Track* m_pTrack;
+		static uint64_t m_frameIndex;
+		static uint64_t m_droppedFramesCount;
+		static bool m_isInitialized;
+	};
+}
+
+#if BATTLECITY_PROFILER
+#define PROFILE_GPU_ZONE(name) RenderEngine::GPUProfiler::Zone PROFILE_CONCAT(profileGPUZone, __LINE__)(name)
+#else
+#define PROFILE_GPU_ZONE(name) ((void)0)
+#endif
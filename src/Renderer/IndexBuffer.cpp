@@ -1,4 +1,5 @@
 #include "IndexBuffer.h"
+#include "RenderStats.h"
 
 namespace RenderEngine
 {
@@ -36,6 +37,7 @@ namespace RenderEngine
 		glGenBuffers(1, &m_id);
 		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_id);
 		glBufferData(GL_ELEMENT_ARRAY_BUFFER, count * sizeof(GLuint), data, GL_STATIC_DRAW);
+		RenderStats::addUploadBytes(count * sizeof(GLuint));
 	}
 
 	void IndexBuffer::bind() const
@@ -0,0 +1,33 @@
+#include "RenderSnapshot.h"
+#include "Sprite.h"
+#include "GPUProfiler.h"
+#include "../System/Profiler.h"
+
+namespace RenderEngine
+{
+	void RenderSnapshot::render() const
+	{
+		PROFILE_ZONE("RenderSnapshot::render");
+		const size_t firstPassItem = m_passes.empty() ? m_items.size() : m_passes.front().firstItem;
+		renderItems(0, firstPassItem);
+		for (size_t currentPass = 0; currentPass < m_passes.size(); ++currentPass)
+		{
+			const size_t endItem = currentPass + 1 < m_passes.size() ? m_passes[currentPass + 1].firstItem : m_items.size();
+			PROFILE_ZONE(m_passes[currentPass].name);
+			PROFILE_GPU_ZONE(m_passes[currentPass].name);
+			renderItems(m_passes[currentPass].firstItem, endItem);
+		}
+	}
+
+	void RenderSnapshot::renderItems(const size_t begin, const size_t end) const
+	{
+		for (size_t currentItem = begin; currentItem < end; ++currentItem)
+		{
+			const RenderItem& item = m_items[currentItem];
+			if (item.pSprite)
+			{
+				item.pSprite->render(item.position, item.size, item.rotation, item.layer, item.frameID);
+			}
+		}
+	}
+}
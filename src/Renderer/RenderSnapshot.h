@@ -0,0 +1,60 @@
+#pragma once
+
+#include <glm/vec2.hpp>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace RenderEngine
+{
+	class Sprite;
+
+	// Immutable description of one frame: which sprite frames to draw where. Filled by the simulation
+	// and drawn on the GL thread, so game objects never touch GL while they are simulated.
+	class RenderSnapshot
+	{
+	public:
+		struct RenderItem
+		{
+			const Sprite* pSprite;
+			glm::vec2 position;
+			glm::vec2 size;
+			float rotation;
+			float layer;
+			size_t frameID;
+		};
+
+		struct RenderPass
+		{
+			// string literal, also the profiler zone name
+			const char* name;
+			size_t firstItem;
+		};
+
+		void clear() { m_items.clear(); m_passes.clear(); m_inputTimestamp = 0; }
+		// items submitted from now on belong to the named pass, passes are timed separately
+		void beginPass(const char* name) { m_passes.push_back({ name, m_items.size() }); }
+		void submit(const Sprite* pSprite,
+					const glm::vec2& position,
+					const glm::vec2& size,
+					const float rotation,
+					const float layer = 0.f,
+					const size_t frameID = 0)
+		{
+			m_items.push_back({ pSprite, position, size, rotation, layer, frameID });
+		}
+		void render() const;
+		const std::vector<RenderItem>& getItems() const { return m_items; }
+
+		// timestamp of the oldest input event applied in the tick this snapshot was built from, 0 - none
+		void setInputTimestamp(const uint64_t inputTimestamp) { m_inputTimestamp = inputTimestamp; }
+		uint64_t getInputTimestamp() const { return m_inputTimestamp; }
+
+	private:
+		void renderItems(const size_t begin, const size_t end) const;
+
+		std::vector<RenderItem> m_items;
+		std::vector<RenderPass> m_passes;
+		uint64_t m_inputTimestamp = 0;
+	};
+}
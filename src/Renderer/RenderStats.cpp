@@ -0,0 +1,77 @@
+#include "RenderStats.h"
+#include "../System/Metrics.h"
+#include <algorithm>
+
+namespace RenderEngine
+{
+	FrameStats RenderStats::m_currentFrame;
+	FrameStats RenderStats::m_lastFrame;
+	RenderStats::Clock::time_point RenderStats::m_frameBeginTime;
+	RenderStats::Clock::time_point RenderStats::m_lastFrameBeginTime;
+	std::atomic<double> RenderStats::m_updateTime(0);
+	std::atomic<double> RenderStats::m_physicsTime(0);
+	std::array<float, RenderStats::HISTORY_SIZE> RenderStats::m_frameTimes{};
+	size_t RenderStats::m_framesCount = 0;
+
+	void RenderStats::beginFrame()
+	{
+		m_currentFrame = FrameStats();
+		m_frameBeginTime = Clock::now();
+		if (m_lastFrameBeginTime != Clock::time_point())
+		{
+			m_currentFrame.frameTime = std::chrono::duration<double, std::milli>(m_frameBeginTime - m_lastFrameBeginTime).count();
+			m_frameTimes[m_framesCount % HISTORY_SIZE] = static_cast<float>(m_currentFrame.frameTime);
+			++m_framesCount;
+		}
+		m_lastFrameBeginTime = m_frameBeginTime;
+	}
+
+	void RenderStats::endFrame()
+	{
+		m_currentFrame.renderTime = std::chrono::duration<double, std::milli>(Clock::now() - m_frameBeginTime).count();
+		m_currentFrame.updateTime = m_updateTime.load(std::memory_order_relaxed);
+		m_currentFrame.physicsTime = m_physicsTime.load(std::memory_order_relaxed);
+		m_lastFrame = m_currentFrame;
+
+		static Metrics::Histogram& frameTimeHistogram = Metrics::histogram("battlecity_frame_seconds", "Time between the starts of two frames", Metrics::TICK_TIME_BOUNDS);
+		static Metrics::Histogram& renderTimeHistogram = Metrics::histogram("battlecity_render_seconds", "CPU time of recording a frame", Metrics::TICK_TIME_BOUNDS);
+		static Metrics::Counter& drawCallsCounter = Metrics::counter("battlecity_render_draw_calls_total", "Draw calls issued");
+		static Metrics::Counter& uploadBytesCounter = Metrics::counter("battlecity_render_upload_bytes_total", "Bytes uploaded to the GPU");
+		if (m_currentFrame.frameTime > 0.0)
+		{
+			frameTimeHistogram.observe(m_currentFrame.frameTime / 1000.0);
+		}
+		renderTimeHistogram.observe(m_currentFrame.renderTime / 1000.0);
+		drawCallsCounter.add(m_currentFrame.drawCalls);
+		uploadBytesCounter.add(m_currentFrame.uploadBytes);
+	}
+
+	void RenderStats::setSimulationTimes(const double updateTime, const double physicsTime)
+	{
+		m_updateTime.store(updateTime, std::memory_order_relaxed);
+		m_physicsTime.store(physicsTime, std::memory_order_relaxed);
+	}
+
+	double RenderStats::getFrameTimePercentile(const double percentile)
+	{
+		const size_t count = std::min(m_framesCount, HISTORY_SIZE);
+		if (count == 0)
+		{
+			return 0;
+		}
+		std::array<float, HISTORY_SIZE> frameTimes = m_frameTimes;
+		const size_t index = std::min(count - 1, static_cast<size_t>(percentile * count));
+		std::nth_element(frameTimes.begin(), frameTimes.begin() + index, frameTimes.begin() + count);
+		return frameTimes[index];
+	}
+
+	void RenderStats::getFrameTimeHistory(std::array<float, HISTORY_SIZE>& frameTimes)
+	{
+		frameTimes.fill(0.f);
+		const size_t count = std::min(m_framesCount, HISTORY_SIZE);
+		for (size_t currentFrame = 0; currentFrame < count; ++currentFrame)
+		{
+			frameTimes[HISTORY_SIZE - count + currentFrame] = m_frameTimes[(m_framesCount - count + currentFrame) % HISTORY_SIZE];
+		}
+	}
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace RenderEngine
+{
+	struct FrameStats
+	{
+		uint32_t drawCalls = 0;
+		// the indices the draw calls read, six per sprite quad
+		uint64_t indices = 0;
+		uint32_t shaderBinds = 0;
+		uint32_t textureBinds = 0;
+		uint32_t vertexArrayBinds = 0;
+		uint64_t uploadBytes = 0;
+		// CPU times in milliseconds
+		double updateTime = 0;
+		double physicsTime = 0;
+		double renderTime = 0;
+		double frameTime = 0;
+	};
+
+	// Per-frame counters of the GL thread. Everything drawn between beginFrame and endFrame is counted,
+	// so the statistics overlay, drawn after endFrame, doesn't show up in its own numbers.
+	class RenderStats
+	{
+	public:
+		static constexpr size_t HISTORY_SIZE = 240;
+
+		static void beginFrame();
+		static void endFrame();
+
+		static void addDrawCall(const uint64_t indices) { ++m_currentFrame.drawCalls; m_currentFrame.indices += indices; }
+		static void addShaderBind() { ++m_currentFrame.shaderBinds; }
+		static void addTextureBind() { ++m_currentFrame.textureBinds; }
+		static void addVertexArrayBind() { ++m_currentFrame.vertexArrayBinds; }
+		static void addUploadBytes(const uint64_t bytes) { m_currentFrame.uploadBytes += bytes; }
+		// simulation thread, times of the last tick
+		static void setSimulationTimes(const double updateTime, const double physicsTime);
+
+		static const FrameStats& getLastFrame() { return m_lastFrame; }
+		// percentile in [0, 1] of the frame times in the history
+		static double getFrameTimePercentile(const double percentile);
+		// oldest first
+		static void getFrameTimeHistory(std::array<float, HISTORY_SIZE>& frameTimes);
+
+	private:
+		using Clock = std::chrono::steady_clock;
+
+		static FrameStats m_currentFrame;
+		static FrameStats m_lastFrame;
+		static Clock::time_point m_frameBeginTime;
+		static Clock::time_point m_lastFrameBeginTime;
+		static std::atomic<double> m_updateTime;
+		static std::atomic<double> m_physicsTime;
+		static std::array<float, HISTORY_SIZE> m_frameTimes;
+		static size_t m_framesCount;
+	};
+}
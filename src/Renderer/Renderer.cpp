@@ -1,7 +1,10 @@
 #include "Renderer.h"
+#include "RenderStats.h"
 
 namespace RenderEngine
 {
+	uint64_t Renderer::m_frameIndex = 0;
+
 	void Renderer::draw(const VertexArray& vertexArray, const IndexBuffer& indexBuffer, const ShaderProgram& shader)
 	{
 		shader.use();
@@ -9,6 +12,7 @@ namespace RenderEngine
 		indexBuffer.bind();
 
 		glDrawElements(GL_TRIANGLES, indexBuffer.getCount(), GL_UNSIGNED_INT, nullptr);
+		RenderStats::addDrawCall(indexBuffer.getCount());
 	}
 	void Renderer::setClearColor(float r, float g, float b, float a)
 	{
@@ -4,6 +4,7 @@
 #include "IndexBuffer.h"
 #include "ShaderProgram.h"
 #include <string>
+#include <cstdint>
 
 namespace RenderEngine
 {
@@ -17,5 +18,11 @@ namespace RenderEngine
 		static void setViewport(unsigned int widht, unsigned int height, unsigned int leftOffset = 0, unsigned int bottomOffset = 0);
 		static std::string getRendererStr();
 		static std::string getVersionStr();
+
+		static void beginFrame() { ++m_frameIndex; }
+		static uint64_t getFrameIndex() { return m_frameIndex; }
+
+	private:
+		static uint64_t m_frameIndex;
 	};
 }
\ No newline at end of file
@@ -1,10 +1,22 @@
 #include "ShaderProgram.h"
+#include "RenderStats.h"
 #include<iostream>
+#include<fstream>
+#include<vector>
+#include<cstdint>
 #include<glm/gtc/type_ptr.hpp>
 
 namespace RenderEngine {
-	ShaderProgram::ShaderProgram(const std::string& vertexShader, const std::string& fragmentShader) 
+	static constexpr uint32_t PROGRAM_BINARY_MAGIC = 0x42534342; // "BCSB"
+
+	ShaderProgram::ShaderProgram(const std::string_view vertexShader, const std::string_view fragmentShader, const std::string& binaryCachePath) 
 	{
+		if (!binaryCachePath.empty() && loadProgramBinary(binaryCachePath))
+		{
+			m_isCompiled = true;
+			return;
+		}
+
 		GLuint vertexShaderID;
 		if (!createShader(vertexShader, GL_VERTEX_SHADER, vertexShaderID)) 
 		{
@@ -21,9 +33,13 @@ namespace RenderEngine {
 		m_ID = glCreateProgram();
 		glAttachShader(m_ID, vertexShaderID);
 		glAttachShader(m_ID, fragmentShaderID);
+		if (!binaryCachePath.empty())
+		{
+			glProgramParameteri(m_ID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+		}
 		glLinkProgram(m_ID);
 		GLint success;
-		glGetShaderiv(m_ID, GL_COMPILE_STATUS, &success);
+		glGetProgramiv(m_ID, GL_LINK_STATUS, &success);
 		if (!success) 
 		{
 			GLchar infoLog[1024];
@@ -33,12 +49,80 @@ namespace RenderEngine {
 		else { m_isCompiled = true; }
 		glDeleteShader(vertexShaderID);
 		glDeleteShader(fragmentShaderID);
+
+		if (m_isCompiled && !binaryCachePath.empty())
+		{
+			saveProgramBinary(binaryCachePath);
+		}
+	}
+
+	bool ShaderProgram::loadProgramBinary(const std::string& binaryPath)
+	{
+		std::ifstream f(binaryPath, std::ios::in | std::ios::binary);
+		if (!f.is_open())
+		{
+			return false;
+		}
+
+		uint32_t magic = 0;
+		GLenum binaryFormat = 0;
+		f.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+		f.read(reinterpret_cast<char*>(&binaryFormat), sizeof(binaryFormat));
+		if (!f || magic != PROGRAM_BINARY_MAGIC)
+		{
+			std::cerr << "Invalid shader program binary: " << binaryPath << std::endl;
+			return false;
+		}
+		const std::vector<char> binary((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+		if (binary.empty())
+		{
+			return false;
+		}
+
+		m_ID = glCreateProgram();
+		glProgramBinary(m_ID, binaryFormat, binary.data(), static_cast<GLsizei>(binary.size()));
+		GLint success;
+		glGetProgramiv(m_ID, GL_LINK_STATUS, &success);
+		if (!success)
+		{
+			// the driver rejected the binary (e.g. after a driver update), so the caller compiles from source
+			std::cerr << "Shader program binary rejected by the driver, recompiling: " << binaryPath << std::endl;
+			glDeleteProgram(m_ID);
+			m_ID = 0;
+			return false;
+		}
+		return true;
+	}
+
+	void ShaderProgram::saveProgramBinary(const std::string& binaryPath) const
+	{
+		GLint binaryLength = 0;
+		glGetProgramiv(m_ID, GL_PROGRAM_BINARY_LENGTH, &binaryLength);
+		if (binaryLength <= 0)
+		{
+			return;
+		}
+
+		std::vector<char> binary(binaryLength);
+		GLenum binaryFormat = 0;
+		glGetProgramBinary(m_ID, binaryLength, nullptr, &binaryFormat, binary.data());
+
+		std::ofstream f(binaryPath, std::ios::out | std::ios::binary | std::ios::trunc);
+		if (!f.is_open())
+		{
+			std::cerr << "Can't write shader program binary: " << binaryPath << std::endl;
+			return;
+		}
+		f.write(reinterpret_cast<const char*>(&PROGRAM_BINARY_MAGIC), sizeof(PROGRAM_BINARY_MAGIC));
+		f.write(reinterpret_cast<const char*>(&binaryFormat), sizeof(binaryFormat));
+		f.write(binary.data(), binary.size());
 	}
-	bool ShaderProgram::createShader(const std::string& source, const GLenum ShaderType, GLuint& shaderID) 
+	bool ShaderProgram::createShader(const std::string_view source, const GLenum ShaderType, GLuint& shaderID) 
 	{
 		shaderID = glCreateShader(ShaderType);
-		const char* code = source.c_str();
-		glShaderSource(shaderID, 1, &code, nullptr);
+		const char* code = source.data();
+		const GLint codeLength = static_cast<GLint>(source.size());
+		glShaderSource(shaderID, 1, &code, &codeLength);
 		glCompileShader(shaderID);
 		GLint success;
 		glGetShaderiv(shaderID, GL_COMPILE_STATUS, &success);
@@ -57,6 +141,7 @@ namespace RenderEngine {
 	}
 	void ShaderProgram::use() const 
 	{
+		RenderStats::addShaderBind();
 		glUseProgram(m_ID);
 	}
 	ShaderProgram& ShaderProgram::operator = (ShaderProgram&& ShaderProgram) noexcept 
@@ -2,13 +2,14 @@
 
 #include<glad/glad.h>
 #include<string>
+#include<string_view>
 #include<glm/mat4x4.hpp>
 
 namespace RenderEngine {
 	class ShaderProgram
 	{
 	public:
-		ShaderProgram(const std::string& vertexShader, const std::string& fragmentShader);
+		ShaderProgram(const std::string_view vertexShader, const std::string_view fragmentShader, const std::string& binaryCachePath = std::string{});
 		~ShaderProgram();
 		bool isCompiled() const { return m_isCompiled; }
 		void use() const;
@@ -23,7 +24,9 @@ namespace RenderEngine {
 		ShaderProgram(ShaderProgram&& ShaderProgram) noexcept;
 
 	private:
-		bool createShader(const std::string& source, const GLenum ShaderType, GLuint& shaderID);
+		bool createShader(const std::string_view source, const GLenum ShaderType, GLuint& shaderID);
+		bool loadProgramBinary(const std::string& binaryPath);
+		void saveProgramBinary(const std::string& binaryPath) const;
 		bool m_isCompiled = false;
 		GLuint m_ID = 0;
 	};
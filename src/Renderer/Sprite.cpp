@@ -2,6 +2,7 @@
 #include "ShaderProgram.h"
 #include "Texture2D.h"
 #include "Renderer.h"
+#include "../System/Profiler.h"
 #include <glm/mat4x4.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
@@ -13,6 +14,14 @@ namespace RenderEngine
 		: m_pTexture(std::move(pTexture))
 		, m_pShaderProgram(std::move(pShaderProgram))
 		, m_lastFrameID(0) 
+		, m_lastUseFrame(0)
+	{
+		const auto& subTexture = m_pTexture->getSubTexture(std::move(initialSubTexture));
+		m_initialLeftBottomUV = subTexture.leftBottomUV;
+		m_initialRightTopUV = subTexture.rightTopUV;
+	}
+
+	void Sprite::materialize() const
 	{
 		const GLfloat vertexCoords[] =
 		{
@@ -27,15 +36,13 @@ namespace RenderEngine
 			1.f, 0.f
 		};
 
-		auto subTexture = m_pTexture->getSubTexture(std::move(initialSubTexture));
-
 		const GLfloat textureCoords[] =
 		{
 			//U  V
-			subTexture.leftBottomUV.x, subTexture.leftBottomUV.y,
-			subTexture.leftBottomUV.x, subTexture.rightTopUV.y,
-			subTexture.rightTopUV.x, subTexture.rightTopUV.y,
-			subTexture.rightTopUV.x, subTexture.leftBottomUV.y,
+			m_initialLeftBottomUV.x, m_initialLeftBottomUV.y,
+			m_initialLeftBottomUV.x, m_initialRightTopUV.y,
+			m_initialRightTopUV.x,   m_initialRightTopUV.y,
+			m_initialRightTopUV.x,   m_initialLeftBottomUV.y,
 		};
 
 		const GLuint indices[] =
@@ -44,20 +51,33 @@ namespace RenderEngine
 			2, 3, 0
 		};
 		
-		m_vertexCoordsBuffer.init(vertexCoords, 2 * 4 * sizeof(GLfloat));
+		m_pBuffers = std::make_unique<Buffers>();
+		m_lastFrameID = 0;
+
+		m_pBuffers->vertexCoordsBuffer.init(vertexCoords, 2 * 4 * sizeof(GLfloat));
 		VertexBufferLayout vertexCoordsLayout;
 		vertexCoordsLayout.addElementLayoutFloat(2, false);
-		m_vertexArray.addBuffer(m_vertexCoordsBuffer, vertexCoordsLayout);
+		m_pBuffers->vertexArray.addBuffer(m_pBuffers->vertexCoordsBuffer, vertexCoordsLayout);
 
-		m_textureCoordsBuffer.init(textureCoords, 2 * 4 * sizeof(GLfloat));
+		m_pBuffers->textureCoordsBuffer.init(textureCoords, 2 * 4 * sizeof(GLfloat));
 		VertexBufferLayout textureCoordsLayout;
 		textureCoordsLayout.addElementLayoutFloat(2, false);
-		m_vertexArray.addBuffer(m_textureCoordsBuffer, textureCoordsLayout);
+		m_pBuffers->vertexArray.addBuffer(m_pBuffers->textureCoordsBuffer, textureCoordsLayout);
+
+		m_pBuffers->indexBuffer.init(indices, 6);
+
+		m_pBuffers->vertexArray.unbind();
+		m_pBuffers->indexBuffer.unbind();
+	}
 
-		m_indexBuffer.init(indices, 6);
+	void Sprite::release() const
+	{
+		m_pBuffers.reset();
+	}
 
-		m_vertexArray.unbind();
-		m_indexBuffer.unbind();
+	size_t Sprite::getMemorySize() const
+	{
+		return isResident() ? 2 * (2 * 4 * sizeof(GLfloat)) + 6 * sizeof(GLuint) : 0;
 	}
 
 	Sprite::~Sprite()
@@ -66,6 +86,13 @@ namespace RenderEngine
 
 	void Sprite::render(const glm::vec2& position, const glm::vec2& size, const float rotation, const float layer, const size_t frameID) const
 	{
+		PROFILE_ZONE("Sprite::render");
+		if (!m_pBuffers)
+		{
+			materialize();
+		}
+		m_lastUseFrame = Renderer::getFrameIndex();
+
 		if (m_lastFrameID != frameID)
 		{
 			m_lastFrameID = frameID;
@@ -79,7 +106,7 @@ namespace RenderEngine
 				currentFrameDescription.rightTopUV.x,   currentFrameDescription.leftBottomUV.y,
 			};
 
-			m_textureCoordsBuffer.update(textureCoords, 2 * 4 * sizeof(GLfloat));
+			m_pBuffers->textureCoordsBuffer.update(textureCoords, 2 * 4 * sizeof(GLfloat));
 		}
 		
 		m_pShaderProgram->use();
@@ -97,7 +124,7 @@ namespace RenderEngine
 		glActiveTexture(GL_TEXTURE0);
 		m_pTexture->bind();
 
-		Renderer::draw(m_vertexArray, m_indexBuffer, *m_pShaderProgram);
+		Renderer::draw(m_pBuffers->vertexArray, m_pBuffers->indexBuffer, *m_pShaderProgram);
 	}
 	void Sprite::insertFrames(std::vector<FrameDescription> FramesDescriptions)
 	{
@@ -7,6 +7,8 @@
 #include <glm/vec2.hpp>
 #include <memory>
 #include <string>
+#include <vector>
+#include <cstdint>
 
 namespace RenderEngine
 {
@@ -46,15 +48,30 @@ namespace RenderEngine
 		double getFrameDuration(const size_t frameId) const;
 		size_t getFramesCount() const;
 
+		void release() const;
+		bool isResident() const { return m_pBuffers != nullptr; }
+		size_t getMemorySize() const;
+		uint64_t getLastUseFrame() const { return m_lastUseFrame; }
+
 	protected:
+		// GL objects are created on the first render() and can be dropped by release()
+		struct Buffers
+		{
+			VertexArray vertexArray;
+			VertexBuffer vertexCoordsBuffer;
+			VertexBuffer textureCoordsBuffer;
+			IndexBuffer indexBuffer;
+		};
+		void materialize() const;
+
 		std::shared_ptr<Texture2D> m_pTexture;
 		std::shared_ptr<ShaderProgram> m_pShaderProgram;
 
-		VertexArray m_vertexArray;
-		VertexBuffer m_vertexCoordsBuffer;
-		VertexBuffer m_textureCoordsBuffer;
-		IndexBuffer m_indexBuffer;
+		glm::vec2 m_initialLeftBottomUV;
+		glm::vec2 m_initialRightTopUV;
+		mutable std::unique_ptr<Buffers> m_pBuffers;
 		std::vector<FrameDescription> m_framesDescriptions;
 		mutable size_t m_lastFrameID;
+		mutable uint64_t m_lastUseFrame;
 	};
 }
\ No newline at end of file
@@ -36,4 +36,11 @@ namespace RenderEngine
 		m_currentFrameDuration = m_pSprite->getFrameDuration(0);
 		m_currentAnimationTime = 0;
 	}
+
+	void SpriteAnimator::setPhase(const size_t frame, const double frameTime)
+	{
+		m_currentFrame = frame < m_pSprite->getFramesCount() ? frame : 0;
+		m_currentFrameDuration = m_pSprite->getFrameDuration(m_currentFrame);
+		m_currentAnimationTime = frameTime;
+	}
 }
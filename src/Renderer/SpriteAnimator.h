@@ -13,6 +13,9 @@ namespace RenderEngine
 		void update(const double delta);
 		double getTotalDuration() const { return m_totalDuration; }
 		void reset();
+		// the phase is the current frame and the time spent in it, milliseconds
+		double getCurrentFrameTime() const { return m_currentAnimationTime; }
+		void setPhase(const size_t frame, const double frameTime);
 
 	private:
 		std::shared_ptr<Sprite> m_pSprite;
@@ -0,0 +1,187 @@
+#include "StatsOverlay.h"
+#include "ShaderProgram.h"
+#include "RenderStats.h"
+#include "GPUProfiler.h"
+#include "VertexBufferLayout.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/mat4x4.hpp>
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstdio>
+
+namespace RenderEngine
+{
+	static constexpr size_t MAX_VERTICES = 32768;
+	// one font pixel in screen pixels, glyphs are 3x5 font pixels
+	static constexpr float FONT_SCALE = 2.f;
+	static constexpr float LINE_HEIGHT = 7 * FONT_SCALE;
+	static constexpr float GRAPH_HEIGHT = 100.f;
+	// frame times above this are clipped in the graph
+	static constexpr float GRAPH_MAX_FRAME_TIME = 50.f;
+
+	// 3x5 bitmaps, row by row from the top, the leftmost pixel in the highest bit
+	static constexpr uint16_t DIGIT_GLYPHS[] =
+	{
+		0x7B6F, 0x2C97, 0x73E7, 0x73CF, 0x5BC9, 0x79CF, 0x79EF, 0x7249, 0x7BEF, 0x7BCF
+	};
+	static constexpr uint16_t LETTER_GLYPHS[] =
+	{
+		0x2BED, 0x6BAE, 0x3923, 0x6B6E, 0x79A7, 0x79A4, 0x396B, 0x5BED, 0x7497, 0x126A, 0x5BAD, 0x4927, 0x5FED,
+		0x6B6D, 0x2B6A, 0x6BA4, 0x2B73, 0x6BAD, 0x388E, 0x7492, 0x5B6F, 0x5B6A, 0x5BFD, 0x5AAD, 0x5A92, 0x72A7
+	};
+
+	static uint16_t getGlyph(const char character)
+	{
+		if (character >= '0' && character <= '9')
+		{
+			return DIGIT_GLYPHS[character - '0'];
+		}
+		const char upperCharacter = static_cast<char>(std::toupper(static_cast<unsigned char>(character)));
+		if (upperCharacter >= 'A' && upperCharacter <= 'Z')
+		{
+			return LETTER_GLYPHS[upperCharacter - 'A'];
+		}
+		switch (character)
+		{
+		case '.':
+			return 0x0002;
+		case ':':
+			return 0x0410;
+		case '%':
+			return 0x52A5;
+		case '/':
+			return 0x12A4;
+		case '-':
+			return 0x01C0;
+		default:
+			return 0;
+		}
+	}
+
+	StatsOverlay::StatsOverlay(std::shared_ptr<ShaderProgram> pShaderProgram)
+		: m_pShaderProgram(std::move(pShaderProgram))
+	{
+		m_vertices.reserve(MAX_VERTICES);
+		// rewritten and drawn once every frame
+		m_vertexBuffer.init(nullptr, static_cast<unsigned int>(MAX_VERTICES * sizeof(Vertex)), GL_STREAM_DRAW);
+		VertexBufferLayout vertexLayout;
+		vertexLayout.reserveElements(2);
+		vertexLayout.addElementLayoutFloat(2, false);
+		vertexLayout.addElementLayoutFloat(4, false);
+		m_vertexArray.addBuffer(m_vertexBuffer, vertexLayout);
+		m_vertexArray.unbind();
+	}
+
+	void StatsOverlay::render(const unsigned int width, const unsigned int height)
+	{
+		if (!m_pShaderProgram || width == 0 || height == 0)
+		{
+			return;
+		}
+		m_vertices.clear();
+
+		const FrameStats& frameStats = RenderStats::getLastFrame();
+		const double p50 = RenderStats::getFrameTimePercentile(0.5);
+		const double p95 = RenderStats::getFrameTimePercentile(0.95);
+		const double p99 = RenderStats::getFrameTimePercentile(0.99);
+
+		std::array<std::string, 8> lines;
+		char buffer[128];
+		std::snprintf(buffer, sizeof(buffer), "FRAME %.2f MS  FPS %.0f", frameStats.frameTime, frameStats.frameTime > 0 ? 1000.0 / frameStats.frameTime : 0.0);
+		lines[0] = buffer;
+		std::snprintf(buffer, sizeof(buffer), "P50 %.2f  P95 %.2f  P99 %.2f", p50, p95, p99);
+		lines[1] = buffer;
+		std::snprintf(buffer, sizeof(buffer), "DRAWS %u  INDICES %llu", frameStats.drawCalls, static_cast<unsigned long long>(frameStats.indices));
+		lines[2] = buffer;
+		std::snprintf(buffer, sizeof(buffer), "BINDS SHADER %u TEX %u VAO %u", frameStats.shaderBinds, frameStats.textureBinds, frameStats.vertexArrayBinds);
+		lines[3] = buffer;
+		std::snprintf(buffer, sizeof(buffer), "UPLOAD %llu B", static_cast<unsigned long long>(frameStats.uploadBytes));
+		lines[4] = buffer;
+		std::snprintf(buffer, sizeof(buffer), "CPU UPDATE %.2f PHYS %.2f RENDER %.2f", frameStats.updateTime, frameStats.physicsTime, frameStats.renderTime);
+		lines[5] = buffer;
+		lines[6] = "GPU";
+		for (const GPUProfiler::PassTime& currentPass : GPUProfiler::getLastPassTimes())
+		{
+			std::snprintf(buffer, sizeof(buffer), " %s %.2f", currentPass.name, currentPass.milliseconds);
+			lines[6] += buffer;
+		}
+
+		size_t longestLine = 0;
+		for (const std::string& currentLine : lines)
+		{
+			longestLine = std::max(longestLine, currentLine.size());
+		}
+		const float panelWidth = std::max(longestLine * 4 * FONT_SCALE, static_cast<float>(RenderStats::HISTORY_SIZE)) + 2 * FONT_SCALE;
+		const float textHeight = lines.size() * LINE_HEIGHT;
+		addQuad(0.f, 0.f, panelWidth, textHeight + GRAPH_HEIGHT + 3 * FONT_SCALE, { 0.f, 0.f, 0.f, 0.6f });
+		for (size_t currentLine = 0; currentLine < lines.size(); ++currentLine)
+		{
+			addText(FONT_SCALE, FONT_SCALE + currentLine * LINE_HEIGHT, lines[currentLine], { 1.f, 1.f, 1.f, 1.f });
+		}
+
+		// rolling frame-time graph, the newest frame on the right
+		std::array<float, RenderStats::HISTORY_SIZE> frameTimes;
+		RenderStats::getFrameTimeHistory(frameTimes);
+		const float graphLeft = FONT_SCALE;
+		const float graphBottom = textHeight + GRAPH_HEIGHT + FONT_SCALE;
+		const float pixelsPerMillisecond = GRAPH_HEIGHT / GRAPH_MAX_FRAME_TIME;
+		for (size_t currentFrame = 0; currentFrame < frameTimes.size(); ++currentFrame)
+		{
+			const float frameTime = frameTimes[currentFrame] < GRAPH_MAX_FRAME_TIME ? frameTimes[currentFrame] : GRAPH_MAX_FRAME_TIME;
+			const Color color = frameTime > 1000.f / 30.f ? Color{ 1.f, 0.2f, 0.2f, 1.f } : frameTime > 1000.f / 60.f ? Color{ 1.f, 0.8f, 0.2f, 1.f } : Color{ 0.2f, 0.9f, 0.3f, 1.f };
+			addQuad(graphLeft + currentFrame, graphBottom - frameTime * pixelsPerMillisecond, 1.f, frameTime * pixelsPerMillisecond, color);
+		}
+		const float graphWidth = static_cast<float>(frameTimes.size());
+		addQuad(graphLeft, graphBottom - 1000.f / 60.f * pixelsPerMillisecond, graphWidth, 1.f, { 1.f, 1.f, 1.f, 0.5f });
+		addQuad(graphLeft, graphBottom - static_cast<float>(p99) * pixelsPerMillisecond, graphWidth, 1.f, { 1.f, 0.2f, 1.f, 0.8f });
+
+		GLint viewport[4];
+		glGetIntegerv(GL_VIEWPORT, viewport);
+		glViewport(0, 0, width, height);
+		glDisable(GL_DEPTH_TEST);
+		glEnable(GL_BLEND);
+		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+		m_pShaderProgram->use();
+		m_pShaderProgram->setMatrix4("projectionMat", glm::ortho(0.f, static_cast<float>(width), static_cast<float>(height), 0.f, -1.f, 1.f));
+		m_vertexBuffer.update(m_vertices.data(), static_cast<unsigned int>(m_vertices.size() * sizeof(Vertex)));
+		m_vertexArray.bind();
+		glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(m_vertices.size()));
+		m_vertexArray.unbind();
+
+		glDisable(GL_BLEND);
+		glEnable(GL_DEPTH_TEST);
+		glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+	}
+
+	void StatsOverlay::addQuad(const float x, const float y, const float width, const float height, const Color& color)
+	{
+		if (m_vertices.size() + 6 > MAX_VERTICES)
+		{
+			return;
+		}
+		const Vertex leftTop{ x, y, color.r, color.g, color.b, color.a };
+		const Vertex rightTop{ x + width, y, color.r, color.g, color.b, color.a };
+		const Vertex rightBottom{ x + width, y + height, color.r, color.g, color.b, color.a };
+		const Vertex leftBottom{ x, y + height, color.r, color.g, color.b, color.a };
+		m_vertices.insert(m_vertices.end(), { leftTop, leftBottom, rightBottom, rightBottom, rightTop, leftTop });
+	}
+
+	void StatsOverlay::addText(const float x, const float y, const std::string& text, const Color& color)
+	{
+		float currentX = x;
+		for (const char currentCharacter : text)
+		{
+			const uint16_t glyph = getGlyph(currentCharacter);
+			for (unsigned int currentPixel = 0; currentPixel < 15; ++currentPixel)
+			{
+				if (glyph & (1u << (14 - currentPixel)))
+				{
+					addQuad(currentX + (currentPixel % 3) * FONT_SCALE, y + (currentPixel / 3) * FONT_SCALE, FONT_SCALE, FONT_SCALE, color);
+				}
+			}
+			currentX += 4 * FONT_SCALE;
+		}
+	}
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "VertexArray.h"
+#include "VertexBuffer.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace RenderEngine
+{
+	class ShaderProgram;
+
+	// On-screen render statistics: counters of the last frame, CPU and GPU times and a rolling
+	// frame-time graph with percentiles. Text and graph are built on the CPU into one vertex buffer
+	// and drawn with a single draw call.
+	class StatsOverlay
+	{
+	public:
+		StatsOverlay(std::shared_ptr<ShaderProgram> pShaderProgram);
+
+		StatsOverlay(const StatsOverlay&) = delete;
+		StatsOverlay& operator = (const StatsOverlay&) = delete;
+
+		// draws over the whole width x height target, must be called after RenderStats::endFrame
+		void render(const unsigned int width, const unsigned int height);
+
+	private:
+		struct Vertex
+		{
+			float x;
+			float y;
+			float r;
+			float g;
+			float b;
+			float a;
+		};
+
+		struct Color
+		{
+			float r;
+			float g;
+			float b;
+			float a;
+		};
+
+		void addQuad(const float x, const float y, const float width, const float height, const Color& color);
+		void addText(const float x, const float y, const std::string& text, const Color& color);
+
+		std::shared_ptr<ShaderProgram> m_pShaderProgram;
+		VertexArray m_vertexArray;
+		VertexBuffer m_vertexBuffer;
+		std::vector<Vertex> m_vertices;
+	};
+}
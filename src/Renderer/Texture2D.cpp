@@ -1,4 +1,6 @@
 #include "Texture2D.h"
+#include "Renderer.h"
+#include "RenderStats.h"
 
 namespace RenderEngine {
 
@@ -7,8 +9,24 @@ namespace RenderEngine {
         const unsigned int channels,
         const GLenum filter,
         const GLenum wrapMode)
-        : m_width(width)
+        : Texture2D(width, height, Materializer{}, channels, filter, wrapMode)
+    {
+        upload(data);
+    }
+
+    Texture2D::Texture2D(const GLuint width, GLuint height,
+        Materializer materializer,
+        const unsigned int channels,
+        const GLenum filter,
+        const GLenum wrapMode)
+        : m_ID(0)
+        , m_filter(filter)
+        , m_wrapMode(wrapMode)
+        , m_width(width)
         , m_height(height)
+        , m_channels(channels)
+        , m_lastUseFrame(0)
+        , m_materializer(std::move(materializer))
     {
         switch (channels)
         {
@@ -22,64 +40,99 @@ namespace RenderEngine {
             m_mode = GL_RGBA;
             break;
         }
+    }
+
+    void Texture2D::upload(const unsigned char* data)
+    {
+        release();
 
         glGenTextures(1, &m_ID);
         glActiveTexture(GL_TEXTURE0);
         glBindTexture(GL_TEXTURE_2D, m_ID);
         glTexImage2D(GL_TEXTURE_2D, 0, m_mode, m_width, m_height, 0, m_mode, GL_UNSIGNED_BYTE, data);
+        RenderStats::addUploadBytes(static_cast<uint64_t>(m_width) * m_height * m_channels);
 
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrapMode);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrapMode);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, m_wrapMode);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, m_wrapMode);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, m_filter);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, m_filter);
         glGenerateMipmap(GL_TEXTURE_2D);
 
         glBindTexture(GL_TEXTURE_2D, 0);
     }
 
+    void Texture2D::release()
+    {
+        if (m_ID != 0)
+        {
+            glDeleteTextures(1, &m_ID);
+            m_ID = 0;
+        }
+    }
+
+    size_t Texture2D::getMemorySize() const
+    {
+        // base level plus roughly a third for the mip chain
+        return isResident() ? static_cast<size_t>(m_width) * m_height * m_channels * 4 / 3 : 0;
+    }
+
     Texture2D& Texture2D::operator=(Texture2D&& texture2d)
     {
-        glDeleteTextures(1, &m_ID);
+        release();
         m_ID = texture2d.m_ID;
         texture2d.m_ID = 0;
         m_mode = texture2d.m_mode;
+        m_filter = texture2d.m_filter;
+        m_wrapMode = texture2d.m_wrapMode;
         m_width = texture2d.m_width;
         m_height = texture2d.m_height;
+        m_channels = texture2d.m_channels;
+        m_lastUseFrame = texture2d.m_lastUseFrame;
+        m_materializer = std::move(texture2d.m_materializer);
+        m_subTextures = std::move(texture2d.m_subTextures);
         return *this;
     }
 
     Texture2D::Texture2D(Texture2D&& texture2d)
+        : m_ID(0)
     {
-        m_ID = texture2d.m_ID;
-        texture2d.m_ID = 0;
-        m_mode = texture2d.m_mode;
-        m_width = texture2d.m_width;
-        m_height = texture2d.m_height;
+        *this = std::move(texture2d);
     }
 
     Texture2D::~Texture2D()
     {
-        glDeleteTextures(1, &m_ID);
+        release();
     }
 
-    void Texture2D::bind() const
+    void Texture2D::bind()
     {
+        if (m_ID == 0 && m_materializer)
+        {
+            m_materializer(*this);
+        }
+        m_lastUseFrame = Renderer::getFrameIndex();
+        RenderStats::addTextureBind();
         glBindTexture(GL_TEXTURE_2D, m_ID);
     }
 
     void Texture2D::addSubTexture(std::string name, const glm::vec2& leftBottomUV, const glm::vec2& rightTopUV)
     {
-        m_subTextures.emplace(std::move(name), SubTexture2D(leftBottomUV, rightTopUV));
+        m_subTextures.emplace(ResourceID(name), SubTexture2D(leftBottomUV, rightTopUV));
     }
 
     const Texture2D::SubTexture2D& Texture2D::getSubTexture(const std::string& name) const
     {
-        auto it = m_subTextures.find(name);
-        if (it != m_subTextures.end())
+        return getSubTexture(ResourceID(name));
+    }
+
+    const Texture2D::SubTexture2D& Texture2D::getSubTexture(const ResourceID subTextureID) const
+    {
+        const SubTexture2D* pSubTexture = m_subTextures.find(subTextureID);
+        if (pSubTexture)
         {
-            return it->second;
+            return *pSubTexture;
         }
         const static SubTexture2D defaultSubTexture;
         return defaultSubTexture;
     }
-}
\ No newline at end of file
+}
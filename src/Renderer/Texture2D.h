@@ -3,7 +3,9 @@
 #include <glad/glad.h>
 #include <glm/vec2.hpp>
 #include <string>
-#include <map>
+#include <functional>
+#include <cstdint>
+#include "../Resources/FlatHashMap.h"
 
 namespace RenderEngine 
 {
@@ -21,12 +23,21 @@ namespace RenderEngine
             SubTexture2D() : leftBottomUV(0.f), rightTopUV(1.f)
             {}
         };
+        // Called on first bind() of a texture that has no GL object; it is expected to call upload()
+        typedef std::function<void(Texture2D&)> Materializer;
+
         Texture2D(const GLuint width, GLuint height,
             const unsigned char* data,
             const unsigned int channels = 4,
             const GLenum filter = GL_LINEAR,
             const GLenum wrapMode = GL_CLAMP_TO_EDGE);
 
+        Texture2D(const GLuint width, GLuint height,
+            Materializer materializer,
+            const unsigned int channels = 4,
+            const GLenum filter = GL_LINEAR,
+            const GLenum wrapMode = GL_CLAMP_TO_EDGE);
+
         Texture2D() = delete;
         Texture2D(const Texture2D&) = delete;
         Texture2D& operator=(const Texture2D&) = delete;
@@ -36,17 +47,29 @@ namespace RenderEngine
 
         void addSubTexture(std::string name, const glm::vec2& leftBottomUV, const glm::vec2& rightTopUV);
         const SubTexture2D& getSubTexture(const std::string& name) const;
+        const SubTexture2D& getSubTexture(const ResourceID subTextureID) const;
         unsigned int width() const { return m_width; }
         unsigned int height() const { return m_height; }
 
-        void bind() const;
+        void upload(const unsigned char* data);
+        void release();
+        bool isResident() const { return m_ID != 0; }
+        size_t getMemorySize() const;
+        uint64_t getLastUseFrame() const { return m_lastUseFrame; }
+
+        void bind();
 
     private:
         GLuint m_ID;
         GLenum m_mode;
+        GLenum m_filter;
+        GLenum m_wrapMode;
         unsigned int m_width;
         unsigned int m_height;
+        unsigned int m_channels;
+        uint64_t m_lastUseFrame;
+        Materializer m_materializer;
 
-        std::map<std::string, SubTexture2D> m_subTextures;
+        FlatHashMap<SubTexture2D> m_subTextures;
     };
-}
\ No newline at end of file
+}
@@ -1,4 +1,5 @@
 #include "VertexArray.h"
+#include "RenderStats.h"
 
 namespace RenderEngine
 {
@@ -27,6 +28,7 @@ namespace RenderEngine
 
 	void VertexArray::bind() const
 	{
+		RenderStats::addVertexArrayBind();
 		glBindVertexArray(m_id);
 	}
 
@@ -1,4 +1,5 @@
 #include "VertexBuffer.h"
+#include "RenderStats.h"
 
 namespace RenderEngine
 {
@@ -25,17 +26,19 @@ namespace RenderEngine
 		vertexBuffer.m_id = 0;
 	}
 
-	void VertexBuffer::init(const void* data, const unsigned int size)
+	void VertexBuffer::init(const void* data, const unsigned int size, const GLenum usage)
 	{
 		glGenBuffers(1, &m_id);
 		glBindBuffer(GL_ARRAY_BUFFER, m_id);
-		glBufferData(GL_ARRAY_BUFFER, size, data, GL_STATIC_DRAW);
+		glBufferData(GL_ARRAY_BUFFER, size, data, usage);
+		RenderStats::addUploadBytes(size);
 	}
 
 	void VertexBuffer::update(const void* data, const unsigned int size) const
 	{
 		glBindBuffer(GL_ARRAY_BUFFER, m_id);
 		glBufferSubData(GL_ARRAY_BUFFER, 0, size, data);
+		RenderStats::addUploadBytes(size);
 	}
 
 	void VertexBuffer::bind() const
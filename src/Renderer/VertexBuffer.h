@@ -15,7 +15,8 @@ namespace RenderEngine
 		VertexBuffer& operator=(VertexBuffer&& VertexBuffer) noexcept;
 		VertexBuffer(VertexBuffer&& vertexBuffer) noexcept;
 
-		void init(const void* data, const unsigned int size);
+		// GL_DYNAMIC_DRAW or GL_STREAM_DRAW for a buffer rewritten with update() every frame
+		void init(const void* data, const unsigned int size, const GLenum usage = GL_STATIC_DRAW);
 		void update(const void* data, const unsigned int size) const;
 		void bind() const;
 		void unbind() const;
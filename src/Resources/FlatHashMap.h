@@ -0,0 +1,112 @@
+#pragma once
+
+#include "ResourceID.h"
+#include <vector>
+#include <utility>
+
+// Open-addressing (linear probing) map keyed by ResourceID.
+// Values must be default constructible; keys are never erased one by one, only cleared.
+template<class TValue>
+class FlatHashMap
+{
+public:
+	std::pair<TValue*, bool> emplace(const ResourceID id, TValue value)
+	{
+		if ((m_size + 1) * 2 > m_slots.size())
+		{
+			rehash(m_slots.empty() ? 16 : m_slots.size() * 2);
+		}
+		Slot& slot = m_slots[findSlot(id)];
+		if (slot.key == id.value())
+		{
+			return { &slot.value, false };
+		}
+		slot.key = id.value();
+		slot.value = std::move(value);
+		++m_size;
+		return { &slot.value, true };
+	}
+
+	TValue* find(const ResourceID id)
+	{
+		if (m_slots.empty())
+		{
+			return nullptr;
+		}
+		Slot& slot = m_slots[findSlot(id)];
+		return slot.key == id.value() ? &slot.value : nullptr;
+	}
+
+	const TValue* find(const ResourceID id) const
+	{
+		return const_cast<FlatHashMap*>(this)->find(id);
+	}
+
+	template<class TFunction>
+	void forEach(TFunction function)
+	{
+		for (Slot& currentSlot : m_slots)
+		{
+			if (currentSlot.key != 0)
+			{
+				function(ResourceID::fromValue(currentSlot.key), currentSlot.value);
+			}
+		}
+	}
+
+	template<class TFunction>
+	void forEach(TFunction function) const
+	{
+		for (const Slot& currentSlot : m_slots)
+		{
+			if (currentSlot.key != 0)
+			{
+				function(ResourceID::fromValue(currentSlot.key), currentSlot.value);
+			}
+		}
+	}
+
+	void clear()
+	{
+		m_slots.clear();
+		m_size = 0;
+	}
+
+	size_t size() const { return m_size; }
+	bool empty() const { return m_size == 0; }
+
+private:
+	struct Slot
+	{
+		uint64_t key = 0;
+		TValue value{};
+	};
+
+	size_t findSlot(const ResourceID id) const
+	{
+		const size_t mask = m_slots.size() - 1;
+		size_t index = static_cast<size_t>(id.value() ^ (id.value() >> 32)) & mask;
+		while (m_slots[index].key != 0 && m_slots[index].key != id.value())
+		{
+			index = (index + 1) & mask;
+		}
+		return index;
+	}
+
+	void rehash(const size_t newCapacity)
+	{
+		std::vector<Slot> oldSlots = std::move(m_slots);
+		m_slots.clear();
+		m_slots.resize(newCapacity);
+		for (Slot& currentSlot : oldSlots)
+		{
+			if (currentSlot.key != 0)
+			{
+				m_slots[findSlot(ResourceID::fromValue(currentSlot.key))] = std::move(currentSlot);
+			}
+		}
+	}
+
+	std::vector<Slot> m_slots;
+	size_t m_size = 0;
+};
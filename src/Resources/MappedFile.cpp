@@ -0,0 +1,131 @@
+#include "MappedFile.h"
+#include <utility>
+
+#ifdef _WIN32
+	#define WIN32_LEAN_AND_MEAN
+	#define NOMINMAX
+	#include <windows.h>
+#else
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <fcntl.h>
+	#include <unistd.h>
+#endif
+
+MappedFile::MappedFile(const std::string& filePath)
+{
+#ifdef _WIN32
+	HANDLE fileHandle = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (fileHandle == INVALID_HANDLE_VALUE)
+	{
+		return;
+	}
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(fileHandle, &fileSize))
+	{
+		CloseHandle(fileHandle);
+		return;
+	}
+	m_fileHandle = fileHandle;
+	m_size = static_cast<size_t>(fileSize.QuadPart);
+	m_isOpen = true;
+	if (m_size == 0)
+	{
+		return;
+	}
+	m_mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (m_mappingHandle)
+	{
+		m_pData = static_cast<const unsigned char*>(MapViewOfFile(m_mappingHandle, FILE_MAP_READ, 0, 0, 0));
+	}
+	if (!m_pData)
+	{
+		close();
+	}
+#else
+	const int fileDescriptor = open(filePath.c_str(), O_RDONLY);
+	if (fileDescriptor < 0)
+	{
+		return;
+	}
+	struct stat fileStat;
+	if (fstat(fileDescriptor, &fileStat) != 0)
+	{
+		::close(fileDescriptor);
+		return;
+	}
+	m_size = static_cast<size_t>(fileStat.st_size);
+	m_isOpen = true;
+	if (m_size > 0)
+	{
+		void* pMapping = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+		if (pMapping == MAP_FAILED)
+		{
+			m_size = 0;
+			m_isOpen = false;
+		}
+		else
+		{
+			m_pData = static_cast<const unsigned char*>(pMapping);
+		}
+	}
+	// the mapping keeps its own reference to the file
+	::close(fileDescriptor);
+#endif
+}
+
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& mappedFile) noexcept
+{
+	close();
+	m_pData = mappedFile.m_pData;
+	m_size = mappedFile.m_size;
+	m_isOpen = mappedFile.m_isOpen;
+	mappedFile.m_pData = nullptr;
+	mappedFile.m_size = 0;
+	mappedFile.m_isOpen = false;
+#ifdef _WIN32
+	m_fileHandle = mappedFile.m_fileHandle;
+	m_mappingHandle = mappedFile.m_mappingHandle;
+	mappedFile.m_fileHandle = nullptr;
+	mappedFile.m_mappingHandle = nullptr;
+#endif
+	return *this;
+}
+
+MappedFile::MappedFile(MappedFile&& mappedFile) noexcept
+{
+	*this = std::move(mappedFile);
+}
+
+void MappedFile::close()
+{
+#ifdef _WIN32
+	if (m_pData)
+	{
+		UnmapViewOfFile(m_pData);
+	}
+	if (m_mappingHandle)
+	{
+		CloseHandle(m_mappingHandle);
+	}
+	if (m_fileHandle)
+	{
+		CloseHandle(m_fileHandle);
+	}
+	m_fileHandle = nullptr;
+	m_mappingHandle = nullptr;
+#else
+	if (m_pData)
+	{
+		munmap(const_cast<unsigned char*>(m_pData), m_size);
+	}
+#endif
+	m_pData = nullptr;
+	m_size = 0;
+	m_isOpen = false;
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <cstddef>
+
+// Read-only memory mapping of a whole file. The contents stay valid while the object is alive.
+class MappedFile
+{
+public:
+	MappedFile() = default;
+	explicit MappedFile(const std::string& filePath);
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator = (const MappedFile&) = delete;
+	MappedFile& operator = (MappedFile&& mappedFile) noexcept;
+	MappedFile(MappedFile&& mappedFile) noexcept;
+
+	bool isOpen() const { return m_isOpen; }
+	const unsigned char* data() const { return m_pData; }
+	size_t size() const { return m_size; }
+	std::string_view view() const { return std::string_view(reinterpret_cast<const char*>(m_pData), m_size); }
+
+private:
+	void close();
+
+	const unsigned char* m_pData = nullptr;
+	size_t m_size = 0;
+	bool m_isOpen = false;
+#ifdef _WIN32
+	void* m_fileHandle = nullptr;
+	void* m_mappingHandle = nullptr;
+#endif
+};
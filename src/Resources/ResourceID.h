@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string_view>
+
+static constexpr uint64_t FNV1A_OFFSET_BASIS = 14695981039346656037ull;
+static constexpr uint64_t FNV1A_PRIME = 1099511628211ull;
+
+constexpr uint64_t fnv1aHash(const std::string_view data, uint64_t hash = FNV1A_OFFSET_BASIS)
+{
+	for (const char currentChar : data)
+	{
+		hash = (hash ^ static_cast<unsigned char>(currentChar)) * FNV1A_PRIME;
+	}
+	return hash;
+}
+
+// Hashed resource name. Literals are hashed at compile time: ResourceManager::getSprite("eagle"_rid)
+class ResourceID
+{
+public:
+	constexpr ResourceID() : m_hash(0) {}
+	constexpr explicit ResourceID(const std::string_view name) : m_hash(makeHash(name)) {}
+	static constexpr ResourceID fromValue(const uint64_t hash) { ResourceID id; id.m_hash = hash; return id; }
+
+	constexpr uint64_t value() const { return m_hash; }
+	constexpr bool isValid() const { return m_hash != 0; }
+	constexpr bool operator==(const ResourceID other) const { return m_hash == other.m_hash; }
+	constexpr bool operator!=(const ResourceID other) const { return m_hash != other.m_hash; }
+
+private:
+	static constexpr uint64_t makeHash(const std::string_view name)
+	{
+		const uint64_t hash = fnv1aHash(name);
+		// 0 marks an empty slot in FlatHashMap
+		return hash != 0 ? hash : 1;
+	}
+
+	uint64_t m_hash;
+};
+
+constexpr ResourceID operator""_rid(const char* name, const size_t length)
+{
+	return ResourceID(std::string_view(name, length));
+}
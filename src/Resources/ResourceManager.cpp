@@ -2,9 +2,15 @@
 #include "../Renderer/ShaderProgram.h"
 #include "../Renderer/Texture2D.h"
 #include "../Renderer/Sprite.h"
+#include "../Renderer/Renderer.h"
+#include "../System/Metrics.h"
+#include "../System/Profiler.h"
 #include <sstream>
-#include <fstream>
 #include <iostream> 
+#include <filesystem>
+#include <cstdint>
+#include <algorithm>
+#include <limits>
 #include <rapidjson/document.h>
 #include <rapidjson/error/en.h>
 
@@ -14,15 +20,55 @@
 
 ResourceManager::ShaderProgramsMap ResourceManager::m_shaderPrograms;
 ResourceManager::TexturesMap ResourceManager::m_textures;
-ResourceManager::SpritesMap ResourceManager::m_sprites;
+ResourceManager::SpriteHandlesMap ResourceManager::m_spriteHandles;
+std::vector<std::shared_ptr<RenderEngine::Sprite>> ResourceManager::m_sprites;
+FlatHashMap<std::string> ResourceManager::m_resourceNames;
+FlatHashMap<ResourceManager::DecodedImage> ResourceManager::m_decodedImages;
+size_t ResourceManager::m_cpuMemoryBudget = 0;
+size_t ResourceManager::m_gpuMemoryBudget = std::numeric_limits<size_t>::max();
 std::string ResourceManager::m_path;
+bool ResourceManager::m_isHeadless = false;
 std::vector<std::vector<std::string>> ResourceManager::m_levels;
 
+static void publishMemoryMetrics(const size_t cpuMemory, const size_t gpuMemory)
+{
+	static Metrics::Gauge& cpuMemoryGauge = Metrics::gauge("battlecity_resource_cpu_bytes", "Decoded images kept in memory");
+	static Metrics::Gauge& gpuMemoryGauge = Metrics::gauge("battlecity_resource_gpu_bytes", "Textures and sprites resident on the GPU");
+	cpuMemoryGauge.set(static_cast<double>(cpuMemory));
+	gpuMemoryGauge.set(static_cast<double>(gpuMemory));
+}
+
 void ResourceManager::unloadAllResources()
 {
 	m_shaderPrograms.clear();
 	m_textures.clear();
+	m_spriteHandles.clear();
 	m_sprites.clear();
+	m_resourceNames.clear();
+	m_decodedImages.clear();
+	m_levels.clear();
+}
+
+ResourceID ResourceManager::internResourceName(const std::string& resourceName)
+{
+	const ResourceID resourceID(resourceName);
+	const auto [pName, isInserted] = m_resourceNames.emplace(resourceID, resourceName);
+	if (!isInserted && *pName != resourceName)
+	{
+		std::cerr << "Resource ID collision: " << resourceName << " and " << *pName << std::endl;
+	}
+	return resourceID;
+}
+
+const std::string& ResourceManager::getResourceName(const ResourceID resourceID)
+{
+	const std::string* pName = m_resourceNames.find(resourceID);
+	if (pName)
+	{
+		return *pName;
+	}
+	static const std::string unknownName = "<unknown>";
+	return unknownName;
 }
 
 void ResourceManager::setExecutablePath(const std::string& executablePath)
@@ -31,37 +77,74 @@ void ResourceManager::setExecutablePath(const std::string& executablePath)
   	m_path = executablePath.substr(0, found);
 }
 
-std::string ResourceManager::getFileString(const std::string& relativefilePath)
+MappedFile ResourceManager::mapFile(const std::string& relativeFilePath)
 {
-	std::ifstream f;
-	f.open(m_path + "/" + relativefilePath.c_str(), std::ios::in | std::ios::binary);
-	if (!f.is_open())
+	MappedFile file(m_path + "/" + relativeFilePath);
+	if (!file.isOpen())
 	{
-		std::cerr << "Failed to open file " << relativefilePath << std::endl;
+		std::cerr << "Failed to open file " << relativeFilePath << std::endl;
+	}
+	return file;
+}
+
+std::string ResourceManager::getShaderBinaryCachePath(const std::string& shaderName, const std::string_view vertexString, const std::string_view fragmentString)
+{
+	GLint binaryFormatsCount = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &binaryFormatsCount);
+	if (binaryFormatsCount <= 0)
+	{
+		return std::string{};
+	}
+
+	const std::string cacheDirectory = m_path + "/shader_cache";
+	std::error_code errorCode;
+	std::filesystem::create_directories(cacheDirectory, errorCode);
+	if (errorCode)
+	{
+		std::cerr << "Can't create shader cache directory: " << cacheDirectory << std::endl;
 		return std::string{};
 	}
 
-	std::stringstream buffer;
-	buffer << f.rdbuf();
-	return buffer.str();
+	// FNV-1a over the sources and the driver identity, so a driver update invalidates the cache
+	const std::string rendererString = RenderEngine::Renderer::getRendererStr();
+	const std::string versionString = RenderEngine::Renderer::getVersionStr();
+	uint64_t hash = FNV1A_OFFSET_BASIS;
+	for (const std::string_view currentKeyPart : { vertexString, fragmentString, std::string_view(rendererString), std::string_view(versionString) })
+	{
+		hash = fnv1aHash(currentKeyPart, hash);
+		hash = (hash ^ 0xFFu) * FNV1A_PRIME;
+	}
+
+	std::stringstream path;
+	path << cacheDirectory << "/" << shaderName << "_" << std::hex << hash << ".bin";
+	return path.str();
 }
 
 std::shared_ptr<RenderEngine::ShaderProgram> ResourceManager::loadShaders(const std::string& shaderName, const std::string& vertexPath, const std::string& fragmentPath)
 {
-	std::string vertexShtring = getFileString(vertexPath);
+	if (m_isHeadless)
+	{
+		internResourceName(shaderName);
+		return nullptr;
+	}
+
+	const MappedFile vertexFile = mapFile(vertexPath);
+	const std::string_view vertexShtring = vertexFile.view();
 	if (vertexShtring.empty())
 	{
 		std::cerr << "No vertex shader" << std::endl;
 		return nullptr;
 	}
 
-	std::string fragmentShtring = getFileString(fragmentPath);
+	const MappedFile fragmentFile = mapFile(fragmentPath);
+	const std::string_view fragmentShtring = fragmentFile.view();
 	if (fragmentShtring.empty())
 	{
 		std::cerr << "No fragment shader" << std::endl;
 		return nullptr;
 	}
-	std::shared_ptr<RenderEngine::ShaderProgram>& newShader = m_shaderPrograms.emplace(shaderName, std::make_shared<RenderEngine::ShaderProgram>(vertexShtring, fragmentShtring)).first ->second;
+	std::shared_ptr<RenderEngine::ShaderProgram>& newShader = *m_shaderPrograms.emplace(internResourceName(shaderName), std::make_shared<RenderEngine::ShaderProgram>(vertexShtring, fragmentShtring,
+																										getShaderBinaryCachePath(shaderName, vertexShtring, fragmentShtring))).first;
 	if (newShader->isCompiled())
 	{
 		return newShader;
@@ -73,12 +156,17 @@ std::shared_ptr<RenderEngine::ShaderProgram> ResourceManager::loadShaders(const
 
 std::shared_ptr<RenderEngine::ShaderProgram> ResourceManager::getShaderProgram(const std::string& shaderName)
 {
-	ShaderProgramsMap::const_iterator it = m_shaderPrograms.find(shaderName);
-	if (it != m_shaderPrograms.end())
+	return getShaderProgram(ResourceID(shaderName));
+}
+
+std::shared_ptr<RenderEngine::ShaderProgram> ResourceManager::getShaderProgram(const ResourceID shaderID)
+{
+	const auto pShaderProgram = m_shaderPrograms.find(shaderID);
+	if (pShaderProgram)
 	{
-		return it->second;
+		return *pShaderProgram;
 	}
-	std::cerr << "Can't find the shader program: " << shaderName << std::endl;
+	std::cerr << "Can't find the shader program: " << getResourceName(shaderID) << std::endl;
 	return nullptr;
 }
 
@@ -88,31 +176,180 @@ std::shared_ptr<RenderEngine::Texture2D> ResourceManager::loadTexture(const std:
 	int widht = 0;
 	int height = 0;
 
-	stbi_set_flip_vertically_on_load(true);
-	unsigned char* pixels = stbi_load(std::string(m_path + "/" + texturePath).c_str(), &widht, &height, &channels, 0);
-	
-	if (!pixels)
+	// only the header is read here, the pixels are decoded when the texture is first bound
+	const MappedFile textureFile = mapFile(texturePath);
+	if (textureFile.size() == 0 || !stbi_info_from_memory(textureFile.data(), static_cast<int>(textureFile.size()), &widht, &height, &channels))
 	{
 		std::cerr << "Can't load image: " << texturePath << std::endl;
 		return nullptr;
 	}
 
-	std::shared_ptr<RenderEngine::Texture2D> newTexture = m_textures.emplace(textureName, std::make_shared<RenderEngine::Texture2D>(widht, height,
-																															pixels, channels, 
+	const ResourceID textureID = internResourceName(textureName);
+	std::shared_ptr<RenderEngine::Texture2D> newTexture = *m_textures.emplace(textureID, std::make_shared<RenderEngine::Texture2D>(widht, height,
+																													[textureID, texturePath](RenderEngine::Texture2D& texture)
+																													{
+																														materializeTexture(textureID, texturePath, texture);
+																													},
+																													channels,
 																													GL_NEAREST,
-																													GL_CLAMP_TO_EDGE)).first->second;
-	stbi_image_free(pixels);
+																													GL_CLAMP_TO_EDGE)).first;
 	return newTexture;
 }
 
+void ResourceManager::materializeTexture(const ResourceID textureID, const std::string& texturePath, RenderEngine::Texture2D& texture)
+{
+	DecodedImage* pDecodedImage = m_decodedImages.find(textureID);
+	if (pDecodedImage && pDecodedImage->pPixels)
+	{
+		pDecodedImage->lastUseFrame = RenderEngine::Renderer::getFrameIndex();
+		texture.upload(pDecodedImage->pPixels.get());
+		return;
+	}
+
+	int channels = 0;
+	int widht = 0;
+	int height = 0;
+
+	const MappedFile textureFile = mapFile(texturePath);
+	stbi_set_flip_vertically_on_load(true);
+	unsigned char* pixels = stbi_load_from_memory(textureFile.data(), static_cast<int>(textureFile.size()), &widht, &height, &channels, 0);
+	if (!pixels)
+	{
+		std::cerr << "Can't load image: " << texturePath << std::endl;
+		return;
+	}
+
+	texture.upload(pixels);
+	if (m_cpuMemoryBudget == 0)
+	{
+		stbi_image_free(pixels);
+		return;
+	}
+
+	DecodedImage& decodedImage = *m_decodedImages.emplace(textureID, DecodedImage{}).first;
+	decodedImage.pPixels = std::shared_ptr<unsigned char>(pixels, stbi_image_free);
+	decodedImage.size = static_cast<size_t>(widht) * height * channels;
+	decodedImage.lastUseFrame = RenderEngine::Renderer::getFrameIndex();
+}
+
+void ResourceManager::setMemoryBudget(const size_t cpuBytes, const size_t gpuBytes)
+{
+	m_cpuMemoryBudget = cpuBytes;
+	m_gpuMemoryBudget = gpuBytes;
+}
+
+size_t ResourceManager::getResidentCPUMemory()
+{
+	size_t cpuMemory = 0;
+	m_decodedImages.forEach([&cpuMemory](const ResourceID, const DecodedImage& decodedImage)
+		{
+			cpuMemory += decodedImage.pPixels ? decodedImage.size : 0;
+		}
+	);
+	return cpuMemory;
+}
+
+size_t ResourceManager::getResidentGPUMemory()
+{
+	size_t gpuMemory = 0;
+	m_textures.forEach([&gpuMemory](const ResourceID, const std::shared_ptr<RenderEngine::Texture2D>& pTexture)
+		{
+			gpuMemory += pTexture->getMemorySize();
+		}
+	);
+	for (const auto& currentSprite : m_sprites)
+	{
+		gpuMemory += currentSprite->getMemorySize();
+	}
+	return gpuMemory;
+}
+
+void ResourceManager::enforceMemoryBudget()
+{
+	PROFILE_ZONE("ResourceManager::enforceMemoryBudget");
+	const uint64_t currentFrame = RenderEngine::Renderer::getFrameIndex();
+
+	size_t gpuMemory = getResidentGPUMemory();
+	if (gpuMemory > m_gpuMemoryBudget)
+	{
+		struct ResidentResource
+		{
+			uint64_t lastUseFrame;
+			size_t size;
+			RenderEngine::Texture2D* pTexture;
+			const RenderEngine::Sprite* pSprite;
+		};
+		std::vector<ResidentResource> residentResources;
+		m_textures.forEach([&residentResources](const ResourceID, const std::shared_ptr<RenderEngine::Texture2D>& pTexture)
+			{
+				if (pTexture->isResident())
+				{
+					residentResources.push_back({ pTexture->getLastUseFrame(), pTexture->getMemorySize(), pTexture.get(), nullptr });
+				}
+			}
+		);
+		for (const auto& currentSprite : m_sprites)
+		{
+			if (currentSprite->isResident())
+			{
+				residentResources.push_back({ currentSprite->getLastUseFrame(), currentSprite->getMemorySize(), nullptr, currentSprite.get() });
+			}
+		}
+		std::sort(residentResources.begin(), residentResources.end(), [](const ResidentResource& a, const ResidentResource& b)
+			{
+				return a.lastUseFrame < b.lastUseFrame;
+			}
+		);
+
+		for (const auto& currentResource : residentResources)
+		{
+			if (gpuMemory <= m_gpuMemoryBudget || currentResource.lastUseFrame == currentFrame)
+			{
+				break;
+			}
+			if (currentResource.pTexture)
+			{
+				currentResource.pTexture->release();
+			}
+			else
+			{
+				currentResource.pSprite->release();
+			}
+			gpuMemory -= currentResource.size;
+		}
+	}
+
+	size_t cpuMemory = getResidentCPUMemory();
+	while (cpuMemory > m_cpuMemoryBudget)
+	{
+		DecodedImage* pOldestImage = nullptr;
+		m_decodedImages.forEach([&pOldestImage](const ResourceID, DecodedImage& decodedImage)
+			{
+				if (decodedImage.pPixels && (!pOldestImage || decodedImage.lastUseFrame < pOldestImage->lastUseFrame))
+				{
+					pOldestImage = &decodedImage;
+				}
+			}
+		);
+		cpuMemory -= pOldestImage->size;
+		pOldestImage->pPixels.reset();
+	}
+	publishMemoryMetrics(cpuMemory, gpuMemory);
+}
+
 std::shared_ptr<RenderEngine::Texture2D> ResourceManager::getTexture(const std::string& textureName)
 {
-	TexturesMap::const_iterator it = m_textures.find(textureName);
-	if (it != m_textures.end())
+	return getTexture(ResourceID(textureName));
+}
+
+std::shared_ptr<RenderEngine::Texture2D> ResourceManager::getTexture(const ResourceID textureID)
+{
+	const auto pTexture = m_textures.find(textureID);
+	if (pTexture)
 	{
-		return it->second;
+		return *pTexture;
 	}
-	std::cerr << "Can't find the texture: " << textureName << std::endl;
+	std::cerr << "Can't find the texture: " << getResourceName(textureID) << std::endl;
 	return nullptr;
 }
 
@@ -125,29 +362,48 @@ std::shared_ptr<RenderEngine::Sprite> ResourceManager::loadSprite(const std::str
 		std::cerr << "Can't find the texture: " << textureName << "for the sprite "<< spriteName << std::endl;
 	}
 
-	auto pShader = getShaderProgram(shaderName);
-	if (!pShader)
+	auto pShader = m_isHeadless ? nullptr : getShaderProgram(shaderName);
+	if (!pShader && !m_isHeadless)
 	{
 		std::cerr << "Can't find the shader: " << shaderName << "for the sprite " << spriteName << std::endl;
 	}
 
-	std::shared_ptr<RenderEngine::Sprite> newSprite = m_sprites.emplace(spriteName, std::make_shared<RenderEngine::Sprite>(pTexture, subTextureName,
-																								pShader)).first->second;
+	const auto [pSpriteHandle, isInserted] = m_spriteHandles.emplace(internResourceName(spriteName), static_cast<SpriteHandle>(m_sprites.size()));
+	if (isInserted)
+	{
+		m_sprites.emplace_back(std::make_shared<RenderEngine::Sprite>(pTexture, subTextureName, pShader));
+	}
 
-	return newSprite;
+	return m_sprites[static_cast<size_t>(*pSpriteHandle)];
 }
 
 std::shared_ptr<RenderEngine::Sprite> ResourceManager::getSprite(const std::string& spriteName)
 {
-	SpritesMap::const_iterator it = m_sprites.find(spriteName);
-	if (it != m_sprites.end())
+	return getSprite(ResourceID(spriteName));
+}
+
+std::shared_ptr<RenderEngine::Sprite> ResourceManager::getSprite(const ResourceID spriteID)
+{
+	const SpriteHandle spriteHandle = getSpriteHandle(spriteID);
+	if (spriteHandle != SpriteHandle::Invalid)
 	{
-		return it->second;
+		return m_sprites[static_cast<size_t>(spriteHandle)];
 	}
-	std::cerr << "Can't find the sprite: " << spriteName << std::endl;
+	std::cerr << "Can't find the sprite: " << getResourceName(spriteID) << std::endl;
 	return nullptr;
 }
 
+ResourceManager::SpriteHandle ResourceManager::getSpriteHandle(const ResourceID spriteID)
+{
+	const SpriteHandle* pSpriteHandle = m_spriteHandles.find(spriteID);
+	return pSpriteHandle ? *pSpriteHandle : SpriteHandle::Invalid;
+}
+
+const std::shared_ptr<RenderEngine::Sprite>& ResourceManager::getSprite(const SpriteHandle spriteHandle)
+{
+	return m_sprites[static_cast<size_t>(spriteHandle)];
+}
+
 std::shared_ptr<RenderEngine::Texture2D> ResourceManager::loadTextureAtlas(std::string textureName, std::string texturePath,
 																std::vector<std::string> subTextures,
 																const unsigned int subTextureWidth, const unsigned int subTextureHeight)
@@ -178,15 +434,17 @@ std::shared_ptr<RenderEngine::Texture2D> ResourceManager::loadTextureAtlas(std::
 
 bool ResourceManager::loadJSONResources(const std::string& JSONPath)
 {
-	const std::string JSONString = getFileString(JSONPath);
+	const MappedFile JSONFile = mapFile(JSONPath);
+	const std::string_view JSONString = JSONFile.view();
 	if (JSONString.empty())
 	{
 		std::cerr << "No JSON resources file!" << std::endl;
 		return false;
 	}
 
+	// the mapping is read-only and not NUL-terminated, so parse by length instead of in situ
 	rapidjson::Document document;
-	rapidjson::ParseResult parseResult = document.Parse(JSONString.c_str());
+	rapidjson::ParseResult parseResult = document.Parse(JSONString.data(), JSONString.size());
 	if (!parseResult)
 	{
 		std::cerr << "JSON parse error: " << rapidjson::GetParseError_En(parseResult.Code()) << "(" << parseResult.Offset() << ")" << std::endl;
@@ -194,6 +452,21 @@ bool ResourceManager::loadJSONResources(const std::string& JSONPath)
 		return false;
 	}
 
+	auto memoryBudgetIt = document.FindMember("memoryBudget");
+	if (memoryBudgetIt != document.MemberEnd())
+	{
+		const rapidjson::Value& memoryBudget = memoryBudgetIt->value;
+		const auto isByteCount = [&memoryBudget](const char* key) { return memoryBudget.HasMember(key) && memoryBudget[key].IsUint64(); };
+		if (memoryBudget.IsObject() && isByteCount("cpuBytes") && isByteCount("gpuBytes"))
+		{
+			setMemoryBudget(memoryBudget["cpuBytes"].GetUint64(), memoryBudget["gpuBytes"].GetUint64());
+		}
+		else
+		{
+			std::cerr << "memoryBudget needs cpuBytes and gpuBytes as byte counts, the default budget is kept" << std::endl;
+		}
+	}
+
 	auto shadersIt = document.FindMember( "shaders" );
 	if (shadersIt != document.MemberEnd())
 	{
@@ -248,11 +521,11 @@ bool ResourceManager::loadJSONResources(const std::string& JSONPath)
 				const auto framesArray = frimesIt->value.GetArray();
 				std::vector<RenderEngine::Sprite::FrameDescription> framesDescriptions;
 				framesDescriptions.reserve(framesArray.Size());
+				const auto pTextureAtlas = getTexture(textureAtlas);
 				for (const auto& currentFrame : framesArray)
 				{
 					const std::string subTextureStr = currentFrame["subTexture"].GetString();
 					const double duration = currentFrame["duration"].GetDouble();
-					const auto pTextureAtlas = getTexture(textureAtlas);
 					const auto pSubTexture = pTextureAtlas->getSubTexture(subTextureStr);
 					framesDescriptions.emplace_back(pSubTexture.leftBottomUV, pSubTexture.rightTopUV, duration);
 				}
@@ -267,27 +540,27 @@ bool ResourceManager::loadJSONResources(const std::string& JSONPath)
 		for (const auto& currentLevel : levelsIt->value.GetArray())
 		{
 			const auto description = currentLevel["description"].GetArray();
-			std::vector<std::string> levelRows;
-			levelRows.reserve(description.Size());
 			size_t maxLength = 0;
 			for (const auto& currentRow : description)
 			{
-  				levelRows.emplace_back(currentRow.GetString());
-				if (maxLength < levelRows.back().length())
+				if (maxLength < currentRow.GetStringLength())
 				{
-					maxLength = levelRows.back().length();
+					maxLength = currentRow.GetStringLength();
 				}
 			}
-			for (auto& currentRow : levelRows)
+			std::vector<std::string> levelRows;
+			levelRows.reserve(description.Size());
+			for (const auto& currentRow : description)
 			{
-				while (currentRow.length() < maxLength)
-				{
-					currentRow.append("D");
-				}
+				std::string& levelRow = levelRows.emplace_back();
+				levelRow.reserve(maxLength);
+				levelRow.assign(currentRow.GetString(), currentRow.GetStringLength());
+				levelRow.resize(maxLength, 'D');
 			}
 			m_levels.emplace_back(std::move(levelRows));
 		}
 	}
 
+	publishMemoryMetrics(getResidentCPUMemory(), getResidentGPUMemory());
 	return true;
 }
\ No newline at end of file
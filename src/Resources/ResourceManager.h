@@ -2,8 +2,9 @@
 
 #include <string>
 #include <memory>
-#include <map>
 #include <vector>
+#include "FlatHashMap.h"
+#include "MappedFile.h"
 
 namespace RenderEngine
 {
@@ -15,7 +16,17 @@ namespace RenderEngine
 class ResourceManager
 {
 public:
+	// Dense index into the loaded sprites, resolved once and valid until unloadAllResources()
+	enum class SpriteHandle : uint32_t
+	{
+		Invalid = 0xFFFFFFFF
+	};
+
 	static void setExecutablePath(const std::string& executablePath);
+	// Without a GL context shader programs are skipped; textures and sprite buffers are created on
+	// first render anyway, so game objects can be loaded and simulated headless.
+	static void setHeadless(const bool isHeadless) { m_isHeadless = isHeadless; }
+	static bool isHeadless() { return m_isHeadless; }
 	static void unloadAllResources();
 
 	~ResourceManager() = delete;
@@ -27,12 +38,27 @@ public:
 
 	static std::shared_ptr<RenderEngine::ShaderProgram> loadShaders(const std::string& shaderName, const std::string& vertexPath, const std::string& fragmentPath);
 	static std::shared_ptr<RenderEngine::ShaderProgram> getShaderProgram(const std::string& shaderName);
+	static std::shared_ptr<RenderEngine::ShaderProgram> getShaderProgram(const ResourceID shaderID);
 	static std::shared_ptr<RenderEngine::Texture2D> loadTexture(const std::string& textureName, const std::string& texturePath);
 	static std::shared_ptr<RenderEngine::Texture2D> getTexture(const std::string& textureName);
+	static std::shared_ptr<RenderEngine::Texture2D> getTexture(const ResourceID textureID);
 	
 	static std::shared_ptr<RenderEngine::Sprite> loadSprite(const std::string& spriteName, const std::string& textureName,
 													    const std::string& shaderName, const std::string& subTextureName = "default");
 	static std::shared_ptr<RenderEngine::Sprite> getSprite(const std::string& spriteName);
+	static std::shared_ptr<RenderEngine::Sprite> getSprite(const ResourceID spriteID);
+	static SpriteHandle getSpriteHandle(const ResourceID spriteID);
+	static const std::shared_ptr<RenderEngine::Sprite>& getSprite(const SpriteHandle spriteHandle);
+
+	static const std::string& getResourceName(const ResourceID resourceID);
+
+	// Textures and sprite GL objects are created on first use. Resources not used in the current frame
+	// are evicted least recently used first once the budget is exceeded. The CPU budget bounds the cache
+	// of decoded pixels kept for re-uploading evicted textures (0 - don't keep them).
+	static void setMemoryBudget(const size_t cpuBytes, const size_t gpuBytes);
+	static void enforceMemoryBudget();
+	static size_t getResidentCPUMemory();
+	static size_t getResidentGPUMemory();
 
 	static std::shared_ptr<RenderEngine::Texture2D> loadTextureAtlas(std::string textureName, std::string texturePath,
 																 std::vector<std::string> subTexures,
@@ -42,17 +68,35 @@ public:
 	static const std::vector<std::vector<std::string>>& getLevels() { return m_levels; }
 
 private:
-	static std::string getFileString(const std::string& relativefilePath);
-	typedef std::map<const std::string, std::shared_ptr<RenderEngine::ShaderProgram>>ShaderProgramsMap;
+	static MappedFile mapFile(const std::string& relativeFilePath);
+	static std::string getShaderBinaryCachePath(const std::string& shaderName, const std::string_view vertexString, const std::string_view fragmentString);
+	static ResourceID internResourceName(const std::string& resourceName);
+	static void materializeTexture(const ResourceID textureID, const std::string& texturePath, RenderEngine::Texture2D& texture);
+
+	struct DecodedImage
+	{
+		std::shared_ptr<unsigned char> pPixels;
+		size_t size = 0;
+		uint64_t lastUseFrame = 0;
+	};
+	static FlatHashMap<DecodedImage> m_decodedImages;
+	static size_t m_cpuMemoryBudget;
+	static size_t m_gpuMemoryBudget;
+
+	typedef FlatHashMap<std::shared_ptr<RenderEngine::ShaderProgram>>ShaderProgramsMap;
 	static ShaderProgramsMap m_shaderPrograms;
 
-	typedef std::map<const std::string, std::shared_ptr<RenderEngine::Texture2D>>TexturesMap;
+	typedef FlatHashMap<std::shared_ptr<RenderEngine::Texture2D>>TexturesMap;
 	static TexturesMap m_textures;
 
-	typedef std::map<const std::string, std::shared_ptr<RenderEngine::Sprite>>SpritesMap;
-	static SpritesMap m_sprites;
+	typedef FlatHashMap<SpriteHandle>SpriteHandlesMap;
+	static SpriteHandlesMap m_spriteHandles;
+	static std::vector<std::shared_ptr<RenderEngine::Sprite>> m_sprites;
+
+	static FlatHashMap<std::string> m_resourceNames;
 	
 	static std::vector<std::vector<std::string>> m_levels;
 
 	static std::string m_path;
+	static bool m_isHeadless;
 };
\ No newline at end of file
@@ -0,0 +1,275 @@
+#include "BotClient.h"
+#include "ServerProtocol.h"
+#include "../Game/Game.h"
+#include "../Network/Packet.h"
+
+#include <fstream>
+#include <sstream>
+
+BotClient::BotClient(const NetAddress& serverAddress, const uint32_t seed)
+	: m_serverAddress(serverAddress)
+	, m_random(seed)
+	, m_isJoined(false)
+	, m_isSpectator(false)
+	, m_updatesCount(0)
+	, m_scriptStep(0)
+	, m_scriptStepTicks(0)
+	, m_roomID(0)
+	, m_player(0)
+	, m_input(0)
+	, m_inputSequence(0)
+	, m_lastSnapshotTick(ServerProtocol::NO_TICK)
+	, m_lastSnapshotSlot(0)
+{
+	for (Snapshot& currentSnapshot : m_snapshots)
+	{
+		currentSnapshot.clear(ServerProtocol::NO_TICK);
+	}
+}
+
+bool BotClient::open()
+{
+	return m_socket.open(0);
+}
+
+void BotClient::setScript(std::shared_ptr<const std::vector<ScriptStep>> pScript)
+{
+	m_pScript = std::move(pScript);
+	m_scriptStep = m_pScript && !m_pScript->empty() ? m_random() % m_pScript->size() : 0;
+	m_scriptStepTicks = 0;
+}
+
+bool BotClient::loadScript(const std::string& path, std::vector<ScriptStep>& script)
+{
+	std::ifstream file(path);
+	if (!file)
+	{
+		return false;
+	}
+	script.clear();
+	std::string line;
+	while (std::getline(file, line))
+	{
+		line = line.substr(0, line.find('#'));
+		std::istringstream stream(line);
+		ScriptStep step = {};
+		std::string keys;
+		if (!(stream >> step.ticksCount))
+		{
+			continue;
+		}
+		if (!(stream >> keys) || step.ticksCount == 0)
+		{
+			return false;
+		}
+		for (const char currentKey : keys)
+		{
+			switch (currentKey)
+			{
+			case 'U': step.input |= Game::INPUT_UP; break;
+			case 'D': step.input |= Game::INPUT_DOWN; break;
+			case 'L': step.input |= Game::INPUT_LEFT; break;
+			case 'R': step.input |= Game::INPUT_RIGHT; break;
+			case 'F': step.input |= Game::INPUT_FIRE; break;
+			case '-': break;
+			default: return false;
+			}
+		}
+		script.push_back(step);
+	}
+	return !script.empty();
+}
+
+void BotClient::spectate(const uint32_t roomID)
+{
+	m_isSpectator = true;
+	m_roomID = roomID;
+}
+
+const Snapshot& BotClient::getLastSnapshot() const
+{
+	return m_snapshots[m_lastSnapshotSlot];
+}
+
+void BotClient::update()
+{
+	receivePackets();
+	sendPackets();
+}
+
+void BotClient::receivePackets()
+{
+	std::array<uint8_t, UDPSocket::MAX_PACKET_SIZE> buffer;
+	NetAddress address;
+	for (size_t size = m_socket.receive(address, buffer.data(), buffer.size()); size > 0; size = m_socket.receive(address, buffer.data(), buffer.size()))
+	{
+		if (address == m_serverAddress)
+		{
+			PacketReader reader(buffer.data(), size);
+			handlePacket(reader, size);
+		}
+	}
+}
+
+void BotClient::sendPackets()
+{
+	if (m_isSpectator)
+	{
+		// asks to watch until the stream comes, then keeps the slot alive once a second
+		if (!m_isJoined || m_updatesCount % static_cast<uint32_t>(Game::TICK_RATE) == 0)
+		{
+			PacketWriter writer;
+			writer.write(ServerProtocol::MAGIC);
+			writer.write(ServerProtocol::SPECTATE);
+			writer.write(m_roomID);
+			m_socket.send(m_serverAddress, writer.getData(), writer.getSize());
+		}
+		++m_updatesCount;
+		return;
+	}
+	if (!m_isJoined)
+	{
+		PacketWriter writer;
+		writer.write(ServerProtocol::MAGIC);
+		writer.write(ServerProtocol::JOIN);
+		m_socket.send(m_serverAddress, writer.getData(), writer.getSize());
+		return;
+	}
+	updateInput();
+	sendInput();
+}
+
+void BotClient::updateInput()
+{
+	if (m_pScript && !m_pScript->empty())
+	{
+		if (m_scriptStepTicks >= (*m_pScript)[m_scriptStep].ticksCount)
+		{
+			m_scriptStep = (m_scriptStep + 1) % m_pScript->size();
+			m_scriptStepTicks = 0;
+		}
+		m_input = (*m_pScript)[m_scriptStep].input;
+		++m_scriptStepTicks;
+		return;
+	}
+	// a player holds a direction for a while and fires now and then
+	static constexpr uint8_t directions[] = { 0, Game::INPUT_UP, Game::INPUT_DOWN, Game::INPUT_LEFT, Game::INPUT_RIGHT };
+	m_input &= ~Game::INPUT_FIRE;
+	if (m_random() % 20 == 0)
+	{
+		m_input = directions[m_random() % 5];
+	}
+	if (m_random() % 8 == 0)
+	{
+		m_input |= Game::INPUT_FIRE;
+	}
+}
+
+void BotClient::leave()
+{
+	if (m_isJoined || m_isSpectator)
+	{
+		PacketWriter writer;
+		writer.write(ServerProtocol::MAGIC);
+		writer.write(ServerProtocol::LEAVE);
+		m_socket.send(m_serverAddress, writer.getData(), writer.getSize());
+		m_isJoined = false;
+	}
+}
+
+void BotClient::sendInput()
+{
+	PacketWriter writer;
+	writer.write(ServerProtocol::MAGIC);
+	writer.write(ServerProtocol::INPUT);
+	writer.write(m_roomID);
+	writer.write(m_player);
+	writer.write(++m_inputSequence);
+	writer.write(m_input);
+	writer.write(m_lastSnapshotTick);
+	m_socket.send(m_serverAddress, writer.getData(), writer.getSize());
+	++m_stats.inputsSentCount;
+}
+
+void BotClient::handlePacket(PacketReader& reader, const size_t size)
+{
+	const uint32_t magic = reader.read<uint32_t>();
+	const uint8_t type = reader.read<uint8_t>();
+	if (reader.hasFailed() || magic != ServerProtocol::MAGIC)
+	{
+		return;
+	}
+	if (type == ServerProtocol::WELCOME)
+	{
+		const uint32_t roomID = reader.read<uint32_t>();
+		const uint8_t player = reader.read<uint8_t>();
+		if (!reader.hasFailed())
+		{
+			m_isJoined = true;
+			m_roomID = roomID;
+			m_player = player;
+		}
+		return;
+	}
+	const bool isSpectatorSnapshot = type == ServerProtocol::SPECTATOR_SNAPSHOT && m_isSpectator;
+	if (!isSpectatorSnapshot && (type != ServerProtocol::SNAPSHOT || !m_isJoined || m_isSpectator))
+	{
+		return;
+	}
+
+	const uint32_t roomID = reader.read<uint32_t>();
+	const uint32_t tick = reader.read<uint32_t>();
+	const uint32_t baselineTick = reader.read<uint32_t>();
+	// an older snapshot that arrived late changes nothing
+	if (reader.hasFailed() || roomID != m_roomID || (m_lastSnapshotTick != ServerProtocol::NO_TICK && tick <= m_lastSnapshotTick))
+	{
+		return;
+	}
+	++m_stats.snapshotsCount;
+	m_stats.snapshotBytes += size;
+
+	static const Snapshot emptySnapshot;
+	const Snapshot* pBaseline = &emptySnapshot;
+	if (isSpectatorSnapshot && baselineTick != ServerProtocol::NO_TICK)
+	{
+		// the stream goes on from the previous spectator snapshot, after a lost one only a keyframe helps
+		if (!m_isJoined || baselineTick != m_lastSnapshotTick)
+		{
+			++m_stats.missingBaselinesCount;
+			return;
+		}
+		pBaseline = &m_snapshots[m_lastSnapshotSlot];
+	}
+	else if (baselineTick != ServerProtocol::NO_TICK)
+	{
+		pBaseline = nullptr;
+		for (const Snapshot& currentSnapshot : m_snapshots)
+		{
+			if (currentSnapshot.getTick() == baselineTick)
+			{
+				pBaseline = &currentSnapshot;
+				break;
+			}
+		}
+		if (!pBaseline)
+		{
+			++m_stats.missingBaselinesCount;
+			return;
+		}
+	}
+	// the slot of the oldest snapshot, never the baseline: the server doesn't use baselines that old
+	size_t slot = (m_lastSnapshotSlot + 1) % SNAPSHOT_HISTORY;
+	if (&m_snapshots[slot] == pBaseline)
+	{
+		slot = (slot + 1) % SNAPSHOT_HISTORY;
+	}
+	if (!m_snapshots[slot].decodeDelta(*pBaseline, tick, reader))
+	{
+		++m_stats.corruptSnapshotsCount;
+		m_snapshots[slot].clear(ServerProtocol::NO_TICK);
+		return;
+	}
+	m_lastSnapshotSlot = slot;
+	m_lastSnapshotTick = tick;
+	m_isJoined = true;
+}
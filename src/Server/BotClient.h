@@ -0,0 +1,91 @@
+#pragma once
+
+#include "../Network/UDPSocket.h"
+#include "Snapshot.h"
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+class PacketReader;
+
+// A client of the game server that plays random inputs: joins a room, sends its input every tick and
+// decodes the snapshots against the ones it acknowledged, like a real client would. A spectator bot
+// watches one room instead and decodes the spectator stream. Used to load and measure the server from
+// the same machine.
+class BotClient
+{
+public:
+	struct Stats
+	{
+		uint64_t snapshotsCount = 0;
+		uint64_t snapshotBytes = 0;
+		uint64_t inputsSentCount = 0;
+		// the baseline of a snapshot was not kept any more
+		uint64_t missingBaselinesCount = 0;
+		// the decoded snapshot didn't match the server's checksum
+		uint64_t corruptSnapshotsCount = 0;
+	};
+
+	// one step of a scripted bot: the input held for that many ticks
+	struct ScriptStep
+	{
+		uint32_t ticksCount;
+		uint8_t input;
+	};
+
+	BotClient(const NetAddress& serverAddress, const uint32_t seed);
+
+	bool open();
+	// Plays the steps in a loop instead of random inputs, every bot from its own step. A script file has
+	// a step per line: the ticks, then the held keys of "UDLRF" or "-" for none; '#' starts a comment.
+	void setScript(std::shared_ptr<const std::vector<ScriptStep>> pScript);
+	static bool loadScript(const std::string& path, std::vector<ScriptStep>& script);
+	// watches the room instead of playing, call it before the first update()
+	void spectate(const uint32_t roomID);
+	// one tick: receives everything that arrived, then asks to join or sends the input
+	void update();
+	// the two halves of update(), for a caller that receives as soon as the socket is readable
+	void receivePackets();
+	void sendPackets();
+	// the socket to wait on
+	intptr_t getNativeHandle() const { return m_socket.getNativeHandle(); }
+	void leave();
+
+	// a spectator is joined once it decoded a keyframe
+	bool isJoined() const { return m_isJoined; }
+	bool isSpectator() const { return m_isSpectator; }
+	uint32_t getRoomID() const { return m_roomID; }
+	uint32_t getLastSnapshotTick() const { return m_lastSnapshotTick; }
+	const Snapshot& getLastSnapshot() const;
+	const Stats& getStats() const { return m_stats; }
+
+private:
+	// snapshots kept to decode the ones sent against them, as many as the server keeps
+	static constexpr size_t SNAPSHOT_HISTORY = 32;
+
+	void handlePacket(PacketReader& reader, const size_t size);
+	void sendInput();
+	void updateInput();
+
+	NetAddress m_serverAddress;
+	UDPSocket m_socket;
+	std::mt19937 m_random;
+	bool m_isJoined;
+	bool m_isSpectator;
+	uint32_t m_updatesCount;
+	std::shared_ptr<const std::vector<ScriptStep>> m_pScript;
+	size_t m_scriptStep;
+	uint32_t m_scriptStepTicks;
+	uint32_t m_roomID;
+	uint8_t m_player;
+	uint8_t m_input;
+	uint32_t m_inputSequence;
+	uint32_t m_lastSnapshotTick;
+	size_t m_lastSnapshotSlot;
+	std::array<Snapshot, SNAPSHOT_HISTORY> m_snapshots;
+	Stats m_stats;
+};
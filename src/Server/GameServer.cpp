@@ -0,0 +1,370 @@
+#include "GameServer.h"
+#include "Room.h"
+#include "../Game/Game.h"
+#include "../Network/Packet.h"
+#include "../System/JobSystem.h"
+#include "../System/Metrics.h"
+#include "../System/Profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <thread>
+
+// behind by more ticks than that the server drops them instead of catching up
+static constexpr uint32_t MAX_TICKS_BEHIND = 8;
+
+GameServer::GameServer(const GameServerSettings& settings)
+	: m_settings(settings)
+	, m_nextJoinRoom(0)
+	, m_threadsCount(0)
+	, m_ticksCount(0)
+	, m_overrunTicksCount(0)
+	, m_totalTickTime(0.0)
+	, m_maxTickTime(0.0)
+	, m_runTime(0.0)
+	, m_publishedTicksCount(0)
+	, m_clientsCount(0)
+{
+	for (auto& currentTime : m_tickStartTimes)
+	{
+		currentTime.store(0, std::memory_order_relaxed);
+	}
+	for (auto& currentBucket : m_tickTimeHistogram)
+	{
+		currentBucket.store(0, std::memory_order_relaxed);
+	}
+}
+
+GameServer::~GameServer()
+{
+	m_rooms.clear();
+}
+
+bool GameServer::init()
+{
+	NetworkEngineSettings networkSettings;
+	networkSettings.port = m_settings.port;
+	networkSettings.bindAddress = m_settings.bindAddress;
+	networkSettings.ioThreadsCount = m_settings.ioThreadsCount;
+	networkSettings.useIoUring = m_settings.useIoUring;
+	if (!m_network.open(networkSettings))
+	{
+		return false;
+	}
+	m_rooms.reserve(m_settings.roomsCount);
+	for (uint32_t currentRoom = 0; currentRoom < m_settings.roomsCount; ++currentRoom)
+	{
+		m_rooms.emplace_back(std::make_unique<Room>(currentRoom, m_settings.levelIndex, m_settings.snapshotInterval,
+															   glm::ivec2(m_settings.viewSize), m_settings.viewMargin, m_settings.spectatorKeyframeInterval));
+		if (!m_rooms.back()->init())
+		{
+			std::cerr << "Can't create room " << currentRoom << " with level " << m_settings.levelIndex << std::endl;
+			return false;
+		}
+	}
+	return true;
+}
+
+void GameServer::run(const std::atomic<bool>& isRunning)
+{
+	PROFILE_THREAD("Server");
+	JobSystem::init(m_settings.threadsCount > 0 ? m_settings.threadsCount : std::thread::hardware_concurrency());
+	m_threadsCount = JobSystem::getThreadsCount();
+	m_network.start();
+
+	using Clock = std::chrono::steady_clock;
+	const auto tickDuration = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::milli>(Game::TICK_DURATION));
+	const auto reportInterval = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(m_settings.reportInterval));
+	const auto startTime = Clock::now();
+	auto nextTickTime = startTime;
+	auto nextReportTime = startTime + reportInterval;
+	Stats lastReportStats;
+	while (isRunning.load(std::memory_order_relaxed))
+	{
+		// inputs are applied as they come until the tick is due, the receive queues never fill up
+		for (auto currentTime = Clock::now(); currentTime < nextTickTime; currentTime = Clock::now())
+		{
+			std::this_thread::sleep_until(std::min(nextTickTime, currentTime + std::chrono::milliseconds(1)));
+			receive();
+		}
+		receive();
+		tick();
+
+		nextTickTime += tickDuration;
+		const auto currentTime = Clock::now();
+		if (currentTime > nextTickTime + tickDuration * MAX_TICKS_BEHIND)
+		{
+			nextTickTime = currentTime;
+		}
+		if (m_settings.reportInterval > 0.0 && currentTime >= nextReportTime)
+		{
+			nextReportTime += reportInterval;
+			m_runTime = std::chrono::duration<double>(currentTime - startTime).count();
+			printReport(getStats(), lastReportStats);
+		}
+	}
+	m_runTime = std::chrono::duration<double>(Clock::now() - startTime).count();
+	m_network.stop();
+	JobSystem::terminate();
+}
+
+void GameServer::receive()
+{
+	PROFILE_ZONE("GameServer::receive");
+	m_network.receive([this](const NetPacket& packet)
+		{
+			PacketReader reader(packet.data, packet.size);
+			handlePacket(packet.address, reader);
+		}
+	);
+}
+
+void GameServer::handlePacket(const NetAddress& address, PacketReader& reader)
+{
+	const uint32_t magic = reader.read<uint32_t>();
+	const uint8_t type = reader.read<uint8_t>();
+	if (reader.hasFailed() || magic != ServerProtocol::MAGIC)
+	{
+		return;
+	}
+	const auto client = m_clients.find(getAddressKey(address));
+	switch (type)
+	{
+	case ServerProtocol::JOIN:
+	{
+		if (client != m_clients.end())
+		{
+			// the welcome got lost
+			sendWelcome(address, *m_rooms[client->second / Game::MAX_PLAYERS], client->second % Game::MAX_PLAYERS);
+			return;
+		}
+		// rooms fill up one after the other, the clients get to play with each other
+		for (size_t currentRoom = 0; currentRoom < m_rooms.size(); ++currentRoom)
+		{
+			const size_t roomIndex = (m_nextJoinRoom + currentRoom) % m_rooms.size();
+			const int player = m_rooms[roomIndex]->join(address);
+			if (player >= 0)
+			{
+				m_nextJoinRoom = roomIndex;
+				m_clients.emplace(getAddressKey(address), roomIndex * Game::MAX_PLAYERS + static_cast<size_t>(player));
+				sendWelcome(address, *m_rooms[roomIndex], static_cast<size_t>(player));
+				return;
+			}
+		}
+		// every room is full, the client asks again
+		return;
+	}
+	case ServerProtocol::INPUT:
+	{
+		const uint32_t roomID = reader.read<uint32_t>();
+		const uint8_t player = reader.read<uint8_t>();
+		const uint32_t sequence = reader.read<uint32_t>();
+		const uint8_t input = reader.read<uint8_t>();
+		const uint32_t ackedTick = reader.read<uint32_t>();
+		// the seat is the one the server gave the address, the packet's room and player only have to match it
+		if (reader.hasFailed() || client == m_clients.end() ||
+			roomID != client->second / Game::MAX_PLAYERS || player != client->second % Game::MAX_PLAYERS)
+		{
+			return;
+		}
+		m_rooms[client->second / Game::MAX_PLAYERS]->receiveInput(client->second % Game::MAX_PLAYERS, sequence, input, ackedTick);
+		return;
+	}
+	case ServerProtocol::SPECTATE:
+	{
+		const uint32_t roomID = reader.read<uint32_t>();
+		if (reader.hasFailed() || roomID >= m_rooms.size())
+		{
+			return;
+		}
+		// a spectator switching rooms leaves the one it watched
+		const auto spectator = m_spectators.find(getAddressKey(address));
+		if (spectator != m_spectators.end() && spectator->second != roomID)
+		{
+			m_rooms[spectator->second]->removeSpectator(address);
+		}
+		m_spectators[getAddressKey(address)] = roomID;
+		m_rooms[roomID]->addSpectator(address);
+		return;
+	}
+	case ServerProtocol::LEAVE:
+	{
+		if (client != m_clients.end())
+		{
+			m_rooms[client->second / Game::MAX_PLAYERS]->leave(client->second % Game::MAX_PLAYERS);
+			m_clients.erase(client);
+		}
+		const auto spectator = m_spectators.find(getAddressKey(address));
+		if (spectator != m_spectators.end())
+		{
+			m_rooms[spectator->second]->removeSpectator(address);
+			m_spectators.erase(spectator);
+		}
+		return;
+	}
+	default:
+		return;
+	}
+}
+
+void GameServer::sendWelcome(const NetAddress& address, const Room& room, const size_t player)
+{
+	PacketWriter writer;
+	writer.write(ServerProtocol::MAGIC);
+	writer.write(ServerProtocol::WELCOME);
+	writer.write(room.getRoomID());
+	writer.write(static_cast<uint8_t>(player));
+	writer.write(static_cast<uint32_t>(room.getLevelIndex()));
+	m_network.send(address, writer.getData(), writer.getSize());
+}
+
+void GameServer::dropSilentClients()
+{
+	const uint32_t timeoutTicks = static_cast<uint32_t>(m_settings.clientTimeout * Game::TICK_RATE);
+	for (auto currentClient = m_clients.begin(); currentClient != m_clients.end();)
+	{
+		Room& room = *m_rooms[currentClient->second / Game::MAX_PLAYERS];
+		const size_t player = currentClient->second % Game::MAX_PLAYERS;
+		if (room.getTicksCount() - room.getClientLastHeardTick(player) > timeoutTicks)
+		{
+			room.leave(player);
+			currentClient = m_clients.erase(currentClient);
+		}
+		else
+		{
+			++currentClient;
+		}
+	}
+
+	static thread_local std::vector<NetAddress> droppedAddresses;
+	droppedAddresses.clear();
+	for (const auto& currentRoom : m_rooms)
+	{
+		currentRoom->dropSilentSpectators(timeoutTicks, droppedAddresses);
+	}
+	for (const NetAddress& currentAddress : droppedAddresses)
+	{
+		m_spectators.erase(getAddressKey(currentAddress));
+	}
+}
+
+void GameServer::tick()
+{
+	PROFILE_ZONE("GameServer::tick");
+	static Metrics::Histogram& tickTimeHistogram = Metrics::histogram("battlecity_server_tick_seconds", "Wall time of one server tick over all rooms",
+																	   Metrics::TICK_TIME_BOUNDS);
+	static Metrics::Counter& overrunTicksCounter = Metrics::counter("battlecity_server_overrun_ticks_total", "Server ticks longer than the tick duration");
+	const auto startTime = std::chrono::steady_clock::now();
+	const uint64_t timestamp = NetworkEngine::now();
+	m_network.setTickTimestamp(timestamp);
+	m_tickStartTimes[(m_ticksCount + 1) % TICK_HISTORY].store(timestamp, std::memory_order_relaxed);
+	m_publishedTicksCount.store(m_ticksCount + 1, std::memory_order_release);
+	JobSystem::parallelFor(m_rooms.size(), 1, [this](const size_t begin, const size_t end)
+		{
+			for (size_t currentRoom = begin; currentRoom < end; ++currentRoom)
+			{
+				m_rooms[currentRoom]->tick(m_network);
+			}
+		}
+	);
+	const double tickTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+	++m_ticksCount;
+	m_totalTickTime += tickTime;
+	m_maxTickTime = std::max(m_maxTickTime, tickTime);
+	tickTimeHistogram.observe(tickTime / 1000.0);
+	if (tickTime > Game::TICK_DURATION)
+	{
+		++m_overrunTicksCount;
+		overrunTicksCounter.add();
+	}
+	const size_t bucket = std::min(static_cast<size_t>(tickTime * 1000.0) / TICK_TIME_BUCKET_WIDTH, TICK_TIME_BUCKETS_COUNT - 1);
+	m_tickTimeHistogram[bucket].fetch_add(1, std::memory_order_relaxed);
+	m_clientsCount.store(m_clients.size(), std::memory_order_relaxed);
+	if (m_ticksCount % static_cast<uint64_t>(Game::TICK_RATE) == 0)
+	{
+		dropSilentClients();
+		publishMetrics();
+	}
+}
+
+GameServer::Stats GameServer::getStats() const
+{
+	Stats stats;
+	stats.ticksCount = m_ticksCount;
+	stats.overrunTicksCount = m_overrunTicksCount;
+	stats.totalTickTime = m_totalTickTime;
+	stats.maxTickTime = m_maxTickTime;
+	for (const auto& currentRoom : m_rooms)
+	{
+		const Room::Stats& roomStats = currentRoom->getStats();
+		stats.totalRoomTime += roomStats.totalTickTime;
+		stats.roomTicksCount += roomStats.ticksCount;
+		stats.snapshotsSentCount += roomStats.snapshotsSentCount;
+		stats.snapshotBytesSent += roomStats.snapshotBytesSent;
+		stats.incompleteSnapshotsCount += roomStats.incompleteSnapshotsCount;
+		stats.fullSnapshotsCount += roomStats.fullSnapshotsCount;
+		stats.interestChangesCount += currentRoom->getInterestChangesCount();
+		stats.spectatorSnapshotsCount += roomStats.spectatorSnapshotsCount;
+		stats.spectatorKeyframesCount += roomStats.spectatorKeyframesCount;
+		stats.spectatorPacketsSentCount += roomStats.spectatorPacketsSentCount;
+		stats.spectatorBytesSent += roomStats.spectatorBytesSent;
+	}
+	stats.network = m_network.getStats();
+	stats.clientsCount = m_clients.size();
+	stats.spectatorsCount = m_spectators.size();
+	stats.runTime = m_runTime;
+	return stats;
+}
+
+void GameServer::publishMetrics() const
+{
+	static Metrics::Gauge& roomsGauge = Metrics::gauge("battlecity_server_rooms", "Rooms hosted by the server");
+	static Metrics::Gauge& clientsGauge = Metrics::gauge("battlecity_server_clients", "Clients playing in the rooms");
+	static Metrics::Gauge& spectatorsGauge = Metrics::gauge("battlecity_server_spectators", "Spectators watching the rooms");
+	static Metrics::Gauge& entitiesGauge = Metrics::gauge("battlecity_server_entities", "Objects in the worlds of all rooms");
+	size_t entitiesCount = 0;
+	for (const auto& currentRoom : m_rooms)
+	{
+		entitiesCount += currentRoom->getStats().entitiesCount;
+	}
+	roomsGauge.set(static_cast<double>(m_rooms.size()));
+	clientsGauge.set(static_cast<double>(m_clients.size()));
+	spectatorsGauge.set(static_cast<double>(m_spectators.size()));
+	entitiesGauge.set(static_cast<double>(entitiesCount));
+}
+
+uint64_t GameServer::getTickStartTime(const uint64_t tick) const
+{
+	const uint64_t ticksCount = m_publishedTicksCount.load(std::memory_order_acquire);
+	if (tick == 0 || tick > ticksCount || ticksCount - tick >= TICK_HISTORY - 1)
+	{
+		return 0;
+	}
+	return m_tickStartTimes[tick % TICK_HISTORY].load(std::memory_order_relaxed);
+}
+
+void GameServer::getTickTimeHistogram(std::array<uint64_t, TICK_TIME_BUCKETS_COUNT>& buckets) const
+{
+	for (size_t currentBucket = 0; currentBucket < TICK_TIME_BUCKETS_COUNT; ++currentBucket)
+	{
+		buckets[currentBucket] = m_tickTimeHistogram[currentBucket].load(std::memory_order_relaxed);
+	}
+}
+
+void GameServer::printReport(const Stats& stats, Stats& lastReportStats) const
+{
+	const uint64_t ticksCount = stats.ticksCount - lastReportStats.ticksCount;
+	const uint64_t roomTicksCount = stats.roomTicksCount - lastReportStats.roomTicksCount;
+	const double roomTime = roomTicksCount > 0 ? (stats.totalRoomTime - lastReportStats.totalRoomTime) / roomTicksCount : 0.0;
+	const double reportTime = stats.runTime - lastReportStats.runTime;
+	const double bytesPerClient = stats.clientsCount > 0 && reportTime > 0.0
+		? (stats.snapshotBytesSent - lastReportStats.snapshotBytesSent) / (stats.clientsCount * reportTime) : 0.0;
+	std::printf("%zu rooms, %zu clients: tick %.3f ms (max %.3f), %.4f ms per room, %.0f rooms per core, %.0f bytes per client per second, %llu overruns\n",
+				m_rooms.size(), stats.clientsCount, ticksCount > 0 ? (stats.totalTickTime - lastReportStats.totalTickTime) / ticksCount : 0.0,
+				stats.maxTickTime, roomTime, roomTime > 0.0 ? Game::TICK_DURATION / roomTime : 0.0, bytesPerClient,
+				static_cast<unsigned long long>(stats.overrunTicksCount - lastReportStats.overrunTicksCount));
+	std::fflush(stdout);
+	lastReportStats = stats;
+}
@@ -0,0 +1,141 @@
+#pragma once
+
+#include "../Network/NetworkEngine.h"
+#include "ServerProtocol.h"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class PacketReader;
+class Room;
+
+struct GameServerSettings
+{
+	uint16_t port = ServerProtocol::DEFAULT_PORT;
+	std::string bindAddress = "127.0.0.1";
+	uint32_t roomsCount = 64;
+	size_t levelIndex = 1;
+	// 0 - a job system thread per hardware thread
+	unsigned int threadsCount = 0;
+	// ticks between two snapshots sent to a client
+	uint32_t snapshotInterval = 2;
+	// snapshots between two keyframes of the spectator stream, a spectator that joins waits that long at most
+	uint32_t spectatorKeyframeInterval = 30;
+	// blocks a client sees around its tank, what is farther away isn't sent; 0 - the whole level
+	int viewSize = 0;
+	// blocks around the view whose objects are sent too, they are there before they come into view
+	int viewMargin = 2;
+	// a client not heard of for this many seconds loses its slot
+	double clientTimeout = 5.0;
+	// seconds between two report lines on stdout, 0 - no reports
+	double reportInterval = 0.0;
+	// event loop threads receiving and sending the packets
+	unsigned int ioThreadsCount = 1;
+	bool useIoUring = false;
+};
+
+// Authoritative headless server: many rooms in one process on a fixed tick, no GL. The I/O threads of
+// the network engine receive the clients' packets, the server thread drains them and applies them to the
+// rooms between ticks. Every tick the rooms are simulated in parallel on the job system and each queues
+// its snapshots from the thread that ticked it, the I/O threads send them.
+class GameServer
+{
+public:
+	// start times of the last ticks kept for getTickStartTime()
+	static constexpr size_t TICK_HISTORY = 256;
+	// the tick time histogram: buckets of TICK_TIME_BUCKET_WIDTH microseconds, the last one takes the rest
+	static constexpr size_t TICK_TIME_BUCKETS_COUNT = 1024;
+	static constexpr uint64_t TICK_TIME_BUCKET_WIDTH = 50;
+
+	struct Stats
+	{
+		uint64_t ticksCount = 0;
+		// ticks that took longer than Game::TICK_DURATION
+		uint64_t overrunTicksCount = 0;
+		// milliseconds of wall time for ticking all rooms
+		double totalTickTime = 0.0;
+		double maxTickTime = 0.0;
+		// milliseconds of thread time summed over the rooms
+		double totalRoomTime = 0.0;
+		uint64_t roomTicksCount = 0;
+		uint64_t snapshotsSentCount = 0;
+		uint64_t snapshotBytesSent = 0;
+		uint64_t incompleteSnapshotsCount = 0;
+		uint64_t fullSnapshotsCount = 0;
+		// entities that entered or left the view of a client
+		uint64_t interestChangesCount = 0;
+		uint64_t spectatorSnapshotsCount = 0;
+		uint64_t spectatorKeyframesCount = 0;
+		uint64_t spectatorPacketsSentCount = 0;
+		uint64_t spectatorBytesSent = 0;
+		size_t spectatorsCount = 0;
+		NetworkEngine::Stats network;
+		size_t clientsCount = 0;
+		// seconds since run() started
+		double runTime = 0.0;
+	};
+
+	explicit GameServer(const GameServerSettings& settings);
+	~GameServer();
+
+	GameServer(const GameServer&) = delete;
+	GameServer& operator = (const GameServer&) = delete;
+
+	// opens the sockets and creates the rooms
+	bool init();
+	// ticks until isRunning turns false, call it on the thread that owns the job system it starts
+	void run(const std::atomic<bool>& isRunning);
+	uint16_t getPort() const { return m_network.getPort(); }
+	const char* getNetworkBackendName() const { return m_network.getBackendName(); }
+	unsigned int getThreadsCount() const { return m_threadsCount; }
+	// complete after run() returned
+	Stats getStats() const;
+
+	// The ones below may be called from any thread while the server runs.
+	// NetworkEngine::now() at the start of the tick, 0 when the tick is not one of the last TICK_HISTORY ones.
+	// The rooms tick in step with the server, the tick of a snapshot is the server's tick.
+	uint64_t getTickStartTime(const uint64_t tick) const;
+	// ticks so far in every bucket of the tick time histogram
+	void getTickTimeHistogram(std::array<uint64_t, TICK_TIME_BUCKETS_COUNT>& buckets) const;
+	size_t getClientsCount() const { return m_clientsCount.load(std::memory_order_relaxed); }
+	NetworkEngine::Stats getNetworkStats() const { return m_network.getStats(); }
+
+private:
+	void receive();
+	void handlePacket(const NetAddress& address, PacketReader& reader);
+	void sendWelcome(const NetAddress& address, const Room& room, const size_t player);
+	void dropSilentClients();
+	// the gauges of the metrics registry, once a second between the ticks
+	void publishMetrics() const;
+	void tick();
+	void printReport(const Stats& stats, Stats& lastReportStats) const;
+
+	static uint64_t getAddressKey(const NetAddress& address) { return static_cast<uint64_t>(address.ip) << 16 | address.port; }
+
+	GameServerSettings m_settings;
+	NetworkEngine m_network;
+	std::vector<std::unique_ptr<Room>> m_rooms;
+	// client address -> room index * Game::MAX_PLAYERS + player
+	std::unordered_map<uint64_t, size_t> m_clients;
+	// spectator address -> room index
+	std::unordered_map<uint64_t, size_t> m_spectators;
+	// joining clients are spread over the rooms from here
+	size_t m_nextJoinRoom;
+	unsigned int m_threadsCount;
+
+	uint64_t m_ticksCount;
+	uint64_t m_overrunTicksCount;
+	double m_totalTickTime;
+	double m_maxTickTime;
+	double m_runTime;
+	// written by the server thread only, read by anyone
+	std::atomic<uint64_t> m_publishedTicksCount;
+	std::array<std::atomic<uint64_t>, TICK_HISTORY> m_tickStartTimes;
+	std::array<std::atomic<uint64_t>, TICK_TIME_BUCKETS_COUNT> m_tickTimeHistogram;
+	std::atomic<size_t> m_clientsCount;
+};
@@ -0,0 +1,214 @@
+#include "InterestGrid.h"
+#include "../Game/GameObjects/IGameObject.h"
+#include "../Game/Level.h"
+#include "../Game/WorldHash.h"
+#include "../System/Profiler.h"
+
+#include <glm/common.hpp>
+
+#include <algorithm>
+
+static bool isMoving(const IGameObject::EObjectType objectType)
+{
+	return objectType == IGameObject::EObjectType::Tank || objectType == IGameObject::EObjectType::Bullet;
+}
+
+void InterestGrid::init(const glm::ivec2& levelSize, const glm::ivec2& viewSize, const int margin, const size_t viewersCount)
+{
+	const int blockSize = static_cast<int>(Level::BLOCK_SIZE);
+	m_cellsCount = glm::max((levelSize + blockSize - 1) / blockSize, glm::ivec2(1));
+	m_chunksCount = (m_cellsCount + CHUNK_SIZE - 1) / CHUNK_SIZE;
+	m_viewSize = glm::max(viewSize, glm::ivec2(1));
+	m_margin = std::max(margin, 0);
+	m_cellEntities.assign(static_cast<size_t>(m_cellsCount.x * m_cellsCount.y), {});
+	m_chunkEntities.assign(static_cast<size_t>(m_chunksCount.x * m_chunksCount.y), {});
+	m_entities.clear();
+	m_viewers.assign(viewersCount, {});
+	m_changesCount = 0;
+}
+
+int InterestGrid::getCellIndex(const glm::vec2& position) const
+{
+	const int x = std::clamp(static_cast<int>(position.x) / static_cast<int>(Level::BLOCK_SIZE), 0, m_cellsCount.x - 1);
+	const int y = std::clamp(static_cast<int>(position.y) / static_cast<int>(Level::BLOCK_SIZE), 0, m_cellsCount.y - 1);
+	return y * m_cellsCount.x + x;
+}
+
+int InterestGrid::getChunkIndex(const int cell) const
+{
+	return cell / m_cellsCount.x / CHUNK_SIZE * m_chunksCount.x + cell % m_cellsCount.x / CHUNK_SIZE;
+}
+
+bool InterestGrid::isVisible(const Viewer& viewer, const Entity& entity, const int cell) const
+{
+	if (cell < 0)
+	{
+		return false;
+	}
+	const int x = cell % m_cellsCount.x;
+	const int y = cell / m_cellsCount.x;
+	return entity.isStatic ? viewer.chunks.contains(x / CHUNK_SIZE, y / CHUNK_SIZE) : viewer.cells.contains(x, y);
+}
+
+void InterestGrid::setInterest(Viewer& viewer, const uint32_t entityID, const Snapshot::EInterest interest)
+{
+	if (viewer.interest.size() <= entityID)
+	{
+		viewer.interest.resize(m_entities.size(), Snapshot::EInterest::Send);
+	}
+	viewer.interest[entityID] = interest;
+}
+
+void InterestGrid::update()
+{
+	PROFILE_ZONE("InterestGrid::update");
+	const std::vector<IGameObject*>& objects = WorldHash::getObjects();
+	if (m_entities.size() < objects.size())
+	{
+		m_entities.resize(objects.size());
+	}
+	for (uint32_t currentEntity = 0; currentEntity < m_entities.size(); ++currentEntity)
+	{
+		IGameObject* pObject = currentEntity < objects.size() ? objects[currentEntity] : nullptr;
+		// objects without state are never in a snapshot
+		if (pObject && pObject->getStateHash() == 0)
+		{
+			pObject = nullptr;
+		}
+		Entity& entity = m_entities[currentEntity];
+		if (entity.pObject != pObject)
+		{
+			move(currentEntity, -1);
+			entity.pObject = pObject;
+			entity.isStatic = pObject && !isMoving(pObject->getObjectType());
+		}
+		if (!pObject || (entity.isStatic && entity.cell >= 0))
+		{
+			continue;
+		}
+		const int cell = getCellIndex(pObject->getCurrentPosition() + pObject->getSize() / 2.f);
+		if (cell != entity.cell)
+		{
+			move(currentEntity, cell);
+		}
+	}
+}
+
+void InterestGrid::move(const uint32_t entityID, const int cell)
+{
+	Entity& entity = m_entities[entityID];
+	const int previousCell = entity.cell;
+	if (previousCell == cell)
+	{
+		return;
+	}
+	std::vector<std::vector<uint32_t>>& lists = entity.isStatic ? m_chunkEntities : m_cellEntities;
+	if (previousCell >= 0)
+	{
+		std::vector<uint32_t>& list = lists[static_cast<size_t>(entity.isStatic ? getChunkIndex(previousCell) : previousCell)];
+		const auto position = std::find(list.begin(), list.end(), entityID);
+		*position = list.back();
+		list.pop_back();
+	}
+	if (cell >= 0)
+	{
+		lists[static_cast<size_t>(entity.isStatic ? getChunkIndex(cell) : cell)].push_back(entityID);
+	}
+	entity.cell = cell;
+
+	const Snapshot::EInterest hiddenInterest = entity.isStatic ? Snapshot::EInterest::Keep : Snapshot::EInterest::Drop;
+	for (Viewer& currentViewer : m_viewers)
+	{
+		const bool wasVisible = isVisible(currentViewer, entity, previousCell);
+		const bool isVisibleNow = isVisible(currentViewer, entity, cell);
+		// a new entity gets its interest even out of view, the ones past the end are sent
+		if (wasVisible != isVisibleNow || previousCell < 0)
+		{
+			setInterest(currentViewer, entityID, isVisibleNow ? Snapshot::EInterest::Send : hiddenInterest);
+			m_changesCount += wasVisible != isVisibleNow ? 1 : 0;
+		}
+	}
+}
+
+template<class TFunction>
+void InterestGrid::forEachCellOutside(const Rect& rect, const Rect& except, const TFunction& function)
+{
+	for (int y = rect.bottom; y <= rect.top; ++y)
+	{
+		for (int x = rect.left; x <= rect.right; ++x)
+		{
+			if (!except.contains(x, y))
+			{
+				function(x, y);
+			}
+		}
+	}
+}
+
+void InterestGrid::setViewerPosition(const size_t viewer, const glm::vec2& position)
+{
+	const int cell = getCellIndex(position);
+	Rect cells;
+	cells.left = std::max(cell % m_cellsCount.x - m_viewSize.x / 2 - m_margin, 0);
+	cells.bottom = std::max(cell / m_cellsCount.x - m_viewSize.y / 2 - m_margin, 0);
+	cells.right = std::min(cell % m_cellsCount.x - m_viewSize.x / 2 + m_viewSize.x - 1 + m_margin, m_cellsCount.x - 1);
+	cells.top = std::min(cell / m_cellsCount.x - m_viewSize.y / 2 + m_viewSize.y - 1 + m_margin, m_cellsCount.y - 1);
+	Viewer& currentViewer = m_viewers[viewer];
+	// the rectangle moves a cell now and then, most ticks nothing changes
+	if (cells == currentViewer.cells)
+	{
+		return;
+	}
+	Rect chunks;
+	chunks.left = cells.left / CHUNK_SIZE;
+	chunks.bottom = cells.bottom / CHUNK_SIZE;
+	chunks.right = cells.right / CHUNK_SIZE;
+	chunks.top = cells.top / CHUNK_SIZE;
+
+	const auto setCellInterest = [this, &currentViewer](const std::vector<uint32_t>& entityIDs, const Snapshot::EInterest interest)
+	{
+		for (const uint32_t currentEntity : entityIDs)
+		{
+			setInterest(currentViewer, currentEntity, interest);
+			++m_changesCount;
+		}
+	};
+	forEachCellOutside(currentViewer.cells, cells, [this, &setCellInterest](const int x, const int y)
+		{
+			setCellInterest(m_cellEntities[static_cast<size_t>(y * m_cellsCount.x + x)], Snapshot::EInterest::Drop);
+		}
+	);
+	forEachCellOutside(cells, currentViewer.cells, [this, &setCellInterest](const int x, const int y)
+		{
+			setCellInterest(m_cellEntities[static_cast<size_t>(y * m_cellsCount.x + x)], Snapshot::EInterest::Send);
+		}
+	);
+	if (!(chunks == currentViewer.chunks))
+	{
+		forEachCellOutside(currentViewer.chunks, chunks, [this, &setCellInterest](const int x, const int y)
+			{
+				setCellInterest(m_chunkEntities[static_cast<size_t>(y * m_chunksCount.x + x)], Snapshot::EInterest::Keep);
+			}
+		);
+		forEachCellOutside(chunks, currentViewer.chunks, [this, &setCellInterest](const int x, const int y)
+			{
+				setCellInterest(m_chunkEntities[static_cast<size_t>(y * m_chunksCount.x + x)], Snapshot::EInterest::Send);
+			}
+		);
+	}
+	currentViewer.cells = cells;
+	currentViewer.chunks = chunks;
+}
+
+void InterestGrid::resetViewer(const size_t viewer)
+{
+	Viewer& currentViewer = m_viewers[viewer];
+	currentViewer.cells = Rect();
+	currentViewer.chunks = Rect();
+	currentViewer.interest.resize(m_entities.size());
+	for (size_t currentEntity = 0; currentEntity < m_entities.size(); ++currentEntity)
+	{
+		const Entity& entity = m_entities[currentEntity];
+		currentViewer.interest[currentEntity] = entity.isStatic ? Snapshot::EInterest::Keep : Snapshot::EInterest::Drop;
+	}
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "Snapshot.h"
+
+#include <glm/vec2.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class IGameObject;
+
+// Area of interest on the level's block grid. Every object with state in the room's world sits in the
+// cell of Level::BLOCK_SIZE pixels its center is in, a viewer sees the cells of its view rectangle plus
+// a margin. The grid is updated incrementally each tick: only an object that changed cells and only the
+// cells a viewer's rectangle gained or lost change what the viewer gets.
+//
+// Moving objects (tanks, bullets) enter and leave a viewer's interest. Objects that never move (walls)
+// are kept per chunk of CHUNK_SIZE x CHUNK_SIZE cells instead and never leave it: out of view a client
+// keeps what it has of a chunk, and the brick changes of the chunk go out together once it comes back.
+class InterestGrid
+{
+public:
+	static constexpr int CHUNK_SIZE = 4;
+
+	// levelSize in pixels, viewSize and margin in cells
+	void init(const glm::ivec2& levelSize, const glm::ivec2& viewSize, const int margin, const size_t viewersCount);
+	// places the objects of the current WorldHash context, once a tick
+	void update();
+	// centers the viewer's rectangle on a position in level pixels
+	void setViewerPosition(const size_t viewer, const glm::vec2& position);
+	// the viewer sees nothing until its next position, a client that joins starts from here
+	void resetViewer(const size_t viewer);
+	// what the viewer gets of every entity, by entity ID
+	const std::vector<Snapshot::EInterest>& getInterest(const size_t viewer) const { return m_viewers[viewer].interest; }
+	// entities that entered or left the interest of a viewer so far
+	uint64_t getChangesCount() const { return m_changesCount; }
+
+private:
+	// inclusive, empty when right < left
+	struct Rect
+	{
+		int left = 0;
+		int bottom = 0;
+		int right = -1;
+		int top = -1;
+
+		bool contains(const int x, const int y) const { return x >= left && x <= right && y >= bottom && y <= top; }
+		bool operator == (const Rect& rect) const { return left == rect.left && bottom == rect.bottom && right == rect.right && top == rect.top; }
+	};
+
+	struct Entity
+	{
+		const IGameObject* pObject = nullptr;
+		bool isStatic = false;
+		// the cell index, -1 - not placed
+		int cell = -1;
+	};
+
+	struct Viewer
+	{
+		Rect cells;
+		Rect chunks;
+		std::vector<Snapshot::EInterest> interest;
+	};
+
+	int getCellIndex(const glm::vec2& position) const;
+	int getChunkIndex(const int cell) const;
+	bool isVisible(const Viewer& viewer, const Entity& entity, const int cell) const;
+	void move(const uint32_t entityID, const int cell);
+	void setInterest(Viewer& viewer, const uint32_t entityID, const Snapshot::EInterest interest);
+	// calls function(x, y) for every cell of rect outside of except
+	template<class TFunction>
+	static void forEachCellOutside(const Rect& rect, const Rect& except, const TFunction& function);
+
+	glm::ivec2 m_cellsCount = glm::ivec2(0);
+	glm::ivec2 m_chunksCount = glm::ivec2(0);
+	glm::ivec2 m_viewSize = glm::ivec2(0);
+	int m_margin = 0;
+	// the moving entities in every cell and the static ones in every chunk, by entity ID
+	std::vector<std::vector<uint32_t>> m_cellEntities;
+	std::vector<std::vector<uint32_t>> m_chunkEntities;
+	std::vector<Entity> m_entities;
+	std::vector<Viewer> m_viewers;
+	uint64_t m_changesCount = 0;
+};
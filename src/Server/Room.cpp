@@ -0,0 +1,308 @@
+#include "Room.h"
+#include "ServerProtocol.h"
+#include "../Network/Packet.h"
+#include "../System/Metrics.h"
+#include "../System/Profiler.h"
+
+#include <algorithm>
+#include <chrono>
+
+// what a client without an acknowledged snapshot holds
+static const Snapshot EMPTY_SNAPSHOT;
+
+// Makes the room's world current on the calling thread. A worker waiting inside one room's tick may run
+// another room's tick meanwhile, so the world current before is made current again afterwards.
+class CurrentWorld
+{
+public:
+	CurrentWorld(WorldHash::Context& worldHashContext, Physics::PhysicsEngine::World& physicsWorld)
+		: m_pPreviousWorldHashContext(WorldHash::getCurrentContext())
+		, m_pPreviousPhysicsWorld(Physics::PhysicsEngine::getCurrentWorld())
+	{
+		WorldHash::setCurrentContext(&worldHashContext);
+		Physics::PhysicsEngine::setCurrentWorld(&physicsWorld);
+	}
+	~CurrentWorld()
+	{
+		WorldHash::setCurrentContext(m_pPreviousWorldHashContext);
+		Physics::PhysicsEngine::setCurrentWorld(m_pPreviousPhysicsWorld);
+	}
+
+	CurrentWorld(const CurrentWorld&) = delete;
+	CurrentWorld& operator = (const CurrentWorld&) = delete;
+
+private:
+	WorldHash::Context* m_pPreviousWorldHashContext;
+	Physics::PhysicsEngine::World* m_pPreviousPhysicsWorld;
+};
+
+Room::Room(const uint32_t roomID, const size_t levelIndex, const uint32_t snapshotInterval, const glm::ivec2& viewSize,
+		   const int viewMargin, const uint32_t spectatorKeyframeInterval)
+	: m_roomID(roomID)
+	, m_levelIndex(levelIndex)
+	, m_snapshotInterval(std::max<uint32_t>(snapshotInterval, 1))
+	, m_viewSize(viewSize)
+	, m_viewMargin(viewMargin)
+	, m_hasInterestManagement(viewSize.x > 0 && viewSize.y > 0)
+	, m_spectatorKeyframeInterval(std::max<uint32_t>(spectatorKeyframeInterval, 1))
+	, m_currentSpectatorSnapshot(0)
+	, m_spectatorSnapshotsCount(0)
+	, m_currentCapture(0)
+{
+}
+
+Room::~Room()
+{
+	// the objects leave the room's world hash on destruction
+	CurrentWorld currentWorld(m_worldHashContext, m_physicsWorld);
+	m_pGame.reset();
+	m_physicsWorld.dynamicObjects.clear();
+	m_physicsWorld.pCurrentLevel.reset();
+}
+
+bool Room::init()
+{
+	CurrentWorld currentWorld(m_worldHashContext, m_physicsWorld);
+	m_pGame = std::make_unique<Game>(glm::ivec2(13 * 16, 14 * 16));
+	if (!m_pGame->init(m_levelIndex, Game::MAX_PLAYERS))
+	{
+		return false;
+	}
+	m_interestGrid.init(glm::ivec2(m_pGame->getCurrentLewelWidth(), m_pGame->getCurrentLewelHeight()), m_viewSize, m_viewMargin, m_clients.size());
+	return true;
+}
+
+uint32_t Room::getTicksCount() const
+{
+	return m_pGame ? m_pGame->getTicksCount() : 0;
+}
+
+int Room::join(const NetAddress& address)
+{
+	for (size_t currentPlayer = 0; currentPlayer < m_clients.size(); ++currentPlayer)
+	{
+		Client& client = m_clients[currentPlayer];
+		if (!client.isConnected)
+		{
+			client.isConnected = true;
+			client.address = address;
+			client.input = 0;
+			client.inputSequence = 0;
+			client.ackedTick = ServerProtocol::NO_TICK;
+			client.lastHeardTick = getTicksCount();
+			m_interestGrid.resetViewer(currentPlayer);
+			return static_cast<int>(currentPlayer);
+		}
+	}
+	return -1;
+}
+
+void Room::leave(const size_t player)
+{
+	if (player >= m_clients.size())
+	{
+		return;
+	}
+	m_clients[player].isConnected = false;
+	m_clients[player].input = 0;
+}
+
+size_t Room::getClientsCount() const
+{
+	return static_cast<size_t>(std::count_if(m_clients.begin(), m_clients.end(), [](const Client& client) { return client.isConnected; }));
+}
+
+void Room::receiveInput(const size_t player, const uint32_t sequence, const uint8_t input, const uint32_t ackedTick)
+{
+	if (player >= m_clients.size())
+	{
+		return;
+	}
+	Client& client = m_clients[player];
+	client.lastHeardTick = getTicksCount();
+	if (sequence >= client.inputSequence)
+	{
+		client.inputSequence = sequence;
+		client.input = input;
+	}
+	if (ackedTick != ServerProtocol::NO_TICK && ackedTick <= getTicksCount() &&
+		(client.ackedTick == ServerProtocol::NO_TICK || ackedTick > client.ackedTick))
+	{
+		client.ackedTick = ackedTick;
+	}
+}
+
+void Room::addSpectator(const NetAddress& address)
+{
+	const auto spectator = std::find_if(m_spectators.begin(), m_spectators.end(), [&address](const Spectator& spectator) { return spectator.address == address; });
+	if (spectator != m_spectators.end())
+	{
+		spectator->lastHeardTick = getTicksCount();
+		return;
+	}
+	// the first spectator starts the stream with a keyframe
+	if (m_spectators.empty())
+	{
+		m_spectatorSnapshotsCount = 0;
+	}
+	m_spectators.push_back({ address, getTicksCount() });
+}
+
+void Room::removeSpectator(const NetAddress& address)
+{
+	const auto spectator = std::find_if(m_spectators.begin(), m_spectators.end(), [&address](const Spectator& spectator) { return spectator.address == address; });
+	if (spectator != m_spectators.end())
+	{
+		*spectator = m_spectators.back();
+		m_spectators.pop_back();
+	}
+}
+
+void Room::dropSilentSpectators(const uint32_t timeoutTicks, std::vector<NetAddress>& droppedAddresses)
+{
+	for (size_t currentSpectator = 0; currentSpectator < m_spectators.size();)
+	{
+		if (getTicksCount() - m_spectators[currentSpectator].lastHeardTick > timeoutTicks)
+		{
+			droppedAddresses.push_back(m_spectators[currentSpectator].address);
+			m_spectators[currentSpectator] = m_spectators.back();
+			m_spectators.pop_back();
+		}
+		else
+		{
+			++currentSpectator;
+		}
+	}
+}
+
+void Room::tick(NetworkEngine& network)
+{
+	PROFILE_ZONE("Room::tick");
+	static Metrics::Histogram& tickTimeHistogram = Metrics::histogram("battlecity_room_tick_seconds", "Thread time of one room tick: simulation, snapshot capture and encoding",
+																	   Metrics::TICK_TIME_BOUNDS);
+	const auto startTime = std::chrono::steady_clock::now();
+	{
+		CurrentWorld currentWorld(m_worldHashContext, m_physicsWorld);
+		for (size_t currentPlayer = 0; currentPlayer < m_clients.size(); ++currentPlayer)
+		{
+			m_pGame->setPlayerInput(currentPlayer, m_clients[currentPlayer].isConnected ? m_clients[currentPlayer].input : 0);
+		}
+		m_pGame->update(Game::TICK_DURATION);
+		Physics::PhysicsEngine::update(Game::TICK_DURATION);
+		if (m_hasInterestManagement)
+		{
+			m_interestGrid.update();
+			for (size_t currentPlayer = 0; currentPlayer < m_clients.size(); ++currentPlayer)
+			{
+				if (m_clients[currentPlayer].isConnected)
+				{
+					m_interestGrid.setViewerPosition(currentPlayer, m_pGame->getPlayerPosition(currentPlayer));
+				}
+			}
+		}
+
+		if (m_pGame->getTicksCount() % m_snapshotInterval == 0 && (getClientsCount() > 0 || !m_spectators.empty()))
+		{
+			const Snapshot& previousCapture = m_captures[m_currentCapture];
+			m_currentCapture ^= 1;
+			m_captures[m_currentCapture].capture(m_pGame->getTicksCount(), previousCapture);
+			for (size_t currentPlayer = 0; currentPlayer < m_clients.size(); ++currentPlayer)
+			{
+				if (m_clients[currentPlayer].isConnected)
+				{
+					sendSnapshot(currentPlayer, network);
+				}
+			}
+			if (!m_spectators.empty())
+			{
+				sendSpectatorSnapshot(network);
+			}
+		}
+		if (m_pGame->getTicksCount() % static_cast<uint32_t>(Game::TICK_RATE) == 0)
+		{
+			const std::vector<IGameObject*>& objects = WorldHash::getObjects();
+			m_stats.entitiesCount = objects.size() - static_cast<size_t>(std::count(objects.begin(), objects.end(), nullptr));
+		}
+	}
+	const double tickTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+	++m_stats.ticksCount;
+	m_stats.totalTickTime += tickTime;
+	m_stats.maxTickTime = std::max(m_stats.maxTickTime, tickTime);
+	tickTimeHistogram.observe(tickTime / 1000.0);
+}
+
+void Room::sendSnapshot(const size_t player, NetworkEngine& network)
+{
+	Client& client = m_clients[player];
+	const Snapshot& current = m_captures[m_currentCapture];
+	const uint32_t tick = current.getTick();
+	const size_t slot = (tick / m_snapshotInterval) % SNAPSHOT_HISTORY;
+
+	// the baseline must still be in the history and not in the slot about to be overwritten
+	const Snapshot* pBaseline = &EMPTY_SNAPSHOT;
+	uint32_t baselineTick = ServerProtocol::NO_TICK;
+	if (client.ackedTick != ServerProtocol::NO_TICK && client.ackedTick < tick &&
+		(tick - client.ackedTick) / m_snapshotInterval < SNAPSHOT_HISTORY)
+	{
+		const Snapshot& ackedSnapshot = client.sentSnapshots[(client.ackedTick / m_snapshotInterval) % SNAPSHOT_HISTORY];
+		if (ackedSnapshot.getTick() == client.ackedTick)
+		{
+			pBaseline = &ackedSnapshot;
+			baselineTick = client.ackedTick;
+		}
+	}
+
+	PacketWriter writer;
+	writer.write(ServerProtocol::MAGIC);
+	writer.write(ServerProtocol::SNAPSHOT);
+	writer.write(m_roomID);
+	writer.write(tick);
+	writer.write(baselineTick);
+	if (!client.sentSnapshots[slot].encodeDelta(*pBaseline, current, writer, m_hasInterestManagement ? &m_interestGrid.getInterest(player) : nullptr))
+	{
+		++m_stats.incompleteSnapshotsCount;
+	}
+	if (baselineTick == ServerProtocol::NO_TICK)
+	{
+		++m_stats.fullSnapshotsCount;
+	}
+	static Metrics::Counter& snapshotsCounter = Metrics::counter("battlecity_snapshots_sent_total", "Snapshots sent to the clients");
+	static Metrics::Counter& snapshotBytesCounter = Metrics::counter("battlecity_snapshot_bytes_sent_total", "Snapshot bytes sent to the clients");
+	network.send(client.address, writer.getData(), writer.getSize());
+	++m_stats.snapshotsSentCount;
+	m_stats.snapshotBytesSent += writer.getSize();
+	snapshotsCounter.add();
+	snapshotBytesCounter.add(writer.getSize());
+}
+
+void Room::sendSpectatorSnapshot(NetworkEngine& network)
+{
+	PROFILE_ZONE("Room::sendSpectatorSnapshot");
+	const Snapshot& current = m_captures[m_currentCapture];
+	// spectators that joined or lost a packet sync up at the next keyframe
+	const bool isKeyframe = m_spectatorSnapshotsCount % m_spectatorKeyframeInterval == 0;
+	const Snapshot& previous = m_spectatorSnapshots[m_currentSpectatorSnapshot];
+	m_currentSpectatorSnapshot ^= 1;
+
+	const auto pPacket = std::make_shared<PacketWriter>();
+	pPacket->write(ServerProtocol::MAGIC);
+	pPacket->write(ServerProtocol::SPECTATOR_SNAPSHOT);
+	pPacket->write(m_roomID);
+	pPacket->write(current.getTick());
+	pPacket->write(isKeyframe ? ServerProtocol::NO_TICK : previous.getTick());
+	m_spectatorSnapshots[m_currentSpectatorSnapshot].encodeDelta(isKeyframe ? EMPTY_SNAPSHOT : previous, current, *pPacket);
+	++m_spectatorSnapshotsCount;
+	++m_stats.spectatorSnapshotsCount;
+	m_stats.spectatorKeyframesCount += isKeyframe ? 1 : 0;
+
+	// every spectator costs a reference and a queue slot, the I/O thread sends them in batches
+	const std::shared_ptr<const PacketWriter> pSharedPacket = pPacket;
+	for (const Spectator& currentSpectator : m_spectators)
+	{
+		network.send(currentSpectator.address, pSharedPacket);
+	}
+	static Metrics::Counter& spectatorPacketsCounter = Metrics::counter("battlecity_spectator_packets_sent_total", "Spectator snapshot packets sent");
+	m_stats.spectatorPacketsSentCount += m_spectators.size();
+	m_stats.spectatorBytesSent += m_spectators.size() * pPacket->getSize();
+	spectatorPacketsCounter.add(m_spectators.size());
+}
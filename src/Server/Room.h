@@ -0,0 +1,129 @@
+#pragma once
+
+#include "../Game/Game.h"
+#include "../Game/WorldHash.h"
+#include "../Network/NetworkEngine.h"
+#include "../Physics/PhysicsEngine.h"
+#include "InterestGrid.h"
+#include "Snapshot.h"
+
+#include <array>
+#include <memory>
+#include <vector>
+
+// One match on the server: a game with its own world hash and physics world, so any number of rooms
+// can be simulated by the threads of one process. The room is ticked by one thread at a time; joining,
+// leaving and inputs are applied between the ticks by the server's network thread.
+class Room
+{
+public:
+	// snapshots a client may still acknowledge, older acknowledgements get a whole snapshot
+	static constexpr size_t SNAPSHOT_HISTORY = 16;
+
+	struct Stats
+	{
+		uint64_t ticksCount = 0;
+		// milliseconds of simulation, snapshot capture and encoding
+		double totalTickTime = 0.0;
+		double maxTickTime = 0.0;
+		uint64_t snapshotsSentCount = 0;
+		uint64_t snapshotBytesSent = 0;
+		// deltas that didn't fit into a packet, the rest went with the next one
+		uint64_t incompleteSnapshotsCount = 0;
+		uint64_t fullSnapshotsCount = 0;
+		// one encoding per snapshot tick for all the spectators, however many they are
+		uint64_t spectatorSnapshotsCount = 0;
+		uint64_t spectatorKeyframesCount = 0;
+		uint64_t spectatorPacketsSentCount = 0;
+		uint64_t spectatorBytesSent = 0;
+		// objects in the world, counted once a second
+		size_t entitiesCount = 0;
+	};
+
+	// viewSize in blocks around a player's tank, what is farther away isn't sent to the client; 0 - the whole level.
+	// Spectators get a keyframe every spectatorKeyframeInterval snapshots.
+	Room(const uint32_t roomID, const size_t levelIndex, const uint32_t snapshotInterval, const glm::ivec2& viewSize = glm::ivec2(0),
+		 const int viewMargin = 0, const uint32_t spectatorKeyframeInterval = 30);
+	~Room();
+
+	Room(const Room&) = delete;
+	Room& operator = (const Room&) = delete;
+
+	bool init();
+	uint32_t getRoomID() const { return m_roomID; }
+	size_t getLevelIndex() const { return m_levelIndex; }
+	uint32_t getTicksCount() const;
+
+	// the free player slot taken by the client, -1 if the room is full
+	int join(const NetAddress& address);
+	void leave(const size_t player);
+	// false for a player past the room's slots
+	bool isConnected(const size_t player) const { return player < m_clients.size() && m_clients[player].isConnected; }
+	const NetAddress& getClientAddress(const size_t player) const { return m_clients[player].address; }
+	uint32_t getClientLastHeardTick(const size_t player) const { return m_clients[player].lastHeardTick; }
+	size_t getClientsCount() const;
+	// inputs may come out of order, only a newer sequence replaces the input; a player past the slots is ignored
+	void receiveInput(const size_t player, const uint32_t sequence, const uint8_t input, const uint32_t ackedTick);
+
+	// a spectator already watching is only marked as heard of
+	void addSpectator(const NetAddress& address);
+	void removeSpectator(const NetAddress& address);
+	size_t getSpectatorsCount() const { return m_spectators.size(); }
+	// removes the spectators not heard of for timeoutTicks and appends their addresses
+	void dropSilentSpectators(const uint32_t timeoutTicks, std::vector<NetAddress>& droppedAddresses);
+
+	// simulates one tick with the last inputs and sends the snapshot of the tick to the clients when it is due
+	void tick(NetworkEngine& network);
+	const Stats& getStats() const { return m_stats; }
+	// entities that entered or left the view of a client
+	uint64_t getInterestChangesCount() const { return m_interestGrid.getChangesCount(); }
+
+private:
+	struct Client
+	{
+		bool isConnected = false;
+		NetAddress address;
+		uint8_t input = 0;
+		uint32_t inputSequence = 0;
+		uint32_t ackedTick = 0;
+		uint32_t lastHeardTick = 0;
+		// what the client holds after decoding the snapshot of each of the last ticks, indexed by tick % SNAPSHOT_HISTORY
+		std::array<Snapshot, SNAPSHOT_HISTORY> sentSnapshots;
+	};
+
+	struct Spectator
+	{
+		NetAddress address;
+		uint32_t lastHeardTick = 0;
+	};
+
+	void sendSnapshot(const size_t player, NetworkEngine& network);
+	// encodes the snapshot once and sends the same packet to every spectator
+	void sendSpectatorSnapshot(NetworkEngine& network);
+
+	uint32_t m_roomID;
+	size_t m_levelIndex;
+	uint32_t m_snapshotInterval;
+	glm::ivec2 m_viewSize;
+	int m_viewMargin;
+	bool m_hasInterestManagement;
+
+	// the process-wide simulation state of this room's world, current while the room runs
+	WorldHash::Context m_worldHashContext;
+	Physics::PhysicsEngine::World m_physicsWorld;
+	std::unique_ptr<Game> m_pGame;
+
+	std::array<Client, Game::MAX_PLAYERS> m_clients;
+	// the last two captures, each captures what didn't change from the one before
+	std::array<Snapshot, 2> m_captures;
+	InterestGrid m_interestGrid;
+
+	std::vector<Spectator> m_spectators;
+	uint32_t m_spectatorKeyframeInterval;
+	// what a spectator that got every spectator snapshot holds: the last one and the one before
+	std::array<Snapshot, 2> m_spectatorSnapshots;
+	size_t m_currentSpectatorSnapshot;
+	uint32_t m_spectatorSnapshotsCount;
+	size_t m_currentCapture;
+	Stats m_stats;
+};
@@ -0,0 +1,145 @@
+#include "GameServer.h"
+#include "../Network/MetricsExporter.h"
+#include "../Resources/ResourceManager.h"
+
+#include <algorithm>
+#include <atomic>
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+// Headless game server: hosts --rooms rooms of two players each and runs until interrupted.
+// Usage: BattleCityServer [--port P] [--bind ADDRESS] [--rooms N] [--threads N] [--io-threads N] [--network epoll|io_uring]
+//                         [--level N] [--snapshot-interval TICKS] [--view BLOCKS] [--view-margin BLOCKS]
+//                         [--timeout SECONDS] [--report SECONDS] [--metrics-port P] [--metrics-file PATH] [--metrics-interval SECONDS]
+// --metrics-port serves the metrics to Prometheus at http://127.0.0.1:P/metrics, --metrics-file appends them as JSON lines.
+
+static std::atomic<bool> g_isRunning{ true };
+
+static void onInterrupt(int)
+{
+	g_isRunning = false;
+}
+
+static bool parseSettings(const int args, char** argv, GameServerSettings& settings, MetricsExporterSettings& metricsSettings)
+{
+	for (int currentArgument = 1; currentArgument < args; ++currentArgument)
+	{
+		const std::string argument = argv[currentArgument];
+		if (currentArgument + 1 >= args)
+		{
+			return false;
+		}
+		const char* value = argv[++currentArgument];
+		if (argument == "--port")
+		{
+			settings.port = static_cast<uint16_t>(std::atoi(value));
+		}
+		else if (argument == "--bind")
+		{
+			settings.bindAddress = value;
+		}
+		else if (argument == "--rooms")
+		{
+			settings.roomsCount = static_cast<uint32_t>(std::max(1, std::atoi(value)));
+		}
+		else if (argument == "--threads")
+		{
+			settings.threadsCount = static_cast<unsigned int>(std::max(0, std::atoi(value)));
+		}
+		else if (argument == "--io-threads")
+		{
+			settings.ioThreadsCount = static_cast<unsigned int>(std::max(1, std::atoi(value)));
+		}
+		else if (argument == "--network")
+		{
+			settings.useIoUring = std::string(value) == "io_uring";
+		}
+		else if (argument == "--view")
+		{
+			settings.viewSize = std::max(0, std::atoi(value));
+		}
+		else if (argument == "--view-margin")
+		{
+			settings.viewMargin = std::max(0, std::atoi(value));
+		}
+		else if (argument == "--level")
+		{
+			settings.levelIndex = static_cast<size_t>(std::max(0, std::atoi(value)));
+		}
+		else if (argument == "--snapshot-interval")
+		{
+			settings.snapshotInterval = static_cast<uint32_t>(std::max(1, std::atoi(value)));
+		}
+		else if (argument == "--timeout")
+		{
+			settings.clientTimeout = std::atof(value);
+		}
+		else if (argument == "--report")
+		{
+			settings.reportInterval = std::atof(value);
+		}
+		else if (argument == "--metrics-port")
+		{
+			metricsSettings.port = static_cast<uint16_t>(std::atoi(value));
+		}
+		else if (argument == "--metrics-file")
+		{
+			metricsSettings.jsonPath = value;
+		}
+		else if (argument == "--metrics-interval")
+		{
+			metricsSettings.jsonInterval = std::max(0.1, std::atof(value));
+		}
+		else
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+int main(int args, char** argv)
+{
+	GameServerSettings settings;
+	settings.bindAddress = "0.0.0.0";
+	settings.reportInterval = 5.0;
+	MetricsExporterSettings metricsSettings;
+	if (!parseSettings(args, argv, settings, metricsSettings))
+	{
+		std::cerr << "Usage: BattleCityServer [--port P] [--bind ADDRESS] [--rooms N] [--threads N] [--io-threads N] [--network epoll|io_uring]"
+				  << " [--level N] [--snapshot-interval TICKS] [--view BLOCKS] [--view-margin BLOCKS] [--timeout SECONDS] [--report SECONDS]"
+				  << " [--metrics-port P] [--metrics-file PATH] [--metrics-interval SECONDS]" << std::endl;
+		return 2;
+	}
+
+	ResourceManager::setExecutablePath(argv[0]);
+	ResourceManager::setHeadless(true);
+	ResourceManager::loadJSONResources("res/resourses.json");
+	int result = 0;
+	{
+		GameServer server(settings);
+		MetricsExporter metricsExporter;
+		const bool isExportingMetrics = metricsSettings.port != 0 || !metricsSettings.jsonPath.empty();
+		if (server.init() && (!isExportingMetrics || metricsExporter.start(metricsSettings)))
+		{
+			std::signal(SIGINT, onInterrupt);
+			std::signal(SIGTERM, onInterrupt);
+			std::cout << "Serving " << settings.roomsCount << " rooms on port " << server.getPort() << " with " << server.getNetworkBackendName() << std::endl;
+			if (metricsExporter.getPort() != 0)
+			{
+				std::cout << "Metrics on http://" << metricsSettings.bindAddress << ":" << metricsExporter.getPort() << "/metrics" << std::endl;
+			}
+			server.run(g_isRunning);
+			metricsExporter.stop();
+		}
+		else
+		{
+			std::cerr << "Can't start the server on port " << settings.port << std::endl;
+			result = 1;
+		}
+	}
+	ResourceManager::unloadAllResources();
+	return result;
+}
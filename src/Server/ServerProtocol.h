@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdint>
+
+// Packets between the game server and its clients. Every packet starts with the magic and the type.
+//   JOIN      client: asks for a player slot in any room with a free one
+//   WELCOME   server: u32 room, u8 player, u32 level index; repeated for every JOIN of a joined client
+//   INPUT     client: u32 room, u8 player, u32 sequence, u8 input, u32 newest snapshot tick decoded
+//   LEAVE     client: frees the slot at once instead of after the timeout
+//   SNAPSHOT  server: u32 room, u32 tick, u32 baseline tick, the delta against the baseline (see Snapshot)
+//   SPECTATE  client: u32 room; watches the room without playing, repeated as a keepalive within the timeout
+//   SPECTATOR_SNAPSHOT  server: u32 room, u32 tick, u32 tick of the previous spectator snapshot or NO_TICK
+//             for a keyframe, the delta against it. Encoded once for every spectator of the room, a spectator
+//             that missed one waits for the next keyframe.
+namespace ServerProtocol
+{
+	// "BCSV"
+	static constexpr uint32_t MAGIC = 0x56534342;
+
+	static constexpr uint8_t JOIN = 1;
+	static constexpr uint8_t WELCOME = 2;
+	static constexpr uint8_t INPUT = 3;
+	static constexpr uint8_t LEAVE = 4;
+	static constexpr uint8_t SNAPSHOT = 5;
+	static constexpr uint8_t SPECTATE = 6;
+	static constexpr uint8_t SPECTATOR_SNAPSHOT = 7;
+
+	// a snapshot against no baseline, or no snapshot decoded yet
+	static constexpr uint32_t NO_TICK = UINT32_MAX;
+	static constexpr uint16_t DEFAULT_PORT = 47700;
+}
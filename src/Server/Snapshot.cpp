@@ -0,0 +1,349 @@
+#include "Snapshot.h"
+#include "../Game/GameObjects/IGameObject.h"
+#include "../Game/WorldHash.h"
+#include "../Network/Packet.h"
+#include "../System/Profiler.h"
+
+#include <algorithm>
+#include <bitset>
+#include <cmath>
+
+// the terminators of both lists and the checksum
+static constexpr size_t TRAILER_SIZE = 6;
+
+static int32_t quantize(const double value)
+{
+	const double steps = std::round(value * Snapshot::QUANTIZATION);
+	return static_cast<int32_t>(std::clamp(steps, static_cast<double>(INT32_MIN), static_cast<double>(INT32_MAX)));
+}
+
+static bool hasSameShape(const SnapshotEntity& entity1, const SnapshotEntity& entity2)
+{
+	return entity1.objectType == entity2.objectType && entity1.fieldsCount == entity2.fieldsCount && entity1.vectorFields == entity2.vectorFields;
+}
+
+void Snapshot::clear(const uint32_t tick)
+{
+	m_tick = tick;
+	m_entities.clear();
+	m_values.clear();
+}
+
+size_t Snapshot::getValuesCount(const SnapshotEntity& entity)
+{
+	return entity.fieldsCount + std::bitset<8>(entity.vectorFields).count();
+}
+
+void Snapshot::addEntity(const SnapshotEntity& entity, const int32_t* pValues)
+{
+	m_entities.push_back(entity);
+	m_entities.back().firstValue = static_cast<uint32_t>(m_values.size());
+	m_values.insert(m_values.end(), pValues, pValues + getValuesCount(entity));
+}
+
+void Snapshot::capture(const uint32_t tick, const Snapshot& previous)
+{
+	PROFILE_ZONE("Snapshot::capture");
+	clear(tick);
+	static thread_local std::vector<WorldHash::Field> fields;
+	size_t previousIndex = 0;
+	for (const IGameObject* pObject : WorldHash::getObjects())
+	{
+		if (!pObject || pObject->getStateHash() == 0)
+		{
+			continue;
+		}
+		const uint32_t entityID = pObject->getEntityID();
+		while (previousIndex < previous.m_entities.size() && previous.m_entities[previousIndex].entityID < entityID)
+		{
+			++previousIndex;
+		}
+		if (previousIndex < previous.m_entities.size() && previous.m_entities[previousIndex].entityID == entityID &&
+			previous.m_entities[previousIndex].stateHash == pObject->getStateHash())
+		{
+			addEntity(previous.m_entities[previousIndex], previous.getValues(previous.m_entities[previousIndex]));
+			continue;
+		}
+
+		fields.clear();
+		WorldHash::StateHasher hasher(entityID, &fields);
+		pObject->hashState(hasher);
+		SnapshotEntity entity = {};
+		entity.entityID = entityID;
+		entity.objectType = static_cast<uint8_t>(pObject->getObjectType());
+		entity.fieldsCount = static_cast<uint8_t>(std::min(fields.size(), MAX_FIELDS));
+		entity.firstValue = static_cast<uint32_t>(m_values.size());
+		entity.stateHash = pObject->getStateHash();
+		for (size_t currentField = 0; currentField < entity.fieldsCount; ++currentField)
+		{
+			m_values.push_back(quantize(fields[currentField].x));
+			if (fields[currentField].isVector)
+			{
+				entity.vectorFields |= static_cast<uint8_t>(1 << currentField);
+				m_values.push_back(quantize(fields[currentField].y));
+			}
+		}
+		m_entities.push_back(entity);
+	}
+}
+
+bool Snapshot::writeEntity(const SnapshotEntity& entity, const int32_t* pValues, const SnapshotEntity* pBaselineEntity,
+						   const int32_t* pBaselineValues, uint32_t& nextEntityID, PacketWriter& writer) const
+{
+	if (pBaselineEntity && hasSameShape(entity, *pBaselineEntity))
+	{
+		uint8_t fieldMask = 0;
+		for (size_t currentField = 0, currentValue = 0; currentField < entity.fieldsCount; ++currentField)
+		{
+			const size_t valuesCount = (entity.vectorFields >> currentField) & 1 ? 2 : 1;
+			if (!std::equal(pValues + currentValue, pValues + currentValue + valuesCount, pBaselineValues + currentValue))
+			{
+				fieldMask |= static_cast<uint8_t>(1 << currentField);
+			}
+			currentValue += valuesCount;
+		}
+		if (fieldMask == 0)
+		{
+			// the state hash changed by less than a quantization step
+			return false;
+		}
+		writer.writeVarint(entity.entityID - nextEntityID + 1);
+		writer.write(fieldMask);
+		for (size_t currentField = 0, currentValue = 0; currentField < entity.fieldsCount; ++currentField)
+		{
+			const size_t valuesCount = (entity.vectorFields >> currentField) & 1 ? 2 : 1;
+			if ((fieldMask >> currentField) & 1)
+			{
+				for (size_t currentComponent = currentValue; currentComponent < currentValue + valuesCount; ++currentComponent)
+				{
+					writer.writeSignedVarint(static_cast<int32_t>(static_cast<uint32_t>(pValues[currentComponent]) - static_cast<uint32_t>(pBaselineValues[currentComponent])));
+				}
+			}
+			currentValue += valuesCount;
+		}
+	}
+	else
+	{
+		writer.writeVarint(entity.entityID - nextEntityID + 1);
+		writer.write(static_cast<uint8_t>(0));
+		writer.write(entity.objectType);
+		writer.write(entity.fieldsCount);
+		writer.write(entity.vectorFields);
+		const size_t valuesCount = getValuesCount(entity);
+		for (size_t currentValue = 0; currentValue < valuesCount; ++currentValue)
+		{
+			writer.writeSignedVarint(pValues[currentValue]);
+		}
+	}
+	nextEntityID = entity.entityID + 1;
+	return true;
+}
+
+bool Snapshot::encodeDelta(const Snapshot& baseline, const Snapshot& current, PacketWriter& writer, const std::vector<EInterest>* pInterest)
+{
+	PROFILE_ZONE("Snapshot::encodeDelta");
+	clear(current.m_tick);
+	bool isComplete = true;
+	const auto getInterest = [pInterest](const uint32_t entityID)
+	{
+		return pInterest && entityID < pInterest->size() ? (*pInterest)[entityID] : EInterest::Send;
+	};
+
+	// removals first, in ID order up to the first one that doesn't fit
+	uint32_t nextEntityID = 0;
+	uint32_t removalsEndID = UINT32_MAX;
+	size_t currentIndex = 0;
+	for (const SnapshotEntity& baselineEntity : baseline.m_entities)
+	{
+		while (currentIndex < current.m_entities.size() && current.m_entities[currentIndex].entityID < baselineEntity.entityID)
+		{
+			++currentIndex;
+		}
+		if (currentIndex < current.m_entities.size() && current.m_entities[currentIndex].entityID == baselineEntity.entityID &&
+			getInterest(baselineEntity.entityID) != EInterest::Drop)
+		{
+			continue;
+		}
+		const size_t recordStart = writer.getSize();
+		writer.writeVarint(baselineEntity.entityID - nextEntityID + 1);
+		if (writer.hasOverflowed() || writer.getSize() + TRAILER_SIZE > UDPSocket::MAX_PACKET_SIZE)
+		{
+			writer.rewind(recordStart);
+			removalsEndID = baselineEntity.entityID;
+			isComplete = false;
+			break;
+		}
+		nextEntityID = baselineEntity.entityID + 1;
+	}
+	writer.writeVarint(0);
+
+	// then the changed and new entities, merged with the baseline into what the client will hold
+	nextEntityID = 0;
+	size_t baselineIndex = 0;
+	const auto keepBaselineEntitiesBefore = [this, &baseline, &baselineIndex, removalsEndID](const uint32_t entityID)
+	{
+		for (; baselineIndex < baseline.m_entities.size() && baseline.m_entities[baselineIndex].entityID < entityID; ++baselineIndex)
+		{
+			// not in the current snapshot any more, gone unless the removal didn't fit
+			if (baseline.m_entities[baselineIndex].entityID >= removalsEndID)
+			{
+				addEntity(baseline.m_entities[baselineIndex], baseline.getValues(baseline.m_entities[baselineIndex]));
+			}
+		}
+	};
+	for (const SnapshotEntity& entity : current.m_entities)
+	{
+		keepBaselineEntitiesBefore(entity.entityID);
+		const SnapshotEntity* pBaselineEntity = nullptr;
+		if (baselineIndex < baseline.m_entities.size() && baseline.m_entities[baselineIndex].entityID == entity.entityID)
+		{
+			pBaselineEntity = &baseline.m_entities[baselineIndex++];
+		}
+		const EInterest interest = getInterest(entity.entityID);
+		if (interest != EInterest::Send)
+		{
+			// a dropped entity is gone unless its removal didn't fit
+			if (pBaselineEntity && (interest == EInterest::Keep || entity.entityID >= removalsEndID))
+			{
+				addEntity(*pBaselineEntity, baseline.getValues(*pBaselineEntity));
+			}
+			continue;
+		}
+		if (pBaselineEntity && pBaselineEntity->stateHash == entity.stateHash)
+		{
+			addEntity(*pBaselineEntity, baseline.getValues(*pBaselineEntity));
+			continue;
+		}
+		if (isComplete)
+		{
+			const size_t recordStart = writer.getSize();
+			const uint32_t recordEntityID = nextEntityID;
+			writeEntity(entity, current.getValues(entity), pBaselineEntity, pBaselineEntity ? baseline.getValues(*pBaselineEntity) : nullptr, nextEntityID, writer);
+			if (!writer.hasOverflowed() && writer.getSize() + TRAILER_SIZE <= UDPSocket::MAX_PACKET_SIZE)
+			{
+				addEntity(entity, current.getValues(entity));
+				continue;
+			}
+			writer.rewind(recordStart);
+			nextEntityID = recordEntityID;
+			isComplete = false;
+		}
+		// didn't fit: the client keeps what it has, the next delta sends it
+		if (pBaselineEntity)
+		{
+			addEntity(*pBaselineEntity, baseline.getValues(*pBaselineEntity));
+		}
+	}
+	keepBaselineEntitiesBefore(UINT32_MAX);
+	writer.writeVarint(0);
+	writer.write(computeChecksum());
+	return isComplete;
+}
+
+bool Snapshot::decodeDelta(const Snapshot& baseline, const uint32_t tick, PacketReader& reader)
+{
+	PROFILE_ZONE("Snapshot::decodeDelta");
+	clear(tick);
+	static thread_local std::vector<uint32_t> removedIDs;
+	removedIDs.clear();
+	uint32_t nextEntityID = 0;
+	for (uint32_t gap = reader.readVarint(); gap != 0 && !reader.hasFailed(); gap = reader.readVarint())
+	{
+		removedIDs.push_back(nextEntityID + gap - 1);
+		nextEntityID = removedIDs.back() + 1;
+	}
+
+	size_t baselineIndex = 0;
+	size_t removedIndex = 0;
+	const auto keepBaselineEntitiesBefore = [this, &baseline, &baselineIndex, &removedIndex](const uint32_t entityID)
+	{
+		for (; baselineIndex < baseline.m_entities.size() && baseline.m_entities[baselineIndex].entityID < entityID; ++baselineIndex)
+		{
+			const SnapshotEntity& baselineEntity = baseline.m_entities[baselineIndex];
+			while (removedIndex < removedIDs.size() && removedIDs[removedIndex] < baselineEntity.entityID)
+			{
+				++removedIndex;
+			}
+			if (removedIndex == removedIDs.size() || removedIDs[removedIndex] != baselineEntity.entityID)
+			{
+				addEntity(baselineEntity, baseline.getValues(baselineEntity));
+			}
+		}
+	};
+	nextEntityID = 0;
+	for (uint32_t gap = reader.readVarint(); gap != 0 && !reader.hasFailed(); gap = reader.readVarint())
+	{
+		const uint32_t entityID = nextEntityID + gap - 1;
+		nextEntityID = entityID + 1;
+		keepBaselineEntitiesBefore(entityID);
+		const SnapshotEntity* pBaselineEntity = nullptr;
+		if (baselineIndex < baseline.m_entities.size() && baseline.m_entities[baselineIndex].entityID == entityID)
+		{
+			pBaselineEntity = &baseline.m_entities[baselineIndex++];
+		}
+
+		const uint8_t fieldMask = reader.read<uint8_t>();
+		if (fieldMask == 0)
+		{
+			SnapshotEntity entity = {};
+			entity.entityID = entityID;
+			entity.objectType = reader.read<uint8_t>();
+			entity.fieldsCount = reader.read<uint8_t>();
+			entity.vectorFields = reader.read<uint8_t>();
+			entity.firstValue = static_cast<uint32_t>(m_values.size());
+			if (entity.fieldsCount > MAX_FIELDS || (entity.vectorFields >> entity.fieldsCount) != 0)
+			{
+				return false;
+			}
+			const size_t valuesCount = getValuesCount(entity);
+			for (size_t currentValue = 0; currentValue < valuesCount; ++currentValue)
+			{
+				m_values.push_back(reader.readSignedVarint());
+			}
+			m_entities.push_back(entity);
+			continue;
+		}
+		if (!pBaselineEntity || (fieldMask >> pBaselineEntity->fieldsCount) != 0)
+		{
+			return false;
+		}
+		addEntity(*pBaselineEntity, baseline.getValues(*pBaselineEntity));
+		int32_t* pValues = m_values.data() + m_entities.back().firstValue;
+		for (size_t currentField = 0, currentValue = 0; currentField < pBaselineEntity->fieldsCount; ++currentField)
+		{
+			const size_t valuesCount = (pBaselineEntity->vectorFields >> currentField) & 1 ? 2 : 1;
+			if ((fieldMask >> currentField) & 1)
+			{
+				for (size_t currentComponent = currentValue; currentComponent < currentValue + valuesCount; ++currentComponent)
+				{
+					pValues[currentComponent] = static_cast<int32_t>(static_cast<uint32_t>(pValues[currentComponent]) + static_cast<uint32_t>(reader.readSignedVarint()));
+				}
+			}
+			currentValue += valuesCount;
+		}
+	}
+	keepBaselineEntitiesBefore(UINT32_MAX);
+	const uint32_t checksum = reader.read<uint32_t>();
+	return !reader.hasFailed() && checksum == computeChecksum();
+}
+
+uint32_t Snapshot::computeChecksum() const
+{
+	// FNV-1a over everything a client holds
+	uint32_t checksum = 2166136261u;
+	const auto add = [&checksum](const uint32_t value)
+	{
+		checksum = (checksum ^ value) * 16777619u;
+	};
+	for (const SnapshotEntity& entity : m_entities)
+	{
+		add(entity.entityID);
+		add(static_cast<uint32_t>(entity.objectType) | static_cast<uint32_t>(entity.fieldsCount) << 8 | static_cast<uint32_t>(entity.vectorFields) << 16);
+		const int32_t* pValues = getValues(entity);
+		for (size_t currentValue = 0, valuesCount = getValuesCount(entity); currentValue < valuesCount; ++currentValue)
+		{
+			add(static_cast<uint32_t>(pValues[currentValue]));
+		}
+	}
+	return checksum;
+}
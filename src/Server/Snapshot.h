@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class PacketReader;
+class PacketWriter;
+
+// What a client sees of one object: the fields of its simulation state as collected by
+// IGameObject::hashState(), every number quantized to 1/QUANTIZATION. A vector field takes two values.
+struct SnapshotEntity
+{
+	uint32_t entityID;
+	// IGameObject::EObjectType
+	uint8_t objectType;
+	uint8_t fieldsCount;
+	// a bit per vector field
+	uint8_t vectorFields;
+	// index into the values of the snapshot
+	uint32_t firstValue;
+	// the state hash the values were taken at, server side only: equal hashes mean nothing to send
+	uint64_t stateHash;
+};
+
+// The quantized state of the world at a tick, entities sorted by ID.
+//
+// A snapshot is sent as a delta against a baseline the client acknowledged: entities whose state hash
+// didn't change are skipped, the others carry a mask of the changed fields and the differences of their
+// quantized values as zigzag varints; entities new to the client are sent whole. The server keeps per
+// client the snapshot the client will hold after decoding, so a delta that doesn't fit into one packet
+// just leaves the rest for the next one and a later delta is still against exactly what the client has.
+//
+// Delta layout: records "varint(ID gap + 1), u8 field mask, differences" or "varint(ID gap + 1), u8 0,
+// u8 type, u8 fields, u8 vector fields, values", varint 0, then the removed entities "varint(ID gap + 1)",
+// varint 0, and the u32 checksum of the resulting snapshot.
+class Snapshot
+{
+public:
+	static constexpr size_t MAX_FIELDS = 8;
+	// steps per unit: pixels, milliseconds and velocities keep 8 fractional bits
+	static constexpr double QUANTIZATION = 256.0;
+
+	// what a client gets of an entity of the current snapshot
+	enum class EInterest : uint8_t
+	{
+		// its changes, all of it when the client doesn't have it
+		Send,
+		// nothing, the client keeps what it has of it
+		Keep,
+		// its removal, the client doesn't see it
+		Drop
+	};
+
+	void clear(const uint32_t tick);
+	uint32_t getTick() const { return m_tick; }
+	size_t getEntitiesCount() const { return m_entities.size(); }
+	const std::vector<SnapshotEntity>& getEntities() const { return m_entities; }
+	const int32_t* getValues(const SnapshotEntity& entity) const { return m_values.data() + entity.firstValue; }
+
+	// The objects with state of the current WorldHash context. Entities whose state hash is the same as
+	// in the previous capture copy its values instead of collecting the fields again.
+	void capture(const uint32_t tick, const Snapshot& previous);
+
+	// Writes the delta of current against baseline and makes this snapshot what the client holds after
+	// reading it. Returns false when not every change fitted into the packet. pInterest filters the
+	// entities by ID, the ones past its end are sent; without it every entity is sent.
+	bool encodeDelta(const Snapshot& baseline, const Snapshot& current, PacketWriter& writer, const std::vector<EInterest>* pInterest = nullptr);
+	// Reads a delta against the baseline into this snapshot. False for a malformed packet or a checksum
+	// that doesn't match, the snapshot is then unusable.
+	bool decodeDelta(const Snapshot& baseline, const uint32_t tick, PacketReader& reader);
+
+	uint32_t computeChecksum() const;
+
+private:
+	static size_t getValuesCount(const SnapshotEntity& entity);
+	void addEntity(const SnapshotEntity& entity, const int32_t* pValues);
+	bool writeEntity(const SnapshotEntity& entity, const int32_t* pValues, const SnapshotEntity* pBaselineEntity,
+					 const int32_t* pBaselineValues, uint32_t& nextEntityID, PacketWriter& writer) const;
+
+	uint32_t m_tick = 0;
+	std::vector<SnapshotEntity> m_entities;
+	std::vector<int32_t> m_values;
+};
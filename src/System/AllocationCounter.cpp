@@ -0,0 +1,47 @@
+#include "Metrics.h"
+
+#include <cstdlib>
+#include <new>
+
+#ifndef BATTLECITY_METRICS_ALLOCATIONS
+#define BATTLECITY_METRICS_ALLOCATIONS 0
+#endif
+
+// Replaces the global operator new and delete of the executable it is compiled into to count every
+// allocation of the process into the metrics registry. Only the executables that export allocation
+// counts build it, with BATTLECITY_METRICS_ALLOCATIONS=1: the rest keep the library's allocator as is.
+#if BATTLECITY_METRICS_ALLOCATIONS
+static void* allocate(const std::size_t size)
+{
+	void* pMemory = std::malloc(size > 0 ? size : 1);
+	while (!pMemory)
+	{
+		const std::new_handler newHandler = std::get_new_handler();
+		if (!newHandler)
+		{
+			throw std::bad_alloc();
+		}
+		newHandler();
+		pMemory = std::malloc(size > 0 ? size : 1);
+	}
+	Metrics::recordAllocation(size);
+	return pMemory;
+}
+
+static void deallocate(void* pMemory)
+{
+	if (pMemory)
+	{
+		Metrics::recordDeallocation();
+		std::free(pMemory);
+	}
+}
+
+// the aligned forms stay the library's, they allocate apart from these
+void* operator new(std::size_t size) { return allocate(size); }
+void* operator new[](std::size_t size) { return allocate(size); }
+void operator delete(void* pMemory) noexcept { deallocate(pMemory); }
+void operator delete[](void* pMemory) noexcept { deallocate(pMemory); }
+void operator delete(void* pMemory, std::size_t) noexcept { deallocate(pMemory); }
+void operator delete[](void* pMemory, std::size_t) noexcept { deallocate(pMemory); }
+#endif
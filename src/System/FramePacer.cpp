@@ -0,0 +1,124 @@
+#include "FramePacer.h"
+#include <algorithm>
+#include <thread>
+
+// below this the OS scheduler can't be trusted to wake us on time
+static constexpr std::chrono::microseconds SPIN_THRESHOLD(2000);
+// reserve on top of the measured frame work in LowLatency mode
+static constexpr std::chrono::microseconds LOW_LATENCY_MARGIN(1000);
+
+FramePacer::FramePacer(const EPacingMode mode, const double targetFrameRate)
+	: m_mode(mode)
+	, m_targetFrameRate(targetFrameRate > 0 ? targetFrameRate : 60.0)
+	, m_framePeriod(std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / m_targetFrameRate)))
+	, m_nextPresent(Clock::now() + m_framePeriod)
+	, m_frameWorkStart(Clock::now())
+	, m_lastPresent()
+	, m_frameWorkEstimate(m_framePeriod / 2)
+	, m_framesCount(0)
+	, m_averageFrameTime(0)
+	, m_frameTimeSquaresSum(0)
+	, m_minFrameTime(0)
+	, m_maxFrameTime(0)
+{
+}
+
+bool FramePacer::parseMode(const std::string& name, EPacingMode& mode)
+{
+	for (const EPacingMode currentMode : { EPacingMode::VSync, EPacingMode::Uncapped, EPacingMode::Capped, EPacingMode::LowLatency })
+	{
+		if (name == getModeName(currentMode))
+		{
+			mode = currentMode;
+			return true;
+		}
+	}
+	return false;
+}
+
+const char* FramePacer::getModeName(const EPacingMode mode)
+{
+	switch (mode)
+	{
+	case EPacingMode::VSync:
+		return "vsync";
+	case EPacingMode::Uncapped:
+		return "uncapped";
+	case EPacingMode::Capped:
+		return "capped";
+	case EPacingMode::LowLatency:
+		return "lowlatency";
+	}
+	return "unknown";
+}
+
+void FramePacer::beginFrame()
+{
+	switch (m_mode)
+	{
+	case EPacingMode::Capped:
+		waitUntil(m_nextPresent - m_framePeriod);
+		break;
+	case EPacingMode::LowLatency:
+		waitUntil(m_nextPresent - std::min(m_frameWorkEstimate + LOW_LATENCY_MARGIN, Clock::duration(m_framePeriod)));
+		break;
+	default:
+		break;
+	}
+	m_frameWorkStart = Clock::now();
+}
+
+void FramePacer::endFrame()
+{
+	const Clock::time_point currentTime = Clock::now();
+
+	// the estimate follows slow frames at once and fast frames gradually
+	const Clock::duration frameWork = currentTime - m_frameWorkStart;
+	m_frameWorkEstimate = frameWork > m_frameWorkEstimate ? frameWork : (m_frameWorkEstimate * 7 + frameWork) / 8;
+
+	// a missed deadline restarts the schedule instead of rushing frames to catch up
+	m_nextPresent += m_framePeriod;
+	if (m_nextPresent < currentTime)
+	{
+		m_nextPresent = currentTime + m_framePeriod;
+	}
+
+	if (m_lastPresent != Clock::time_point())
+	{
+		const double frameTime = std::chrono::duration<double, std::milli>(currentTime - m_lastPresent).count();
+		++m_framesCount;
+		const double delta = frameTime - m_averageFrameTime;
+		m_averageFrameTime += delta / m_framesCount;
+		m_frameTimeSquaresSum += delta * (frameTime - m_averageFrameTime);
+		m_minFrameTime = m_framesCount == 1 ? frameTime : std::min(m_minFrameTime, frameTime);
+		m_maxFrameTime = std::max(m_maxFrameTime, frameTime);
+	}
+	m_lastPresent = currentTime;
+}
+
+void FramePacer::reset()
+{
+	m_nextPresent = Clock::now() + m_framePeriod;
+	m_lastPresent = Clock::time_point();
+}
+
+double FramePacer::getFrameTimeVariance() const
+{
+	return m_framesCount > 1 ? m_frameTimeSquaresSum / (m_framesCount - 1) : 0;
+}
+
+void FramePacer::waitUntil(const Clock::time_point& time) const
+{
+	for (Clock::time_point currentTime = Clock::now(); currentTime < time; currentTime = Clock::now())
+	{
+		const Clock::duration timeLeft = time - currentTime;
+		if (timeLeft > SPIN_THRESHOLD)
+		{
+			std::this_thread::sleep_for(timeLeft - SPIN_THRESHOLD);
+		}
+		else
+		{
+			std::this_thread::yield();
+		}
+	}
+}
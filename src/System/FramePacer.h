@@ -0,0 +1,63 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+enum class EPacingMode : uint8_t
+{
+	VSync,
+	Uncapped,
+	Capped,
+	// capped, but input sampling and simulation start as late as the measured frame work allows
+	LowLatency
+};
+
+// Decides when the main loop starts a frame. The capped modes wait with a hybrid limiter:
+// sleep while the deadline is far away, then spin for the last couple of milliseconds.
+// Frame times are measured between consecutive presents, in milliseconds.
+class FramePacer
+{
+public:
+	FramePacer(const EPacingMode mode = EPacingMode::VSync, const double targetFrameRate = 60.0);
+
+	static bool parseMode(const std::string& name, EPacingMode& mode);
+	static const char* getModeName(const EPacingMode mode);
+
+	EPacingMode getMode() const { return m_mode; }
+	double getTargetFrameRate() const { return m_targetFrameRate; }
+	int getSwapInterval() const { return m_mode == EPacingMode::VSync ? 1 : 0; }
+
+	// blocks until the frame should start sampling input
+	void beginFrame();
+	// call right after the buffers were swapped
+	void endFrame();
+	// restarts the schedule after the loop was suspended, the gap is not counted as a frame
+	void reset();
+
+	uint64_t getFramesCount() const { return m_framesCount; }
+	double getAverageFrameTime() const { return m_averageFrameTime; }
+	double getFrameTimeVariance() const;
+	double getMinFrameTime() const { return m_minFrameTime; }
+	double getMaxFrameTime() const { return m_maxFrameTime; }
+
+private:
+	using Clock = std::chrono::steady_clock;
+
+	void waitUntil(const Clock::time_point& time) const;
+
+	EPacingMode m_mode;
+	double m_targetFrameRate;
+	Clock::duration m_framePeriod;
+	Clock::time_point m_nextPresent;
+	Clock::time_point m_frameWorkStart;
+	Clock::time_point m_lastPresent;
+	// moving estimate of the time between input sampling and present, used by LowLatency
+	Clock::duration m_frameWorkEstimate;
+
+	uint64_t m_framesCount;
+	double m_averageFrameTime;
+	double m_frameTimeSquaresSum;
+	double m_minFrameTime;
+	double m_maxFrameTime;
+};
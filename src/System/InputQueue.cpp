@@ -0,0 +1,37 @@
+#include "InputQueue.h"
+#include <chrono>
+
+uint64_t InputQueue::now()
+{
+	return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+bool InputQueue::push(const int key, const int action)
+{
+	if (!m_events.push({ key, action, now() }))
+	{
+		++m_droppedEventsCount;
+		return false;
+	}
+	return true;
+}
+
+void InputQueue::onFramePresented(const uint64_t inputTimestamp)
+{
+	// the same snapshot may be presented several times, count its input once
+	if (inputTimestamp == 0 || inputTimestamp <= m_lastPresentedTimestamp)
+	{
+		return;
+	}
+	m_lastPresentedTimestamp = inputTimestamp;
+
+	const double latency = static_cast<double>(now() - inputTimestamp) / 1e6;
+	m_totalLatency += latency;
+	m_maxLatency = latency > m_maxLatency ? latency : m_maxLatency;
+	++m_presentedInputsCount;
+}
+
+double InputQueue::getAverageLatency() const
+{
+	return m_presentedInputsCount > 0 ? m_totalLatency / m_presentedInputsCount : 0;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "SPSCQueue.h"
+#include <cstdint>
+
+struct InputEvent
+{
+	int key;
+	int action;
+	uint64_t timestamp;
+};
+
+// Key events travel from the window thread to the simulation thread through a lock-free ring.
+// The simulation drains the events stamped before the start of a tick and applies them in order.
+// The presenting thread reports when the frame built from those events reaches the screen;
+// latencies are in milliseconds.
+class InputQueue
+{
+public:
+	static uint64_t now();
+
+	bool push(const int key, const int action);
+
+	template<class TFunction>
+	uint64_t drain(const uint64_t tickTimestamp, const TFunction& apply)
+	{
+		uint64_t oldestTimestamp = 0;
+		for (const InputEvent* pEvent = m_events.front(); pEvent && pEvent->timestamp <= tickTimestamp; pEvent = m_events.front())
+		{
+			if (oldestTimestamp == 0)
+			{
+				oldestTimestamp = pEvent->timestamp;
+			}
+			apply(*pEvent);
+			m_events.pop();
+		}
+		return oldestTimestamp;
+	}
+
+	void onFramePresented(const uint64_t inputTimestamp);
+	double getAverageLatency() const;
+	double getMaxLatency() const { return m_maxLatency; }
+	uint64_t getPresentedInputsCount() const { return m_presentedInputsCount; }
+	uint64_t getDroppedEventsCount() const { return m_droppedEventsCount; }
+
+private:
+	SPSCQueue<InputEvent, 256> m_events;
+	uint64_t m_droppedEventsCount = 0;
+
+	uint64_t m_lastPresentedTimestamp = 0;
+	uint64_t m_presentedInputsCount = 0;
+	double m_totalLatency = 0;
+	double m_maxLatency = 0;
+};
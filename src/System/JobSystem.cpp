@@ -0,0 +1,230 @@
+#include "JobSystem.h"
+#include "Profiler.h"
+#include <chrono>
+#include <string>
+
+std::vector<std::unique_ptr<JobSystem::Worker>> JobSystem::m_workers;
+std::atomic<bool> JobSystem::m_isRunning(false);
+std::atomic<int32_t> JobSystem::m_queuedJobs(0);
+std::atomic<int32_t> JobSystem::m_sleepingWorkers(0);
+std::mutex JobSystem::m_sleepMutex;
+std::condition_variable JobSystem::m_wakeCondition;
+thread_local int JobSystem::m_workerIndex = -1;
+
+bool JobSystem::WorkStealingQueue::push(Job* pJob)
+{
+	const int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+	const int64_t top = m_top.load(std::memory_order_acquire);
+	if (bottom - top >= CAPACITY)
+	{
+		return false;
+	}
+	m_jobs[bottom & (CAPACITY - 1)].store(pJob, std::memory_order_relaxed);
+	m_bottom.store(bottom + 1, std::memory_order_release);
+	return true;
+}
+
+Job* JobSystem::WorkStealingQueue::pop()
+{
+	const int64_t bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+	m_bottom.store(bottom, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	int64_t top = m_top.load(std::memory_order_relaxed);
+	if (top > bottom)
+	{
+		m_bottom.store(bottom + 1, std::memory_order_relaxed);
+		return nullptr;
+	}
+
+	Job* pJob = m_jobs[bottom & (CAPACITY - 1)].load(std::memory_order_relaxed);
+	if (top == bottom)
+	{
+		// last job in the queue, race the thieves for it
+		if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+		{
+			pJob = nullptr;
+		}
+		m_bottom.store(bottom + 1, std::memory_order_relaxed);
+	}
+	return pJob;
+}
+
+Job* JobSystem::WorkStealingQueue::steal()
+{
+	int64_t top = m_top.load(std::memory_order_acquire);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	const int64_t bottom = m_bottom.load(std::memory_order_acquire);
+	if (top >= bottom)
+	{
+		return nullptr;
+	}
+
+	Job* pJob = m_jobs[top & (CAPACITY - 1)].load(std::memory_order_relaxed);
+	if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+	{
+		return nullptr;
+	}
+	return pJob;
+}
+
+void JobSystem::init(unsigned int threadsCount)
+{
+	terminate();
+	if (threadsCount == 0)
+	{
+		threadsCount = 1;
+	}
+
+	m_isRunning = true;
+	m_workers.reserve(threadsCount);
+	for (unsigned int currentWorker = 0; currentWorker < threadsCount; ++currentWorker)
+	{
+		m_workers.emplace_back(std::make_unique<Worker>());
+	}
+	// the calling thread is worker 0 and executes jobs while it waits
+	m_workerIndex = 0;
+	for (unsigned int currentWorker = 1; currentWorker < threadsCount; ++currentWorker)
+	{
+		m_workers[currentWorker]->thread = std::thread(&JobSystem::workerThread, currentWorker);
+	}
+}
+
+void JobSystem::terminate()
+{
+	if (m_workers.empty())
+	{
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lock(m_sleepMutex);
+		m_isRunning = false;
+	}
+	m_wakeCondition.notify_all();
+	for (auto& currentWorker : m_workers)
+	{
+		if (currentWorker->thread.joinable())
+		{
+			currentWorker->thread.join();
+		}
+	}
+	m_workers.clear();
+	m_queuedJobs = 0;
+	m_workerIndex = -1;
+}
+
+Job* JobSystem::createJob(JobFunction function, Job* pParent)
+{
+	Worker& worker = *m_workers[m_workerIndex];
+	Job* pJob = &worker.jobPool[worker.allocatedJobs++ & (MAX_JOBS_PER_THREAD - 1)];
+	pJob->function = function;
+	pJob->pParent = pParent;
+	pJob->unfinishedJobs.store(1, std::memory_order_relaxed);
+	if (pParent)
+	{
+		pParent->unfinishedJobs.fetch_add(1, std::memory_order_relaxed);
+	}
+	return pJob;
+}
+
+void JobSystem::run(Job* pJob)
+{
+	if (!m_workers[m_workerIndex]->queue.push(pJob))
+	{
+		// the queue is full, don't block the producer
+		execute(pJob);
+		return;
+	}
+	// pairs with the sleeping worker incrementing the counter before it checks for queued jobs
+	m_queuedJobs.fetch_add(1, std::memory_order_seq_cst);
+	if (m_sleepingWorkers.load(std::memory_order_seq_cst) > 0)
+	{
+		// a worker between its check and the wait holds the mutex, so the notification can't be lost
+		{
+			std::lock_guard<std::mutex> lock(m_sleepMutex);
+		}
+		m_wakeCondition.notify_one();
+	}
+}
+
+void JobSystem::wait(const Job* pJob)
+{
+	while (pJob->unfinishedJobs.load(std::memory_order_acquire) > 0)
+	{
+		Job* pNextJob = getJob();
+		if (pNextJob)
+		{
+			execute(pNextJob);
+		}
+		else
+		{
+			std::this_thread::yield();
+		}
+	}
+}
+
+Job* JobSystem::getJob()
+{
+	Job* pJob = m_workers[m_workerIndex]->queue.pop();
+	if (!pJob)
+	{
+		const size_t workersCount = m_workers.size();
+		for (size_t currentOffset = 1; currentOffset < workersCount && !pJob; ++currentOffset)
+		{
+			pJob = m_workers[(m_workerIndex + currentOffset) % workersCount]->queue.steal();
+		}
+	}
+	if (pJob)
+	{
+		m_queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+	}
+	return pJob;
+}
+
+void JobSystem::execute(Job* pJob)
+{
+	pJob->function(*pJob);
+	finish(pJob);
+}
+
+void JobSystem::finish(Job* pJob)
+{
+	const int32_t unfinishedJobs = pJob->unfinishedJobs.fetch_sub(1, std::memory_order_acq_rel) - 1;
+	if (unfinishedJobs == 0 && pJob->pParent)
+	{
+		finish(pJob->pParent);
+	}
+}
+
+void JobSystem::workerThread(const unsigned int workerIndex)
+{
+	m_workerIndex = static_cast<int>(workerIndex);
+	PROFILE_THREAD("Worker " + std::to_string(workerIndex));
+	unsigned int idleSpins = 0;
+	while (m_isRunning.load(std::memory_order_relaxed))
+	{
+		Job* pJob = getJob();
+		if (pJob)
+		{
+			execute(pJob);
+			idleSpins = 0;
+			continue;
+		}
+
+		if (++idleSpins < 256)
+		{
+			std::this_thread::yield();
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(m_sleepMutex);
+		m_sleepingWorkers.fetch_add(1, std::memory_order_seq_cst);
+		// idle workers stay asleep while the game is paused, the timeout is only a safety net
+		m_wakeCondition.wait_for(lock, std::chrono::milliseconds(100), []()
+			{
+				return !m_isRunning || m_queuedJobs.load(std::memory_order_seq_cst) > 0;
+			}
+		);
+		m_sleepingWorkers.fetch_sub(1, std::memory_order_acq_rel);
+		idleSpins = 0;
+	}
+}
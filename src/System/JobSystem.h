@@ -0,0 +1,140 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <thread>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <type_traits>
+
+struct Job;
+typedef void (*JobFunction)(Job&);
+
+struct alignas(64) Job
+{
+	JobFunction function;
+	Job* pParent;
+	std::atomic<int32_t> unfinishedJobs;
+	alignas(8) unsigned char data[40];
+
+	template<class TData>
+	const TData& getData() const { return *reinterpret_cast<const TData*>(data); }
+};
+
+// Work-stealing job system: every worker owns a lock-free deque, pushes and pops at its bottom
+// and steals from the top of the others. Jobs may be created, run and waited on from the thread
+// that called init() and from inside jobs. Each thread recycles a ring of MAX_JOBS_PER_THREAD jobs,
+// so no more than that may be in flight per thread.
+class JobSystem
+{
+public:
+	static constexpr size_t MAX_JOBS_PER_THREAD = 4096;
+
+	~JobSystem() = delete;
+	JobSystem() = delete;
+	JobSystem(const JobSystem&) = delete;
+	JobSystem& operator = (const JobSystem&) = delete;
+	JobSystem& operator = (JobSystem&&) = delete;
+	JobSystem(JobSystem&&) = delete;
+
+	static void init(unsigned int threadsCount = std::thread::hardware_concurrency());
+	static void terminate();
+	static bool isRunning() { return !m_workers.empty(); }
+	static unsigned int getThreadsCount() { return static_cast<unsigned int>(m_workers.size()); }
+	// 0 for the thread that called init(), -1 for threads outside the job system
+	static int getCurrentWorkerIndex() { return m_workerIndex; }
+
+	static Job* createJob(JobFunction function, Job* pParent = nullptr);
+	template<class TData>
+	static Job* createJob(JobFunction function, const TData& data, Job* pParent = nullptr)
+	{
+		static_assert(sizeof(TData) <= sizeof(Job::data) && std::is_trivially_copyable_v<TData>, "Job data doesn't fit into a job");
+		Job* pJob = createJob(function, pParent);
+		std::memcpy(pJob->data, &data, sizeof(TData));
+		return pJob;
+	}
+	static void run(Job* pJob);
+	static void wait(const Job* pJob);
+
+	// Calls function(begin, end) over [0, count) split into chunks of at least grainSize elements
+	template<class TFunction>
+	static void parallelFor(const size_t count, size_t grainSize, const TFunction& function)
+	{
+		const size_t threadsCount = getThreadsCount();
+		if (threadsCount <= 1 || count <= grainSize || m_workerIndex < 0)
+		{
+			function(size_t(0), count);
+			return;
+		}
+		// bound the number of jobs in flight independently of count
+		const size_t minGrainSize = count / (threadsCount * 16);
+		grainSize = grainSize > minGrainSize ? grainSize : minGrainSize;
+
+		Job* pRoot = createJob(&parallelForJob<TFunction>, ParallelForData{ &function, 0, count, grainSize });
+		run(pRoot);
+		wait(pRoot);
+	}
+
+private:
+	struct ParallelForData
+	{
+		const void* pFunction;
+		size_t begin;
+		size_t end;
+		size_t grainSize;
+	};
+
+	template<class TFunction>
+	static void parallelForJob(Job& job)
+	{
+		const ParallelForData& data = job.getData<ParallelForData>();
+		if (data.end - data.begin <= data.grainSize)
+		{
+			(*static_cast<const TFunction*>(data.pFunction))(data.begin, data.end);
+			return;
+		}
+		const size_t middle = data.begin + (data.end - data.begin) / 2;
+		run(createJob(&parallelForJob<TFunction>, ParallelForData{ data.pFunction, data.begin, middle, data.grainSize }, &job));
+		run(createJob(&parallelForJob<TFunction>, ParallelForData{ data.pFunction, middle, data.end, data.grainSize }, &job));
+	}
+
+	class WorkStealingQueue
+	{
+	public:
+		static constexpr int64_t CAPACITY = MAX_JOBS_PER_THREAD;
+
+		bool push(Job* pJob);
+		Job* pop();
+		Job* steal();
+
+	private:
+		alignas(64) std::atomic<int64_t> m_top{ 0 };
+		alignas(64) std::atomic<int64_t> m_bottom{ 0 };
+		std::atomic<Job*> m_jobs[CAPACITY];
+	};
+
+	struct Worker
+	{
+		WorkStealingQueue queue;
+		std::vector<Job> jobPool = std::vector<Job>(MAX_JOBS_PER_THREAD);
+		size_t allocatedJobs = 0;
+		std::thread thread;
+	};
+
+	static void workerThread(const unsigned int workerIndex);
+	static Job* getJob();
+	static void execute(Job* pJob);
+	static void finish(Job* pJob);
+
+	static std::vector<std::unique_ptr<Worker>> m_workers;
+	static std::atomic<bool> m_isRunning;
+	static std::atomic<int32_t> m_queuedJobs;
+	static std::atomic<int32_t> m_sleepingWorkers;
+	static std::mutex m_sleepMutex;
+	static std::condition_variable m_wakeCondition;
+	static thread_local int m_workerIndex;
+};
@@ -0,0 +1,284 @@
+#include "Metrics.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+std::mutex Metrics::m_registerMutex;
+std::array<std::unique_ptr<Metrics::Metric>, Metrics::MAX_METRICS> Metrics::m_metrics;
+std::atomic<size_t> Metrics::m_metricsCount(0);
+
+namespace
+{
+	// the allocating threads count into shards of their own cache line instead of contending for one
+	struct alignas(64) AllocationShard
+	{
+		std::atomic<uint64_t> allocationsCount;
+		std::atomic<uint64_t> deallocationsCount;
+		std::atomic<uint64_t> allocatedBytes;
+	};
+
+	constexpr size_t ALLOCATION_SHARDS_COUNT = 64;
+	constexpr uint32_t NO_SHARD = ~0u;
+	AllocationShard g_allocationShards[ALLOCATION_SHARDS_COUNT];
+	std::atomic<uint32_t> g_nextAllocationShard(0);
+	thread_local uint32_t t_allocationShard = NO_SHARD;
+
+	AllocationShard& getAllocationShard()
+	{
+		if (t_allocationShard == NO_SHARD)
+		{
+			t_allocationShard = g_nextAllocationShard.fetch_add(1, std::memory_order_relaxed) % ALLOCATION_SHARDS_COUNT;
+		}
+		return g_allocationShards[t_allocationShard];
+	}
+
+	template<class TFunction>
+	uint64_t sumAllocationShards(const TFunction& getValue)
+	{
+		uint64_t sum = 0;
+		for (const AllocationShard& currentShard : g_allocationShards)
+		{
+			sum += getValue(currentShard).load(std::memory_order_relaxed);
+		}
+		return sum;
+	}
+}
+
+void Metrics::recordAllocation(const size_t size)
+{
+	AllocationShard& shard = getAllocationShard();
+	shard.allocationsCount.fetch_add(1, std::memory_order_relaxed);
+	shard.allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+}
+
+void Metrics::recordDeallocation()
+{
+	getAllocationShard().deallocationsCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+uint64_t Metrics::getAllocationsCount()
+{
+	return sumAllocationShards([](const AllocationShard& shard) -> const std::atomic<uint64_t>& { return shard.allocationsCount; });
+}
+
+uint64_t Metrics::getDeallocationsCount()
+{
+	return sumAllocationShards([](const AllocationShard& shard) -> const std::atomic<uint64_t>& { return shard.deallocationsCount; });
+}
+
+uint64_t Metrics::getAllocatedBytes()
+{
+	return sumAllocationShards([](const AllocationShard& shard) -> const std::atomic<uint64_t>& { return shard.allocatedBytes; });
+}
+
+void Metrics::Histogram::observe(const double value)
+{
+	const size_t bucket = static_cast<size_t>(std::lower_bound(m_bounds.begin(), m_bounds.begin() + m_boundsCount, value) - m_bounds.begin());
+	m_counts[bucket].fetch_add(1, std::memory_order_relaxed);
+	double sum = m_sum.load(std::memory_order_relaxed);
+	while (!m_sum.compare_exchange_weak(sum, sum + value, std::memory_order_relaxed))
+	{
+	}
+}
+
+double Metrics::Histogram::getUpperBound(const size_t bucket) const
+{
+	return bucket < m_boundsCount ? m_bounds[bucket] : HUGE_VAL;
+}
+
+Metrics::Metric& Metrics::registerMetric(const char* name, const char* help, const EType type, const double* pUpperBounds, const size_t boundsCount)
+{
+	std::lock_guard<std::mutex> lock(m_registerMutex);
+	const size_t metricsCount = m_metricsCount.load(std::memory_order_relaxed);
+	for (size_t currentMetric = 0; currentMetric < metricsCount; ++currentMetric)
+	{
+		if (std::strcmp(m_metrics[currentMetric]->name, name) == 0)
+		{
+			return *m_metrics[currentMetric];
+		}
+	}
+	if (metricsCount == MAX_METRICS)
+	{
+		std::fprintf(stderr, "Too many metrics, %s is not exported\n", name);
+		// updated like any other, never written out
+		static Metric unexported;
+		return unexported;
+	}
+	m_metrics[metricsCount] = std::make_unique<Metric>();
+	Metric& metric = *m_metrics[metricsCount];
+	metric.name = name;
+	metric.help = help;
+	metric.type = type;
+	metric.histogram.m_boundsCount = std::min(boundsCount, MAX_BUCKETS);
+	std::copy(pUpperBounds, pUpperBounds + metric.histogram.m_boundsCount, metric.histogram.m_bounds.begin());
+	m_metricsCount.store(metricsCount + 1, std::memory_order_release);
+	return metric;
+}
+
+Metrics::Counter& Metrics::counter(const char* name, const char* help)
+{
+	return registerMetric(name, help, EType::Counter, nullptr, 0).counter;
+}
+
+Metrics::Gauge& Metrics::gauge(const char* name, const char* help)
+{
+	return registerMetric(name, help, EType::Gauge, nullptr, 0).gauge;
+}
+
+Metrics::Histogram& Metrics::histogram(const char* name, const char* help, const double* pUpperBounds, const size_t boundsCount)
+{
+	return registerMetric(name, help, EType::Histogram, pUpperBounds, boundsCount).histogram;
+}
+
+const char* Metrics::getTypeName(const EType type)
+{
+	switch (type)
+	{
+	case EType::Counter: return "counter";
+	case EType::Gauge: return "gauge";
+	case EType::Histogram: return "histogram";
+	}
+	return "untyped";
+}
+
+static void appendNumber(std::string& text, const double value)
+{
+	if (std::isinf(value))
+	{
+		text += value > 0.0 ? "+Inf" : "-Inf";
+		return;
+	}
+	char buffer[32];
+	std::snprintf(buffer, sizeof(buffer), "%.9g", value);
+	text += buffer;
+}
+
+static void appendPrometheusMetric(std::string& text, const char* name, const char* help, const char* type, const double value)
+{
+	text += "# HELP ";
+	text += name;
+	text += ' ';
+	text += help;
+	text += "\n# TYPE ";
+	text += name;
+	text += ' ';
+	text += type;
+	text += '\n';
+	text += name;
+	text += ' ';
+	appendNumber(text, value);
+	text += '\n';
+}
+
+void Metrics::writePrometheus(std::string& text)
+{
+	const size_t metricsCount = m_metricsCount.load(std::memory_order_acquire);
+	for (size_t currentMetric = 0; currentMetric < metricsCount; ++currentMetric)
+	{
+		const Metric& metric = *m_metrics[currentMetric];
+		if (metric.type != EType::Histogram)
+		{
+			appendPrometheusMetric(text, metric.name, metric.help, getTypeName(metric.type),
+								   metric.type == EType::Counter ? static_cast<double>(metric.counter.get()) : metric.gauge.get());
+			continue;
+		}
+		text += "# HELP ";
+		text += metric.name;
+		text += ' ';
+		text += metric.help;
+		text += "\n# TYPE ";
+		text += metric.name;
+		text += " histogram\n";
+		// Prometheus buckets are cumulative
+		uint64_t count = 0;
+		for (size_t currentBucket = 0; currentBucket < metric.histogram.getBucketsCount(); ++currentBucket)
+		{
+			count += metric.histogram.getCount(currentBucket);
+			text += metric.name;
+			text += "_bucket{le=\"";
+			appendNumber(text, metric.histogram.getUpperBound(currentBucket));
+			text += "\"} ";
+			text += std::to_string(count);
+			text += '\n';
+		}
+		text += metric.name;
+		text += "_sum ";
+		appendNumber(text, metric.histogram.getSum());
+		text += '\n';
+		text += metric.name;
+		text += "_count ";
+		text += std::to_string(count);
+		text += '\n';
+	}
+	// nothing is counted unless the executable was built with the counting operator new
+	const uint64_t allocationsCount = getAllocationsCount();
+	const uint64_t deallocationsCount = getDeallocationsCount();
+	if (allocationsCount == 0)
+	{
+		return;
+	}
+	appendPrometheusMetric(text, "battlecity_allocations_total", "Allocations through the global operator new", "counter", static_cast<double>(allocationsCount));
+	appendPrometheusMetric(text, "battlecity_deallocations_total", "Deallocations through the global operator delete", "counter", static_cast<double>(deallocationsCount));
+	appendPrometheusMetric(text, "battlecity_allocated_bytes_total", "Bytes requested from the global operator new", "counter", static_cast<double>(getAllocatedBytes()));
+	appendPrometheusMetric(text, "battlecity_live_allocations", "Allocations not deallocated yet", "gauge",
+						   static_cast<double>(allocationsCount) - static_cast<double>(deallocationsCount));
+}
+
+void Metrics::writeJSONLine(std::string& text)
+{
+	char time[32];
+	std::snprintf(time, sizeof(time), "{\"time\":%.3f", std::chrono::duration<double>(std::chrono::system_clock::now().time_since_epoch()).count());
+	text += time;
+	const size_t metricsCount = m_metricsCount.load(std::memory_order_acquire);
+	for (size_t currentMetric = 0; currentMetric < metricsCount; ++currentMetric)
+	{
+		const Metric& metric = *m_metrics[currentMetric];
+		text += ",\"";
+		text += metric.name;
+		text += "\":";
+		if (metric.type == EType::Counter)
+		{
+			text += std::to_string(metric.counter.get());
+			continue;
+		}
+		if (metric.type == EType::Gauge)
+		{
+			appendNumber(text, metric.gauge.get());
+			continue;
+		}
+		// the upper bounds without the last +Inf one and a count per bucket, not cumulative
+		text += "{\"bounds\":[";
+		uint64_t count = 0;
+		for (size_t currentBucket = 0; currentBucket + 1 < metric.histogram.getBucketsCount(); ++currentBucket)
+		{
+			text += currentBucket > 0 ? "," : "";
+			appendNumber(text, metric.histogram.getUpperBound(currentBucket));
+		}
+		text += "],\"counts\":[";
+		for (size_t currentBucket = 0; currentBucket < metric.histogram.getBucketsCount(); ++currentBucket)
+		{
+			text += currentBucket > 0 ? "," : "";
+			text += std::to_string(metric.histogram.getCount(currentBucket));
+			count += metric.histogram.getCount(currentBucket);
+		}
+		text += "],\"sum\":";
+		appendNumber(text, metric.histogram.getSum());
+		text += ",\"count\":";
+		text += std::to_string(count);
+		text += '}';
+	}
+	const uint64_t allocationsCount = getAllocationsCount();
+	if (allocationsCount > 0)
+	{
+		text += ",\"battlecity_allocations_total\":";
+		text += std::to_string(allocationsCount);
+		text += ",\"battlecity_deallocations_total\":";
+		text += std::to_string(getDeallocationsCount());
+		text += ",\"battlecity_allocated_bytes_total\":";
+		text += std::to_string(getAllocatedBytes());
+	}
+	text += "}\n";
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+
+// Process-wide registry of named counters, gauges and fixed-bucket histograms, the numbers ops watch over
+// time. A metric is registered once, into a function-local static reference, and from then on updated
+// from any thread with relaxed atomics: no locks, no allocation. Readers take the values at any time
+// and render them as Prometheus text or as a JSON line. The allocations of the process are counted only
+// in the executables built with AllocationCounter.cpp, its operator new and delete report them here.
+class Metrics
+{
+public:
+	static constexpr size_t MAX_METRICS = 128;
+	static constexpr size_t MAX_BUCKETS = 16;
+	// upper bounds in seconds for tick and frame times, around the 16.7 ms budget of a tick
+	static constexpr std::array<double, 11> TICK_TIME_BOUNDS = { 0.0005, 0.001, 0.002, 0.004, 0.008, 0.0125, 0.0167, 0.025, 0.0333, 0.05, 0.1 };
+
+	class Counter
+	{
+	public:
+		void add(const uint64_t value = 1) { m_value.fetch_add(value, std::memory_order_relaxed); }
+		uint64_t get() const { return m_value.load(std::memory_order_relaxed); }
+
+	private:
+		std::atomic<uint64_t> m_value{ 0 };
+	};
+
+	class Gauge
+	{
+	public:
+		void set(const double value) { m_value.store(value, std::memory_order_relaxed); }
+		double get() const { return m_value.load(std::memory_order_relaxed); }
+
+	private:
+		std::atomic<double> m_value{ 0.0 };
+	};
+
+	// counts of the values up to each upper bound, the last bucket takes the rest (+Inf)
+	class Histogram
+	{
+	public:
+		void observe(const double value);
+		size_t getBucketsCount() const { return m_boundsCount + 1; }
+		// +Inf for the last bucket
+		double getUpperBound(const size_t bucket) const;
+		// not cumulative
+		uint64_t getCount(const size_t bucket) const { return m_counts[bucket].load(std::memory_order_relaxed); }
+		double getSum() const { return m_sum.load(std::memory_order_relaxed); }
+
+	private:
+		friend class Metrics;
+
+		std::array<double, MAX_BUCKETS> m_bounds = {};
+		size_t m_boundsCount = 0;
+		std::array<std::atomic<uint64_t>, MAX_BUCKETS + 1> m_counts = {};
+		std::atomic<double> m_sum{ 0.0 };
+	};
+
+	// Registers a metric or returns the one registered under the name. Names follow Prometheus:
+	// snake case with the unit last, "_total" for counters; name and help must be string literals.
+	static Counter& counter(const char* name, const char* help);
+	static Gauge& gauge(const char* name, const char* help);
+	// at most MAX_BUCKETS ascending upper bounds
+	static Histogram& histogram(const char* name, const char* help, const double* pUpperBounds, const size_t boundsCount);
+	template<size_t BoundsCount>
+	static Histogram& histogram(const char* name, const char* help, const std::array<double, BoundsCount>& upperBounds)
+	{
+		static_assert(BoundsCount <= MAX_BUCKETS, "too many buckets");
+		return histogram(name, help, upperBounds.data(), BoundsCount);
+	}
+
+	// Prometheus text exposition format
+	static void writePrometheus(std::string& text);
+	// one JSON object on a line: the Unix time, then every metric by name, histograms as buckets, sum and count
+	static void writeJSONLine(std::string& text);
+
+	// called by the counting operator new and delete
+	static void recordAllocation(const size_t size);
+	static void recordDeallocation();
+	// 0 without the counting operator new
+	static uint64_t getAllocationsCount();
+	static uint64_t getDeallocationsCount();
+	static uint64_t getAllocatedBytes();
+
+private:
+	enum class EType : uint8_t
+	{
+		Counter,
+		Gauge,
+		Histogram
+	};
+
+	struct Metric
+	{
+		const char* name = "";
+		const char* help = "";
+		EType type = EType::Counter;
+		Counter counter;
+		Gauge gauge;
+		Histogram histogram;
+	};
+
+	static Metric& registerMetric(const char* name, const char* help, const EType type, const double* pUpperBounds, const size_t boundsCount);
+	static const char* getTypeName(const EType type);
+
+	static std::mutex m_registerMutex;
+	// written once under the mutex, then published by the count
+	static std::array<std::unique_ptr<Metric>, MAX_METRICS> m_metrics;
+	static std::atomic<size_t> m_metricsCount;
+};
@@ -0,0 +1,194 @@
+#include "Profiler.h"
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/writer.h>
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+
+std::mutex Profiler::m_tracksMutex;
+std::vector<std::unique_ptr<Profiler::Track>> Profiler::m_tracks;
+std::atomic<uint64_t> Profiler::m_frameStarts[FRAMES_CAPACITY];
+std::atomic<uint64_t> Profiler::m_framesCount(0);
+
+thread_local Profiler::ThreadTrack Profiler::m_threadTrack;
+
+static const uint64_t g_calibrationTicks = Profiler::now();
+static const uint64_t g_calibrationNanoseconds = Profiler::getSteadyNanoseconds();
+
+uint64_t Profiler::getSteadyNanoseconds()
+{
+	return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+double Profiler::getTicksPerNanosecond()
+{
+#if defined(BATTLECITY_PROFILER_TSC)
+	// the rate is measured over the whole run, the longer the run the better the estimate
+	const uint64_t elapsedNanoseconds = getSteadyNanoseconds() - g_calibrationNanoseconds;
+	const uint64_t elapsedTicks = now() - g_calibrationTicks;
+	return elapsedNanoseconds > 0 && elapsedTicks > 0 ? static_cast<double>(elapsedTicks) / elapsedNanoseconds : 1.0;
+#else
+	return 1.0;
+#endif
+}
+
+double Profiler::ticksToNanoseconds(const uint64_t ticks)
+{
+	return static_cast<double>(ticks) / getTicksPerNanosecond();
+}
+
+uint64_t Profiler::nanosecondsToTicks(const double nanoseconds)
+{
+	return static_cast<uint64_t>(nanoseconds * getTicksPerNanosecond());
+}
+
+Profiler::ThreadTrack::~ThreadTrack()
+{
+	if (pTrack)
+	{
+		std::lock_guard<std::mutex> lock(m_tracksMutex);
+		pTrack->isReleased = true;
+		pTrack = nullptr;
+	}
+}
+
+Profiler::Track& Profiler::getThreadTrack()
+{
+	if (m_threadTrack.pTrack)
+	{
+		return *m_threadTrack.pTrack;
+	}
+	{
+		std::lock_guard<std::mutex> lock(m_tracksMutex);
+		const auto it = std::find_if(m_tracks.begin(), m_tracks.end(), [](const std::unique_ptr<Track>& pTrack) { return pTrack->isReleased; });
+		if (it != m_tracks.end())
+		{
+			// the zones of the exited thread are dropped with it, the dump reads under the mutex
+			Track& track = **it;
+			track.isReleased = false;
+			track.name = "Thread " + std::to_string(track.trackID);
+			track.writeIndex.store(0, std::memory_order_relaxed);
+			m_threadTrack.pTrack = &track;
+			return track;
+		}
+	}
+	m_threadTrack.pTrack = createTrack(std::string());
+	return *m_threadTrack.pTrack;
+}
+
+Profiler::Track* Profiler::createTrack(const std::string& name)
+{
+	std::lock_guard<std::mutex> lock(m_tracksMutex);
+	m_tracks.emplace_back(std::make_unique<Track>());
+	Track* pTrack = m_tracks.back().get();
+	pTrack->trackID = m_tracks.size();
+	pTrack->name = name.empty() ? "Thread " + std::to_string(pTrack->trackID) : name;
+	return pTrack;
+}
+
+void Profiler::recordZone(const char* name, const uint64_t start, const uint64_t end)
+{
+	recordZone(getThreadTrack(), name, start, end);
+}
+
+void Profiler::recordZone(Track& track, const char* name, const uint64_t start, const uint64_t end)
+{
+	const uint64_t index = track.writeIndex.load(std::memory_order_relaxed);
+	// a seqlock: writeIndex reached index before the slot of zone index - RING_CAPACITY is overwritten
+	std::atomic_thread_fence(std::memory_order_release);
+	ZoneRecord& zone = track.zones[index & (RING_CAPACITY - 1)];
+	zone.name.store(name, std::memory_order_relaxed);
+	zone.start.store(start, std::memory_order_relaxed);
+	zone.end.store(end, std::memory_order_relaxed);
+	track.writeIndex.store(index + 1, std::memory_order_release);
+}
+
+void Profiler::setThreadName(const std::string& name)
+{
+	Track& track = getThreadTrack();
+	std::lock_guard<std::mutex> lock(m_tracksMutex);
+	track.name = name;
+}
+
+void Profiler::markFrame()
+{
+	const uint64_t frame = m_framesCount.load(std::memory_order_relaxed);
+	m_frameStarts[frame % FRAMES_CAPACITY].store(now(), std::memory_order_relaxed);
+	m_framesCount.store(frame + 1, std::memory_order_release);
+}
+
+bool Profiler::dumpChromeTrace(const std::string& path, const size_t framesCount)
+{
+	const uint64_t currentFrame = m_framesCount.load(std::memory_order_acquire);
+	const uint64_t firstFrame = currentFrame - std::min<uint64_t>({ currentFrame, framesCount, FRAMES_CAPACITY });
+	const uint64_t traceStart = currentFrame > 0 ? m_frameStarts[firstFrame % FRAMES_CAPACITY].load(std::memory_order_relaxed) : 0;
+	const double ticksPerMicrosecond = getTicksPerNanosecond() * 1000.0;
+
+	rapidjson::StringBuffer buffer;
+	rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+	writer.StartObject();
+	writer.Key("displayTimeUnit");
+	writer.String("ms");
+	writer.Key("traceEvents");
+	writer.StartArray();
+
+	size_t zonesCount = 0;
+	{
+		std::lock_guard<std::mutex> lock(m_tracksMutex);
+		for (const auto& pTrack : m_tracks)
+		{
+			writer.StartObject();
+			writer.Key("name"); writer.String("thread_name");
+			writer.Key("ph"); writer.String("M");
+			writer.Key("pid"); writer.Uint(1);
+			writer.Key("tid"); writer.Uint64(pTrack->trackID);
+			writer.Key("args"); writer.StartObject(); writer.Key("name"); writer.String(pTrack->name.c_str()); writer.EndObject();
+			writer.EndObject();
+
+			// the owner keeps writing while we read: zones overwritten meanwhile are dropped below
+			const uint64_t writeIndex = pTrack->writeIndex.load(std::memory_order_acquire);
+			const uint64_t readIndex = writeIndex - std::min<uint64_t>(writeIndex, RING_CAPACITY);
+			for (uint64_t index = readIndex; index < writeIndex; ++index)
+			{
+				const ZoneRecord& zone = pTrack->zones[index & (RING_CAPACITY - 1)];
+				const char* name = zone.name.load(std::memory_order_relaxed);
+				const uint64_t start = zone.start.load(std::memory_order_relaxed);
+				const uint64_t end = zone.end.load(std::memory_order_relaxed);
+				// the record is read before writeIndex is checked again, a torn record is seen as overwritten
+				std::atomic_thread_fence(std::memory_order_acquire);
+				const uint64_t overwrittenIndex = pTrack->writeIndex.load(std::memory_order_relaxed);
+				if (index + RING_CAPACITY <= overwrittenIndex)
+				{
+					continue;
+				}
+				if (start < traceStart || end < start)
+				{
+					continue;
+				}
+				writer.StartObject();
+				writer.Key("name"); writer.String(name);
+				writer.Key("ph"); writer.String("X");
+				writer.Key("pid"); writer.Uint(1);
+				writer.Key("tid"); writer.Uint64(pTrack->trackID);
+				writer.Key("ts"); writer.Double(static_cast<double>(start - traceStart) / ticksPerMicrosecond);
+				writer.Key("dur"); writer.Double(static_cast<double>(end - start) / ticksPerMicrosecond);
+				writer.EndObject();
+				++zonesCount;
+			}
+		}
+	}
+
+	writer.EndArray();
+	writer.EndObject();
+
+	std::ofstream file(path, std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!file.is_open())
+	{
+		std::cerr << "Can't write profiler trace: " << path << std::endl;
+		return false;
+	}
+	file.write(buffer.GetString(), buffer.GetSize());
+	std::cout << "Profiler trace of " << currentFrame - firstFrame << " frames, " << zonesCount << " zones written to " << path << std::endl;
+	return true;
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define BATTLECITY_PROFILER_TSC 1
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BATTLECITY_PROFILER_TSC 1
+#endif
+
+#ifndef BATTLECITY_PROFILER
+#define BATTLECITY_PROFILER 1
+#endif
+
+// Scoped CPU zones recorded into per-thread rings. A thread only writes its own ring, without locks;
+// the oldest zones are overwritten. The main thread marks frames and can dump the last frames
+// as Chrome trace-event JSON (chrome://tracing, ui.perfetto.dev). Zones are stamped with raw
+// profiler ticks (the TSC on x86) and converted to nanoseconds only when they are read.
+class Profiler
+{
+public:
+	static constexpr size_t RING_CAPACITY = 1 << 16;
+	static constexpr size_t FRAMES_CAPACITY = 1024;
+
+	struct ZoneRecord
+	{
+		std::atomic<const char*> name;
+		std::atomic<uint64_t> start;
+		std::atomic<uint64_t> end;
+	};
+
+	struct Track
+	{
+		std::string name;
+		size_t trackID;
+		std::atomic<uint64_t> writeIndex{ 0 };
+		// the thread that wrote it exited, the next new thread takes it over; under the tracks mutex
+		bool isReleased = false;
+		ZoneRecord zones[RING_CAPACITY];
+	};
+
+	class Zone
+	{
+	public:
+		Zone(const char* name) : m_name(name), m_start(now()) {}
+		~Zone() { recordZone(m_name, m_start, now()); }
+
+		Zone(const Zone&) = delete;
+		Zone& operator = (const Zone&) = delete;
+
+	private:
+		const char* m_name;
+		uint64_t m_start;
+	};
+
+	static uint64_t now()
+	{
+#if defined(BATTLECITY_PROFILER_TSC)
+		return __rdtsc();
+#else
+		return getSteadyNanoseconds();
+#endif
+	}
+	static uint64_t getSteadyNanoseconds();
+	static double ticksToNanoseconds(const uint64_t ticks);
+	static uint64_t nanosecondsToTicks(const double nanoseconds);
+	// name must outlive the profiler, string literals are expected
+	static void recordZone(const char* name, const uint64_t start, const uint64_t end);
+	// zones timed elsewhere, e.g. on the GPU, go to their own track; a track must have a single writer
+	static Track* createTrack(const std::string& name);
+	static void recordZone(Track& track, const char* name, const uint64_t start, const uint64_t end);
+	static void setThreadName(const std::string& name);
+	static void markFrame();
+	static uint64_t getFramesCount() { return m_framesCount.load(std::memory_order_relaxed); }
+
+	static bool dumpChromeTrace(const std::string& path, const size_t framesCount);
+
+private:
+	// hands the track of an exiting thread back for reuse, threads come and go with every JobSystem::init
+	struct ThreadTrack
+	{
+		Track* pTrack = nullptr;
+		~ThreadTrack();
+	};
+
+	static Track& getThreadTrack();
+	static double getTicksPerNanosecond();
+
+	static std::mutex m_tracksMutex;
+	static std::vector<std::unique_ptr<Track>> m_tracks;
+	static std::atomic<uint64_t> m_frameStarts[FRAMES_CAPACITY];
+	static std::atomic<uint64_t> m_framesCount;
+	static thread_local ThreadTrack m_threadTrack;
+};
+
+#if BATTLECITY_PROFILER
+#define PROFILE_CONCAT_IMPL(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_IMPL(a, b)
+#define PROFILE_ZONE(name) Profiler::Zone PROFILE_CONCAT(profileZone, __LINE__)(name)
+#define PROFILE_FUNCTION() PROFILE_ZONE(__func__)
+#define PROFILE_THREAD(name) Profiler::setThreadName(name)
+#define PROFILE_FRAME() Profiler::markFrame()
+#else
+#define PROFILE_ZONE(name) ((void)0)
+#define PROFILE_FUNCTION() ((void)0)
+#define PROFILE_THREAD(name) ((void)0)
+#define PROFILE_FRAME() ((void)0)
+#endif
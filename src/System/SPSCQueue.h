@@ -0,0 +1,81 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+// Bounded lock-free queue for exactly one producer thread and one consumer thread.
+template<class T, size_t CAPACITY>
+class SPSCQueue
+{
+	static_assert((CAPACITY & (CAPACITY - 1)) == 0, "SPSCQueue capacity must be a power of two");
+
+public:
+	bool push(const T& value)
+	{
+		const size_t tail = m_tail.load(std::memory_order_relaxed);
+		if (tail - m_head.load(std::memory_order_acquire) == CAPACITY)
+		{
+			return false;
+		}
+		m_items[tail & (CAPACITY - 1)] = value;
+		m_tail.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	// The free slot offset places after the next push, nullptr if the queue has no room for it. The
+	// producer fills slots in place and publishes them with commitPush(), large items aren't copied twice.
+	T* beginPush(const size_t offset = 0)
+	{
+		const size_t tail = m_tail.load(std::memory_order_relaxed);
+		if (tail + offset - m_head.load(std::memory_order_acquire) >= CAPACITY)
+		{
+			return nullptr;
+		}
+		return &m_items[(tail + offset) & (CAPACITY - 1)];
+	}
+
+	void commitPush(const size_t count = 1)
+	{
+		m_tail.store(m_tail.load(std::memory_order_relaxed) + count, std::memory_order_release);
+	}
+
+	const T* front() const
+	{
+		const size_t head = m_head.load(std::memory_order_relaxed);
+		if (head == m_tail.load(std::memory_order_acquire))
+		{
+			return nullptr;
+		}
+		return &m_items[head & (CAPACITY - 1)];
+	}
+
+	// the item offset places after the head, nullptr if the queue holds no more than offset items
+	const T* peek(const size_t offset) const
+	{
+		const size_t head = m_head.load(std::memory_order_relaxed);
+		if (m_tail.load(std::memory_order_acquire) - head <= offset)
+		{
+			return nullptr;
+		}
+		return &m_items[(head + offset) & (CAPACITY - 1)];
+	}
+
+	// the consumer may change an item before popping it, e.g. release what it holds
+	T* peek(const size_t offset)
+	{
+		return const_cast<T*>(static_cast<const SPSCQueue&>(*this).peek(offset));
+	}
+
+	bool isEmpty() const { return m_head.load(std::memory_order_acquire) == m_tail.load(std::memory_order_acquire); }
+
+	void pop(const size_t count = 1)
+	{
+		m_head.store(m_head.load(std::memory_order_relaxed) + count, std::memory_order_release);
+	}
+
+private:
+	alignas(64) std::atomic<size_t> m_head{ 0 };
+	alignas(64) std::atomic<size_t> m_tail{ 0 };
+	std::array<T, CAPACITY> m_items;
+};
@@ -26,6 +26,11 @@ void Timer::start(const double duration)
 	m_isRunning = true;
 }
 
+void Timer::stop()
+{
+	m_isRunning = false;
+}
+
 void Timer::setCallback(std::function<void()> callback)
 {
 	m_callback = callback;
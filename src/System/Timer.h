@@ -8,7 +8,11 @@ public:
 	Timer();
 	void update (const double delta);
 	void start (const double duration);
+	void stop();
+	bool isRunning() const { return m_isRunning; }
 	void setCallback(std::function<void()> callback);
+	// 0 when the timer is not running
+	double getTimeLeft() const { return m_isRunning ? m_timeLeft : 0.0; }
 
 private:
 	std::function<void()> m_callback;
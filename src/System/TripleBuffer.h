@@ -0,0 +1,41 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+// Lock-free single producer / single consumer triple buffer. The producer fills getWriteBuffer() and
+// publish()es it, the consumer calls update() to switch to the newest published buffer.
+// Neither side ever waits for the other.
+template<class T>
+class TripleBuffer
+{
+public:
+	T& getWriteBuffer() { return m_buffers[m_writeIndex]; }
+
+	void publish()
+	{
+		m_writeIndex = m_readyIndex.exchange(m_writeIndex | FRESH_BIT, std::memory_order_acq_rel) & INDEX_MASK;
+	}
+
+	bool update()
+	{
+		if ((m_readyIndex.load(std::memory_order_relaxed) & FRESH_BIT) == 0)
+		{
+			return false;
+		}
+		m_readIndex = m_readyIndex.exchange(m_readIndex, std::memory_order_acq_rel) & INDEX_MASK;
+		return true;
+	}
+
+	const T& getReadBuffer() const { return m_buffers[m_readIndex]; }
+
+private:
+	static constexpr uint8_t INDEX_MASK = 0x3;
+	static constexpr uint8_t FRESH_BIT = 0x4;
+
+	std::array<T, 3> m_buffers;
+	uint8_t m_writeIndex = 0;
+	std::atomic<uint8_t> m_readyIndex{ 1 };
+	uint8_t m_readIndex = 2;
+};
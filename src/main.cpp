@@ -7,14 +7,41 @@
 #include "Resources/ResourceManager.h"
 #include "Renderer/Renderer.h"
 #include "Physics/PhysicsEngine.h"
+#include "Game/SimulationThread.h"
+#include "Game/Replay.h"
+#include "Network/LinkConditioner.h"
+#include "Network/MetricsExporter.h"
+#include "Network/RollbackSession.h"
+#include "Network/UDPSocket.h"
+#include "System/FramePacer.h"
+#include "Renderer/FrameBuffer.h"
+#include "Renderer/GPUProfiler.h"
+#include "Renderer/RenderStats.h"
+#include "Renderer/StatsOverlay.h"
+#include "System/Profiler.h"
+#include <cstdlib>
+#include <string>
 
 glm::ivec2 g_window_Size(13 * 16, 14 * 16);
 std::unique_ptr<Game> g_game = std::make_unique<Game>(g_window_Size);
+bool g_windowIconified = false;
+bool g_windowResized = true;
+bool g_windowExposed = false;
+std::string g_profilerTracePath = "profile_trace.json";
+size_t g_profilerTraceFrames = 300;
+std::unique_ptr<RenderEngine::StatsOverlay> g_pStatsOverlay;
+bool g_showStatsOverlay = false;
+bool g_isNetworkGame = false;
 
 void glfwWindowSizeCallback(GLFWwindow* pWindow, int widht, int height)
 {
     g_window_Size.x = widht;
     g_window_Size.y = height;
+    g_windowResized = true;
+    if (widht == 0 || height == 0)
+    {
+        return;
+    }
 
     const float map_aspect_ratio = static_cast<float>(g_game->getCurrentLewelWidth()) / g_game->getCurrentLewelHeight();
     unsigned int viewPortWidth = g_window_Size.x;
@@ -41,12 +68,162 @@ void glfwKeyCallback(GLFWwindow* pWindow, int key, int scancode, int action, int
     {
         glfwSetWindowShouldClose(pWindow, GL_TRUE);
     }
+    if (key == GLFW_KEY_F12 && action == GLFW_PRESS)
+    {
+        Profiler::dumpChromeTrace(g_profilerTracePath, g_profilerTraceFrames);
+    }
+    if (key == GLFW_KEY_F3 && action == GLFW_PRESS)
+    {
+        g_showStatsOverlay = !g_showStatsOverlay;
+    }
+    /* a networked game can't pause, the peer keeps playing */
+    if (key == GLFW_KEY_P && action == GLFW_PRESS && !g_isNetworkGame)
+    {
+        g_game->setPause(!g_game->isPaused());
+    }
     g_game->setKey(key, action);
 }
 
+void glfwWindowIconifyCallback(GLFWwindow* pWindow, int iconified)
+{
+    g_windowIconified = iconified == GLFW_TRUE;
+}
+
+void glfwWindowRefreshCallback(GLFWwindow* pWindow)
+{
+    g_windowExposed = true;
+}
+
+void renderFrame(GLFWwindow* pWindow, RenderEngine::FrameBuffer& frameBuffer, const RenderEngine::RenderSnapshot& snapshot)
+{
+    if (g_windowResized)
+    {
+        int frameBufferWidth = 0;
+        int frameBufferHeight = 0;
+        glfwGetFramebufferSize(pWindow, &frameBufferWidth, &frameBufferHeight);
+        frameBuffer.resize(frameBufferWidth, frameBufferHeight);
+        g_windowResized = false;
+    }
+
+    /* The frame is kept in the offscreen buffer so a suspended loop can present it again,
+       the statistics overlay is drawn after the counted part of the frame */
+    PROFILE_ZONE("renderFrame");
+    RenderEngine::GPUProfiler::beginFrame();
+    {
+        PROFILE_GPU_ZONE("frame");
+        frameBuffer.bind();
+        RenderEngine::Renderer::beginFrame();
+        RenderEngine::RenderStats::beginFrame();
+        RenderEngine::Renderer::clear();
+        snapshot.render();
+        RenderEngine::RenderStats::endFrame();
+        if (g_showStatsOverlay && g_pStatsOverlay)
+        {
+            PROFILE_ZONE("overlay");
+            PROFILE_GPU_ZONE("overlay");
+            g_pStatsOverlay->render(frameBuffer.getWidth(), frameBuffer.getHeight());
+        }
+        PROFILE_GPU_ZONE("present");
+        frameBuffer.blitToScreen();
+    }
+    RenderEngine::GPUProfiler::endFrame();
+}
+
 int main(int args, char** argv)
 {
-    
+    /* --pacing=vsync|uncapped|capped|lowlatency, --fps=<rate> for the capped modes,
+       --profile[=<trace.json>] dumps the last --profile-frames=<count> frames on exit, F12 dumps them at any time,
+       --stats shows the statistics overlay, F3 toggles it,
+       --record=<file> records the input of the session into a replay, ReplayTool plays it back headless,
+       --net-player=1|2 --net-port=<port> --net-peer=<host:port> plays two players over UDP with rollback,
+       --input-delay=<ticks> and --rollback=<ticks> tune it, --net-latency=<ms> --net-jitter=<ms> --net-loss=<0..1> simulate a bad network */
+    EPacingMode pacingMode = EPacingMode::VSync;
+    bool dumpProfilerTraceOnExit = false;
+    double targetFrameRate = 60.0;
+    std::string replayRecordPath;
+    size_t netPlayer = 0;
+    uint16_t netPort = 0;
+    std::string netPeer;
+    RollbackSettings rollbackSettings;
+    LinkConditioner::Settings linkSettings;
+    MetricsExporterSettings metricsSettings;
+    for (int i = 1; i < args; ++i)
+    {
+        const std::string argument = argv[i];
+        if (argument.compare(0, 9, "--pacing=") == 0)
+        {
+            if (!FramePacer::parseMode(argument.substr(9), pacingMode))
+            {
+                std::cerr << "Unknown pacing mode: " << argument.substr(9) << std::endl;
+            }
+        }
+        else if (argument.compare(0, 6, "--fps=") == 0)
+        {
+            targetFrameRate = std::atof(argument.c_str() + 6);
+        }
+        else if (argument.compare(0, 17, "--profile-frames=") == 0)
+        {
+            g_profilerTraceFrames = static_cast<size_t>(std::strtoull(argument.c_str() + 17, nullptr, 10));
+        }
+        else if (argument.compare(0, 9, "--record=") == 0)
+        {
+            replayRecordPath = argument.substr(9);
+        }
+        else if (argument.compare(0, 13, "--net-player=") == 0)
+        {
+            netPlayer = static_cast<size_t>(std::atoi(argument.c_str() + 13));
+        }
+        else if (argument.compare(0, 11, "--net-port=") == 0)
+        {
+            netPort = static_cast<uint16_t>(std::atoi(argument.c_str() + 11));
+        }
+        else if (argument.compare(0, 11, "--net-peer=") == 0)
+        {
+            netPeer = argument.substr(11);
+        }
+        else if (argument.compare(0, 14, "--input-delay=") == 0)
+        {
+            rollbackSettings.inputDelay = static_cast<uint32_t>(std::atoi(argument.c_str() + 14));
+        }
+        else if (argument.compare(0, 11, "--rollback=") == 0)
+        {
+            rollbackSettings.rollbackWindow = static_cast<uint32_t>(std::atoi(argument.c_str() + 11));
+        }
+        else if (argument.compare(0, 14, "--net-latency=") == 0)
+        {
+            linkSettings.latency = std::atof(argument.c_str() + 14);
+        }
+        else if (argument.compare(0, 13, "--net-jitter=") == 0)
+        {
+            linkSettings.jitter = std::atof(argument.c_str() + 13);
+        }
+        else if (argument.compare(0, 11, "--net-loss=") == 0)
+        {
+            linkSettings.loss = std::atof(argument.c_str() + 11);
+        }
+        else if (argument == "--stats")
+        {
+            g_showStatsOverlay = true;
+        }
+        else if (argument.compare(0, 15, "--metrics-port=") == 0)
+        {
+            metricsSettings.port = static_cast<uint16_t>(std::atoi(argument.c_str() + 15));
+        }
+        else if (argument.compare(0, 15, "--metrics-file=") == 0)
+        {
+            metricsSettings.jsonPath = argument.substr(15);
+        }
+        else if (argument == "--profile" || argument.compare(0, 10, "--profile=") == 0)
+        {
+            dumpProfilerTraceOnExit = true;
+            if (argument.size() > 10)
+            {
+                g_profilerTracePath = argument.substr(10);
+            }
+        }
+    }
+    FramePacer framePacer(pacingMode, targetFrameRate);
+
     /* Initialize the library */
     if (!glfwInit())
     {
@@ -72,6 +249,9 @@ int main(int args, char** argv)
     /* Make the window's context current */
     glfwMakeContextCurrent(pWindow);
     glfwSetKeyCallback(pWindow, glfwKeyCallback);
+    glfwSetWindowIconifyCallback(pWindow, glfwWindowIconifyCallback);
+    glfwSetWindowRefreshCallback(pWindow, glfwWindowRefreshCallback);
+    glfwSwapInterval(framePacer.getSwapInterval());
 
 	if(!gladLoadGL())
 	{
@@ -84,37 +264,138 @@ int main(int args, char** argv)
 
     RenderEngine::Renderer::setClearColor( 0, 0, 0, 1);
     RenderEngine::Renderer::setDepthTest(true);
+    RenderEngine::GPUProfiler::init();
      
     {
+        PROFILE_THREAD("Main");
+        MetricsExporter metricsExporter;
+        if (metricsSettings.port != 0 || !metricsSettings.jsonPath.empty())
+        {
+            metricsExporter.start(metricsSettings);
+        }
         ResourceManager::setExecutablePath(argv[0]);
         Physics::PhysicsEngine::init();
-        g_game->init();
+        g_isNetworkGame = netPlayer == 1 || netPlayer == 2;
+        g_game->init(1, g_isNetworkGame ? 2 : 1);
+        Replay replayRecorder(g_game->getLevelIndex(), Game::TICK_RATE);
+        if (!replayRecordPath.empty() && !g_isNetworkGame)
+        {
+            g_game->setReplayRecorder(&replayRecorder);
+        }
+
+        UDPSocket netSocket;
+        NetAddress netPeerAddress;
+        if (g_isNetworkGame && (!NetAddress::parse(netPeer, netPeerAddress) || !netSocket.open(netPort, "0.0.0.0")))
+        {
+            std::cerr << "Can't start the network game, --net-peer=<host:port> and a free --net-port=<port> are needed" << std::endl;
+            glfwTerminate();
+            return -1;
+        }
+        LinkConditioner netLink(netSocket, linkSettings);
+        std::unique_ptr<RollbackSession> pRollbackSession;
+        if (g_isNetworkGame)
+        {
+            pRollbackSession = std::make_unique<RollbackSession>(*g_game, netPlayer - 1, netLink, netPeerAddress, rollbackSettings);
+        }
+        g_pStatsOverlay = std::make_unique<RenderEngine::StatsOverlay>(ResourceManager::getShaderProgram("overlayShader"_rid));
         glfwSetWindowSize(pWindow, static_cast<int>(2 * g_game->getCurrentLewelWidth()), static_cast<int>(2 * g_game->getCurrentLewelHeight()));
-        auto lastTime = std::chrono::high_resolution_clock::now();
+        SimulationThread simulationThread(*g_game);
+        if (pRollbackSession)
+        {
+            simulationThread.setTickFunction([&pRollbackSession]() { pRollbackSession->advanceTick(g_game->pollLocalInput()); });
+        }
+        simulationThread.start();
+        RenderEngine::FrameBuffer frameBuffer;
+        const RenderEngine::RenderSnapshot* pLastSnapshot = nullptr;
 
         /* Loop until the user closes the window */
         while (!glfwWindowShouldClose(pWindow))
         {
+            if (pLastSnapshot && (g_game->isPaused() || g_windowIconified))
+            {
+                /* Nothing changes while suspended: sleep until an event arrives and present the cached frame only when the window needs it */
+                glfwWaitEvents();
+                if (!g_windowIconified && (g_windowResized || g_windowExposed))
+                {
+                    if (g_windowResized)
+                    {
+                        renderFrame(pWindow, frameBuffer, *pLastSnapshot);
+                    }
+                    else
+                    {
+                        frameBuffer.blitToScreen();
+                    }
+                    glfwSwapBuffers(pWindow);
+                }
+                g_windowExposed = false;
+
+                if (!g_game->isPaused() && !g_windowIconified)
+                {
+                    simulationThread.skipElapsedTime();
+                    framePacer.reset();
+                }
+                continue;
+            }
+
+            framePacer.beginFrame();
+            PROFILE_FRAME();
+
             /* Poll for and process events */
             glfwPollEvents();
 
-            auto currentTime = std::chrono::high_resolution_clock::now();
-            double duration = std::chrono::duration<double, std::milli>(currentTime - lastTime).count();
-            lastTime = currentTime;
-            g_game->update(duration);
-            Physics::PhysicsEngine::update(duration);
+            /* Render the newest tick while the simulation thread computes the next one,
+               in low-latency mode simulate the input just polled and render that tick */
+            const RenderEngine::RenderSnapshot& snapshot = framePacer.getMode() == EPacingMode::LowLatency
+                ? simulationThread.acquireFreshSnapshot()
+                : simulationThread.acquireLatestSnapshot();
+            renderFrame(pWindow, frameBuffer, snapshot);
+            pLastSnapshot = &snapshot;
+            g_windowExposed = false;
 
-            /* Render here */
-            RenderEngine::Renderer::clear();
+            /* Swap front and back buffers */
+            {
+                PROFILE_ZONE("glfwSwapBuffers");
+                glfwSwapBuffers(pWindow);
+            }
+            framePacer.endFrame();
+            g_game->getInputQueue().onFramePresented(snapshot.getInputTimestamp());
 
-            g_game->render();
+            ResourceManager::enforceMemoryBudget();
+        }
+        simulationThread.stop();
+        if (pRollbackSession)
+        {
+            const RollbackSession::Stats& stats = pRollbackSession->getStats();
+            std::cout << "Rollback: " << stats.rollbacksCount << " rollbacks, " << stats.resimulatedTicksCount << " ticks resimulated, max "
+                      << stats.maxRollbackTicks << " ticks in " << stats.maxRollbackTime << " ms, " << stats.stalledTicksCount
+                      << " ticks stalled, " << stats.desyncsCount << " desyncs in " << stats.checksumsComparedCount << " checks" << std::endl;
+        }
+        if (!replayRecordPath.empty() && !g_isNetworkGame && replayRecorder.save(replayRecordPath))
+        {
+            std::cout << "Replay of " << replayRecorder.getTicksCount() << " ticks written to " << replayRecordPath << std::endl;
+        }
+        if (dumpProfilerTraceOnExit)
+        {
+            Profiler::dumpChromeTrace(g_profilerTracePath, g_profilerTraceFrames);
+        }
 
-            /* Swap front and back buffers */
-            glfwSwapBuffers(pWindow);        
+        std::cout << "Frame pacing " << FramePacer::getModeName(framePacer.getMode());
+        if (framePacer.getMode() == EPacingMode::Capped || framePacer.getMode() == EPacingMode::LowLatency)
+        {
+            std::cout << " " << framePacer.getTargetFrameRate() << " fps";
         }
+        std::cout << ": " << framePacer.getFramesCount() << " frames, average " << framePacer.getAverageFrameTime()
+                  << " ms, variance " << framePacer.getFrameTimeVariance() << " ms^2, min " << framePacer.getMinFrameTime()
+                  << " ms, max " << framePacer.getMaxFrameTime() << " ms" << std::endl;
+
+        const InputQueue& inputQueue = g_game->getInputQueue();
+        std::cout << "Input-to-photon latency: average " << inputQueue.getAverageLatency() << " ms, max " << inputQueue.getMaxLatency()
+                  << " ms over " << inputQueue.getPresentedInputsCount() << " inputs, " << inputQueue.getDroppedEventsCount() << " events dropped" << std::endl;
         Physics::PhysicsEngine::terminate();
         g_game = nullptr;
+        g_pStatsOverlay = nullptr;
         ResourceManager::unloadAllResources();
+        RenderEngine::GPUProfiler::terminate();
     }
 
     glfwTerminate();
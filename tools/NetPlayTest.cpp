@@ -0,0 +1,302 @@
+#include "../src/Game/Game.h"
+#include "../src/Game/WorldHash.h"
+#include "../src/Game/WorldState.h"
+#include "../src/Network/LinkConditioner.h"
+#include "../src/Network/RollbackSession.h"
+#include "../src/Network/UDPSocket.h"
+#include "../src/Physics/PhysicsEngine.h"
+#include "../src/Resources/ResourceManager.h"
+#include "../src/System/JobSystem.h"
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Two-player rollback play over UDP loopback through a latency/loss shim. The peers run in two
+// processes, the simulation keeps process-wide state. Both play random inputs for the same number
+// of ticks, then the world checksums they end with must match and no exchanged checksum may differ.
+// Also measures restoring a state and resimulating --resimulate ticks against the frame budget.
+// Usage: NetPlayTest [--ticks N] [--tick-ms T] [--latency ms] [--jitter ms] [--loss 0..1]
+//                    [--input-delay N] [--rollback N] [--resimulate N] [--level N] [--port P] [--seed S]
+
+struct Options
+{
+	uint32_t ticksCount = 600;
+	double tickDuration = Game::TICK_DURATION;
+	LinkConditioner::Settings link;
+	RollbackSettings rollback;
+	uint32_t resimulatedTicks = 8;
+	size_t levelIndex = 1;
+	uint16_t port = 47600;
+	uint32_t seed = 1;
+};
+
+// sent from the second peer's process to the first one through a pipe
+struct PeerResult
+{
+	bool isFinished = false;
+	uint32_t finalTick = 0;
+	uint32_t finalChecksum = 0;
+	double playTime = 0.0;
+	RollbackSession::Stats stats;
+	uint64_t sentPackets = 0;
+	uint64_t sentBytes = 0;
+	uint64_t droppedPackets = 0;
+	// milliseconds to restore a state and simulate Options::resimulatedTicks ticks
+	double resimulateMedian = 0.0;
+	double resimulateMax = 0.0;
+};
+
+static uint8_t nextRandomInput(std::mt19937& random, const uint8_t input)
+{
+	// a player holds a direction for a while and fires now and then
+	static constexpr uint8_t directions[] = { 0, Game::INPUT_UP, Game::INPUT_DOWN, Game::INPUT_LEFT, Game::INPUT_RIGHT };
+	uint8_t nextInput = input & ~Game::INPUT_FIRE;
+	if (random() % 20 == 0)
+	{
+		nextInput = directions[random() % 5];
+	}
+	if (random() % 8 == 0)
+	{
+		nextInput |= Game::INPUT_FIRE;
+	}
+	return nextInput;
+}
+
+static void measureResimulation(Game& game, const Options& options, PeerResult& result)
+{
+	WorldState state;
+	game.saveState(state);
+	std::vector<double> times;
+	for (int currentRepeat = 0; currentRepeat < 100; ++currentRepeat)
+	{
+		const auto startTime = std::chrono::steady_clock::now();
+		game.restoreState(state);
+		for (uint32_t currentTick = 0; currentTick < options.resimulatedTicks; ++currentTick)
+		{
+			game.setPlayerInput(0, Game::INPUT_UP | Game::INPUT_FIRE);
+			game.setPlayerInput(1, Game::INPUT_LEFT);
+			game.update(Game::TICK_DURATION);
+			Physics::PhysicsEngine::update(Game::TICK_DURATION);
+		}
+		times.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count());
+	}
+	std::sort(times.begin(), times.end());
+	result.resimulateMedian = times[times.size() / 2];
+	result.resimulateMax = times.back();
+	game.restoreState(state);
+}
+
+static PeerResult runPeer(const char* executablePath, const size_t player, const Options& options)
+{
+	PeerResult result;
+	ResourceManager::setExecutablePath(executablePath);
+	ResourceManager::setHeadless(true);
+	JobSystem::init();
+	Physics::PhysicsEngine::init();
+	{
+		Game game(glm::ivec2(13 * 16, 14 * 16));
+		UDPSocket socket;
+		NetAddress remoteAddress;
+		NetAddress::parse("127.0.0.1:" + std::to_string(options.port + 1 - player), remoteAddress);
+		if (game.init(options.levelIndex, 2) && socket.open(static_cast<uint16_t>(options.port + player)))
+		{
+			LinkConditioner::Settings linkSettings = options.link;
+			linkSettings.seed = options.seed * 2 + static_cast<uint32_t>(player);
+			LinkConditioner link(socket, linkSettings);
+			RollbackSession session(game, player, link, remoteAddress, options.rollback);
+			std::mt19937 random(options.seed * 7919 + static_cast<uint32_t>(player));
+			uint8_t input = 0;
+
+			using Clock = std::chrono::steady_clock;
+			const auto tickDuration = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::milli>(options.tickDuration));
+			const auto startTime = Clock::now();
+			auto nextTickTime = startTime;
+			// the peer that starts later is waited for by the rollback window, a quiet peer ends the test
+			const auto deadline = startTime + tickDuration * (options.ticksCount * 4) + std::chrono::seconds(5);
+			while (Clock::now() < deadline)
+			{
+				std::this_thread::sleep_until(nextTickTime);
+				nextTickTime += tickDuration;
+				if (game.getTicksCount() < options.ticksCount)
+				{
+					if (session.advanceTick(input))
+					{
+						input = nextRandomInput(random, input);
+					}
+				}
+				else
+				{
+					session.idle();
+					if (session.getConfirmedTick() >= options.ticksCount && session.getRemoteAckedTick() >= options.ticksCount)
+					{
+						result.isFinished = true;
+						break;
+					}
+				}
+			}
+			result.playTime = std::chrono::duration<double>(Clock::now() - startTime).count();
+			result.finalTick = game.getTicksCount();
+			result.finalChecksum = WorldHash::getChecksum();
+			result.stats = session.getStats();
+			result.sentPackets = socket.getSentPacketsCount();
+			result.sentBytes = socket.getSentBytesCount();
+			result.droppedPackets = link.getDroppedPacketsCount();
+			// the remote may still wait for the last acknowledgements
+			for (int currentRepeat = 0; currentRepeat < 10; ++currentRepeat)
+			{
+				std::this_thread::sleep_for(tickDuration);
+				session.idle();
+			}
+			measureResimulation(game, options, result);
+		}
+	}
+	Physics::PhysicsEngine::terminate();
+	JobSystem::terminate();
+	ResourceManager::unloadAllResources();
+	return result;
+}
+
+static void printResult(const size_t player, const PeerResult& result)
+{
+	const RollbackSession::Stats& stats = result.stats;
+	std::printf("player %zu: %s at tick %u, checksum %08x, %.2f s\n", player + 1, result.isFinished ? "finished" : "DID NOT FINISH",
+				result.finalTick, result.finalChecksum, result.playTime);
+	std::printf("  rollbacks %llu, resimulated ticks %llu, max %u ticks in %.3f ms, average %.3f ms\n",
+				static_cast<unsigned long long>(stats.rollbacksCount), static_cast<unsigned long long>(stats.resimulatedTicksCount),
+				stats.maxRollbackTicks, stats.maxRollbackTime, stats.rollbacksCount > 0 ? stats.totalRollbackTime / stats.rollbacksCount : 0.0);
+	std::printf("  stalled ticks %llu (time sync %llu), checksums compared %llu, desyncs %llu\n",
+				static_cast<unsigned long long>(stats.stalledTicksCount), static_cast<unsigned long long>(stats.timeSyncWaitsCount),
+				static_cast<unsigned long long>(stats.checksumsComparedCount), static_cast<unsigned long long>(stats.desyncsCount));
+	std::printf("  sent %llu packets, %llu bytes, %llu dropped by the shim\n", static_cast<unsigned long long>(result.sentPackets),
+				static_cast<unsigned long long>(result.sentBytes), static_cast<unsigned long long>(result.droppedPackets));
+}
+
+static bool parseOptions(const int args, char** argv, Options& options)
+{
+	for (int currentArgument = 1; currentArgument < args; ++currentArgument)
+	{
+		const std::string argument = argv[currentArgument];
+		if (currentArgument + 1 >= args)
+		{
+			return false;
+		}
+		const char* value = argv[++currentArgument];
+		if (argument == "--ticks")
+		{
+			options.ticksCount = static_cast<uint32_t>(std::max(1, std::atoi(value)));
+		}
+		else if (argument == "--tick-ms")
+		{
+			options.tickDuration = std::max(0.1, std::atof(value));
+		}
+		else if (argument == "--latency")
+		{
+			options.link.latency = std::atof(value);
+		}
+		else if (argument == "--jitter")
+		{
+			options.link.jitter = std::atof(value);
+		}
+		else if (argument == "--loss")
+		{
+			options.link.loss = std::atof(value);
+		}
+		else if (argument == "--input-delay")
+		{
+			options.rollback.inputDelay = static_cast<uint32_t>(std::max(0, std::atoi(value)));
+		}
+		else if (argument == "--rollback")
+		{
+			options.rollback.rollbackWindow = static_cast<uint32_t>(std::max(1, std::atoi(value)));
+		}
+		else if (argument == "--resimulate")
+		{
+			options.resimulatedTicks = static_cast<uint32_t>(std::max(1, std::atoi(value)));
+		}
+		else if (argument == "--level")
+		{
+			options.levelIndex = static_cast<size_t>(std::max(0, std::atoi(value)));
+		}
+		else if (argument == "--port")
+		{
+			options.port = static_cast<uint16_t>(std::atoi(value));
+		}
+		else if (argument == "--seed")
+		{
+			options.seed = static_cast<uint32_t>(std::atoi(value));
+		}
+		else
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+int main(int args, char** argv)
+{
+	Options options;
+	if (!parseOptions(args, argv, options))
+	{
+		std::cerr << "Usage: NetPlayTest [--ticks N] [--tick-ms T] [--latency ms] [--jitter ms] [--loss 0..1] [--input-delay N]"
+				  << " [--rollback N] [--resimulate N] [--level N] [--port P] [--seed S]" << std::endl;
+		return 2;
+	}
+	std::printf("%u ticks every %.2f ms, latency %.1f + %.1f ms jitter, loss %.0f%%, input delay %u, rollback window %u\n",
+				options.ticksCount, options.tickDuration, options.link.latency, options.link.jitter, options.link.loss * 100,
+				options.rollback.inputDelay, options.rollback.rollbackWindow);
+	std::fflush(stdout);
+
+	int resultPipe[2];
+	if (pipe(resultPipe) != 0)
+	{
+		std::cerr << "Can't create a pipe" << std::endl;
+		return 2;
+	}
+	// the second peer forks before any thread exists
+	const pid_t childProcess = fork();
+	if (childProcess < 0)
+	{
+		std::cerr << "Can't start the second peer" << std::endl;
+		return 2;
+	}
+	if (childProcess == 0)
+	{
+		close(resultPipe[0]);
+		const PeerResult result = runPeer(argv[0], 1, options);
+		const bool isWritten = write(resultPipe[1], &result, sizeof(result)) == static_cast<ssize_t>(sizeof(result));
+		close(resultPipe[1]);
+		_exit(isWritten ? 0 : 1);
+	}
+	close(resultPipe[1]);
+	const PeerResult result1 = runPeer(argv[0], 0, options);
+	PeerResult result2;
+	const bool hasResult2 = read(resultPipe[0], &result2, sizeof(result2)) == static_cast<ssize_t>(sizeof(result2));
+	close(resultPipe[0]);
+	waitpid(childProcess, nullptr, 0);
+
+	printResult(0, result1);
+	if (hasResult2)
+	{
+		printResult(1, result2);
+	}
+	const double resimulateMax = std::max(result1.resimulateMax, hasResult2 ? result2.resimulateMax : 0.0);
+	std::printf("restore + %u resimulated ticks: median %.3f ms, max %.3f ms, frame budget %.2f ms\n", options.resimulatedTicks,
+				result1.resimulateMedian, resimulateMax, Game::TICK_DURATION);
+
+	const bool isPassed = hasResult2 && result1.isFinished && result2.isFinished && result1.finalTick == result2.finalTick &&
+		result1.finalChecksum == result2.finalChecksum && result1.stats.desyncsCount == 0 && result2.stats.desyncsCount == 0 &&
+		resimulateMax < Game::TICK_DURATION;
+	std::cout << (isPassed ? "PASSED" : "FAILED") << std::endl;
+	return isPassed ? 0 : 1;
+}
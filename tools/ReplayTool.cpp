@@ -0,0 +1,362 @@
+#include "../src/Game/Game.h"
+#include "../src/Game/Replay.h"
+#include "../src/Game/WorldHash.h"
+#include "../src/Game/WorldState.h"
+#include "../src/Physics/PhysicsEngine.h"
+#include "../src/Resources/ResourceManager.h"
+#include "../src/System/JobSystem.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+
+// Replays recorded with BattleCity --record=<file>.
+//   ReplayTool play <replay> [--repeat N] [--output <file>] [--log <file>]
+//       plays the replay headless as fast as possible and checks the recorded world checksums;
+//       --output saves the replay with the checksums of this run, --log writes "tick checksum" lines
+//   ReplayTool diff <replay> <replay>
+//       finds the first tick the two runs diverge at and dumps the entities that differ there
+//   ReplayTool rewind <replay> [--every N]
+//       every N ticks (60 by default) saves the world state, plays N ticks, restores the state and plays
+//       them again; both runs must end in the same world state
+//   ReplayTool convert <replay> <output>   saves a text or binary replay in the binary format
+//   ReplayTool info <replay>               prints the replay header
+
+static int printUsage()
+{
+	std::cerr << "Usage: ReplayTool play <replay> [--repeat N] [--output <file>] [--log <file>] | diff <replay> <replay> |"
+			  << " rewind <replay> [--every N] | convert <replay> <output> | info <replay>" << std::endl;
+	return 2;
+}
+
+static size_t getFileSize(const std::string& path)
+{
+	std::ifstream file(path, std::ios::in | std::ios::binary | std::ios::ate);
+	return file.is_open() ? static_cast<size_t>(file.tellg()) : 0;
+}
+
+// Plays ticksCount ticks of the replay and records this run's events and checksums into pRecorder.
+// pWorldDump receives the world state at the start of the tick after the last one played.
+static bool playReplay(const Replay& replay, const uint32_t ticksCount, Replay* pRecorder, std::string* pWorldDump = nullptr)
+{
+	Physics::PhysicsEngine::init();
+	bool isPlayed = false;
+	{
+		Game game(glm::ivec2(13 * 16, 14 * 16));
+		if (game.init(replay.getLevelIndex()))
+		{
+			game.setReplayRecorder(pRecorder);
+			ReplayPlayer player(replay);
+			while (!player.isFinished() && player.getCurrentTick() < ticksCount)
+			{
+				player.feedTick(game);
+				game.update(replay.getTickDuration());
+				Physics::PhysicsEngine::update(replay.getTickDuration());
+			}
+			if (pWorldDump)
+			{
+				std::ostringstream stream;
+				WorldHash::dump(stream);
+				*pWorldDump = stream.str();
+			}
+			isPlayed = true;
+		}
+	}
+	Physics::PhysicsEngine::terminate();
+	return isPlayed;
+}
+
+// index of the first differing checksum, the shorter length if one is a prefix of the other
+static size_t findFirstDivergence(const std::vector<uint32_t>& checksums1, const std::vector<uint32_t>& checksums2)
+{
+	const auto mismatch = std::mismatch(checksums1.begin(), checksums1.begin() + std::min(checksums1.size(), checksums2.size()), checksums2.begin());
+	return static_cast<size_t>(mismatch.first - checksums1.begin());
+}
+
+static std::map<std::string, std::string> parseWorldDump(const std::string& dump)
+{
+	// "entity <id> <type> ..." keyed by "entity <id>"
+	std::map<std::string, std::string> entities;
+	std::istringstream stream(dump);
+	for (std::string line; std::getline(stream, line);)
+	{
+		const size_t idEnd = line.find(' ', line.find(' ') + 1);
+		entities[line.substr(0, idEnd)] = line;
+	}
+	return entities;
+}
+
+static int play(const Replay& replay, const int repeatsCount, const std::string& outputPath, const std::string& logPath)
+{
+	const auto startTime = std::chrono::steady_clock::now();
+	Replay recorded(replay.getLevelIndex(), replay.getTickRate());
+	for (int currentRepeat = 0; currentRepeat < repeatsCount; ++currentRepeat)
+	{
+		recorded = Replay(replay.getLevelIndex(), replay.getTickRate());
+		if (!playReplay(replay, replay.getTicksCount(), &recorded))
+		{
+			return 1;
+		}
+	}
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+	const double ticksCount = static_cast<double>(replay.getTicksCount()) * repeatsCount;
+	std::cout << "Played " << ticksCount << " ticks in " << seconds << " s, " << ticksCount / seconds << " ticks/s ("
+			  << ticksCount / seconds / replay.getTickRate() << "x real time)" << std::endl;
+
+	if (!logPath.empty())
+	{
+		std::ofstream log(logPath, std::ios::out | std::ios::trunc);
+		for (size_t currentTick = 0; currentTick < recorded.getChecksums().size(); ++currentTick)
+		{
+			log << currentTick << " " << std::hex << std::setw(8) << std::setfill('0') << recorded.getChecksums()[currentTick] << std::dec << "\n";
+		}
+	}
+	if (!outputPath.empty())
+	{
+		recorded.setTicksCount(replay.getTicksCount());
+		if (!recorded.save(outputPath))
+		{
+			return 1;
+		}
+	}
+
+	if (replay.getChecksums().empty())
+	{
+		std::cout << "The replay has no checksums to verify" << std::endl;
+		return 0;
+	}
+	const size_t divergedTick = findFirstDivergence(replay.getChecksums(), recorded.getChecksums());
+	if (divergedTick < std::min(replay.getChecksums().size(), recorded.getChecksums().size()))
+	{
+		std::cout << "DESYNC: the world diverges from the recording at tick " << divergedTick << std::endl;
+		return 1;
+	}
+	std::cout << "All " << divergedTick << " recorded checksums match" << std::endl;
+	return 0;
+}
+
+static int diff(const Replay& replay1, const Replay& replay2)
+{
+	if (replay1.getChecksums().empty() || replay2.getChecksums().empty())
+	{
+		std::cerr << "Both replays need checksums, record them with ReplayTool play --output" << std::endl;
+		return 2;
+	}
+	const size_t divergedTick = findFirstDivergence(replay1.getChecksums(), replay2.getChecksums());
+	if (divergedTick == std::min(replay1.getChecksums().size(), replay2.getChecksums().size()))
+	{
+		std::cout << "No divergence in " << divergedTick << " common ticks" << std::endl;
+		return 0;
+	}
+	std::cout << "First divergence at the start of tick " << divergedTick << ": " << std::hex << replay1.getChecksums()[divergedTick]
+			  << " != " << replay2.getChecksums()[divergedTick] << std::dec << std::endl;
+
+	// the world is simulated once per replay up to the diverged tick and its entities are compared
+	std::string worldDump1;
+	std::string worldDump2;
+	if (!playReplay(replay1, static_cast<uint32_t>(divergedTick), nullptr, &worldDump1) ||
+		!playReplay(replay2, static_cast<uint32_t>(divergedTick), nullptr, &worldDump2))
+	{
+		return 2;
+	}
+	const std::map<std::string, std::string> entities1 = parseWorldDump(worldDump1);
+	const std::map<std::string, std::string> entities2 = parseWorldDump(worldDump2);
+	for (const auto& [entity, state1] : entities1)
+	{
+		const auto it = entities2.find(entity);
+		if (it == entities2.end() || it->second != state1)
+		{
+			std::cout << "- " << state1 << "\n+ " << (it == entities2.end() ? entity + " missing" : it->second) << std::endl;
+		}
+	}
+	for (const auto& [entity, state2] : entities2)
+	{
+		if (entities1.find(entity) == entities1.end())
+		{
+			std::cout << "- " << entity << " missing\n+ " << state2 << std::endl;
+		}
+	}
+	return 1;
+}
+
+static bool statesEqual(const WorldState& state1, const WorldState& state2)
+{
+	return state1.getSize() == state2.getSize() && std::memcmp(state1.getData(), state2.getData(), state1.getSize()) == 0;
+}
+
+static int rewind(const Replay& replay, const uint32_t ticksBetweenStates)
+{
+	Physics::PhysicsEngine::init();
+	int result = 0;
+	{
+		Game game(glm::ivec2(13 * 16, 14 * 16));
+		if (!game.init(replay.getLevelIndex()))
+		{
+			Physics::PhysicsEngine::terminate();
+			return 1;
+		}
+		const auto playTicks = [&game, &replay, ticksBetweenStates](ReplayPlayer& player)
+		{
+			for (uint32_t currentTick = 0; currentTick < ticksBetweenStates && !player.isFinished(); ++currentTick)
+			{
+				player.feedTick(game);
+				game.update(replay.getTickDuration());
+				Physics::PhysicsEngine::update(replay.getTickDuration());
+			}
+		};
+
+		WorldState savedState;
+		WorldState playedState;
+		WorldState replayedState;
+		double saveMicroseconds = 0;
+		double restoreMicroseconds = 0;
+		size_t rewindsCount = 0;
+		ReplayPlayer player(replay);
+		while (!player.isFinished())
+		{
+			const auto saveStart = std::chrono::steady_clock::now();
+			game.saveState(savedState);
+			saveMicroseconds += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - saveStart).count();
+			ReplayPlayer rewoundPlayer(player);
+			playTicks(player);
+			game.saveState(playedState);
+
+			const auto restoreStart = std::chrono::steady_clock::now();
+			const bool isRestored = game.restoreState(savedState);
+			restoreMicroseconds += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - restoreStart).count();
+			playTicks(rewoundPlayer);
+			game.saveState(replayedState);
+			++rewindsCount;
+			if (!isRestored || !statesEqual(playedState, replayedState))
+			{
+				std::cout << "DESYNC: the world played again from tick " << game.getTicksCount() - ticksBetweenStates
+						  << " doesn't end in the same state" << std::endl;
+				result = 1;
+				break;
+			}
+		}
+		if (result == 0)
+		{
+			std::cout << "All " << rewindsCount << " rewinds replayed the same world, state " << savedState.getSize() << " bytes, save "
+					  << saveMicroseconds / rewindsCount << " us, restore " << restoreMicroseconds / rewindsCount << " us" << std::endl;
+		}
+	}
+	Physics::PhysicsEngine::terminate();
+	return result;
+}
+
+int main(int args, char** argv)
+{
+	if (args < 3)
+	{
+		return printUsage();
+	}
+	const std::string command = argv[1];
+	const std::string replayPath = argv[2];
+
+	Replay replay;
+	if (!replay.load(replayPath))
+	{
+		return 1;
+	}
+
+	if (command == "info")
+	{
+		std::cout << replayPath << ": level " << replay.getLevelIndex() << ", " << replay.getTicksCount() << " ticks at "
+				  << replay.getTickRate() << " Hz, " << replay.getEvents().size() << " events, " << replay.getChecksums().size()
+				  << " checksums, " << getFileSize(replayPath) << " bytes" << std::endl;
+		return 0;
+	}
+	if (command == "convert")
+	{
+		if (args < 4 || !replay.save(argv[3]))
+		{
+			return args < 4 ? printUsage() : 1;
+		}
+		std::cout << replayPath << " (" << getFileSize(replayPath) << " bytes) -> " << argv[3] << " (" << getFileSize(argv[3]) << " bytes)" << std::endl;
+		return 0;
+	}
+
+	int repeatsCount = 1;
+	std::string outputPath;
+	std::string logPath;
+	Replay otherReplay;
+	uint32_t ticksBetweenStates = 60;
+	if (command == "diff")
+	{
+		if (args != 4 || !otherReplay.load(argv[3]))
+		{
+			return args != 4 ? printUsage() : 1;
+		}
+	}
+	else if (command == "rewind")
+	{
+		if (args == 5 && std::string(argv[3]) == "--every")
+		{
+			ticksBetweenStates = static_cast<uint32_t>(std::max(1, std::atoi(argv[4])));
+		}
+		else if (args != 3)
+		{
+			return printUsage();
+		}
+	}
+	else if (command == "play")
+	{
+		for (int currentArgument = 3; currentArgument < args; ++currentArgument)
+		{
+			const std::string argument = argv[currentArgument];
+			if (currentArgument + 1 >= args)
+			{
+				return printUsage();
+			}
+			if (argument == "--repeat")
+			{
+				repeatsCount = std::max(1, std::atoi(argv[++currentArgument]));
+			}
+			else if (argument == "--output")
+			{
+				outputPath = argv[++currentArgument];
+			}
+			else if (argument == "--log")
+			{
+				logPath = argv[++currentArgument];
+			}
+			else
+			{
+				return printUsage();
+			}
+		}
+	}
+	else
+	{
+		return printUsage();
+	}
+
+	ResourceManager::setExecutablePath(argv[0]);
+	ResourceManager::setHeadless(true);
+	// the same threading as the game: the level update runs on the job system
+	JobSystem::init();
+	int result = 0;
+	if (command == "diff")
+	{
+		result = diff(replay, otherReplay);
+	}
+	else if (command == "rewind")
+	{
+		result = rewind(replay, ticksBetweenStates);
+	}
+	else
+	{
+		result = play(replay, repeatsCount, outputPath, logPath);
+	}
+	JobSystem::terminate();
+	ResourceManager::unloadAllResources();
+	return result;
+}